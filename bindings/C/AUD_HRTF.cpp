@@ -47,4 +47,11 @@ extern AUD_API void AUD_HRTF_addImpulseResponseFromSound(AUD_HRTF* hrtfs, AUD_So
 	assert(sound);
 
 	(*hrtfs)->addImpulseResponse(std::make_shared<StreamBuffer>(*sound), azimuth, elevation);
-}
\ No newline at end of file
+}
+
+extern AUD_API void AUD_HRTF_setInterpolation(AUD_HRTF* hrtfs, int interpolation)
+{
+	assert(hrtfs);
+
+	(*hrtfs)->setInterpolation(interpolation);
+}
@@ -43,6 +43,13 @@ extern AUD_API void AUD_HRTF_free(AUD_HRTF* hrtfs);
 */
 extern AUD_API void AUD_HRTF_addImpulseResponseFromSound(AUD_HRTF* hrtfs, AUD_Sound* sound, float azimuth, float elevation);
 
+/**
+* Sets whether the HRTFs are interpolated between the measured directions.
+* \param hrtfs The HRTF object.
+* \param interpolation Whether to interpolate.
+*/
+extern AUD_API void AUD_HRTF_setInterpolation(AUD_HRTF* hrtfs, int interpolation);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
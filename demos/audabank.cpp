@@ -0,0 +1,154 @@
+/*******************************************************************************
+ * Copyright 2009-2024 Jörg Müller
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************/
+
+
+#include "plugin/PluginManager.h"
+#include "file/File.h"
+#include "file/FileManager.h"
+#include "file/SoundBank.h"
+#include "file/SoundBankWriter.h"
+#include "Exception.h"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+using namespace aud;
+
+static std::vector<std::string> listFiles(const std::string& directory)
+{
+	std::vector<std::string> files;
+
+#ifdef _WIN32
+	WIN32_FIND_DATAA data;
+	HANDLE find = FindFirstFileA((directory + "\\*").c_str(), &data);
+
+	if(find != INVALID_HANDLE_VALUE)
+	{
+		do
+		{
+			if(!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+				files.push_back(data.cFileName);
+		}
+		while(FindNextFileA(find, &data));
+
+		FindClose(find);
+	}
+#else
+	DIR* dir = opendir(directory.c_str());
+
+	if(dir)
+	{
+		struct stat status;
+
+		while(struct dirent* entry = readdir(dir))
+		{
+			if(stat((directory + "/" + entry->d_name).c_str(), &status) == 0 && S_ISREG(status.st_mode))
+				files.push_back(entry->d_name);
+		}
+
+		closedir(dir);
+	}
+#endif
+
+	std::sort(files.begin(), files.end());
+
+	return files;
+}
+
+int main(int argc, char* argv[])
+{
+	if(argc != 3 && argc != 4)
+	{
+		std::cerr << "Usage: " << argv[0] << " <directory> <bank_file> [file|u8|s16|s24|s32|float|double]" << std::endl;
+		std::cerr << "Packs the sound files of a directory into a sound bank, either as they are (file, the default) or decoded to PCM samples of the given format." << std::endl;
+		return 1;
+	}
+
+	std::string directory = argv[1];
+	std::string bankfile = argv[2];
+	std::string sFormat = argc > 3 ? argv[3] : "file";
+	SampleFormat format = FORMAT_INVALID;
+
+	if(sFormat == "u8")
+		format = FORMAT_U8;
+	else if(sFormat == "s16")
+		format = FORMAT_S16;
+	else if(sFormat == "s24")
+		format = FORMAT_S24;
+	else if(sFormat == "s32")
+		format = FORMAT_S32;
+	else if(sFormat == "float")
+		format = FORMAT_FLOAT32;
+	else if(sFormat == "double")
+		format = FORMAT_FLOAT64;
+	else if(sFormat != "file")
+	{
+		std::cerr << "Unknown sample format: " << sFormat << std::endl;
+		return 2;
+	}
+
+	PluginManager::loadPlugins("");
+
+	SoundBankWriter writer;
+
+	for(const std::string& name : listFiles(directory))
+	{
+		std::string filename = directory + "/" + name;
+
+		try
+		{
+			// skip anything that isn't a sound file
+			FileManager::queryStreams(filename);
+
+			if(format == FORMAT_INVALID)
+				writer.addFile(name, filename);
+			else
+				writer.addSound(name, std::make_shared<File>(filename), format);
+
+			std::cout << "Added " << name << std::endl;
+		}
+		catch(Exception& e)
+		{
+			std::cerr << "Skipped " << name << " - " << e.getMessage() << std::endl;
+		}
+	}
+
+	try
+	{
+		writer.write(bankfile);
+
+		// verify that the bank can be read back
+		SoundBank bank(bankfile);
+
+		std::cout << "Wrote " << bank.getNames().size() << " sounds to " << bankfile << std::endl;
+	}
+	catch(Exception& e)
+	{
+		std::cerr << "Error writing " << bankfile << " - " << e.getMessage() << std::endl;
+		return 3;
+	}
+
+	return 0;
+}
@@ -0,0 +1,1192 @@
+/*******************************************************************************
+ * Copyright 2009-2016 Jörg Müller
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************/
+
+#include "Exception.h"
+#include "devices/I3DHandle.h"
+#include "devices/ReadDevice.h"
+#include "file/File.h"
+#include "file/FileWriter.h"
+#include "fx/IIRFilterReader.h"
+#include "fx/Limiter.h"
+#include "generator/Sine.h"
+#include "generator/SineReader.h"
+#include "plugin/PluginManager.h"
+#include "respec/ChannelMapperReader.h"
+#include "respec/ConverterFunctions.h"
+#include "respec/JOSResampleReader.h"
+#include "respec/LinearResampleReader.h"
+#include "respec/Mixer.h"
+#include "respec/PolyphaseResampleReader.h"
+#include "util/Buffer.h"
+#include "util/BufferReader.h"
+#include "util/SIMD.h"
+
+#ifdef WITH_CONVOLUTION
+#include "fx/AmbisonicsBus.h"
+#include "fx/BinauralBus.h"
+#include "fx/BinauralSound.h"
+#include "fx/ConvolverSound.h"
+#include "fx/ImpulseResponse.h"
+#include "util/SplitSpectrum.h"
+#include "util/StreamBuffer.h"
+#include "util/ThreadPool.h"
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace aud;
+
+static const int BUFFER_SIZE = AUD_DEFAULT_BUFFER_SIZE;
+
+/// The number of allocations with new in all threads, to check that mixing doesn't allocate.
+static std::atomic<long long> allocationCount(0);
+
+// inlined into the callers GCC pairs the replaced new with free and warns
+#if defined(__GNUC__) || defined(__clang__)
+	#define AUDABENCH_NOINLINE __attribute__((noinline))
+#else
+	#define AUDABENCH_NOINLINE
+#endif
+
+AUDABENCH_NOINLINE void* operator new(std::size_t size)
+{
+	allocationCount++;
+
+	if(void* pointer = std::malloc(size ? size : 1))
+		return pointer;
+
+	throw std::bad_alloc();
+}
+
+AUDABENCH_NOINLINE void operator delete(void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+static std::vector<SIMDLevel> levels()
+{
+	std::vector<SIMDLevel> result = {SIMD_NONE};
+
+	switch(SIMD::getSupportedLevel())
+	{
+	case SIMD_AVX2:
+		result.push_back(SIMD_SSE2);
+		result.push_back(SIMD_AVX2);
+		break;
+	case SIMD_NONE:
+		break;
+	default:
+		result.push_back(SIMD::getSupportedLevel());
+		break;
+	}
+
+	return result;
+}
+
+static const char* levelName(SIMDLevel level)
+{
+	switch(level)
+	{
+	case SIMD_SSE2:
+		return "sse2";
+	case SIMD_AVX2:
+		return "avx2";
+	case SIMD_NEON:
+		return "neon";
+	default:
+		return "scalar";
+	}
+}
+
+static void report(const std::string& name, SIMDLevel level, double frames, double seconds)
+{
+	std::cout << std::left << std::setw(40) << name << std::setw(8) << levelName(level) << std::right << std::setw(14) << std::fixed << std::setprecision(1) << frames / seconds / 1e6 << " Mframes/s" << std::endl;
+}
+
+/**
+ * Calls the function repeatedly for about the given time.
+ * Returns the number of calls and stores the elapsed time.
+ */
+static long long measure(const std::function<void()>& function, double duration, double& seconds)
+{
+	auto start = std::chrono::steady_clock::now();
+	long long calls = 0;
+
+	do
+	{
+		for(int i = 0; i < 16; i++)
+			function();
+
+		calls += 16;
+		seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+	while(seconds < duration);
+
+	return calls;
+}
+
+static void benchmarkMixer(Channels channels, int voices, double duration)
+{
+	DeviceSpecs specs;
+	specs.channels = channels;
+	specs.rate = RATE_48000;
+	specs.format = FORMAT_FLOAT32;
+
+	Buffer source(BUFFER_SIZE * AUD_SAMPLE_SIZE(specs));
+	Buffer target(BUFFER_SIZE * AUD_DEVICE_SAMPLE_SIZE(specs));
+
+	for(int i = 0; i < BUFFER_SIZE * channels; i++)
+		source.getBuffer()[i] = std::rand() / float(RAND_MAX) * 2.0f - 1.0f;
+
+	std::string suffix = " (" + std::to_string(channels) + " channels)";
+
+	for(SIMDLevel level : levels())
+	{
+		SIMD::setLevel(level);
+		Mixer mixer(specs);
+		mixer.clear(BUFFER_SIZE);
+
+		double seconds;
+		long long calls;
+
+		calls = measure([&]() { mixer.mix(source.getBuffer(), 0, BUFFER_SIZE, 0.5f); }, duration, seconds);
+		report("mix constant" + suffix, level, double(calls) * BUFFER_SIZE, seconds);
+
+		calls = measure([&]() { mixer.mix(source.getBuffer(), 0, BUFFER_SIZE, 0.5f, 0.25f); }, duration, seconds);
+		report("mix ramp" + suffix, level, double(calls) * BUFFER_SIZE, seconds);
+
+		// a device callback: clear, mix all voices and write the output
+		calls = measure([&]() {
+			mixer.clear(BUFFER_SIZE);
+			for(int i = 0; i < voices; i++)
+				mixer.mix(source.getBuffer(), 0, BUFFER_SIZE, 0.5f, 0.25f);
+			mixer.read(reinterpret_cast<data_t*>(target.getBuffer()), 0.8f);
+		}, duration, seconds);
+		report("callback " + std::to_string(voices) + " voices" + suffix, level, double(calls) * BUFFER_SIZE * voices, seconds);
+	}
+
+	SIMD::setLevel(SIMD::getSupportedLevel());
+}
+
+static bool benchmarkPlayback(int burst, unsigned int threads, double duration)
+{
+	DeviceSpecs specs;
+	specs.channels = CHANNELS_STEREO;
+	specs.rate = RATE_48000;
+	specs.format = FORMAT_FLOAT32;
+
+	ReadDevice device(specs);
+	device.setThreadCount(threads);
+	device.reserveVoices(256);
+
+	// short sounds at another rate, so that every voice is resampled
+	std::vector<std::shared_ptr<ISound>> sounds;
+
+	for(int i = 0; i < 16; i++)
+		sounds.push_back(std::make_shared<Limiter>(std::make_shared<Sine>(220 + 20 * i, RATE_44100), 0, 0.05));
+
+	Buffer target(BUFFER_SIZE * AUD_DEVICE_SAMPLE_SIZE(specs));
+	int index = 0;
+	long long mixingAllocations = 0;
+
+	// creating the readers of the sounds allocates, so only the allocations while mixing are counted
+	auto callback = [&]() {
+		for(int i = 0; i < burst; i++)
+			device.play(sounds[index++ % sounds.size()])->setVolume(0.1f);
+
+		long long allocations = allocationCount;
+		device.read(reinterpret_cast<data_t*>(target.getBuffer()), BUFFER_SIZE);
+		mixingAllocations += allocationCount - allocations;
+	};
+
+	// reach the steady state before measuring
+	for(int i = 0; i < 64; i++)
+		callback();
+
+	long long deviceAllocations = device.getAllocationCount();
+	mixingAllocations = 0;
+
+	double seconds;
+	long long calls = measure(callback, duration, seconds);
+
+	report("play " + std::to_string(burst) + " voices per callback, " + std::to_string(threads) + " threads", SIMD::getLevel(), double(calls) * BUFFER_SIZE, seconds);
+	std::cout << "  allocations while mixing: " << mixingAllocations << ", device allocations: " << device.getAllocationCount() - deviceAllocations << std::endl;
+
+	if(mixingAllocations)
+		std::cout << "  FAILED: mixing in the steady state allocated memory" << std::endl;
+
+	return !mixingAllocations;
+}
+
+static void benchmarkVirtualization(int emitters, int voices, double duration)
+{
+	DeviceSpecs specs;
+	specs.channels = CHANNELS_STEREO;
+	specs.rate = RATE_48000;
+	specs.format = FORMAT_FLOAT32;
+
+	Buffer target(BUFFER_SIZE * AUD_DEVICE_SAMPLE_SIZE(specs));
+
+	for(int limit : {0, voices})
+	{
+		ReadDevice device(specs);
+		device.setMaximumRealVoices(limit);
+
+		for(int i = 0; i < emitters; i++)
+		{
+			auto handle = device.play(std::make_shared<Sine>(100 + i, RATE_44100));
+			handle->setVolume(1.0f / emitters);
+			SoftwareDevice::setPriority(handle.get(), i % 4);
+		}
+
+		double seconds;
+		long long calls = measure([&]() { device.read(reinterpret_cast<data_t*>(target.getBuffer()), BUFFER_SIZE); }, duration, seconds);
+
+		std::string name = std::to_string(emitters) + " emitters, " + (limit ? std::to_string(limit) + " real" : std::string("all real"));
+		report(name, SIMD::getLevel(), double(calls) * BUFFER_SIZE * emitters, seconds);
+	}
+}
+
+static void benchmarkSpatialization(int emitters, double duration)
+{
+	DeviceSpecs specs;
+	specs.channels = CHANNELS_STEREO;
+	specs.rate = RATE_48000;
+	specs.format = FORMAT_FLOAT32;
+
+	Buffer target(BUFFER_SIZE * AUD_DEVICE_SAMPLE_SIZE(specs));
+
+	for(bool batch : {false, true})
+	{
+		ReadDevice device(specs);
+		device.setBatchUpdateEnabled(batch);
+		device.setDopplerFactor(1.0f);
+
+		// only a few voices are real, so that the update dominates
+		device.setMaximumRealVoices(8);
+
+		for(int i = 0; i < emitters; i++)
+		{
+			auto handle = std::dynamic_pointer_cast<I3DHandle>(device.play(std::make_shared<Sine>(100 + i, RATE_48000)));
+			handle->setLocation(Vector3(std::rand() % 100 - 50, std::rand() % 100 - 50, std::rand() % 100 - 50));
+			handle->setVelocity(Vector3(std::rand() % 20 - 10, 0, std::rand() % 20 - 10));
+		}
+
+		// short low latency callbacks, where the update of all emitters matters most
+		int length = 64;
+
+		double seconds;
+		long long calls = measure([&]() { device.read(reinterpret_cast<data_t*>(target.getBuffer()), length); }, duration, seconds);
+
+		std::string name = std::to_string(emitters) + " 3D emitters, " + (batch ? "batched" : "per sound");
+		report(name, SIMD::getLevel(), double(calls) * length * emitters, seconds);
+	}
+}
+
+struct Converter
+{
+	const char* name;
+	convert_f function;
+	int source_size;
+	int target_size;
+};
+
+static const Converter converters[] = {
+	{"u8 to float", convert_u8_float, 1, 4},
+	{"s16 to float", convert_s16_float, 2, 4},
+	{"s24 be to float", convert_s24_float_be, 3, 4},
+	{"s24 le to float", convert_s24_float_le, 3, 4},
+	{"s32 to float", convert_s32_float, 4, 4},
+	{"float to u8", convert_float_u8, 4, 1},
+	{"float to s16", convert_float_s16, 4, 2},
+	{"float to s24 be", convert_float_s24_be, 4, 3},
+	{"float to s24 le", convert_float_s24_le, 4, 3},
+	{"float to s32", convert_float_s32, 4, 4}
+};
+
+/**
+ * Creates the verification input of a converter. Integer formats up to 24
+ * bit are covered exhaustively, floats densely around the clipping points
+ * and sparsely elsewhere. The odd length makes the scalar code convert a tail.
+ */
+static std::vector<data_t> converterInput(const Converter& converter)
+{
+	std::vector<data_t> input;
+
+	auto append = [&](const void* value, int size) {
+		const data_t* bytes = reinterpret_cast<const data_t*>(value);
+		input.insert(input.end(), bytes, bytes + size);
+	};
+
+	if(converter.source_size == 4 && converter.target_size == 4 && converter.function == convert_s32_float)
+	{
+		for(int64_t i = INT32_MIN; i <= INT32_MAX; i += 251)
+		{
+			int32_t value = int32_t(i);
+			append(&value, 4);
+		}
+	}
+	else if(converter.source_size == 4)
+	{
+		// all floats around -1, 0 and 1 and a sweep over [-4, 4]
+		for(float center : {-1.0f, 0.0f, 1.0f})
+		{
+			int32_t bits;
+			std::memcpy(&bits, &center, 4);
+
+			for(int32_t i = -(1 << 20); i <= (1 << 20); i++)
+			{
+				float value;
+				int32_t b = center == 0.0f ? (i < 0 ? (-i) | INT32_MIN : i) : bits + i;
+				std::memcpy(&value, &b, 4);
+				append(&value, 4);
+			}
+		}
+
+		for(int i = -(1 << 22); i <= (1 << 22); i++)
+		{
+			float value = i / float(1 << 20);
+			append(&value, 4);
+		}
+
+		for(float value : {-1e30f, 1e30f, -2.0f, 2.0f})
+			append(&value, 4);
+	}
+	else
+	{
+		int count = 1 << (8 * converter.source_size);
+
+		for(int i = 0; i < count; i++)
+			append(&i, converter.source_size);
+	}
+
+	while(input.size() % converter.source_size || (input.size() / converter.source_size) % 16 != 7)
+		input.push_back(0);
+
+	return input;
+}
+
+/**
+ * Verifies that the vector kernels of all SIMD levels convert exactly like
+ * the scalar code, both into another buffer and in place.
+ */
+static bool verifyConverter(const Converter& converter)
+{
+	std::vector<data_t> input = converterInput(converter);
+	int length = input.size() / converter.source_size;
+	int size = std::max(converter.source_size, converter.target_size) * length;
+
+	std::vector<data_t> reference(converter.target_size * length);
+	std::vector<data_t> target(size);
+
+	SIMD::setLevel(SIMD_NONE);
+	converter.function(reference.data(), input.data(), length);
+
+	bool equal = true;
+
+	for(SIMDLevel level : levels())
+	{
+		SIMD::setLevel(level);
+
+		converter.function(target.data(), input.data(), length);
+		bool copy = std::memcmp(target.data(), reference.data(), reference.size()) == 0;
+
+		std::memcpy(target.data(), input.data(), input.size());
+		converter.function(target.data(), target.data(), length);
+		bool in_place = std::memcmp(target.data(), reference.data(), reference.size()) == 0;
+
+		if(!copy || !in_place)
+		{
+			std::cout << "  " << converter.name << " (" << levelName(level) << ") differs from the scalar code" << (copy ? "" : " converting into another buffer") << (copy || in_place ? "" : " and") << (in_place ? "" : " in place") << std::endl;
+			equal = false;
+		}
+	}
+
+	SIMD::setLevel(SIMD::getSupportedLevel());
+
+	return equal;
+}
+
+static void benchmarkConverters(double duration)
+{
+	int length = BUFFER_SIZE * CHANNELS_STEREO;
+
+	std::vector<data_t> source(length * 4);
+	std::vector<data_t> target(length * 4);
+
+	for(int i = 0; i < length; i++)
+		reinterpret_cast<float*>(source.data())[i] = std::rand() / float(RAND_MAX) * 2.2f - 1.1f;
+
+	bool equal = true;
+
+	for(const Converter& converter : converters)
+		equal = verifyConverter(converter) && equal;
+
+	std::cout << "Converters " << (equal ? "equal" : "NOT equal") << " to the scalar code" << std::endl;
+
+	for(const Converter& converter : converters)
+	{
+		for(SIMDLevel level : levels())
+		{
+			SIMD::setLevel(level);
+
+			double seconds;
+			long long calls = measure([&]() { converter.function(target.data(), source.data(), length); }, duration, seconds);
+			report(converter.name, level, double(calls) * length, seconds);
+		}
+	}
+
+	SIMD::setLevel(SIMD::getSupportedLevel());
+}
+
+static void benchmarkDeinterleave(SampleFormat format, convert_f convert, convert_planar_f convert_planar, Channels channels, double duration)
+{
+	int length = BUFFER_SIZE;
+	int size = AUD_FORMAT_SIZE(format);
+
+	std::vector<std::vector<data_t>> planes(channels, std::vector<data_t>(length * size));
+	std::vector<data_t*> source(channels);
+	std::vector<data_t> interleaved(length * channels * size);
+	std::vector<float> target(length * channels);
+
+	for(int channel = 0; channel < channels; channel++)
+	{
+		for(data_t& byte : planes[channel])
+			byte = std::rand();
+		source[channel] = planes[channel].data();
+	}
+
+	std::string suffix = std::string(format == FORMAT_S16 ? " s16" : " float") + " (" + std::to_string(channels) + " channels)";
+
+	double seconds;
+
+	// interleaving into a packet buffer first, then converting
+	long long calls = measure([&]() {
+		for(int channel = 0; channel < channels; channel++)
+			for(int i = 0; i < length; i++)
+				std::memcpy(interleaved.data() + (channels * i + channel) * size, source[channel] + i * size, size);
+		convert(reinterpret_cast<data_t*>(target.data()), interleaved.data(), length * channels);
+	}, duration, seconds);
+
+	report("planar copy, convert" + suffix, SIMD::getLevel(), double(calls) * length, seconds);
+
+	calls = measure([&]() { convert_planar(reinterpret_cast<data_t*>(target.data()), source.data(), 0, length, channels); }, duration, seconds);
+
+	report("planar fused" + suffix, SIMD::getLevel(), double(calls) * length, seconds);
+}
+
+static void benchmarkDecode(const std::string& name, Codec codec, SampleFormat format, double duration)
+{
+	DeviceSpecs specs;
+	specs.channels = CHANNELS_STEREO;
+	specs.rate = RATE_48000;
+	specs.format = format;
+
+	// matroska, so that the file is read with ffmpeg and no other plugin
+	std::string filename = "audabench-decode.mkv";
+
+	// ten seconds of noise
+	int length = 10 * specs.rate;
+	auto buffer = std::make_shared<Buffer>(length * AUD_SAMPLE_SIZE(specs));
+
+	for(int i = 0; i < length * specs.channels; i++)
+		buffer->getBuffer()[i] = std::rand() / float(RAND_MAX) - 0.5f;
+
+	std::shared_ptr<IReader> reader;
+
+	try
+	{
+		auto writer = FileWriter::createWriter(filename, specs, CONTAINER_MATROSKA, codec, 192000);
+		FileWriter::writeReader(std::make_shared<BufferReader>(buffer, specs.specs), writer, length, BUFFER_SIZE);
+		writer.reset();
+
+		reader = File(filename).createReader();
+	}
+	catch(Exception&)
+	{
+		std::cout << "decode " << name << " not available" << std::endl;
+		std::remove(filename.c_str());
+		return;
+	}
+
+	std::vector<sample_t> target(BUFFER_SIZE * specs.channels);
+
+	double seconds;
+	long long frames = 0;
+
+	measure([&]() {
+		int len = BUFFER_SIZE;
+		bool eos;
+		reader->read(len, eos, target.data());
+		frames += len;
+		if(eos)
+			reader->seek(0);
+	}, duration, seconds);
+
+	report("decode " + name, SIMD::getLevel(), double(frames), seconds);
+
+	reader.reset();
+	std::remove(filename.c_str());
+}
+
+static bool checkVirtualFile()
+{
+	DeviceSpecs specs;
+	specs.channels = CHANNELS_MONO;
+	specs.rate = RATE_48000;
+	specs.format = FORMAT_S16;
+
+	std::string filename = "audabench-virtual.mkv";
+
+	// two seconds of a sine, read with ffmpeg which reports the remaining length
+	int length = 2 * specs.rate;
+	auto buffer = std::make_shared<Buffer>(length * AUD_SAMPLE_SIZE(specs));
+
+	for(int i = 0; i < length; i++)
+		buffer->getBuffer()[i] = 0.5f * std::sin(2 * M_PI * 440 * i / specs.rate);
+
+	try
+	{
+		auto writer = FileWriter::createWriter(filename, specs, CONTAINER_MATROSKA, CODEC_PCM, 0);
+		FileWriter::writeReader(std::make_shared<BufferReader>(buffer, specs.specs), writer, length, BUFFER_SIZE);
+	}
+	catch(Exception&)
+	{
+		std::cout << "virtual file check not available" << std::endl;
+		std::remove(filename.c_str());
+		return true;
+	}
+
+	specs.format = FORMAT_FLOAT32;
+
+	ReadDevice device(specs);
+	device.setAudibilityThreshold(0.01f);
+
+	auto handle = device.play(std::make_shared<File>(filename));
+	std::vector<sample_t> target(specs.rate / 4);
+
+	auto play = [&](float volume, int quarters) {
+		handle->setVolume(volume);
+
+		float peak = 0;
+
+		for(int i = 0; i < quarters; i++)
+		{
+			device.read(reinterpret_cast<data_t*>(target.data()), target.size());
+
+			for(sample_t sample : target)
+				peak = std::max(peak, std::fabs(sample));
+		}
+
+		return peak;
+	};
+
+	// real for a second, virtual for half a second and real again until the end
+	play(1, 4);
+	play(0, 2);
+
+	bool success = handle->getStatus() == STATUS_PLAYING && std::fabs(handle->getPosition() - 1.5) < 0.01;
+
+	success = success && play(1, 1) > 0.4f && handle->getStatus() == STATUS_PLAYING;
+
+	play(1, 2);
+
+	success = success && handle->getStatus() == STATUS_INVALID;
+
+	std::cout << "virtual file playback: " << (success ? "ok" : "FAILED") << std::endl;
+
+	handle.reset();
+	std::remove(filename.c_str());
+
+	return success;
+}
+
+static void benchmarkResampler(ResampleQuality quality, Channels channels, bool polyphase, double duration)
+{
+	int length = BUFFER_SIZE;
+	std::vector<sample_t> target(length * channels);
+
+	std::string name = std::string(polyphase ? "polyphase " : "JOS ") + (quality == ResampleQuality::LOW ? "low" : quality == ResampleQuality::MEDIUM ? "medium" : "high") + " 44.1k to 48k, " + std::to_string(channels) + " ch";
+
+	for(SIMDLevel level : levels())
+	{
+		SIMD::setLevel(level);
+
+		// the resampler chooses its kernels when it sees the channel count first
+		auto source = std::make_shared<ChannelMapperReader>(std::make_shared<SineReader>(440, RATE_44100), channels);
+		std::shared_ptr<ResampleReader> resampler;
+
+		if(polyphase)
+		{
+			auto reader = std::make_shared<PolyphaseResampleReader>(source, RATE_48000, quality);
+			reader->setSourceRate(RATE_44100);
+			resampler = reader;
+		}
+		else
+			resampler = std::make_shared<JOSResampleReader>(source, RATE_48000, quality);
+
+		double seconds;
+		long long calls = measure([&]() {
+			int len = length;
+			bool eos;
+			resampler->read(len, eos, target.data());
+		}, duration, seconds);
+
+		report(name, level, double(calls) * length, seconds);
+	}
+
+	SIMD::setLevel(SIMD::getSupportedLevel());
+}
+
+static void benchmarkChannelMapper(Channels source_channels, Channels target_channels, double duration)
+{
+	Specs specs;
+	specs.channels = source_channels;
+	specs.rate = RATE_48000;
+
+	int length = BUFFER_SIZE;
+	auto noise = std::make_shared<Buffer>(length * AUD_SAMPLE_SIZE(specs));
+
+	for(int i = 0; i < length * source_channels; i++)
+		noise->getBuffer()[i] = std::rand() / float(RAND_MAX) * 2.0f - 1.0f;
+
+	std::vector<sample_t> target(length * target_channels);
+
+	std::string name = "map " + std::to_string(source_channels) + " to " + std::to_string(target_channels) + " ch";
+
+	for(SIMDLevel level : levels())
+	{
+		SIMD::setLevel(level);
+
+		// the mapper chooses its function when it sees the source channels first
+		ChannelMapperReader mapper(std::make_shared<BufferReader>(noise, specs), target_channels);
+		mapper.setMonoAngle(0.4f);
+
+		double seconds;
+		long long calls = measure([&]() {
+			int len = length;
+			bool eos;
+			mapper.seek(0);
+			mapper.read(len, eos, target.data());
+		}, duration, seconds);
+
+		report(name, level, double(calls) * length, seconds);
+	}
+
+	SIMD::setLevel(SIMD::getSupportedLevel());
+}
+
+/**
+ * The channel major LinearResampleReader with floating point positions as
+ * it was before the fixed point rewrite, as reference for the benchmark.
+ */
+class ReferenceLinearResampleReader : public ResampleReader
+{
+private:
+	Channels m_channels;
+	float m_cache_pos;
+	Buffer m_buffer;
+	Buffer m_cache;
+	bool m_cache_ok;
+
+public:
+	ReferenceLinearResampleReader(std::shared_ptr<IReader> reader, SampleRate rate) :
+		ResampleReader(reader, rate), m_channels(CHANNELS_INVALID), m_cache_pos(0), m_cache_ok(false)
+	{
+	}
+
+	virtual void reset()
+	{
+		m_cache_ok = false;
+		m_cache_pos = 0;
+	}
+
+	virtual void seek(int position)
+	{
+		m_reader->seek(std::floor(position * double(m_reader->getSpecs().rate) / double(m_rate)));
+		reset();
+	}
+
+	virtual int getLength() const
+	{
+		return std::floor(m_reader->getLength() * double(m_rate) / double(m_reader->getSpecs().rate));
+	}
+
+	virtual int getPosition() const
+	{
+		return std::floor((m_reader->getPosition() + (m_cache_ok ? m_cache_pos - 1 : 0)) * m_rate / m_reader->getSpecs().rate);
+	}
+
+	virtual Specs getSpecs() const
+	{
+		Specs specs = m_reader->getSpecs();
+		specs.rate = m_rate;
+		return specs;
+	}
+
+	virtual void read(int& length, bool& eos, sample_t* buffer)
+	{
+		Specs specs = m_reader->getSpecs();
+
+		int samplesize = AUD_SAMPLE_SIZE(specs);
+		int size = length;
+		float factor = m_rate / specs.rate;
+		float spos = 0.0f;
+		eos = false;
+
+		if(specs.channels != m_channels)
+		{
+			m_cache.assureSize(2 * samplesize);
+			m_channels = specs.channels;
+			m_cache_ok = false;
+		}
+
+		int len;
+		sample_t* buf;
+
+		if(m_cache_ok)
+		{
+			int need = std::ceil(length / factor + m_cache_pos) - 1;
+			len = need;
+			m_buffer.assureSize((len + 2) * samplesize);
+			buf = m_buffer.getBuffer();
+			std::memcpy(buf, m_cache.getBuffer(), 2 * samplesize);
+			m_reader->read(len, eos, buf + 2 * m_channels);
+
+			if(len < need)
+				length = std::floor((len + 1 - m_cache_pos) * factor);
+		}
+		else
+		{
+			m_cache_pos = 1 - 1 / factor;
+			int need = std::ceil(length / factor + m_cache_pos);
+			len = need;
+			m_buffer.assureSize((len + 1) * samplesize);
+			buf = m_buffer.getBuffer();
+			std::memset(buf, 0, samplesize);
+			m_reader->read(len, eos, buf + m_channels);
+
+			if(len == 0)
+			{
+				length = 0;
+				return;
+			}
+
+			if(len < need)
+				length = std::floor((len - m_cache_pos) * factor);
+
+			m_cache_ok = true;
+		}
+
+		if(length == 0)
+			return;
+
+		for(int channel = 0; channel < m_channels; channel++)
+		{
+			for(int i = 0; i < length; i++)
+			{
+				spos = (i + 1) / factor + m_cache_pos;
+
+				sample_t low = buf[(int)std::floor(spos) * m_channels + channel];
+				sample_t high = buf[(int)std::ceil(spos) * m_channels + channel];
+
+				buffer[i * m_channels + channel] = low + (spos - std::floor(spos)) * (high - low);
+			}
+		}
+
+		if(std::floor(spos) == spos)
+		{
+			std::memcpy(m_cache.getBuffer() + m_channels, buf + int(std::floor(spos)) * m_channels, samplesize);
+			m_cache_pos = 1;
+		}
+		else
+		{
+			std::memcpy(m_cache.getBuffer(), buf + int(std::floor(spos)) * m_channels, 2 * samplesize);
+			m_cache_pos = spos - std::floor(spos);
+		}
+
+		eos &= length < size;
+	}
+};
+
+static void benchmarkLinearResampler(Channels channels, double duration)
+{
+	Specs specs;
+	specs.channels = channels;
+	specs.rate = RATE_44100;
+
+	// one second of noise, so that reading the source costs next to nothing
+	auto noise = std::make_shared<Buffer>(specs.rate * AUD_SAMPLE_SIZE(specs));
+
+	for(int i = 0; i < specs.rate * channels; i++)
+		noise->getBuffer()[i] = std::rand() / float(RAND_MAX) * 2.0f - 1.0f;
+
+	int length = BUFFER_SIZE;
+	std::vector<sample_t> target(length * channels);
+
+	std::string suffix = " 44.1k to 48k, " + std::to_string(channels) + " ch";
+
+	auto run = [&](ResampleReader& resampler, const std::string& name, SIMDLevel level) {
+		double seconds;
+		long long calls = measure([&]() {
+			int len = length;
+			bool eos;
+			resampler.read(len, eos, target.data());
+
+			if(eos)
+				resampler.seek(0);
+		}, duration, seconds);
+
+		report(name + suffix, level, double(calls) * length, seconds);
+	};
+
+	ReferenceLinearResampleReader reference(std::make_shared<BufferReader>(noise, specs), RATE_48000);
+	run(reference, "linear before", SIMD_NONE);
+
+	for(SIMDLevel level : levels())
+	{
+		SIMD::setLevel(level);
+
+		LinearResampleReader resampler(std::make_shared<BufferReader>(noise, specs), RATE_48000);
+		run(resampler, "linear", level);
+	}
+
+	SIMD::setLevel(SIMD::getSupportedLevel());
+}
+
+/**
+ * This IIR filter always uses the per sample direct form, as reference for
+ * the biquad cascade.
+ */
+class DirectFormIIRFilterReader : public IIRFilterReader
+{
+public:
+	DirectFormIIRFilterReader(std::shared_ptr<IReader> reader, const std::vector<float>& b, const std::vector<float>& a) :
+		IIRFilterReader(reader, b, a)
+	{
+	}
+
+	virtual bool filterBlock(sample_t*, int, Channels)
+	{
+		return false;
+	}
+};
+
+static void benchmarkIIRFilter(Channels channels, double duration)
+{
+	Specs specs;
+	specs.channels = channels;
+	specs.rate = RATE_48000;
+
+	int length = BUFFER_SIZE;
+	auto noise = std::make_shared<Buffer>(length * AUD_SAMPLE_SIZE(specs));
+
+	for(int i = 0; i < length * channels; i++)
+		noise->getBuffer()[i] = std::rand() / float(RAND_MAX) * 2.0f - 1.0f;
+
+	// a butterworth lowpass at 3 kHz
+	std::vector<float> b = {0.000933498613f, 0.00373399445f, 0.00560099168f, 0.00373399445f, 0.000933498613f};
+	std::vector<float> a = {1.0f, -2.97684433f, 3.42230953f, -1.7861066f, 0.355577382f};
+
+	std::vector<sample_t> target(length * channels);
+
+	std::string suffix = " 4th order, " + std::to_string(channels) + " ch";
+
+	auto run = [&](IReader& filter, const std::string& name, SIMDLevel level) {
+		double seconds;
+		long long calls = measure([&]() {
+			int len = length;
+			bool eos;
+			filter.seek(0);
+			filter.read(len, eos, target.data());
+		}, duration, seconds);
+
+		report(name + suffix, level, double(calls) * length, seconds);
+	};
+
+	DirectFormIIRFilterReader reference(std::make_shared<BufferReader>(noise, specs), b, a);
+	run(reference, "iir direct form", SIMD_NONE);
+
+	for(SIMDLevel level : levels())
+	{
+		SIMD::setLevel(level);
+
+		IIRFilterReader filter(std::make_shared<BufferReader>(noise, specs), b, a);
+		run(filter, "iir biquads", level);
+	}
+
+	SIMD::setLevel(SIMD::getSupportedLevel());
+}
+
+#ifdef WITH_CONVOLUTION
+static void benchmarkMultiplyAdd(int partitions, int bins, double duration)
+{
+	int size = SplitSpectrum::getSize(bins);
+
+	std::vector<sample_t> spectra(2 * partitions * size);
+	std::vector<sample_t> accumulator(size);
+	std::vector<const sample_t*> a;
+	std::vector<const sample_t*> b;
+
+	for(sample_t& value : spectra)
+		value = std::rand() / float(RAND_MAX) * 2.0f - 1.0f;
+
+	for(int p = 0; p < partitions; p++)
+	{
+		a.push_back(spectra.data() + p * size);
+		b.push_back(spectra.data() + (partitions + p) * size);
+	}
+
+	std::string name = "complex mac " + std::to_string(partitions) + " x " + std::to_string(bins) + " bins";
+
+	for(SIMDLevel level : levels())
+	{
+		SIMD::setLevel(level);
+		SplitSpectrum::multiply_add_f multiplyAdd = SplitSpectrum::getMultiplyAdd();
+
+		double seconds;
+		long long calls = measure([&]() { multiplyAdd(a.data(), b.data(), partitions, accumulator.data(), size / 2); }, duration, seconds);
+
+		report(name, level, double(calls) * partitions * bins, seconds);
+	}
+
+	SIMD::setLevel(SIMD::getSupportedLevel());
+}
+
+static void benchmarkConvolution(int irSeconds, double duration)
+{
+	Specs specs;
+	specs.channels = CHANNELS_MONO;
+	specs.rate = RATE_48000;
+
+	// an exponentially decaying noise tail like a reverb
+	int irLength = irSeconds * int(specs.rate);
+	auto irBuffer = std::make_shared<Buffer>(irLength * AUD_SAMPLE_SIZE(specs));
+
+	for(int i = 0; i < irLength; i++)
+		irBuffer->getBuffer()[i] = (std::rand() / float(RAND_MAX) * 2.0f - 1.0f) * std::exp(-6.9f * i / irLength) * 0.01f;
+
+	auto irSound = std::make_shared<StreamBuffer>(irBuffer, specs);
+	auto sound = std::make_shared<Sine>(440, specs.rate);
+	auto threadPool = std::make_shared<ThreadPool>(std::max(std::thread::hardware_concurrency(), 2u));
+
+	std::vector<sample_t> target(BUFFER_SIZE);
+
+	auto run = [&](ISound& convolver, const std::string& name, int latency) {
+		auto reader = convolver.createReader();
+
+		// fill the delay lines before measuring
+		for(int i = 0; i < 16; i++)
+		{
+			int len = BUFFER_SIZE;
+			bool eos;
+			reader->read(len, eos, target.data());
+		}
+
+		double seconds;
+		long long calls = measure([&]() {
+			int len = BUFFER_SIZE;
+			bool eos;
+			reader->read(len, eos, target.data());
+		}, duration, seconds);
+
+		std::ostringstream label;
+		label << "convolve " << irSeconds << " s IR, " << name << " " << std::fixed << std::setprecision(1) << latency * 1000.0 / specs.rate << " ms";
+
+		report(label.str(), SIMD::getLevel(), double(calls) * BUFFER_SIZE, seconds);
+		std::cout << "  calling thread load at " << int(specs.rate) << " Hz: " << std::fixed << std::setprecision(1) << seconds * specs.rate * 100.0 / (double(calls) * BUFFER_SIZE) << " %" << std::endl;
+	};
+
+	for(int N : {512, 2048, 8192})
+	{
+		auto plan = std::make_shared<FFTPlan>(N, 0.0);
+		ConvolverSound convolver(sound, std::make_shared<ImpulseResponse>(irSound, plan), threadPool, plan);
+		run(convolver, "uniform", N / 2);
+	}
+
+	auto impulseResponse = std::make_shared<ImpulseResponse>(irSound);
+
+	for(int blockSize : {64, 256, 1024})
+	{
+		ConvolverSound convolver(sound, impulseResponse, threadPool, blockSize);
+		run(convolver, "non uniform", blockSize);
+	}
+}
+
+static void benchmarkBinaural(int sources, double duration)
+{
+	Specs specs;
+	specs.channels = CHANNELS_MONO;
+	specs.rate = RATE_48000;
+
+	// a synthetic HRTF set with 512 taps every 5 degrees
+	auto hrtfs = std::make_shared<HRTF>();
+
+	for(int azimuth = 0; azimuth < 360; azimuth += 5)
+	{
+		auto buffer = std::make_shared<Buffer>(512 * AUD_SAMPLE_SIZE(specs));
+
+		for(int i = 0; i < 512; i++)
+			buffer->getBuffer()[i] = (std::rand() / float(RAND_MAX) * 2.0f - 1.0f) * std::exp(-i / 64.0f);
+
+		hrtfs->addImpulseResponse(std::make_shared<StreamBuffer>(buffer, specs), azimuth, 0);
+	}
+
+	auto threadPool = std::make_shared<ThreadPool>(std::max(std::thread::hardware_concurrency(), 2u));
+	auto bus = std::make_shared<BinauralBus>(hrtfs);
+	auto ambisonics = std::make_shared<AmbisonicsBus>(3, hrtfs);
+	std::vector<std::shared_ptr<IReader>> readers;
+
+	for(int i = 0; i < sources; i++)
+	{
+		auto sound = std::make_shared<Sine>(220 + 10 * i, specs.rate);
+		auto source = std::make_shared<Source>(i * 360.0f / sources, 0);
+
+		bus->addSound(sound, source);
+		ambisonics->addSound(sound, source);
+		readers.push_back(BinauralSound(sound, hrtfs, source, threadPool).createReader());
+	}
+
+	std::vector<sample_t> target(BUFFER_SIZE * 2);
+	std::vector<sample_t> mix(BUFFER_SIZE * 2);
+
+	double seconds;
+	long long calls = measure([&]() {
+		std::fill(mix.begin(), mix.end(), 0.0f);
+
+		for(auto& reader : readers)
+		{
+			int len = BUFFER_SIZE;
+			bool eos;
+			reader->read(len, eos, target.data());
+
+			for(int i = 0; i < len * 2; i++)
+				mix[i] += target[i];
+		}
+	}, duration, seconds);
+
+	report("binaural " + std::to_string(sources) + " sources, readers", SIMD::getLevel(), double(calls) * BUFFER_SIZE, seconds);
+
+	auto reader = bus->createReader();
+
+	calls = measure([&]() {
+		int len = BUFFER_SIZE;
+		bool eos;
+		reader->read(len, eos, target.data());
+	}, duration, seconds);
+
+	report("binaural " + std::to_string(sources) + " sources, bus", SIMD::getLevel(), double(calls) * BUFFER_SIZE, seconds);
+
+	reader = ambisonics->createReader();
+
+	calls = measure([&]() {
+		int len = BUFFER_SIZE;
+		bool eos;
+		reader->read(len, eos, target.data());
+	}, duration, seconds);
+
+	report("binaural " + std::to_string(sources) + " sources, 3rd order", SIMD::getLevel(), double(calls) * BUFFER_SIZE, seconds);
+}
+#endif
+
+int main(int argc, char* argv[])
+{
+	double duration = 0.5;
+	bool success = true;
+
+	if(argc > 1)
+		duration = std::atof(argv[1]);
+
+	std::cout << "Supported SIMD level: " << levelName(SIMD::getSupportedLevel()) << std::endl;
+
+	for(Channels channels : {CHANNELS_MONO, CHANNELS_STEREO, CHANNELS_SURROUND51})
+		benchmarkMixer(channels, 64, duration);
+
+	benchmarkConverters(duration);
+
+	for(Channels channels : {CHANNELS_STEREO, CHANNELS_SURROUND51})
+	{
+		benchmarkDeinterleave(FORMAT_FLOAT32, convert_copy<float>, convert_planar_float_float, channels, duration);
+		benchmarkDeinterleave(FORMAT_S16, convert_s16_float, convert_planar_s16_float, channels, duration);
+	}
+
+	PluginManager::loadPlugins("");
+
+	benchmarkDecode("aac fltp", CODEC_AAC, FORMAT_FLOAT32, duration);
+	benchmarkDecode("opus fltp", CODEC_OPUS, FORMAT_FLOAT32, duration);
+	benchmarkDecode("vorbis fltp", CODEC_VORBIS, FORMAT_FLOAT32, duration);
+	benchmarkDecode("pcm s16", CODEC_PCM, FORMAT_S16, duration);
+
+	for(Channels source : {CHANNELS_MONO, CHANNELS_STEREO, CHANNELS_SURROUND51, CHANNELS_SURROUND71})
+	{
+		for(Channels target : {CHANNELS_MONO, CHANNELS_STEREO, CHANNELS_SURROUND51, CHANNELS_SURROUND71})
+		{
+			if(source != target)
+				benchmarkChannelMapper(source, target, duration);
+		}
+	}
+
+	for(Channels channels : {CHANNELS_MONO, CHANNELS_STEREO, CHANNELS_SURROUND51})
+		benchmarkLinearResampler(channels, duration);
+
+	for(Channels channels : {CHANNELS_MONO, CHANNELS_STEREO, CHANNELS_SURROUND51, CHANNELS_SURROUND71})
+		benchmarkIIRFilter(channels, duration);
+
+#ifdef WITH_CONVOLUTION
+	for(int partitions : {1, 16, 256})
+		benchmarkMultiplyAdd(partitions, 2049, duration);
+
+	for(int irSeconds : {1, 5, 10})
+		benchmarkConvolution(irSeconds, duration);
+
+	for(int sources : {8, 64})
+		benchmarkBinaural(sources, duration);
+#endif
+
+	for(ResampleQuality quality : {ResampleQuality::LOW, ResampleQuality::MEDIUM})
+	{
+		for(Channels channels : {CHANNELS_MONO, CHANNELS_STEREO, CHANNELS_SURROUND51})
+		{
+			benchmarkResampler(quality, channels, false, duration);
+			benchmarkResampler(quality, channels, true, duration);
+		}
+	}
+
+	for(unsigned int threads : {1, 4})
+		success = benchmarkPlayback(4, threads, duration) && success;
+
+	benchmarkVirtualization(1000, 32, duration);
+
+	success = checkVirtualFile() && success;
+
+	benchmarkSpatialization(1000, duration);
+
+	return success ? 0 : 1;
+}
@@ -64,6 +64,9 @@ int main(int argc, char* argv[])
 		return 2;
 	}
 
+	// the source moves continuously
+	hrtfs->setInterpolation(true);
+
 	DeviceSpecs specs;
 	specs.channels = CHANNELS_MONO;
 	specs.rate = hrtfs->getSpecs().rate;
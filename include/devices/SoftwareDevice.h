@@ -28,9 +28,13 @@
 #include "devices/I3DHandle.h"
 #include "devices/DefaultSynchronizer.h"
 #include "util/Buffer.h"
+#include "util/LockFreeQueue.h"
 
+#include <atomic>
 #include <list>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 AUD_NAMESPACE_BEGIN
 
@@ -38,6 +42,8 @@ class Mixer;
 class PitchReader;
 class ResampleReader;
 class ChannelMapperReader;
+class Barrier;
+class PrefetchThread;
 
 /**
  * The software device is a generic device with software mixing.
@@ -51,8 +57,120 @@ class ChannelMapperReader;
 class AUD_API SoftwareDevice : public IDevice, public I3DDevice
 {
 protected:
+	class SoftwareHandle;
+
+	/// A list of handles linked through their m_prev and m_next members.
+	struct SoundList
+	{
+		/// The first handle in the list.
+		SoftwareHandle* first;
+
+		/// The last handle in the list.
+		SoftwareHandle* last;
+
+		/// The number of handles in the list.
+		int size;
+
+		/// Creates an empty list.
+		SoundList();
+
+		/**
+		 * Returns whether the list is empty.
+		 * \return Whether there are no handles in the list.
+		 */
+		bool empty() const;
+
+		/**
+		 * Returns whether a handle is in this list.
+		 * \param sound The handle to look for.
+		 * \return Whether the handle is in the list.
+		 */
+		bool contains(SoftwareHandle* sound) const;
+
+		/**
+		 * Appends a handle that is in no list.
+		 * \param sound The handle to append.
+		 */
+		void push_back(SoftwareHandle* sound);
+
+		/**
+		 * Removes a handle from the list.
+		 * \param sound The handle to remove, it has to be in the list.
+		 */
+		void remove(SoftwareHandle* sound);
+	};
+
+	/// The changes of a handle that can be queued for the mixing thread.
+	enum CommandType
+	{
+		COMMAND_PLAY,
+		COMMAND_PAUSE,
+		COMMAND_RESUME,
+		COMMAND_STOP,
+		COMMAND_KEEP,
+		COMMAND_SEEK,
+		COMMAND_VOLUME,
+		COMMAND_PITCH,
+		COMMAND_PANNING,
+		COMMAND_LOOP_COUNT,
+		COMMAND_STOP_CALLBACK,
+		COMMAND_LOCATION,
+		COMMAND_VELOCITY,
+		COMMAND_ORIENTATION,
+		COMMAND_RELATIVE,
+		COMMAND_VOLUME_MAXIMUM,
+		COMMAND_VOLUME_MINIMUM,
+		COMMAND_DISTANCE_MAXIMUM,
+		COMMAND_DISTANCE_REFERENCE,
+		COMMAND_ATTENUATION,
+		COMMAND_CONE_ANGLE_OUTER,
+		COMMAND_CONE_ANGLE_INNER,
+		COMMAND_CONE_VOLUME_OUTER,
+		COMMAND_PRIORITY
+	};
+
+	/// A change of a handle, only the members used by the type are set.
+	struct HandleCommand
+	{
+		/// The handle to change.
+		std::shared_ptr<SoftwareHandle> handle;
+
+		/// The type of the change.
+		CommandType type;
+
+		/// Value for float parameters.
+		float value;
+
+		/// Value for boolean parameters.
+		bool flag;
+
+		/// Value for integer parameters.
+		int count;
+
+		/// Value for the seek position.
+		double position;
+
+		/// Value for vector parameters.
+		Vector3 vector;
+
+		/// Value for the orientation.
+		Quaternion quaternion;
+
+		/// Value for the stop callback.
+		stopCallback callback;
+
+		/// Value for the stop callback data.
+		void* data;
+
+		/**
+		 * Creates a new command.
+		 * \param type The type of the change.
+		 */
+		HandleCommand(CommandType type = COMMAND_PLAY);
+	};
+
 	/// Saves the data for playback.
-	class AUD_API SoftwareHandle : public IHandle, public I3DHandle
+	class AUD_API SoftwareHandle : public IHandle, public I3DHandle, public std::enable_shared_from_this<SoftwareHandle>
 	{
 	private:
 		// delete copy constructor and operator=
@@ -72,6 +190,18 @@ protected:
 		/// The channel mapper reader in between.
 		std::shared_ptr<ChannelMapperReader> m_mapper;
 
+		/// The quality of the resample reader.
+		ResampleQuality m_quality;
+
+		/// The list of playing or paused sounds the handle is in.
+		SoundList* m_list;
+
+		/// The previous handle in the list of playing or paused sounds.
+		SoftwareHandle* m_prev;
+
+		/// The next handle in the list of playing or paused sounds.
+		SoftwareHandle* m_next;
+
 		/// Whether the source is being read for the first time.
 		bool m_first_reading;
 
@@ -142,11 +272,29 @@ protected:
 		void* m_stop_data;
 
 		/// Current status of the handle
-		Status m_status;
+		std::atomic<Status> m_status;
 
 		/// Own device.
 		SoftwareDevice* m_device;
 
+		/// The playback position in samples as of the last mixing call, only used when queuing commands.
+		std::atomic<int> m_position;
+
+		/// The priority when limiting the number of real voices, higher priorities are rendered first.
+		int m_priority;
+
+		/// Whether the sound is virtual, its position advances but it is neither read nor mixed.
+		std::atomic<bool> m_virtual;
+
+		/// The position of a virtual sound in samples of the source.
+		double m_virtual_position;
+
+		/// The length of the source in samples when it started playing, as readers of files report their remaining length.
+		int m_source_length;
+
+		/// Whether the sound was mixed as a real sound in the last mixing call.
+		bool m_rendered;
+
 		/**
 		 * This method is for internal use only.
 		 * @param keep Whether the sound should be marked stopped or paused.
@@ -154,17 +302,70 @@ protected:
 		 */
 		bool pause(bool keep);
 
+		/**
+		 * Stops the handle and removes it from the device immediately.
+		 * The source reader is released, afterwards the device can reuse
+		 * the handle for another sound once nobody else references it.
+		 * This method is for internal use only.
+		 * @return Whether the action succeeded.
+		 */
+		bool invalidate();
+
+		/**
+		 * Resets the playback parameters to their defaults.
+		 * This method is for internal use only.
+		 * @param keep Whether to keep the handle when the sound ends.
+		 */
+		void reset(bool keep);
+
+		/**
+		 * Retrieves the playback position in samples of the device rate,
+		 * also while the sound is virtual.
+		 * This method is for internal use only.
+		 * @return The playback position.
+		 */
+		int getSamplePosition();
+
+		/**
+		 * Sets the virtual position to the position the readers are at.
+		 * This method is for internal use only.
+		 */
+		void updateVirtualPosition();
+
+		/**
+		 * Advances the position of a virtual sound including its loops.
+		 * This method is for internal use only.
+		 * @param length The number of samples of the device rate to advance.
+		 * @return Whether the end of the sound has been reached.
+		 */
+		bool advance(int length);
+
+		/**
+		 * Applies a change to the handle immediately.
+		 * This method is for internal use only.
+		 * @param command The change to apply.
+		 * @return Whether the action succeeded.
+		 */
+		bool apply(const HandleCommand& command);
+
+		/**
+		 * Applies a change to the handle or queues it for the mixing thread
+		 * depending on whether the device queues commands.
+		 * @param command The change to execute.
+		 * @return Whether the action succeeded or could be queued.
+		 */
+		bool execute(HandleCommand& command);
+
 	public:
 		/**
-		 * Creates a new software handle.
+		 * Creates a new software handle, it is invalid until reset.
 		 * \param device The device this handle is from.
-		 * \param reader The reader to play.
-		 * \param pitch The pitch reader.
-		 * \param resampler The resampling reader.
-		 * \param mapper The channel mapping reader.
-		 * \param keep Whether to keep the handle when the sound ends.
+		 * \param pitch The pitch reader reading the source.
+		 * \param resampler The resampling reader reading the pitch reader.
+		 * \param mapper The channel mapping reader reading the resampler.
+		 * \param quality The quality of the resampling reader.
 		 */
-		SoftwareHandle(SoftwareDevice* device, std::shared_ptr<IReader> reader, std::shared_ptr<PitchReader> pitch, std::shared_ptr<ResampleReader> resampler, std::shared_ptr<ChannelMapperReader> mapper, bool keep);
+		SoftwareHandle(SoftwareDevice* device, std::shared_ptr<PitchReader> pitch, std::shared_ptr<ResampleReader> resampler, std::shared_ptr<ChannelMapperReader> mapper, ResampleQuality quality);
 
 		/**
 		 * Updates the handle's playback parameters.
@@ -286,17 +487,37 @@ private:
 	/**
 	 * The list of sounds that are currently playing.
 	 */
-	std::list<std::shared_ptr<SoftwareHandle> > m_playingSounds;
+	SoundList m_playingSounds;
 
 	/**
 	 * The list of sounds that are currently paused.
 	 */
-	std::list<std::shared_ptr<SoftwareHandle> > m_pausedSounds;
+	SoundList m_pausedSounds;
+
+	/**
+	 * All handles of the device including the ones that can be reused.
+	 */
+	std::vector<std::shared_ptr<SoftwareHandle> > m_voices;
+
+	/**
+	 * The index in m_voices to start looking for a reusable handle.
+	 */
+	int m_voiceCursor;
+
+	/**
+	 * Serializes the threads taking handles from m_voices.
+	 */
+	std::mutex m_voiceMutex;
+
+	/**
+	 * How often memory had to be allocated for handles or mixing.
+	 */
+	std::atomic<long long> m_allocations;
 
 	/**
 	 * Whether there is currently playback.
 	 */
-	bool m_playback;
+	std::atomic<bool> m_playback;
 
 	/**
 	 * The mutex for locking.
@@ -332,10 +553,173 @@ private:
 	/// Synchronizer.
 	DefaultSynchronizer m_synchronizer;
 
+	/// The number of threads rendering the playing sounds.
+	unsigned int m_threadCount;
+
+	/// The worker threads for parallel rendering, the mixing thread renders the first range itself.
+	std::vector<std::thread> m_threads;
+
+	/// The mixers accumulating the sounds of each worker thread.
+	std::vector<std::shared_ptr<Mixer> > m_threadMixers;
+
+	/// The reading buffers of each worker thread.
+	std::vector<std::shared_ptr<Buffer> > m_threadBuffers;
+
+	/// Releases the worker threads to render, the mixing thread takes part in it.
+	std::shared_ptr<Barrier> m_renderStart;
+
+	/// Waits for the worker threads to finish rendering.
+	std::shared_ptr<Barrier> m_renderEnd;
+
+	/// The number of threads rendering during the current mixing call.
+	int m_renderThreads;
+
+	/// The number of sounds rendered during the current mixing call.
+	int m_renderCount;
+
+	/// The length in samples rendered during the current mixing call.
+	int m_renderLength;
+
+	/// Whether the worker threads have to exit.
+	bool m_renderStop;
+
+	/// Whether handle changes are queued for the mixing thread instead of locking the device.
+	std::atomic<bool> m_queueCommands;
+
+	/// The queued handle changes, created when queuing is enabled for the first time.
+	std::shared_ptr<LockFreeQueue<HandleCommand> > m_commands;
+
+	/// Serializes the threads queuing commands.
+	std::mutex m_commandMutex;
+
+	/// The sounds rendered during the current mixing call.
+	std::vector<SoftwareHandle*> m_renderSounds;
+
+	/// Whether the sounds rendered during the current mixing call reached their end.
+	std::vector<char> m_renderEnded;
+
+	/// The maximum number of sounds rendered at once, 0 for no limit.
+	int m_maximumRealVoices;
+
+	/// The volume below which sounds become virtual.
+	float m_audibilityThreshold;
+
+	/// The sounds to pause after the current mixing call.
+	std::vector<SoftwareHandle*> m_pauseSounds;
+
+	/// The sounds to stop after the current mixing call.
+	std::vector<SoftwareHandle*> m_stopSounds;
+
+	/// Whether the 3D parameters of all sounds are updated at once.
+	bool m_batchUpdate;
+
+	/// The thread decoding file sounds ahead, nullptr if prefetching is disabled.
+	std::shared_ptr<PrefetchThread> m_prefetchThread;
+
+	/// The underruns of all readers decoding ahead for the device.
+	std::shared_ptr<std::atomic<long long> > m_prefetchUnderruns;
+
+	/// The mono sounds of the current batched 3D update.
+	std::vector<SoftwareHandle*> m_spatialSounds;
+
+	/// The parameter arrays of the batched 3D update.
+	Buffer m_spatialBuffer;
+
 	// delete copy constructor and operator=
 	SoftwareDevice(const SoftwareDevice&) = delete;
 	SoftwareDevice& operator=(const SoftwareDevice&) = delete;
 
+	/**
+	 * Reads a playing sound including its loops and mixes it.
+	 * \param sound The sound to render.
+	 * \param mixer The mixer to mix the sound into.
+	 * \param buffer The reading buffer, it has to be big enough for length samples.
+	 * \param length The length in samples to be rendered.
+	 * \return Whether the end of the sound has been reached.
+	 */
+	bool AUD_LOCAL renderSound(SoftwareHandle* sound, Mixer& mixer, sample_t* buffer, int length);
+
+	/**
+	 * Renders a range of the sounds in m_renderSounds.
+	 * \param mixer The mixer to mix the sounds into.
+	 * \param buffer The reading buffer, it has to be big enough for length samples.
+	 * \param length The length in samples to be rendered.
+	 * \param begin The index of the first sound to render.
+	 * \param end The index after the last sound to render.
+	 */
+	void AUD_LOCAL renderSounds(Mixer* mixer, sample_t* buffer, int length, int begin, int end);
+
+	/**
+	 * The function of a worker thread, which renders its range of the sounds
+	 * whenever the mixing thread lifts the start barrier.
+	 * \param index The index of the thread, starting at 1.
+	 */
+	void AUD_LOCAL renderThread(int index);
+
+	/**
+	 * Stops and joins the worker threads.
+	 */
+	void AUD_LOCAL stopThreads();
+
+	/**
+	 * Decides which of the sounds in m_renderSounds are rendered.
+	 * The rendered sounds are moved to the front, the others are made
+	 * virtual and advanced.
+	 * \param length The length in samples to be rendered.
+	 * \return The number of sounds to render.
+	 */
+	int AUD_LOCAL virtualizeSounds(int length);
+
+	/**
+	 * Makes sure the vectors used while mixing can hold all playing sounds.
+	 * \param count The number of playing sounds.
+	 */
+	void AUD_LOCAL reserveMixing(int count);
+
+	/**
+	 * Updates the 3D parameters of all sounds in m_renderSounds at once.
+	 */
+	void AUD_LOCAL updateSounds();
+
+	/**
+	 * Creates a resampling reader of the current quality.
+	 * Except for the fastest quality this is a PolyphaseResampleReader, which
+	 * filters with phase tables prepared for the source rate when a sound is
+	 * played, as long as the pitch is 1 and there is no doppler effect.
+	 * \param reader The reader to resample.
+	 * \return The resampling reader.
+	 */
+	std::shared_ptr<ResampleReader> AUD_LOCAL createResampler(std::shared_ptr<IReader> reader);
+
+	/**
+	 * Creates a new invalid handle with its reader chain and adds it to m_voices.
+	 * m_voiceMutex has to be locked.
+	 * \return The new handle.
+	 */
+	std::shared_ptr<SoftwareHandle> AUD_LOCAL createVoice();
+
+	/**
+	 * Takes a reusable handle or creates one and prepares it to play a reader.
+	 * \param reader The reader to play.
+	 * \param keep Whether to keep the handle when the sound ends.
+	 * \return The playing handle, not yet added to the playing sounds.
+	 */
+	std::shared_ptr<SoftwareHandle> AUD_LOCAL acquireVoice(std::shared_ptr<IReader> reader, bool keep);
+
+	/**
+	 * Queues a handle change for the mixing thread.
+	 * If the queue is full or the device is not playing back the queued
+	 * changes are applied immediately with the device locked.
+	 * \param command The change to queue.
+	 * \return Whether the change could be queued or succeeded.
+	 */
+	bool AUD_LOCAL queueCommand(HandleCommand& command);
+
+	/**
+	 * Applies all queued handle changes, the device has to be locked.
+	 */
+	void AUD_LOCAL applyCommands();
+
 public:
 
 	/**
@@ -345,12 +729,163 @@ public:
 	 */
 	static void setPanning(IHandle* handle, float pan);
 
+	/**
+	 * Sets the priority of a specific handle.
+	 * When more sounds are audible than the maximum number of real voices,
+	 * the sounds with the higher priority and then the louder ones are
+	 * rendered while the others become virtual.
+	 * \param handle The handle to set the priority from.
+	 * \param priority The new priority, the default is 0.
+	 */
+	static void setPriority(IHandle* handle, int priority);
+
+	/**
+	 * Retrieves the priority of a specific handle.
+	 * \param handle The handle to get the priority from.
+	 * \return The priority.
+	 */
+	static int getPriority(IHandle* handle);
+
+	/**
+	 * Retrieves whether a specific handle is virtual.
+	 * \param handle The handle to check.
+	 * \return Whether the sound was virtual in the last mixing call.
+	 */
+	static bool isVirtual(IHandle* handle);
+
 	/**
 	 * Sets the resampling quality.
 	 * \param quality Resampling quality vs performance setting.
 	 */
 	void setQuality(ResampleQuality quality);
 
+	/**
+	 * Sets the number of threads rendering the playing sounds.
+	 * With more than one thread the reader chains of the playing sounds are
+	 * read in parallel, each thread rendering a contiguous range of the
+	 * sounds into its own buffer. The buffers are then added up in a fixed
+	 * order, so the output only depends on the thread count.
+	 * \param count The number of threads, 0 and 1 render serially in the mixing thread.
+	 * \warning In parallel mode the readers of different handles must not
+	 *          share state that is not thread safe.
+	 */
+	void setThreadCount(unsigned int count);
+
+	/**
+	 * Retrieves the number of threads rendering the playing sounds.
+	 * \return The thread count.
+	 */
+	unsigned int getThreadCount() const;
+
+	/**
+	 * Sets whether handle changes are queued for the mixing thread.
+	 * By default the handles change their state directly and lock the
+	 * device for changes of the playback state, which contends with the
+	 * mixing thread. When queuing, play() and all setters of the handles
+	 * push their changes into a lock free queue that is applied at the start
+	 * of the next mixing call, so only the mixing thread changes the list of
+	 * playing sounds. The getters and return values of the handles then
+	 * reflect the state as of the last mixing call, for example the status
+	 * is still STATUS_PLAYING right after pausing.
+	 * \param queue Whether to queue handle changes.
+	 */
+	void setCommandQueueEnabled(bool queue);
+
+	/**
+	 * Retrieves whether handle changes are queued for the mixing thread.
+	 * \return Whether handle changes are queued.
+	 */
+	bool isCommandQueueEnabled() const;
+
+	/**
+	 * Sets the maximum number of sounds that are rendered at once.
+	 * Audible sounds exceeding the maximum become virtual: their position
+	 * keeps advancing, but they are neither read nor mixed until they are
+	 * among the sounds with the highest priority and volume again. Sounds
+	 * fade out when they become virtual and fade in when they become real.
+	 * Sounds that are not seekable are never virtual.
+	 * \param count The maximum number of real voices, 0 for no limit.
+	 */
+	void setMaximumRealVoices(int count);
+
+	/**
+	 * Retrieves the maximum number of sounds that are rendered at once.
+	 * \return The maximum number of real voices, 0 if there is no limit.
+	 */
+	int getMaximumRealVoices() const;
+
+	/**
+	 * Sets the volume below which sounds become virtual.
+	 * The volume of a sound includes the distance attenuation and the cone
+	 * of 3D sounds, but not the volume of the device.
+	 * \param threshold The audibility threshold, 0 never makes sounds virtual.
+	 */
+	void setAudibilityThreshold(float threshold);
+
+	/**
+	 * Retrieves the volume below which sounds become virtual.
+	 * \return The audibility threshold.
+	 */
+	float getAudibilityThreshold() const;
+
+	/**
+	 * Sets whether the 3D parameters of all playing sounds are calculated
+	 * at once with vector instructions instead of sound by sound.
+	 * Both ways give the same result up to floating point rounding.
+	 * \param enabled Whether to update all sounds at once, the default.
+	 */
+	void setBatchUpdateEnabled(bool enabled);
+
+	/**
+	 * Retrieves whether the 3D parameters of all playing sounds are calculated at once.
+	 * \return Whether the batched update is enabled.
+	 */
+	bool isBatchUpdateEnabled() const;
+
+	/**
+	 * Sets whether file sounds are decoded ahead on a background thread.
+	 * When enabled, play() wraps the readers of File sounds in a
+	 * PrefetchReader, so that reading and decoding the file doesn't happen in
+	 * the mixing thread. Sounds that are already playing and readers passed
+	 * to play() directly are not affected.
+	 * \param enabled Whether to decode file sounds ahead.
+	 */
+	void setPrefetchEnabled(bool enabled);
+
+	/**
+	 * Retrieves whether file sounds are decoded ahead on a background thread.
+	 * \return Whether prefetching is enabled.
+	 */
+	bool isPrefetchEnabled() const;
+
+	/**
+	 * Retrieves how often file sounds decoded ahead ran out of samples, so
+	 * that silence was played instead.
+	 * \return The number of underruns since the device was created.
+	 */
+	long long getPrefetchUnderrunCount() const;
+
+	/**
+	 * Preallocates handles and mixing memory for playing sounds.
+	 * play() reuses the handles of sounds that were stopped and are not
+	 * referenced anymore including their reader chains, so after reserving
+	 * enough handles playing and mixing sounds does not allocate memory in
+	 * the device, also in parallel mode. The readers passed to play() are not
+	 * managed by the device.
+	 * \param count The number of sounds that can play at the same time without allocating.
+	 */
+	void reserveVoices(int count);
+
+	/**
+	 * Retrieves how often the device had to allocate memory for handles,
+	 * reader chains or mixing, for example to verify that playback in a
+	 * steady state is allocation free. Only the allocations of the device
+	 * itself are counted, not those of the readers it plays, so this doesn't
+	 * replace a check of all allocations like the one in audabench.
+	 * \return The number of allocations since the device was created.
+	 */
+	long long getAllocationCount() const;
+
 	virtual DeviceSpecs getSpecs() const;
 	virtual std::shared_ptr<IHandle> play(std::shared_ptr<IReader> reader, bool keep = false);
 	virtual std::shared_ptr<IHandle> play(std::shared_ptr<ISound> sound, bool keep = false);
@@ -24,6 +24,7 @@
 
 #include "ISound.h"
 #include "FileInfo.h"
+#include "IWriter.h"
 
 #include <string>
 #include <memory>
@@ -58,6 +59,16 @@ private:
 	 */
 	int m_stream;
 
+	/**
+	 * The container format of the buffer if known, which saves probing it.
+	 */
+	Container m_container;
+
+	/**
+	 * The codec of the audio stream in the buffer if known.
+	 */
+	Codec m_codec;
+
 	// delete copy constructor and operator=
 	File(const File&) = delete;
 	File& operator=(const File&) = delete;
@@ -73,13 +84,33 @@ public:
 
 	/**
 	 * Creates a new sound.
-	 * The file is read from memory using the supplied buffer.
+	 * The file is read from memory using the supplied buffer, which is copied.
 	 * \param buffer The buffer to read from.
 	 * \param size The size of the buffer.
 	 * \param stream The index of the audio stream within the file if it contains multiple audio streams.
 	 */
 	File(const data_t* buffer, int size, int stream = 0);
 
+	/**
+	 * Creates a new sound.
+	 * The file is read from the given buffer without copying it, for example
+	 * from a mapping returned by FileManager::mapFile.
+	 * \param buffer The buffer to read from.
+	 * \param stream The index of the audio stream within the file if it contains multiple audio streams.
+	 */
+	File(std::shared_ptr<Buffer> buffer, int stream = 0);
+
+	/**
+	 * Creates a new sound.
+	 * The file is read from the given buffer without copying it and the file
+	 * inputs are told its format, so that they don't have to probe it.
+	 * \param buffer The buffer to read from.
+	 * \param container The container format of the file.
+	 * \param codec The codec of the audio stream, CODEC_INVALID if unknown.
+	 * \param stream The index of the audio stream within the file if it contains multiple audio streams.
+	 */
+	File(std::shared_ptr<Buffer> buffer, Container container, Codec codec, int stream = 0);
+
 	/**
 	 * Queries the streams of the file.
 	 * \return A vector with as many streams as there are in the file.
@@ -27,6 +27,7 @@
 #include "IWriter.h"
 
 #include <list>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -46,6 +47,7 @@ class AUD_API FileManager
 private:
 	static std::list<std::shared_ptr<IFileInput>>& inputs();
 	static std::list<std::shared_ptr<IFileOutput>>& outputs();
+	static std::map<std::string, std::weak_ptr<Buffer>>& mappings();
 
 	// delete copy constructor and operator=
 	FileManager(const FileManager&) = delete;
@@ -83,6 +85,31 @@ public:
 	 */
 	static std::shared_ptr<IReader> createReader(std::shared_ptr<Buffer> buffer, int stream = 0);
 
+	/**
+	 * Creates a file reader for the given buffer with a hint of its format,
+	 * which lets the file inputs skip probing it. If no file input can read the
+	 * file with the hint, the file is probed as usual.
+	 * @param buffer The buffer to read the file from.
+	 * @param container The container format of the file, CONTAINER_INVALID if unknown.
+	 * @param codec The codec of the audio stream, CODEC_INVALID if unknown.
+	 * @param stream The index of the audio stream within the file if it contains multiple audio streams.
+	 * @return The reader created.
+	 * @exception Exception If no file input can read the file an exception is thrown.
+	 */
+	static std::shared_ptr<IReader> createReader(std::shared_ptr<Buffer> buffer, Container container, Codec codec, int stream = 0);
+
+	/**
+	 * Maps a file read-only into memory to read it with createReader.
+	 * While the returned buffer is referenced, mapping the same path again
+	 * returns the same buffer, so all readers of a file share one mapping.
+	 * Reading from the mapping doesn't copy the file into memory and its
+	 * pages can be dropped by the operating system when memory is low.
+	 * @param filename The path to the file.
+	 * @return The buffer mapping the file.
+	 * @exception Exception Thrown if the file cannot be mapped.
+	 */
+	static std::shared_ptr<Buffer> mapFile(const std::string &filename);
+
 	/**
 	 * Queries the streams of a sound file.
 	 * \param filename Path to the file to be read.
@@ -24,6 +24,7 @@
 
 #include "Audaspace.h"
 #include "FileInfo.h"
+#include "IWriter.h"
 
 #include <memory>
 #include <string>
@@ -65,6 +66,19 @@ public:
 	 */
 	virtual std::shared_ptr<IReader> createReader(std::shared_ptr<Buffer> buffer, int stream = 0)=0;
 
+	/**
+	 * Creates a reader for a file to be read from memory whose format is known.
+	 * The hint allows the file input to skip probing the format, inputs that
+	 * don't need it may ignore it.
+	 * \param buffer The in-memory file buffer.
+	 * \param container The container format of the file.
+	 * \param codec The codec of the audio stream, CODEC_INVALID if unknown.
+	 * \param stream The index of the audio stream within the file if it contains multiple audio streams.
+	 * \return The reader that reads the file.
+	 * \exception Exception Thrown if the file specified cannot be read.
+	 */
+	virtual std::shared_ptr<IReader> createReader(std::shared_ptr<Buffer> buffer, Container container, Codec codec, int stream = 0)=0;
+
 	/**
 	 * Queries the streams of a sound file.
 	 * \param filename Path to the file to be read.
@@ -0,0 +1,157 @@
+/*******************************************************************************
+ * Copyright 2009-2016 Jörg Müller
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************/
+
+#pragma once
+
+/**
+ * @file SoundBank.h
+ * @ingroup file
+ * The SoundBank class.
+ */
+
+#include "ISound.h"
+#include "respec/Specification.h"
+#include "file/IWriter.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// The first bytes of a sound bank file.
+#define AUD_SOUNDBANK_MAGIC "AUDBANK1"
+
+/// The alignment of the sound data within a sound bank file in bytes.
+#define AUD_SOUNDBANK_ALIGNMENT 32
+
+AUD_NAMESPACE_BEGIN
+
+class Buffer;
+
+/**
+ * A sound bank packs many sounds into a single file with an index, so that
+ * they can be loaded at once instead of opening and probing every file.
+ *
+ * The file starts with the index: the magic AUD_SOUNDBANK_MAGIC, a 32 bit
+ * byte order mark 0x01020304 and the 32 bit sound count, followed by each
+ * sound's name as 32 bit length and characters, encoding, sample format,
+ * container, codec and channel count as 8, 8, 8, 8 and 16 bit integers, the
+ * rate as double and the offset and size of its data as 64 bit integers. The
+ * container and codec of embedded files are detected when the bank is written
+ * and are invalid if unknown. All values are in the byte
+ * order of the machine that wrote the bank. The data of the sounds follows,
+ * each aligned to AUD_SOUNDBANK_ALIGNMENT bytes.
+ *
+ * The bank is memory mapped and the sounds are created on request, reading
+ * their data straight from the mapping. PCM sounds don't need any probing and
+ * the file inputs are told the format of embedded files, so that they only
+ * probe files of unknown format when their reader is created.
+ * Banks are written with SoundBankWriter.
+ */
+class AUD_API SoundBank
+{
+public:
+	/// How the data of a sound is stored.
+	enum Encoding
+	{
+		/// Interleaved samples of the sound's sample format.
+		ENCODING_PCM = 0,
+
+		/// A sound file read with the file inputs of the FileManager.
+		ENCODING_FILE = 1
+	};
+
+private:
+	/// An entry of the index.
+	struct Entry
+	{
+		/// How the data is stored.
+		Encoding encoding;
+
+		/// The specification of PCM data.
+		DeviceSpecs specs;
+
+		/// The container format of an embedded file.
+		Container container;
+
+		/// The codec of an embedded file.
+		Codec codec;
+
+		/// The offset of the data within the bank.
+		long long offset;
+
+		/// The size of the data in bytes.
+		long long size;
+	};
+
+	/**
+	 * The bank file.
+	 */
+	std::shared_ptr<Buffer> m_buffer;
+
+	/**
+	 * The index of the sounds by name.
+	 */
+	std::map<std::string, Entry> m_entries;
+
+	/**
+	 * Reads the index of the bank.
+	 * \exception Exception Thrown if the buffer isn't a valid sound bank.
+	 */
+	AUD_LOCAL void readIndex();
+
+	// delete copy constructor and operator=
+	SoundBank(const SoundBank&) = delete;
+	SoundBank& operator=(const SoundBank&) = delete;
+
+public:
+	/**
+	 * Opens a sound bank file by mapping it into memory.
+	 * \param filename The path to the sound bank.
+	 * \exception Exception Thrown if the file cannot be mapped or isn't a valid sound bank.
+	 */
+	SoundBank(const std::string& filename);
+
+	/**
+	 * Opens a sound bank in memory.
+	 * \param buffer The buffer containing the sound bank.
+	 * \exception Exception Thrown if the buffer isn't a valid sound bank.
+	 */
+	SoundBank(std::shared_ptr<Buffer> buffer);
+
+	/**
+	 * Retrieves the names of all sounds in the bank.
+	 * \return The sorted names.
+	 */
+	std::vector<std::string> getNames() const;
+
+	/**
+	 * Retrieves whether the bank contains a sound.
+	 * \param name The name of the sound.
+	 * \return Whether there is a sound with this name.
+	 */
+	bool contains(const std::string& name) const;
+
+	/**
+	 * Creates a sound of the bank, which reads from the bank without copying its data.
+	 * \param name The name of the sound.
+	 * \return The sound.
+	 * \exception Exception Thrown if there is no sound with this name.
+	 */
+	std::shared_ptr<ISound> getSound(const std::string& name) const;
+};
+
+AUD_NAMESPACE_END
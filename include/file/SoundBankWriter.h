@@ -0,0 +1,131 @@
+/*******************************************************************************
+ * Copyright 2009-2016 Jörg Müller
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************/
+
+#pragma once
+
+/**
+ * @file SoundBankWriter.h
+ * @ingroup file
+ * The SoundBankWriter class.
+ */
+
+#include "file/SoundBank.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+AUD_NAMESPACE_BEGIN
+
+class Buffer;
+
+/**
+ * This class collects sounds and writes them into a sound bank file, which
+ * is read with SoundBank.
+ */
+class AUD_API SoundBankWriter
+{
+private:
+	/// A sound to write.
+	struct Entry
+	{
+		/// The name of the sound.
+		std::string name;
+
+		/// How the data is stored.
+		SoundBank::Encoding encoding;
+
+		/// The specification of PCM data.
+		DeviceSpecs specs;
+
+		/// The container format of an embedded file.
+		Container container;
+
+		/// The codec of an embedded file.
+		Codec codec;
+
+		/// The data of the sound.
+		std::shared_ptr<Buffer> data;
+	};
+
+	/**
+	 * The sounds to write.
+	 */
+	std::vector<Entry> m_entries;
+
+	/**
+	 * Adds an entry to the bank.
+	 * \param entry The entry.
+	 * \exception Exception Thrown if there is already a sound with the name.
+	 */
+	AUD_LOCAL void add(const Entry& entry);
+
+	/**
+	 * Detects the container format and codec of a sound file from its header.
+	 * \param data The sound file.
+	 * \param[out] container The container format, CONTAINER_INVALID if unknown.
+	 * \param[out] codec The codec, CODEC_INVALID if unknown.
+	 */
+	AUD_LOCAL static void detectFormat(const Buffer& data, Container& container, Codec& codec);
+
+	// delete copy constructor and operator=
+	SoundBankWriter(const SoundBankWriter&) = delete;
+	SoundBankWriter& operator=(const SoundBankWriter&) = delete;
+
+public:
+	/**
+	 * Creates an empty sound bank writer.
+	 */
+	SoundBankWriter();
+
+	/**
+	 * Adds a sound file to the bank as it is. The file stays compressed in
+	 * the bank. Its container format and codec are detected from its header
+	 * and stored in the index, so that the file inputs don't have to probe
+	 * it when it is played. Files of other formats are probed then.
+	 * \param name The name of the sound in the bank.
+	 * \param filename The path of the sound file.
+	 * \exception Exception Thrown if the file cannot be read or the name is used already.
+	 */
+	void addFile(const std::string& name, const std::string& filename);
+
+	/**
+	 * Adds a sound to the bank as PCM samples. The sound is read completely
+	 * and its samples are stored in the given format, so that playing it from
+	 * the bank doesn't need any probing or decoding.
+	 * \param name The name of the sound in the bank.
+	 * \param sound The sound to add.
+	 * \param format The sample format to store the samples in.
+	 * \exception Exception Thrown if the sound cannot be read, the format is
+	 *            invalid or the name is used already.
+	 */
+	void addSound(const std::string& name, std::shared_ptr<ISound> sound, SampleFormat format = FORMAT_S16);
+
+	/**
+	 * Retrieves the number of sounds added.
+	 * \return The number of sounds.
+	 */
+	int getSoundCount() const;
+
+	/**
+	 * Writes the sound bank file.
+	 * \param filename The path of the file to write.
+	 * \exception Exception Thrown if the file cannot be written.
+	 */
+	void write(const std::string& filename) const;
+};
+
+AUD_NAMESPACE_END
@@ -0,0 +1,93 @@
+/*******************************************************************************
+* Copyright 2015-2016 Juan Francisco Crespo Galán
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+******************************************************************************/
+
+
+#pragma once
+
+/**
+* @file Ambisonics.h
+* @ingroup fx
+* The Ambisonics class.
+*/
+
+#include "Audaspace.h"
+#include "util/Math3D.h"
+
+AUD_NAMESPACE_BEGIN
+
+/**
+* This class contains the math of higher order ambisonics up to the third order.
+* The channels are in ACN order with SN3D normalization (AmbiX). Directions are given like for the Source class:
+* the azimuth in degrees clockwise from the front and the elevation in degrees upwards.
+*/
+class AUD_API Ambisonics
+{
+private:
+	// delete copy constructor and operator=
+	Ambisonics(const Ambisonics&) = delete;
+	Ambisonics& operator=(const Ambisonics&) = delete;
+	Ambisonics() = delete;
+
+public:
+	/**
+	* The highest supported order.
+	*/
+	static const int MAX_ORDER = 3;
+
+	/**
+	* Returns the number of channels of an order.
+	* \param order The ambisonics order.
+	* \return The number of channels, (order + 1)^2.
+	*/
+	static int getChannelCount(int order);
+
+	/**
+	* Calculates the encoding gains of a direction.
+	* \param order The ambisonics order.
+	* \param azimuth The azimuth in degrees.
+	* \param elevation The elevation in degrees.
+	* \param gains The gain of each channel.
+	*/
+	static void encode(int order, float azimuth, float elevation, float* gains);
+
+	/**
+	* Calculates the matrix that rotates a sound field into the view of a listener.
+	* \param order The ambisonics order.
+	* \param orientation The orientation of the listener, as for I3DDevice::setListenerOrientation.
+	* \param matrix The channels x channels matrix in row major order.
+	*/
+	static void getRotation(int order, const Quaternion& orientation, float* matrix);
+
+	/**
+	* Calculates a sampling decoder with max-rE weighting for a set of speakers.
+	* \param order The ambisonics order.
+	* \param azimuths The azimuth of each speaker in degrees.
+	* \param elevations The elevation of each speaker in degrees.
+	* \param speakers The number of speakers.
+	* \param matrix The speakers x channels matrix in row major order.
+	*/
+	static void getDecoder(int order, const float* azimuths, const float* elevations, int speakers, float* matrix);
+
+	/**
+	* Calculates evenly spread directions on the sphere for virtual speakers.
+	* \param count The number of directions.
+	* \param azimuths The azimuth of each direction in degrees.
+	* \param elevations The elevation of each direction in degrees.
+	*/
+	static void getVirtualSpeakers(int count, float* azimuths, float* elevations);
+};
+
+AUD_NAMESPACE_END
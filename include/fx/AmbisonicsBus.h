@@ -0,0 +1,148 @@
+/*******************************************************************************
+* Copyright 2015-2016 Juan Francisco Crespo Galán
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+******************************************************************************/
+
+
+#pragma once
+
+/**
+* @file AmbisonicsBus.h
+* @ingroup fx
+* The AmbisonicsBus class.
+*/
+
+#include "ISound.h"
+#include "Source.h"
+#include "respec/Specification.h"
+#include "devices/I3DDevice.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+AUD_NAMESPACE_BEGIN
+
+class HRTF;
+class ImpulseResponse;
+class FFTPlan;
+
+/**
+* This class mixes several mono sounds into a higher order ambisonics sound field, each sound placed at the position of its
+* own source, rotates the sound field into the view of the listener and decodes it to speakers or binaurally.
+* Every sound only costs the encoding into the ambisonics channels, the rotation and decoding are done once for the whole bus.
+* The binaural decoding convolves each ambisonics channel with a filter per ear that combines the HRTFs of a set of
+* virtual speakers, so it needs as many transforms as there are ambisonics channels, independent of the number of sounds.
+* The binaural decoding is only available if the library is built with FFTW.
+*/
+class AUD_API AmbisonicsBus : public ISound
+{
+private:
+	/**
+	* The sounds and their sources.
+	*/
+	std::vector<std::pair<std::shared_ptr<ISound>, std::shared_ptr<Source>>> m_sounds;
+
+	/**
+	* The ambisonics order.
+	*/
+	int m_order;
+
+	/**
+	* The specs of the output.
+	*/
+	Specs m_specs;
+
+	/**
+	* The speakers x channels decoding matrix, empty for binaural decoding.
+	*/
+	std::vector<float> m_decoder;
+
+	/**
+	* The binaural filters for the left (first) and right (second) ear per ambisonics channel.
+	*/
+	std::vector<std::pair<std::shared_ptr<ImpulseResponse>, std::shared_ptr<ImpulseResponse>>> m_filters;
+
+	/**
+	* A shared ponter to an FFT plan, nullptr for speaker decoding.
+	*/
+	std::shared_ptr<FFTPlan> m_plan;
+
+	/**
+	* The device whose listener orientation rotates the sound field.
+	*/
+	std::weak_ptr<I3DDevice> m_listener;
+
+	// delete copy constructor and operator=
+	AmbisonicsBus(const AmbisonicsBus&) = delete;
+	AmbisonicsBus& operator=(const AmbisonicsBus&) = delete;
+
+public:
+	/**
+	* Creates a new AmbisonicsBus that is decoded to speakers.
+	* \param order The ambisonics order, from 1 to 3.
+	* \param specs The rate of the sounds and the speaker layout.
+	* \exception Exception Thrown if the order isn't supported.
+	*/
+	AmbisonicsBus(int order, Specs specs);
+
+#ifdef WITH_CONVOLUTION
+	/**
+	* Creates a new AmbisonicsBus that is decoded binaurally.
+	* \param order The ambisonics order, from 1 to 3.
+	* \param hrtfs The HRTF set of the virtual speakers.
+	* \param plan A shared pointer to a FFTPlan object that will be used for convolution.
+	* \exception Exception Thrown if the order isn't supported or the HRTF set is empty.
+	* \warning The same FFTPlan object must be used to construct both this and the HRTF object provided.
+	*/
+	AmbisonicsBus(int order, std::shared_ptr<HRTF> hrtfs, std::shared_ptr<FFTPlan> plan);
+
+	/**
+	* Creates a new AmbisonicsBus that is decoded binaurally. A default FFT plan will be used.
+	* \param order The ambisonics order, from 1 to 3.
+	* \param hrtfs The HRTF set of the virtual speakers.
+	* \exception Exception Thrown if the order isn't supported or the HRTF set is empty.
+	* \warning To use this constructor no FFTPlan object must have been provided to the hrtfs.
+	*/
+	AmbisonicsBus(int order, std::shared_ptr<HRTF> hrtfs);
+#endif
+
+	virtual std::shared_ptr<IReader> createReader();
+
+	/**
+	* Adds a sound to the bus, it'll only affect newly created readers.
+	* \param sound The sound to add. It must have only one channel and the rate of the bus.
+	* \param source A shared pointer to a Source object that contains the source of the sound.
+	*/
+	void addSound(std::shared_ptr<ISound> sound, std::shared_ptr<Source> source);
+
+	/**
+	* Removes all sounds from the bus, it'll only affect newly created readers.
+	*/
+	void clear();
+
+	/**
+	* Sets the device whose listener orientation rotates the sound field, usually the device the bus is played on.
+	* Without a device the sources are relative to the listener.
+	* \param listener The device, it is only weakly referenced.
+	*/
+	void setListener(std::shared_ptr<I3DDevice> listener);
+
+	/**
+	* Retrieves the ambisonics order.
+	* \return The order.
+	*/
+	int getOrder() const;
+};
+AUD_NAMESPACE_END
@@ -0,0 +1,280 @@
+/*******************************************************************************
+* Copyright 2015-2016 Juan Francisco Crespo Galán
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+******************************************************************************/
+
+
+#pragma once
+
+/**
+* @file AmbisonicsBusReader.h
+* @ingroup fx
+* The AmbisonicsBusReader class.
+*/
+
+#include "IReader.h"
+#include "Source.h"
+#include "devices/I3DDevice.h"
+#include "util/Buffer.h"
+#include "util/SplitSpectrum.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+AUD_NAMESPACE_BEGIN
+
+class ImpulseResponse;
+class FFTPlan;
+
+/**
+* This class represents a reader for an AmbisonicsBus. The sounds are read block by block, encoded into the ambisonics
+* channels with gains that are interpolated over the block, the sound field is rotated into the view of the listener and
+* then decoded to speakers with a matrix or binaurally with one pair of filters per ambisonics channel.
+*/
+class AUD_API AmbisonicsBusReader : public IReader
+{
+private:
+	/**
+	* The state of one sound of the bus.
+	*/
+	struct Voice
+	{
+		/// The reader of the sound.
+		std::shared_ptr<IReader> reader;
+
+		/// The source of the sound.
+		std::shared_ptr<Source> source;
+
+		/// The encoding gains at the end of the last block.
+		std::vector<float> gains;
+
+		/// Whether the reader of the sound has ended.
+		bool eos;
+	};
+
+	/**
+	* The sounds of the bus.
+	*/
+	std::vector<Voice> m_voices;
+
+	/**
+	* The ambisonics order.
+	*/
+	int m_order;
+
+	/**
+	* The number of ambisonics channels.
+	*/
+	int m_channels;
+
+	/**
+	* The specs of the output.
+	*/
+	Specs m_specs;
+
+	/**
+	* The block size.
+	*/
+	int m_blockSize;
+
+	/**
+	* The speakers x channels decoding matrix, empty for binaural decoding.
+	*/
+	std::vector<float> m_decoder;
+
+	/**
+	* The binaural filters for the left (first) and right (second) ear per ambisonics channel.
+	*/
+	std::vector<std::pair<std::shared_ptr<ImpulseResponse>, std::shared_ptr<ImpulseResponse>>> m_filters;
+
+	/**
+	* A shared ponter to an FFT plan, nullptr for speaker decoding.
+	*/
+	std::shared_ptr<FFTPlan> m_plan;
+
+	/**
+	* The device whose listener orientation rotates the sound field.
+	*/
+	std::weak_ptr<I3DDevice> m_listener;
+
+	/**
+	* The listener orientation of the last block.
+	*/
+	Quaternion m_orientation;
+
+	/**
+	* The rotation matrix of the last block and the current one.
+	*/
+	std::vector<float> m_rotation[2];
+
+	/**
+	* The buffer the sounds are read into.
+	*/
+	Buffer m_input;
+
+	/**
+	* The encoding gains of the current block.
+	*/
+	std::vector<float> m_gains;
+
+	/**
+	* The encoded sound field of the current block, one channel after the other.
+	*/
+	Buffer m_field;
+
+	/**
+	* The rotated sound field of the current block.
+	*/
+	Buffer m_rotated;
+
+	/**
+	* The last two blocks of each ambisonics channel for the binaural decoding.
+	*/
+	std::vector<std::unique_ptr<Buffer>> m_history;
+
+	/**
+	* The split spectra of the last blocks of each ambisonics channel, one per filter partition.
+	*/
+	std::vector<std::vector<std::vector<sample_t>>> m_delayLines;
+
+	/**
+	* The position of the newest spectrum in the delay lines.
+	*/
+	int m_head;
+
+	/**
+	* The size of a split spectrum.
+	*/
+	int m_spectrumSize;
+
+	/**
+	* The complex multiply-accumulate kernel.
+	*/
+	SplitSpectrum::multiply_add_f m_multiplyAdd;
+
+	/**
+	* The FFT buffer.
+	*/
+	Buffer m_fft;
+
+	/**
+	* The accumulated spectrum.
+	*/
+	Buffer m_accumulator;
+
+	/**
+	* The spectra to be multiplied for each ear.
+	*/
+	std::vector<const sample_t*> m_spectra[2][2];
+
+	/**
+	* The interleaved output of the last block.
+	*/
+	Buffer m_outBuffer;
+
+	/**
+	* The number of frames in the output buffer.
+	*/
+	int m_outLength;
+
+	/**
+	* The number of frames of the output buffer that have been read.
+	*/
+	int m_outPosition;
+
+	/**
+	* The current position.
+	*/
+	int m_position;
+
+	/**
+	* The number of blocks left until the tail of the filters has been played after all sounds ended.
+	*/
+	int m_tail;
+
+	/**
+	* Whether all sounds and the tail have ended.
+	*/
+	bool m_eos;
+
+	// delete copy constructor and operator=
+	AmbisonicsBusReader(const AmbisonicsBusReader&) = delete;
+	AmbisonicsBusReader& operator=(const AmbisonicsBusReader&) = delete;
+
+public:
+	/**
+	* Creates a new ambisonics bus reader that decodes to speakers.
+	* \param readers The readers of the sounds, which must have only one channel and the rate of the bus, and their sources.
+	* \param order The ambisonics order.
+	* \param specs The specs of the output.
+	* \param decoder The speakers x channels decoding matrix.
+	* \param listener The device whose listener orientation rotates the sound field.
+	* \exception Exception thrown if the specs of a reader aren't valid.
+	*/
+	AmbisonicsBusReader(const std::vector<std::pair<std::shared_ptr<IReader>, std::shared_ptr<Source>>>& readers, int order, Specs specs, const std::vector<float>& decoder, std::weak_ptr<I3DDevice> listener);
+
+#ifdef WITH_CONVOLUTION
+	/**
+	* Creates a new ambisonics bus reader that decodes binaurally.
+	* \param readers The readers of the sounds, which must have only one channel and the rate of the bus, and their sources.
+	* \param order The ambisonics order.
+	* \param specs The specs of the output.
+	* \param filters The binaural filters per ambisonics channel.
+	* \param plan A shared pointer to the FFT plan the filters were processed with.
+	* \param listener The device whose listener orientation rotates the sound field.
+	* \exception Exception thrown if the specs of a reader aren't valid.
+	*/
+	AmbisonicsBusReader(const std::vector<std::pair<std::shared_ptr<IReader>, std::shared_ptr<Source>>>& readers, int order, Specs specs, const std::vector<std::pair<std::shared_ptr<ImpulseResponse>, std::shared_ptr<ImpulseResponse>>>& filters, std::shared_ptr<FFTPlan> plan, std::weak_ptr<I3DDevice> listener);
+#endif
+
+	virtual bool isSeekable() const;
+	virtual void seek(int position);
+	virtual int getLength() const;
+	virtual int getPosition() const;
+	virtual Specs getSpecs() const;
+	virtual void read(int& length, bool& eos, sample_t* buffer);
+
+private:
+	/**
+	* Sets up the state shared by both decodings.
+	* \param readers The readers of the sounds and their sources.
+	*/
+	AUD_LOCAL void initialize(const std::vector<std::pair<std::shared_ptr<IReader>, std::shared_ptr<Source>>>& readers);
+
+	/**
+	* Reads and encodes the next block of all sounds and rotates the sound field.
+	* \return Whether any sound is still playing.
+	*/
+	AUD_LOCAL bool encodeBlock();
+
+	/**
+	* Decodes the rotated sound field to the speakers.
+	*/
+	AUD_LOCAL void decodeSpeakers();
+
+#ifdef WITH_CONVOLUTION
+	/**
+	* Decodes the rotated sound field binaurally.
+	*/
+	AUD_LOCAL void decodeBinaural();
+#endif
+
+	/**
+	* Reads, encodes and decodes the next block.
+	*/
+	AUD_LOCAL void processBlock();
+};
+
+AUD_NAMESPACE_END
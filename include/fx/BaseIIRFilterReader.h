@@ -92,6 +92,15 @@ protected:
 	 */
 	void setLengths(int in, int out);
 
+	/**
+	 * Filters a whole block at once instead of calling filter() per sample.
+	 * \param buffer The interleaved samples to filter in place.
+	 * \param length The number of frames.
+	 * \param channels The channel count.
+	 * \return Whether the block has been filtered, if not filter() is used.
+	 */
+	virtual bool filterBlock(sample_t* buffer, int length, Channels channels);
+
 public:
 	/**
 	 * Retrieves the last input samples.
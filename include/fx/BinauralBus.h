@@ -0,0 +1,101 @@
+/*******************************************************************************
+* Copyright 2015-2016 Juan Francisco Crespo Galán
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+******************************************************************************/
+
+
+#pragma once
+
+/**
+* @file BinauralBus.h
+* @ingroup fx
+* The BinauralBus class.
+*/
+
+#include "ISound.h"
+#include "HRTF.h"
+#include "Source.h"
+#include "util/FFTPlan.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+AUD_NAMESPACE_BEGIN
+
+/**
+* This class mixes several mono sounds into one binaural stereo sound, each sound placed at the position of its own source.
+* Compared to one BinauralSound per sound, every sound is transformed only once per block, the products with the HRTFs of all
+* sounds are accumulated in the frequency domain and only two inverse transforms per block are needed, so additional sounds
+* only cost a complex multiply-accumulate per partition.
+*/
+class AUD_API BinauralBus : public ISound
+{
+private:
+	/**
+	* The sounds and their sources.
+	*/
+	std::vector<std::pair<std::shared_ptr<ISound>, std::shared_ptr<Source>>> m_sounds;
+
+	/**
+	* A pointer to an HRTF object with a collection of impulse responses.
+	*/
+	std::shared_ptr<HRTF> m_hrtfs;
+
+	/**
+	* A shared ponter to an FFT plan.
+	*/
+	std::shared_ptr<FFTPlan> m_plan;
+
+	// delete copy constructor and operator=
+	BinauralBus(const BinauralBus&) = delete;
+	BinauralBus& operator=(const BinauralBus&) = delete;
+
+public:
+	/**
+	* Creates a new BinauralBus.
+	* \param hrtfs The HRTF set that will be used.
+	* \param plan A shared pointer to a FFTPlan object that will be used for convolution.
+	* \warning The same FFTPlan object must be used to construct both this and the HRTF object provided.
+	*/
+	BinauralBus(std::shared_ptr<HRTF> hrtfs, std::shared_ptr<FFTPlan> plan);
+
+	/**
+	* Creates a new BinauralBus. A default FFT plan will be used.
+	* \param hrtfs The HRTF set that will be used.
+	* \warning To use this constructor no FFTPlan object must have been provided to the hrtfs.
+	*/
+	BinauralBus(std::shared_ptr<HRTF> hrtfs);
+
+	virtual std::shared_ptr<IReader> createReader();
+
+	/**
+	* Adds a sound to the bus, it'll only affect newly created readers.
+	* \param sound The sound to add. It must have only one channel and the rate of the HRTFs.
+	* \param source A shared pointer to a Source object that contains the source of the sound.
+	*/
+	void addSound(std::shared_ptr<ISound> sound, std::shared_ptr<Source> source);
+
+	/**
+	* Removes all sounds from the bus, it'll only affect newly created readers.
+	*/
+	void clear();
+
+	/**
+	* Retrieves the HRTF set being used.
+	* \return A shared pointer to the current HRTF object being used.
+	*/
+	std::shared_ptr<HRTF> getHRTFs();
+};
+AUD_NAMESPACE_END
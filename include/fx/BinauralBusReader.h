@@ -0,0 +1,209 @@
+/*******************************************************************************
+* Copyright 2015-2016 Juan Francisco Crespo Galán
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+******************************************************************************/
+
+
+#pragma once
+
+/**
+* @file BinauralBusReader.h
+* @ingroup fx
+* The BinauralBusReader class.
+*/
+
+#include "IReader.h"
+#include "ISound.h"
+#include "HRTF.h"
+#include "Source.h"
+#include "util/Buffer.h"
+#include "util/FFTPlan.h"
+#include "util/SplitSpectrum.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+AUD_NAMESPACE_BEGIN
+
+/**
+* This class represents a reader for a BinauralBus, which mixes several mono sounds into a binaural stereo sound.
+* The input of every sound is transformed once per block and kept in a frequency domain delay line. The products of all
+* delay lines with the HRTFs of their sources are accumulated per ear, which are then transformed back to the time domain.
+*/
+class AUD_API BinauralBusReader : public IReader
+{
+private:
+	/**
+	* The state of one sound of the bus.
+	*/
+	struct Voice
+	{
+		/// The reader of the sound.
+		std::shared_ptr<IReader> reader;
+
+		/// The source of the sound.
+		std::shared_ptr<Source> source;
+
+		/// The azimuth and elevation the source had at the last check.
+		float azimuth, elevation;
+
+		/// The azimuth and elevation of the HRTFs being used.
+		float realAzimuth, realElevation;
+
+		/// The HRTFs for the left (first) and right (second) ear.
+		std::pair<std::shared_ptr<ImpulseResponse>, std::shared_ptr<ImpulseResponse>> hrtfs;
+
+		/// The HRTFs that are faded out in the current block, nullptr if there is no transition.
+		std::pair<std::shared_ptr<ImpulseResponse>, std::shared_ptr<ImpulseResponse>> previous;
+
+		/// The last two input blocks.
+		Buffer input;
+
+		/// The split spectra of the last input blocks, one per HRTF partition.
+		std::vector<std::vector<sample_t>> delayLine;
+
+		/// The position of the newest spectrum in the delay line.
+		int head;
+
+		/// Whether the reader of the sound has ended.
+		bool eos;
+
+		/// The number of blocks left until the tail of the HRTFs has been played after the sound ended.
+		int tail;
+	};
+
+	/**
+	* The sounds of the bus.
+	*/
+	std::vector<std::unique_ptr<Voice>> m_voices;
+
+	/**
+	* A pointer to an HRTF object with a collection of impulse responses.
+	*/
+	std::shared_ptr<HRTF> m_hrtfs;
+
+	/**
+	* A shared ponter to an FFT plan.
+	*/
+	std::shared_ptr<FFTPlan> m_plan;
+
+	/**
+	* The FFT size.
+	*/
+	int m_N;
+
+	/**
+	* The block size, N/2.
+	*/
+	int m_L;
+
+	/**
+	* The size of a split spectrum.
+	*/
+	int m_spectrumSize;
+
+	/**
+	* The complex multiply-accumulate kernel.
+	*/
+	SplitSpectrum::multiply_add_f m_multiplyAdd;
+
+	/**
+	* The FFT buffer.
+	*/
+	Buffer m_fft;
+
+	/**
+	* The accumulated spectra per ear of the steady sounds, the sounds fading in and the sounds fading out.
+	*/
+	Buffer m_accumulators[2][3];
+
+	/**
+	* The spectra to be multiplied for each accumulator.
+	*/
+	std::vector<const sample_t*> m_spectra[2][3][2];
+
+	/**
+	* The time domain signal of each accumulator.
+	*/
+	Buffer m_signals[3];
+
+	/**
+	* The interleaved stereo output of the last block.
+	*/
+	Buffer m_outBuffer;
+
+	/**
+	* The number of frames in the output buffer.
+	*/
+	int m_outLength;
+
+	/**
+	* The number of frames of the output buffer that have been read.
+	*/
+	int m_outPosition;
+
+	/**
+	* The current position.
+	*/
+	int m_position;
+
+	/**
+	* Whether all sounds and their tails have ended.
+	*/
+	bool m_eos;
+
+	// delete copy constructor and operator=
+	BinauralBusReader(const BinauralBusReader&) = delete;
+	BinauralBusReader& operator=(const BinauralBusReader&) = delete;
+
+public:
+	/**
+	* Creates a new binaural bus reader.
+	* \param readers The readers of the sounds, which must have only one channel and the rate of the HRTFs, and their sources.
+	* \param hrtfs The HRTF set that will be used.
+	* \param plan A shared pointer to a FFT plan that will be used for convolution.
+	* \exception Exception thrown if the specs of a reader aren't valid or the HRTF set is empty.
+	*/
+	BinauralBusReader(const std::vector<std::pair<std::shared_ptr<IReader>, std::shared_ptr<Source>>>& readers, std::shared_ptr<HRTF> hrtfs, std::shared_ptr<FFTPlan> plan);
+
+	virtual bool isSeekable() const;
+	virtual void seek(int position);
+	virtual int getLength() const;
+	virtual int getPosition() const;
+	virtual Specs getSpecs() const;
+	virtual void read(int& length, bool& eos, sample_t* buffer);
+
+private:
+	/**
+	* Changes the HRTFs of a voice if its source has moved.
+	* \param voice The voice to check.
+	* \return True if the HRTFs have changed, false otherwise.
+	*/
+	AUD_LOCAL bool checkSource(Voice& voice);
+
+	/**
+	* Grows the delay line of a voice to a number of partitions.
+	* \param voice The voice.
+	* \param parts The number of partitions.
+	*/
+	AUD_LOCAL void assureDelayLine(Voice& voice, int parts);
+
+	/**
+	* Reads, transforms and convolves the next block of all sounds.
+	*/
+	AUD_LOCAL void processBlock();
+};
+
+AUD_NAMESPACE_END
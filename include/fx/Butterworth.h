@@ -26,6 +26,8 @@
 
 AUD_NAMESPACE_BEGIN
 
+class AnimateableProperty;
+
 /**
  * This sound creates a butterworth lowpass filter reader.
  */
@@ -43,6 +45,17 @@ public:
 	 * \param frequency The cutoff frequency.
 	 */
 	Butterworth(std::shared_ptr<ISound> sound, float frequency);
+
+	/**
+	 * Creates a new butterworth sound with an animated cutoff frequency, which
+	 * changes without recreating the reader. Changes are interpolated to
+	 * avoid zipper noise.
+	 * \param sound The input sound.
+	 * \param frequency The cutoff frequency.
+	 * \param fps The frames per second of the animation, the property is
+	 *        read at the position of the filtered stream.
+	 */
+	Butterworth(std::shared_ptr<ISound> sound, std::shared_ptr<AnimateableProperty> frequency, float fps);
 };
 
 AUD_NAMESPACE_END
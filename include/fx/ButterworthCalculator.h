@@ -24,8 +24,12 @@
 
 #include "fx/IDynamicIIRFilterCalculator.h"
 
+#include <memory>
+
 AUD_NAMESPACE_BEGIN
 
+class AnimateableProperty;
+
 /**
  * The ButterworthCalculator class calculates fourth order Butterworth low pass
  * filter coefficients for a dynamic DynamicIIRFilter.
@@ -34,14 +38,33 @@ class AUD_LOCAL ButterworthCalculator : public IDynamicIIRFilterCalculator
 {
 private:
 	/**
-	 * The attack value in seconds.
+	 * The cutoff frequency.
 	 */
 	const float m_frequency;
 
+	/**
+	 * The animated cutoff frequency, nullptr if it's constant.
+	 */
+	std::shared_ptr<AnimateableProperty> m_frequency_property;
+
+	/**
+	 * The frames per second of the animation.
+	 */
+	const float m_fps;
+
 	// delete copy constructor and operator=
 	ButterworthCalculator(const ButterworthCalculator&) = delete;
 	ButterworthCalculator& operator=(const ButterworthCalculator&) = delete;
 
+	/**
+	 * Calculates the coefficients b0, b1, b2, a1 and a2 of the two second
+	 * order sections of the filter.
+	 * \param rate The sample rate.
+	 * \param time The position in the stream in seconds.
+	 * \param[out] sections The ten coefficients.
+	 */
+	void AUD_LOCAL calculate(SampleRate rate, double time, float* sections);
+
 public:
 	/**
 	 * Creates a ButterworthCalculator object.
@@ -49,7 +72,15 @@ public:
 	 */
 	ButterworthCalculator(float frequency);
 
+	/**
+	 * Creates a ButterworthCalculator object with an animated cutoff frequency.
+	 * @param frequency The cutoff frequency.
+	 * @param fps The frames per second of the animation.
+	 */
+	ButterworthCalculator(std::shared_ptr<AnimateableProperty> frequency, float fps);
+
 	virtual void recalculateCoefficients(SampleRate rate, std::vector<float> &b, std::vector<float> &a);
+	virtual bool animateSections(SampleRate rate, double time, std::vector<float> &sections);
 };
 
 AUD_NAMESPACE_END
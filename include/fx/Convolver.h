@@ -58,12 +58,12 @@ private:
 	/**
 	* The impulse response divided in parts.
 	*/
-	std::shared_ptr<std::vector<std::shared_ptr<std::vector<std::complex<sample_t>>>>> m_irBuffers;
+	std::shared_ptr<std::vector<std::shared_ptr<std::vector<sample_t>>>> m_irBuffers;
 
 	/**
 	* Accumulation buffers for the threads.
 	*/
-	std::vector<fftwf_complex*> m_threadAccBuffers;
+	std::vector<sample_t*> m_threadAccBuffers;
 
 	/**
 	* A vector of FFTConvolvers used to calculate the partial convolutions.
@@ -98,12 +98,32 @@ private:
 	/**
 	* Global accumulation buffer.
 	*/
-	fftwf_complex* m_accBuffer;
+	sample_t* m_accBuffer;
 
 	/**
 	* Delay line.
 	*/
-	std::deque<fftwf_complex*> m_delayLine;
+	std::deque<sample_t*> m_delayLine;
+
+	/**
+	* The spectra of the delay line in the order of the impulse response parts, for the threads.
+	*/
+	std::vector<const sample_t*> m_delayParts;
+
+	/**
+	* The spectra of the impulse response parts.
+	*/
+	std::vector<const sample_t*> m_irParts;
+
+	/**
+	* The size of the split spectra.
+	*/
+	int m_spectrumSize;
+
+	/**
+	* The complex multiply-accumulate kernel.
+	*/
+	SplitSpectrum::multiply_add_f m_multiplyAdd;
 
 	/**
 	* The complete length of the impulse response.
@@ -128,12 +148,12 @@ public:
 
 	/**
 	* Creates a new FFTConvolver.
-	* \param ir A shared pointer to a vector with the data of the various impulse response parts in the frequency domain (see ImpulseResponse class for an easy way to obtain it).
+	* \param ir A shared pointer to a vector with the data of the various impulse response parts as split spectra (see ImpulseResponse class for an easy way to obtain it).
 	* \param irLength The length of the full impulse response.
 	* \param threadPool A shared pointer to a ThreadPool object with 1 or more threads.
 	* \param plan A shared pointer to a FFT plan that will be used for convolution.
 	*/
-	Convolver(std::shared_ptr<std::vector<std::shared_ptr<std::vector<std::complex<sample_t>>>>> ir, int irLength, std::shared_ptr<ThreadPool> threadPool, std::shared_ptr<FFTPlan> plan);
+	Convolver(std::shared_ptr<std::vector<std::shared_ptr<std::vector<sample_t>>>> ir, int irLength, std::shared_ptr<ThreadPool> threadPool, std::shared_ptr<FFTPlan> plan);
 
 	virtual ~Convolver();
 
@@ -157,13 +177,13 @@ public:
 	* Retrieves the current impulse response being used.
 	* \return The current impulse response.
 	*/
-	std::shared_ptr<std::vector<std::shared_ptr<std::vector<std::complex<sample_t>>>>> getImpulseResponse();
+	std::shared_ptr<std::vector<std::shared_ptr<std::vector<sample_t>>>> getImpulseResponse();
 
 	/**
 	* Changes the impulse response and resets the convolver.
-	* \param ir A shared pointer to a vector with the data of the various impulse response parts in the frequency domain (see ImpulseResponse class for an easy way to obtain it).
+	* \param ir A shared pointer to a vector with the data of the various impulse response parts as split spectra (see ImpulseResponse class for an easy way to obtain it).
 	*/
-	void setImpulseResponse(std::shared_ptr<std::vector<std::shared_ptr<std::vector<std::complex<sample_t>>>>> ir);
+	void setImpulseResponse(std::shared_ptr<std::vector<std::shared_ptr<std::vector<sample_t>>>> ir);
 
 private:
 
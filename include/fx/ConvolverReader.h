@@ -25,6 +25,7 @@
 #include "IReader.h"
 #include "ISound.h"
 #include "Convolver.h"
+#include "NonUniformConvolver.h"
 #include "ImpulseResponse.h"
 #include "util/FFTPlan.h"
 #include "util/ThreadPool.h"
@@ -76,6 +77,11 @@ private:
 	*/
 	std::vector<std::unique_ptr<Convolver>> m_convolvers;
 
+	/**
+	* The array of non uniform convolvers that will be used instead, one per channel.
+	*/
+	std::vector<std::unique_ptr<NonUniformConvolver>> m_nonUniformConvolvers;
+
 	/**
 	* The output buffer in which the convolved data will be written and from which the reader will read.
 	*/
@@ -155,6 +161,16 @@ public:
 	* \exception Exception thrown if impulse response doesn't match the specs (number fo channels and rate) of the input reader.
 	*/
 	ConvolverReader(std::shared_ptr<IReader> reader, std::shared_ptr<ImpulseResponse> ir, std::shared_ptr<ThreadPool> threadPool, std::shared_ptr<FFTPlan> plan);
+
+	/**
+	* Creates a new convolver reader that uses non uniform partitions, see NonUniformConvolver.
+	* \param reader A reader of the input sound to be assigned to this reader.
+	* \param ir A shared pointer to an impulseResponse object that will be used to convolve the sound.
+	* \param threadPool A shared pointer to a ThreadPool object with 1 or more threads.
+	* \param blockSize The block size of the convolution, which is its latency.
+	* \exception Exception thrown if impulse response doesn't match the specs (number fo channels and rate) of the input reader.
+	*/
+	ConvolverReader(std::shared_ptr<IReader> reader, std::shared_ptr<ImpulseResponse> ir, std::shared_ptr<ThreadPool> threadPool, int blockSize);
 	virtual ~ConvolverReader();
 
 	virtual bool isSeekable() const;
@@ -165,6 +181,11 @@ public:
 	virtual void read(int& length, bool& eos, sample_t* buffer);
 
 private:
+	/**
+	* Checks the impulse response and allocates the buffers once the block size is known.
+	*/
+	void AUD_LOCAL initialize();
+
 	/**
 	* Divides a sound buffer in several buffers, one per channel.
 	* \param buffer The buffer that will be divided.
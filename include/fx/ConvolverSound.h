@@ -58,6 +58,11 @@ private:
 	*/
 	std::shared_ptr<FFTPlan> m_plan;
 
+	/**
+	* The block size of the non uniform convolution, only used if there is no FFT plan.
+	*/
+	int m_blockSize;
+
 	// delete copy constructor and operator=
 	ConvolverSound(const ConvolverSound&) = delete;
 	ConvolverSound& operator=(const ConvolverSound&) = delete;
@@ -82,6 +87,16 @@ public:
 	*/
 	ConvolverSound(std::shared_ptr<ISound> sound, std::shared_ptr<ImpulseResponse> impulseResponse, std::shared_ptr<ThreadPool> threadPool);
 
+	/**
+	* Creates a new ConvolverSound that convolves with non uniform partitions, which keeps the latency at the block size
+	* even for impulse responses of several seconds (see NonUniformConvolver).
+	* \param sound The sound that will be convolved.
+	* \param impulseResponse The impulse response sound, it may have been processed with any FFTPlan.
+	* \param threadPool A shared pointer to a ThreadPool object with 1 or more threads.
+	* \param blockSize The block size of the convolution, for example 256 samples.
+	*/
+	ConvolverSound(std::shared_ptr<ISound> sound, std::shared_ptr<ImpulseResponse> impulseResponse, std::shared_ptr<ThreadPool> threadPool, int blockSize);
+
 	virtual std::shared_ptr<IReader> createReader();
 
 	/**
@@ -31,6 +31,9 @@ class IDynamicIIRFilterCalculator;
 /**
  * This class is for dynamic infinite impulse response filters with simple
  * coefficients that change depending on the sample rate.
+ * If the calculator animates its second order sections, they are recalculated
+ * every few milliseconds and the biquad cascade moves linearly towards them in
+ * small steps, so that parameter sweeps don't cause zipper noise.
  */
 class AUD_API DynamicIIRFilterReader : public IIRFilterReader
 {
@@ -40,6 +43,44 @@ private:
 	 */
 	std::shared_ptr<IDynamicIIRFilterCalculator> m_calculator;
 
+	/**
+	 * Whether the calculator animates the coefficients.
+	 */
+	bool m_animated;
+
+	/**
+	 * Whether the cascade is still moving towards the target coefficients.
+	 */
+	bool m_ramping;
+
+	/**
+	 * The position where the next block continues the animation, it jumps
+	 * to the target coefficients after seeking.
+	 */
+	int m_position;
+
+	/**
+	 * The coefficients the cascade moves towards.
+	 */
+	BiquadCascade m_target;
+
+	/**
+	 * The second order sections of the target.
+	 */
+	std::vector<float> m_target_sections;
+
+	/**
+	 * The second order sections for the next target.
+	 */
+	std::vector<float> m_next_sections;
+
+	// delete copy constructor and operator=
+	DynamicIIRFilterReader(const DynamicIIRFilterReader&) = delete;
+	DynamicIIRFilterReader& operator=(const DynamicIIRFilterReader&) = delete;
+
+protected:
+	virtual bool filterBlock(sample_t* buffer, int length, Channels channels);
+
 public:
 	/**
 	 * Creates a new DynamicIIRFilterReader.
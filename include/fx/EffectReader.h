@@ -57,6 +57,13 @@ public:
 	 */
 	virtual ~EffectReader();
 
+	/**
+	 * Replaces the reader to read from.
+	 * \param reader The new reader to read from.
+	 * \note State the effect keeps about the previous reader is not reset.
+	 */
+	void setReader(std::shared_ptr<IReader> reader);
+
 	virtual bool isSeekable() const;
 	virtual void seek(int position);
 	virtual int getLength() const;
@@ -23,6 +23,7 @@
  */
 
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include "ISound.h"
@@ -32,6 +33,7 @@ AUD_NAMESPACE_BEGIN
 
 class Buffer;
 class ImpulseResponse;
+class ThreadPool;
 /**
  * This class represents a sound that can be modified depending on a given impulse response.
  */
@@ -53,6 +55,36 @@ private:
 	 */
 	std::shared_ptr<ImpulseResponse> m_impulseResponse;
 
+	/**
+	 * The equalizer curve the cached impulse response was created from.
+	 */
+	std::vector<float> m_curve;
+
+	/**
+	 * The sample rate the cached impulse response was created for.
+	 */
+	SampleRate m_rate;
+
+	/**
+	 * The filter length the cached impulse response was created with.
+	 */
+	int m_length;
+
+	/**
+	 * The maximum frequency the cached impulse response was created with.
+	 */
+	float m_maxFreq;
+
+	/**
+	 * A pointer to a thread pool shared by all readers.
+	 */
+	std::shared_ptr<ThreadPool> m_threadPool;
+
+	/**
+	 * Protects the cached impulse response and the thread pool.
+	 */
+	std::mutex m_mutex;
+
 	/**
 	 * delete copy constructor and operator=
 	 */
@@ -62,8 +94,16 @@ private:
 	/**
 	 * Create ImpulseResponse from the definition in the Buffer,
 	 * using at the end a minimum phase change
+	 * \param sampleRate The sample rate of the sound.
+	 */
+	std::shared_ptr<ImpulseResponse> createImpulseResponse(SampleRate sampleRate);
+
+	/**
+	 * Returns the impulse response for a sample rate, which is only created again
+	 * when the equalizer definition or the rate changed since the last call.
+	 * \param sampleRate The sample rate of the sound.
 	 */
-	std::shared_ptr<ImpulseResponse> createImpulseResponse();
+	std::shared_ptr<ImpulseResponse> getImpulseResponse(SampleRate sampleRate);
 
 	/**
 	 * Create an Impulse Response with minimum phase distortion using Homomorphic
@@ -84,6 +124,13 @@ public:
 	 */
 	Equalizer(std::shared_ptr<ISound> sound, std::shared_ptr<Buffer> bufEQ, int externalSizeEq, float maxFreqEq, int sizeConversion);
 
+	/**
+	 * Creates a new Equalizer whose readers share a thread pool.
+	 * \param sound The sound that will be equalized
+	 * \param threadPool A shared pointer to a ThreadPool object with 1 or more threads, if nullptr a pool of two threads is created for this equalizer.
+	 */
+	Equalizer(std::shared_ptr<ISound> sound, std::shared_ptr<Buffer> bufEQ, int externalSizeEq, float maxFreqEq, int sizeConversion, std::shared_ptr<ThreadPool> threadPool);
+
 	virtual ~Equalizer();
 	virtual std::shared_ptr<IReader> createReader();
 
@@ -25,6 +25,7 @@
 #include "IReader.h"
 #include "ISound.h"
 #include "util/FFTPlan.h"
+#include "util/SplitSpectrum.h"
 
 #include <memory>
 #include <vector>
@@ -79,7 +80,12 @@ private:
 	/**
 	* The provided impulse response.
 	*/
-	std::shared_ptr<std::vector<std::complex<sample_t>>> m_irBuffer;
+	std::shared_ptr<std::vector<sample_t>> m_irBuffer;
+
+	/**
+	* The complex multiply-accumulate kernel.
+	*/
+	SplitSpectrum::multiply_add_f m_multiplyAdd;
 
 	/**
 	* If the tail is being read, this marks the current position.
@@ -93,10 +99,10 @@ private:
 public:
 	/**
 	* Creates a new FFTConvolver.
-	* \param ir A shared pointer to a vector with the impulse response data in the frequency domain (see ImpulseResponse class for an easy way to obtain it).
+	* \param ir A shared pointer to a vector with the impulse response data in the frequency domain as split spectrum, scaled by 1/N (see ImpulseResponse class for an easy way to obtain it).
 	* \param plan A shared pointer to and FFT plan.
 	*/
-	FFTConvolver(std::shared_ptr<std::vector<std::complex<sample_t>>> ir, std::shared_ptr<FFTPlan> plan);
+	FFTConvolver(std::shared_ptr<std::vector<sample_t>> ir, std::shared_ptr<FFTPlan> plan);
 	virtual ~FFTConvolver();
 
 	/**
@@ -154,43 +160,50 @@ public:
 
 	/**
 	* Calculates the Inverse Fast Fourier Transform of the input array.
-	* \param[in] inBuffer A buffer with the input data to be transformed. Its length must be N/2 + 1
+	* \param[in] inBuffer A split spectrum of N/2 + 1 bins with the input data to be transformed (see SplitSpectrum).
 	* \param[in] outBuffer A pointer to the buffer in which the transform result will be written. 
 	* \param[in,out] length The number of samples to be transformed and the length of the outBuffer.
 	*						It must be equal or lower than N, but tipically N/2 should be used (N=size of the FFTPlan) or the call will fail and the value 
 	*						of length will be setted to 0, since no data would be written in the outBuffer.
 	*/
-	void IFFT_FDL(const fftwf_complex* inBuffer, sample_t* outBuffer, int& length);
+	void IFFT_FDL(const sample_t* inBuffer, sample_t* outBuffer, int& length);
 
 	/**
 	* Multiplicates a frequency domain input by the impulse response and accumulates the result to a buffer.
-	* \param[in] inBuffer A buffer of complex numbers, samples in the frequency domain, that will be multiplied by the impulse response. Its length must be N/2 + 1
-	* \param[in] accBuffer A pointer to the buffer into which the result of the multiplication will be summed. Its length must be N/2 + 1
+	* \param[in] inBuffer A split spectrum of N/2 + 1 bins that will be multiplied by the impulse response (see SplitSpectrum).
+	* \param[in] accBuffer A split spectrum of N/2 + 1 bins into which the result of the multiplication will be summed.
 	*/
-	void getNextFDL(const std::complex<sample_t>* inBuffer, std::complex<sample_t>* accBuffer);
+	void getNextFDL(const sample_t* inBuffer, sample_t* accBuffer);
 
 	/**
 	* Transforms an input array of real data to the frequency domain and multiplies it by the impulse response. The result is accumulated to a buffer.
 	* \param[in] inBuffer A buffer of real numbers, samples in the time domain, that will be multiplied by the impulse response.
-	* \param[in] accBuffer A pointer to the buffer into which the result of the multiplication will be summed. Its length must be N/2 + 1.
+	* \param[in] accBuffer A split spectrum of N/2 + 1 bins into which the result of the multiplication will be summed.
 	* \param[in,out] length The number of samples to be transformed and the length of the inBuffer.
 	*						It must be equal or lower than N/2 (N=size of the FFTPlan) or the call will fail and the value
 	*						of length will be setted to 0, since no data would be written in the outBuffer.
-	* \param[in] transformedData A pointer to a buffer in which the Fourier transform of the input will be written.
+	* \param[in] transformedData A pointer to a buffer in which the Fourier transform of the input will be written as split spectrum.
 	*/
-	void getNextFDL(const sample_t* inBuffer, std::complex<sample_t>* accBuffer, int& length, fftwf_complex* transformedData);
+	void getNextFDL(const sample_t* inBuffer, sample_t* accBuffer, int& length, sample_t* transformedData);
 
 	/**
 	* Changes the impulse response and resets the FFTConvolver.
-	* \param ir A shared pointer to a vector with the data of the impulse response in the frequency domain.
+	* \param ir A shared pointer to a vector with the data of the impulse response in the frequency domain as split spectrum, scaled by 1/N.
 	*/
-	void setImpulseResponse(std::shared_ptr<std::vector<std::complex<sample_t>>> ir);
+	void setImpulseResponse(std::shared_ptr<std::vector<sample_t>> ir);
 
 	/**
 	* Retrieves the current impulse response being used.
 	* \return The current impulse response.
 	*/
-	std::shared_ptr<std::vector<std::complex<sample_t>>> getImpulseResponse();
+	std::shared_ptr<std::vector<sample_t>> getImpulseResponse();
+
+private:
+	/**
+	* Multiplies an interleaved spectrum by the impulse response.
+	* \param spectrum The spectrum of N/2 + 1 bins.
+	*/
+	void multiply(sample_t* spectrum);
 };
 
 AUD_NAMESPACE_END
@@ -26,9 +26,13 @@
 #include "util/FFTPlan.h"
 #include "ImpulseResponse.h"
 
+#include <condition_variable>
+#include <list>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
-#include <unordered_map>
 #include <utility>
 
 AUD_NAMESPACE_BEGIN
@@ -40,9 +44,37 @@ class AUD_API HRTF
 {
 private:
 	/**
-	* An unordered map of unordered maps containing the ImpulseResponse objects of the HRTFs.
+	* The HRTFs measured at one elevation.
 	*/
-	std::unordered_map<float, std::unordered_map<float, std::shared_ptr<ImpulseResponse>>> m_hrtfs;
+	struct Ring
+	{
+		/// The elevation of the ring.
+		float elevation;
+
+		/// The azimuths of the HRTFs in ascending order.
+		std::vector<float> azimuths;
+
+		/// The ImpulseResponse objects of the HRTFs.
+		std::vector<std::shared_ptr<ImpulseResponse>> hrtfs;
+
+		/// The position of the last azimuth below each degree, -1 if there is none.
+		std::vector<int> index;
+	};
+
+	/**
+	* The rings of HRTFs in ascending order of elevation.
+	*/
+	std::vector<Ring> m_rings;
+
+	/**
+	* The position of the last ring below each degree of elevation, starting at the lowest elevation.
+	*/
+	std::vector<int> m_elevationIndex;
+
+	/**
+	* Whether the HRTFs are interpolated between the measured directions.
+	*/
+	bool m_interpolation;
 
 	/**
 	* The FFTPlan used to create the ImpulseResponses.
@@ -59,10 +91,113 @@ private:
 	*/
 	bool m_empty;
 
+	/**
+	* The directions of the cached HRTFs, the most recently used first.
+	*/
+	std::list<std::pair<float, float>> m_recent;
+
+	/**
+	* The interpolated HRTFs of recently used directions, by azimuth and elevation, with their position in m_recent.
+	*/
+	std::map<std::pair<float, float>, std::pair<std::shared_ptr<ImpulseResponse>, std::list<std::pair<float, float>>::iterator>> m_cache;
+
+	/**
+	* The directions to interpolate in the background, with reserved capacity.
+	*/
+	std::vector<std::pair<float, float>> m_requests;
+
+	/**
+	* Incremented whenever an HRTF is added, so that outdated interpolations are discarded.
+	*/
+	unsigned int m_generation;
+
+	/**
+	* Whether the worker thread should stop.
+	*/
+	bool m_stop;
+
+	/**
+	* Mutex for the cache, the requests and the flags above.
+	*/
+	std::mutex m_cacheMutex;
+
+	/**
+	* Wakes the worker thread up when there are requests.
+	*/
+	std::condition_variable m_condition;
+
+	/**
+	* The thread interpolating the requested directions, started when interpolation is enabled.
+	*/
+	std::thread m_worker;
+
 	// delete copy constructor and operator=
 	HRTF(const HRTF&) = delete;
 	HRTF& operator=(const HRTF&) = delete;
 
+	/**
+	* Finds the ring below an elevation.
+	* \param elevation The elevation.
+	* \return The position of the ring, -1 if the elevation is below all rings.
+	*/
+	AUD_LOCAL int findRing(float elevation) const;
+
+	/**
+	* Finds the HRTF below an azimuth in a ring.
+	* \param ring The ring to search.
+	* \param azimuth The azimuth in the interval [0,360).
+	* \return The position of the HRTF, -1 if the azimuth is below all HRTFs of the ring.
+	*/
+	AUD_LOCAL static int findAzimuth(const Ring& ring, float azimuth);
+
+	/**
+	* Retrieves the HRTF closest to a direction.
+	* \param[in,out] azimuth The desired azimuth, set to the azimuth of the chosen HRTF.
+	* \param[in,out] elevation The desired elevation, set to the elevation of the chosen HRTF.
+	* \return The chosen HRTF.
+	*/
+	AUD_LOCAL std::shared_ptr<ImpulseResponse> getNearest(float& azimuth, float& elevation) const;
+
+	/**
+	* Interpolates the HRTF of a direction between the closest measured HRTFs of the two neighbouring rings.
+	* \param azimuth The azimuth in the interval [0,360).
+	* \param elevation The elevation.
+	* \return The interpolated HRTF.
+	*/
+	AUD_LOCAL std::shared_ptr<ImpulseResponse> getInterpolated(float azimuth, float elevation) const;
+
+	/**
+	* Retrieves the interpolated HRTF of a direction from the cache.
+	* \param azimuth The azimuth in whole degrees in the interval [0,360).
+	* \param elevation The elevation in whole degrees.
+	* \param wait Whether to interpolate a missing HRTF now instead of requesting it from the worker thread.
+	* \return The interpolated HRTF or nullptr if it has been requested.
+	*/
+	AUD_LOCAL std::shared_ptr<ImpulseResponse> getCached(float azimuth, float elevation, bool wait);
+
+	/**
+	* Adds an interpolated HRTF to the cache and evicts the least recently used one if it is full.
+	* m_cacheMutex has to be locked.
+	* \param direction The azimuth and elevation.
+	* \param hrtf The interpolated HRTF.
+	*/
+	AUD_LOCAL void insert(const std::pair<float, float>& direction, std::shared_ptr<ImpulseResponse> hrtf);
+
+	/**
+	* Retrieves a pair of HRTFs, see getImpulseResponse.
+	* \param[in,out] azimuth The desired azimuth, set to the azimuth of the chosen HRTFs.
+	* \param[in,out] elevation The desired elevation, set to the elevation of the chosen HRTFs.
+	* \param wait Whether to interpolate missing HRTFs now.
+	* \param[out] complete Whether the interpolated HRTFs were returned.
+	* \return The HRTFs for the left and right ears.
+	*/
+	AUD_LOCAL std::pair<std::shared_ptr<ImpulseResponse>, std::shared_ptr<ImpulseResponse>> lookup(float& azimuth, float& elevation, bool wait, bool& complete);
+
+	/**
+	* The function of the worker thread, which interpolates the requested directions.
+	*/
+	AUD_LOCAL void work();
+
 public:
 	/**
 	* Creates a new empty HRTF object that will instance it own FFTPlan with default size.
@@ -75,6 +210,11 @@ public:
 	*/
 	HRTF(std::shared_ptr<FFTPlan> plan);
 
+	/**
+	* Destroys the HRTF object and stops its worker thread.
+	*/
+	~HRTF();
+
 	/**
 	* Adds a new HRTF to the class.
 	* \param impulseResponse A shared pointer to an StreamBuffer with the HRTF.
@@ -86,12 +226,37 @@ public:
 
 	/**
 	* Retrieves a pair of HRTFs for a certain azimuth and elevation. If no exact match is found, the closest ones will be chosen (the elevation has priority over the azimuth).
+	* If interpolation is enabled, the HRTFs are interpolated in the frequency domain between up to four measured HRTFs around the direction, which is rounded to whole degrees. The interpolated HRTFs of recently used directions are cached.
 	* \param[in,out] azimuth The desired azimuth angle. If no exact match is found, the value of azimuth will represent the actual azimuth elevation of the chosen HRTF. Interval [0,360)
 	* \param[in,out] elevation The desired elevation angle. If no exact match is found, the value of elevation will represent the actual elevation angle of the chosen HRTF.
 	* \return A pair of shared pointers to ImpulseResponse objects containing the HRTFs for the left (first element) and right (second element) ears.
 	*/
 	std::pair<std::shared_ptr<ImpulseResponse>, std::shared_ptr<ImpulseResponse>> getImpulseResponse(float &azimuth, float &elevation);
 
+	/**
+	* Retrieves a pair of HRTFs like the other overload, but never interpolates on the calling thread, so that it can be used while reading.
+	* If the interpolated HRTFs of the direction aren't cached, they are interpolated by a worker thread and the closest measured HRTFs are returned meanwhile.
+	* \param[in,out] azimuth The desired azimuth angle, set to the actual azimuth of the returned HRTFs.
+	* \param[in,out] elevation The desired elevation angle, set to the actual elevation of the returned HRTFs.
+	* \param[out] complete False if the interpolated HRTFs aren't ready yet, in which case the call should be repeated later.
+	* \return A pair of shared pointers to ImpulseResponse objects containing the HRTFs for the left (first element) and right (second element) ears.
+	*/
+	std::pair<std::shared_ptr<ImpulseResponse>, std::shared_ptr<ImpulseResponse>> getImpulseResponse(float &azimuth, float &elevation, bool &complete);
+
+	/**
+	* Sets whether the HRTFs are interpolated between the measured directions.
+	* Interpolation results in smoother movement, while without it the closest HRTF is used.
+	* Enabling it starts the worker thread, all HRTFs should be added before.
+	* \param interpolation Whether to interpolate.
+	*/
+	void setInterpolation(bool interpolation);
+
+	/**
+	* Retrieves whether the HRTFs are interpolated between the measured directions.
+	* \return Whether the HRTFs are interpolated.
+	*/
+	bool getInterpolation() const;
+
 	/**
 	* Retrieves the specs shared by all the HRTFs.
 	* \return The shared specs of all the HRTFs.
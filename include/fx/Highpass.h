@@ -26,6 +26,8 @@
 
 AUD_NAMESPACE_BEGIN
 
+class AnimateableProperty;
+
 /**
  * This sound creates a highpass filter reader.
  */
@@ -44,6 +46,17 @@ public:
 	 * \param Q The Q factor.
 	 */
 	Highpass(std::shared_ptr<ISound> sound, float frequency, float Q = 1.0f);
+
+	/**
+	 * Creates a new highpass sound with animated parameters, which change without
+	 * recreating the reader. Changes are interpolated to avoid zipper noise.
+	 * \param sound The input sound.
+	 * \param frequency The cutoff frequency.
+	 * \param Q The Q factor.
+	 * \param fps The frames per second of the animation, the properties are
+	 *        read at the position of the filtered stream.
+	 */
+	Highpass(std::shared_ptr<ISound> sound, std::shared_ptr<AnimateableProperty> frequency, std::shared_ptr<AnimateableProperty> Q, float fps);
 };
 
 AUD_NAMESPACE_END
@@ -24,8 +24,12 @@
 
 #include "fx/IDynamicIIRFilterCalculator.h"
 
+#include <memory>
+
 AUD_NAMESPACE_BEGIN
 
+class AnimateableProperty;
+
 /**
  * The HighpassCalculator class calculates high pass filter coefficients for a
  * dynamic DynamicIIRFilter.
@@ -43,10 +47,33 @@ private:
 	 */
 	const float m_Q;
 
+	/**
+	 * The animated cutoff frequency, nullptr if it's constant.
+	 */
+	std::shared_ptr<AnimateableProperty> m_frequency_property;
+
+	/**
+	 * The animated Q factor.
+	 */
+	std::shared_ptr<AnimateableProperty> m_Q_property;
+
+	/**
+	 * The frames per second of the animation.
+	 */
+	const float m_fps;
+
 	// delete copy constructor and operator=
 	HighpassCalculator(const HighpassCalculator&) = delete;
 	HighpassCalculator& operator=(const HighpassCalculator&) = delete;
 
+	/**
+	 * Calculates the coefficients b0, b1, b2, a1 and a2 of the filter.
+	 * \param rate The sample rate.
+	 * \param time The position in the stream in seconds.
+	 * \param[out] section The five coefficients.
+	 */
+	void AUD_LOCAL calculate(SampleRate rate, double time, float* section);
+
 public:
 	/**
 	 * Creates a HighpassCalculator object.
@@ -55,7 +82,16 @@ public:
 	 */
 	HighpassCalculator(float frequency, float Q);
 
+	/**
+	 * Creates a HighpassCalculator object with animated parameters.
+	 * @param frequency The cutoff frequency.
+	 * @param Q The Q factor of the filter.
+	 * @param fps The frames per second of the animation.
+	 */
+	HighpassCalculator(std::shared_ptr<AnimateableProperty> frequency, std::shared_ptr<AnimateableProperty> Q, float fps);
+
 	virtual void recalculateCoefficients(SampleRate rate, std::vector<float> &b, std::vector<float> &a);
+	virtual bool animateSections(SampleRate rate, double time, std::vector<float> &sections);
 };
 
 AUD_NAMESPACE_END
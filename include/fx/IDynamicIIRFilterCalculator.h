@@ -45,6 +45,23 @@ public:
 	 * \param[out] a The output filter coefficients.
 	 */
 	virtual void recalculateCoefficients(SampleRate rate, std::vector<float>& b, std::vector<float>& a)=0;
+
+	/**
+	 * Calculates the filter at a position of the stream as second order
+	 * sections, so that filters whose parameters are animated don't have to
+	 * be factored while filtering. Calculators that don't provide sections
+	 * are built from recalculateCoefficients and aren't animated.
+	 * \param rate The sample rate of the audio data.
+	 * \param time The position in the stream in seconds.
+	 * \param[out] sections The coefficients b0, b1, b2, a1 and a2 of each
+	 *             section, which are appended. a0 is 1 for every section.
+	 * \return Whether the sections depend on the time. If not, the filter
+	 *         coefficients are only recalculated when the sample rate changes.
+	 */
+	virtual bool animateSections(SampleRate, double, std::vector<float>&)
+	{
+		return false;
+	}
 };
 
 AUD_NAMESPACE_END
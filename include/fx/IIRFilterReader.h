@@ -23,6 +23,7 @@
  */
 
 #include "fx/BaseIIRFilterReader.h"
+#include "util/BiquadCascade.h"
 
 #include <vector>
 
@@ -30,6 +31,9 @@ AUD_NAMESPACE_BEGIN
 
 /**
  * This class is for infinite impulse response filters with simple coefficients.
+ * Filters that can be factored into second order sections, like the
+ * butterworth, lowpass and highpass filters, are run as a biquad cascade,
+ * which filters a whole block and all channels at once.
  */
 class AUD_API IIRFilterReader : public BaseIIRFilterReader
 {
@@ -48,6 +52,17 @@ private:
 	IIRFilterReader(const IIRFilterReader&) = delete;
 	IIRFilterReader& operator=(const IIRFilterReader&) = delete;
 
+protected:
+	/**
+	 * The second order sections of the filter.
+	 */
+	BiquadCascade m_cascade;
+
+	/**
+	 * Whether the filter runs as the biquad cascade.
+	 */
+	bool m_biquads;
+
 public:
 	/**
 	 * Creates a new IIR filter reader.
@@ -58,6 +73,7 @@ public:
 	IIRFilterReader(std::shared_ptr<IReader> reader, const std::vector<float>& b, const std::vector<float>& a);
 
 	virtual sample_t filter();
+	virtual bool filterBlock(sample_t* buffer, int length, Channels channels);
 
 	/**
 	 * Sets new filter coefficients.
@@ -24,9 +24,12 @@
 
 #include "util/StreamBuffer.h"
 #include "util/FFTPlan.h"
+#include "fx/NonUniformPartitions.h"
 #include "IReader.h"
 
+#include <map>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 AUD_NAMESPACE_BEGIN
@@ -42,10 +45,25 @@ class AUD_API ImpulseResponse
 private:
 	/**
 	* A tri-dimensional array (channels, parts, values) The impulse response is divided in channels and those channels are divided
-	* in parts of N/2 samples. Those parts are transformed to the frequency domain transform which generates uni-dimensional 
-	* arrays of fftwtf_complex data (complex numbers).
+	* in parts of N/2 samples. Those parts are transformed to the frequency domain, scaled by 1/N for the inverse transform
+	* and stored in the split layout of the SplitSpectrum class.
 	*/
-	std::vector<std::shared_ptr<std::vector<std::shared_ptr<std::vector<std::complex<sample_t>>>>>> m_processedIR;
+	std::vector<std::shared_ptr<std::vector<std::shared_ptr<std::vector<sample_t>>>>> m_processedIR;
+
+	/**
+	* The samples of each channel of the impulse response.
+	*/
+	std::vector<std::vector<sample_t>> m_samples;
+
+	/**
+	* The non uniform partitions of each channel that have been requested, by block size.
+	*/
+	std::map<int, std::vector<std::shared_ptr<const NonUniformPartitions>>> m_partitions;
+
+	/**
+	* A mutex for the creation of non uniform partitions.
+	*/
+	std::mutex m_partitionsMutex;
 
 	/**
 	* The specification of the samples.
@@ -77,6 +95,15 @@ public:
 	*/
 	ImpulseResponse(std::shared_ptr<StreamBuffer> impulseResponse);
 
+	/**
+	* Creates a new ImpulseResponse object as the weighted sum of other impulse responses.
+	* The sum is calculated on the already transformed parts, so no FFT is necessary.
+	* \param impulseResponses The impulse responses, which must have been processed with FFT plans of the same size and have the same specs.
+	* \param weights The weight of each impulse response.
+	* \exception Exception Thrown if the impulse responses don't match.
+	*/
+	ImpulseResponse(const std::vector<std::shared_ptr<ImpulseResponse>>& impulseResponses, const std::vector<float>& weights);
+
 	/**
 	* Returns the specification of the impulse response.
 	* \return The specification of the impulse response.
@@ -94,7 +121,16 @@ public:
 	* \param n The desired channel number (from 0 to channels-1).
 	* \return The desired channel of the impulse response.
 	*/
-	std::shared_ptr<std::vector<std::shared_ptr<std::vector<std::complex<sample_t>>>>> getChannel(int n);
+	std::shared_ptr<std::vector<std::shared_ptr<std::vector<sample_t>>>> getChannel(int n);
+
+	/**
+	* Retrieves one channel of the impulse response divided in non uniform partitions for the NonUniformConvolver class.
+	* The partitions are created on the first request and shared by all following requests with the same block size.
+	* \param n The desired channel number (from 0 to channels-1).
+	* \param blockSize The block size of the convolution.
+	* \return The desired channel of the impulse response.
+	*/
+	std::shared_ptr<const NonUniformPartitions> getPartitions(int n, int blockSize);
 
 private:
 	/**
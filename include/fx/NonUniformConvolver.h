@@ -0,0 +1,185 @@
+/*******************************************************************************
+* Copyright 2015-2016 Juan Francisco Crespo Galán
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+******************************************************************************/
+
+#pragma once
+
+/**
+* @file NonUniformConvolver.h
+* @ingroup fx
+* The NonUniformConvolver class.
+*/
+
+#include "NonUniformPartitions.h"
+#include "util/Buffer.h"
+#include "util/SplitSpectrum.h"
+#include "util/ThreadPool.h"
+
+#include <memory>
+#include <vector>
+#include <future>
+
+AUD_NAMESPACE_BEGIN
+/**
+* This class convolves a sound with a long impulse response in small blocks.
+* The head of the impulse response is convolved in the calling thread with partitions of the block size, while the
+* larger partitions of the tail are convolved by the thread pool in the time one of their partitions takes to play.
+* Compared to the Convolver class the latency only depends on the block size and the cost grows with the logarithm
+* of the impulse response length instead of linearly.
+*/
+class AUD_API NonUniformConvolver
+{
+private:
+	/**
+	* The convolution state of one segment of partitions.
+	*/
+	struct SegmentState
+	{
+		/// The partitions of the segment.
+		const NonUniformPartitions::Segment* partitions;
+
+		/// The last two input blocks of the segment's partition size.
+		Buffer input;
+
+		/// The number of samples of the current input block.
+		int fill;
+
+		/// The FFT buffer, used by the thread while it is processing.
+		Buffer fft;
+
+		/// The split spectra of the last input blocks, one per partition.
+		Buffer delayLine;
+
+		/// The position of the newest spectrum in the delay line.
+		int head;
+
+		/// The split spectrum the products are accumulated in.
+		Buffer accumulator;
+
+		/// The input spectrum for each partition.
+		std::vector<const sample_t*> inputs;
+
+		/// The spectrum of each partition.
+		std::vector<const sample_t*> spectra;
+
+		/// The output currently being played and the output being computed.
+		Buffer output[2];
+
+		/// The index of the output currently being played.
+		int current;
+
+		/// The read position in the output currently being played.
+		int position;
+
+		/// Whether the segment is processed by the thread pool.
+		bool threaded;
+
+		/// The future of the computation.
+		std::future<void> future;
+	};
+
+	/**
+	* The partitioned impulse response.
+	*/
+	std::shared_ptr<const NonUniformPartitions> m_partitions;
+
+	/**
+	* The block size.
+	*/
+	int m_blockSize;
+
+	/**
+	* The state of every segment, the first segment is always processed directly.
+	*/
+	std::vector<std::unique_ptr<SegmentState>> m_segments;
+
+	/**
+	* A pool of threads that will be used for the tail segments, may be nullptr.
+	*/
+	std::shared_ptr<ThreadPool> m_threadPool;
+
+	/**
+	* The complex multiply-accumulate kernel.
+	*/
+	SplitSpectrum::multiply_add_f m_multiplyAdd;
+
+	/**
+	* The number of input samples convolved since the last reset.
+	*/
+	long long m_inputLength;
+
+	/**
+	* The number of output samples written since the last reset.
+	*/
+	long long m_outputLength;
+
+	/**
+	* Flag end of sound.
+	*/
+	bool m_eos;
+
+	// delete copy constructor and operator=
+	NonUniformConvolver(const NonUniformConvolver&) = delete;
+	NonUniformConvolver& operator=(const NonUniformConvolver&) = delete;
+
+public:
+	/**
+	* Creates a new NonUniformConvolver.
+	* \param partitions The partitioned impulse response (see ImpulseResponse::getPartitions for an easy way to obtain it).
+	* \param threadPool A shared pointer to a ThreadPool object, if nullptr every segment is processed in the calling thread.
+	*/
+	NonUniformConvolver(std::shared_ptr<const NonUniformPartitions> partitions, std::shared_ptr<ThreadPool> threadPool);
+
+	virtual ~NonUniformConvolver();
+
+	/**
+	* Convolves the data that is provided with the impulse response.
+	* The amount of samples convolved by one call to this method is the block size.
+	* \param[in] inBuffer A buffer with the input data to be convolved, nullptr if the source sound has ended (the convolved sound is larger than the source sound).
+	* \param[in] outBuffer A buffer in which the convolved data will be written. Its size must be at least the block size and it may be the inBuffer.
+	* \param[in,out] length The number of samples you wish to obtain. If an inBuffer is provided this argument must match its length,
+	*						a length shorter than the block size ends the input.
+	*						When this method returns, the value of length represents the number of samples written into the outBuffer.
+	* \param[out] eos True if the end of the sound is reached, false otherwise.
+	* \exception StateException Thrown if the length is larger than the block size.
+	*/
+	void getNext(sample_t* inBuffer, sample_t* outBuffer, int& length, bool& eos);
+
+	/**
+	* Resets all the internally stored data so the convolution of a new sound can be started.
+	*/
+	void reset();
+
+	/**
+	* Retrieves the block size of the convolution.
+	* \return The block size.
+	*/
+	int getBlockSize() const;
+
+private:
+	/**
+	* Convolves the last two input blocks of a segment, which have already been copied to the FFT buffer, with its partitions.
+	* \param segment The segment to process.
+	* \param output The buffer the segment's partition size of samples will be written to.
+	*/
+	void AUD_LOCAL processSegment(SegmentState* segment, sample_t* output);
+
+	/**
+	* Waits for the computations of all segments to finish.
+	*/
+	void AUD_LOCAL wait();
+};
+
+AUD_NAMESPACE_END
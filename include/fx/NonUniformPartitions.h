@@ -0,0 +1,112 @@
+/*******************************************************************************
+* Copyright 2015-2016 Juan Francisco Crespo Galán
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+******************************************************************************/
+
+#pragma once
+
+/**
+* @file NonUniformPartitions.h
+* @ingroup fx
+* The NonUniformPartitions class.
+*/
+
+#include "util/FFTPlan.h"
+
+#include <memory>
+#include <vector>
+
+AUD_NAMESPACE_BEGIN
+
+/**
+* This class represents one channel of an impulse response divided in partitions that grow with their distance to the start.
+* The first segment uses partitions of the block size, every following segment doubles the partition size up to a maximum,
+* so that a long impulse response only needs a few large partitions while the latency stays at one block.
+* Each segment of partition size S starts 2*S samples into the impulse response, which gives a convolver S samples of time
+* to compute it, and the last segment holds all the remaining partitions.
+*/
+class AUD_API NonUniformPartitions
+{
+public:
+	/**
+	* A number of consecutive partitions of the same size.
+	*/
+	struct Segment
+	{
+		/// The partition size, the FFT size is twice as large.
+		int size;
+
+		/// The position of the first partition in the impulse response.
+		int offset;
+
+		/// The number of partitions.
+		int count;
+
+		/// The FFT plan of size 2*size.
+		std::shared_ptr<FFTPlan> plan;
+
+		/// The split spectra of the partitions with size+1 bins each, already scaled for the inverse transform.
+		std::vector<sample_t> spectra;
+	};
+
+private:
+	/**
+	* The segments, sorted by offset.
+	*/
+	std::vector<Segment> m_segments;
+
+	/**
+	* The size of the partitions of the first segment.
+	*/
+	int m_blockSize;
+
+	/**
+	* The length of the impulse response.
+	*/
+	int m_length;
+
+	// delete copy constructor and operator=
+	NonUniformPartitions(const NonUniformPartitions&) = delete;
+	NonUniformPartitions& operator=(const NonUniformPartitions&) = delete;
+
+public:
+	/**
+	* Creates a new NonUniformPartitions object, dividing the impulse response and transforming it to the frequency domain.
+	* \param ir The samples of one channel of the impulse response.
+	* \param length The length of the impulse response.
+	* \param blockSize The size of the first partitions, which is the block size of the convolution.
+	* \exception StateException Thrown if the block size is not positive.
+	*/
+	NonUniformPartitions(const sample_t* ir, int length, int blockSize);
+
+	/**
+	* Retrieves the size of the first partitions.
+	* \return The block size of the convolution.
+	*/
+	int getBlockSize() const;
+
+	/**
+	* Retrieves the length of the impulse response.
+	* \return The length of the impulse response.
+	*/
+	int getLength() const;
+
+	/**
+	* Retrieves the segments of partitions.
+	* \return The segments, the first one starting at the beginning of the impulse response.
+	*/
+	const std::vector<Segment>& getSegments() const;
+};
+
+AUD_NAMESPACE_END
@@ -25,6 +25,8 @@
 #include "fx/EffectReader.h"
 #include "util/Buffer.h"
 
+#include <memory>
+
 AUD_NAMESPACE_BEGIN
 
 /**
@@ -33,7 +35,16 @@ AUD_NAMESPACE_BEGIN
  */
 class AUD_API ChannelMapperReader : public EffectReader
 {
+public:
+	/**
+	 * A mapping matrix together with the data of its kernels, it is only
+	 * defined in the implementation.
+	 */
+	struct Mapping;
+
 private:
+	typedef void (*map_f)(const Mapping& mapping, const sample_t* in, int length, sample_t* out);
+
 	/**
 	 * The sound reading buffer.
 	 */
@@ -50,14 +61,21 @@ private:
 	Channels m_source_channels;
 
 	/**
-	 * The mapping specification.
+	 * The mapping specification, shared with other readers of the same layouts
+	 * unless the source is mono.
 	 */
-	float* m_mapping;
+	std::shared_ptr<const Mapping> m_mapping;
 
 	/**
-	 * The size of the mapping.
+	 * The mapping of a mono source, which depends on its angle and is
+	 * recalculated in place when the angle changes.
 	 */
-	int m_map_size;
+	std::shared_ptr<Mapping> m_own_mapping;
+
+	/**
+	 * The mapping function for m_mapping.
+	 */
+	map_f m_map;
 
 	/**
 	 * The mono source angle.
@@ -89,10 +107,18 @@ private:
 	ChannelMapperReader& operator=(const ChannelMapperReader&) = delete;
 
 	/**
-	 * Calculates the mapping matrix.
+	 * Looks up the mapping matrix for the current layouts in the cache and
+	 * calculates it if it isn't there. Mono sources get their own mapping
+	 * for the current angle.
 	 */
 	void AUD_LOCAL calculateMapping();
 
+	/**
+	 * Calculates a mapping matrix and the data of its kernels.
+	 * \param mapping The mapping with the layouts and mono angle set.
+	 */
+	void AUD_LOCAL fillMapping(Mapping& mapping);
+
 	/**
 	 * Calculates the distance between two angles.
 	 */
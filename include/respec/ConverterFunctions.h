@@ -34,6 +34,12 @@ AUD_NAMESPACE_BEGIN
  */
 typedef void (*convert_f)(data_t* target, data_t* source, int length);
 
+/**
+ * The function template for functions converting planar audio with one
+ * source buffer per channel to interleaved samples of another format.
+ */
+typedef void (*convert_planar_f)(data_t* target, data_t** source, int offset, int length, int channels);
+
 /**
  * The copy conversion function simply calls std::memcpy.
  * @param target The target buffer.
@@ -374,4 +380,54 @@ void AUD_API convert_double_s32(data_t* target, data_t* source, int length);
  */
 void AUD_API convert_double_float(data_t* target, data_t* source, int length);
 
+/**
+ * @brief Converts from planar FORMAT_U8 to interleaved FORMAT_FLOAT32.
+ * @param target The interleaved target buffer.
+ * @param source The source buffers, one per channel.
+ * @param offset The sample offset within each source buffer.
+ * @param length The amount of samples per channel to be converted.
+ * @param channels The channel count.
+ */
+void AUD_API convert_planar_u8_float(data_t* target, data_t** source, int offset, int length, int channels);
+
+/**
+ * @brief Converts from planar FORMAT_S16 to interleaved FORMAT_FLOAT32.
+ * @param target The interleaved target buffer.
+ * @param source The source buffers, one per channel.
+ * @param offset The sample offset within each source buffer.
+ * @param length The amount of samples per channel to be converted.
+ * @param channels The channel count.
+ */
+void AUD_API convert_planar_s16_float(data_t* target, data_t** source, int offset, int length, int channels);
+
+/**
+ * @brief Converts from planar FORMAT_S32 to interleaved FORMAT_FLOAT32.
+ * @param target The interleaved target buffer.
+ * @param source The source buffers, one per channel.
+ * @param offset The sample offset within each source buffer.
+ * @param length The amount of samples per channel to be converted.
+ * @param channels The channel count.
+ */
+void AUD_API convert_planar_s32_float(data_t* target, data_t** source, int offset, int length, int channels);
+
+/**
+ * @brief Converts from planar FORMAT_FLOAT32 to interleaved FORMAT_FLOAT32.
+ * @param target The interleaved target buffer.
+ * @param source The source buffers, one per channel.
+ * @param offset The sample offset within each source buffer.
+ * @param length The amount of samples per channel to be converted.
+ * @param channels The channel count.
+ */
+void AUD_API convert_planar_float_float(data_t* target, data_t** source, int offset, int length, int channels);
+
+/**
+ * @brief Converts from planar FORMAT_FLOAT64 to interleaved FORMAT_FLOAT32.
+ * @param target The interleaved target buffer.
+ * @param source The source buffers, one per channel.
+ * @param offset The sample offset within each source buffer.
+ * @param length The amount of samples per channel to be converted.
+ * @param channels The channel count.
+ */
+void AUD_API convert_planar_double_float(data_t* target, data_t** source, int offset, int length, int channels);
+
 AUD_NAMESPACE_END
@@ -32,8 +32,10 @@ AUD_NAMESPACE_BEGIN
  */
 class AUD_API JOSResampleReader : public ResampleReader
 {
-private:
+protected:
 	typedef void (JOSResampleReader::*resample_f)(double target_factor, int length, sample_t* buffer);
+	typedef void (*interpolate_f)(const float* coeff, unsigned int P, int P_increment, int count, float* taps);
+	typedef void (*accumulate_f)(const float* taps, const sample_t* data, int frames, int channels, float* sums);
 
 	/**
 	 * The half filter length for HIGH quality setting. 
@@ -122,6 +124,21 @@ private:
 	 */
 	resample_f m_resample;
 
+	/**
+	 * The interpolated filter taps of one output sample for the vector path.
+	 */
+	Buffer m_taps;
+
+	/**
+	 * Tap interpolation function of the vector path.
+	 */
+	interpolate_f m_interpolate;
+
+	/**
+	 * Accumulation function for the channel count and SIMD level.
+	 */
+	accumulate_f m_accumulate;
+
 	/**
 	 * Last resampling factor.
 	 */
@@ -131,11 +148,6 @@ private:
 	JOSResampleReader(const JOSResampleReader&) = delete;
 	JOSResampleReader& operator=(const JOSResampleReader&) = delete;
 
-	/**
-	 * Resets the resampler to its initial state.
-	 */
-	void AUD_LOCAL reset();
-
 	/**
 	 * Updates the buffer to be as small as possible for the coming reading.
 	 * \param size The size of samples to be read.
@@ -148,9 +160,26 @@ private:
 	void AUD_LOCAL resample_mono(double target_factor, int length, sample_t* buffer);
 	void AUD_LOCAL resample_stereo(double target_factor, int length, sample_t* buffer);
 
+	/**
+	 * Resamples by first interpolating the filter taps of an output sample
+	 * and then accumulating all channels with m_accumulate.
+	 * \param target_factor The resampling factor at the end of the buffer.
+	 * \param length The number of samples to produce.
+	 * \param buffer The output buffer.
+	 */
+	void AUD_LOCAL resample_taps(double target_factor, int length, sample_t* buffer);
+
 	template <typename T>
 	void AUD_LOCAL resample(double target_factor, int length, sample_t* buffer);
 
+	/**
+	 * Resamples from the cache once read() made enough input available.
+	 * \param target_factor The resampling factor at the end of the buffer.
+	 * \param length The number of samples to produce.
+	 * \param buffer The output buffer.
+	 */
+	virtual void resampleBlock(double target_factor, int length, sample_t* buffer);
+
 public:
 
 	/**
@@ -160,6 +189,7 @@ public:
 	 */
 	JOSResampleReader(std::shared_ptr<IReader> reader, SampleRate rate, ResampleQuality quality = ResampleQuality::HIGH);
 
+	virtual void reset();
 	virtual void seek(int position);
 	virtual int getLength() const;
 	virtual int getPosition() const;
@@ -33,15 +33,18 @@ AUD_NAMESPACE_BEGIN
 class AUD_API LinearResampleReader : public ResampleReader
 {
 private:
+	typedef void (*resample_f)(const sample_t* buf, unsigned long long position, unsigned long long step, int length, int channels, sample_t* buffer);
+
 	/**
 	 * The reader channels.
 	 */
 	Channels m_channels;
 
 	/**
-	 * The position in the cache.
+	 * The position in the cache as 32.32 fixed point number, in (0, 1] while
+	 * the cache is valid.
 	 */
-	float m_cache_pos;
+	unsigned long long m_cache_pos;
 
 	/**
 	 * The sound output buffer.
@@ -58,6 +61,11 @@ private:
 	 */
 	bool m_cache_ok;
 
+	/**
+	 * Interpolation function for the channel count and SIMD level.
+	 */
+	resample_f m_resample;
+
 	// delete copy constructor and operator=
 	LinearResampleReader(const LinearResampleReader&) = delete;
 	LinearResampleReader& operator=(const LinearResampleReader&) = delete;
@@ -70,6 +78,7 @@ public:
 	 */
 	LinearResampleReader(std::shared_ptr<IReader> reader, SampleRate rate);
 
+	virtual void reset();
 	virtual void seek(int position);
 	virtual int getLength() const;
 	virtual int getPosition() const;
@@ -64,9 +64,25 @@ protected:
 	 */
 	convert_f m_convert;
 
+	/**
+	 * Kernel mixing a buffer with a constant volume.
+	 */
+	void (*m_mix)(sample_t* target, const sample_t* source, int length, float volume);
+
+	/**
+	 * Kernel mixing a buffer with a volume that changes linearly per frame.
+	 */
+	void (*m_mix_ramp)(sample_t* target, const sample_t* source, int frames, int channels, float volume, float step);
+
+	/**
+	 * Kernel scaling a buffer by a volume.
+	 */
+	void (*m_scale)(sample_t* buffer, int length, float volume);
+
 public:
 	/**
 	 * Creates the mixer.
+	 * The mixing kernels are selected according to SIMD::getLevel().
 	 */
 	Mixer(DeviceSpecs specs);
 
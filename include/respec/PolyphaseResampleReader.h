@@ -0,0 +1,106 @@
+/*******************************************************************************
+ * Copyright 2009-2016 Jörg Müller
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************/
+
+#pragma once
+
+/**
+ * @file PolyphaseResampleReader.h
+ * @ingroup respec
+ * The PolyphaseResampleReader class.
+ */
+
+#include "respec/JOSResampleReader.h"
+
+#include <memory>
+
+AUD_NAMESPACE_BEGIN
+
+/**
+ * This resampling reader uses a polyphase filter bank for constant rational
+ * ratios L/M between integer sample rates, like 44100 to 48000 Hz.
+ * The filter taps of all L phases are computed from the windowed sinc of the
+ * JOSResampleReader when the nominal source rate or the target rate is set,
+ * never while reading, and shared between all readers with the same ratio
+ * and quality as long as one of them uses them. While the rate of the source
+ * differs from the nominal one, for example because of a pitch or the doppler
+ * effect, or if the ratio isn't representable with a small table, the reader
+ * falls back to the variable ratio algorithm of the JOSResampleReader.
+ */
+class AUD_API PolyphaseResampleReader : public JOSResampleReader
+{
+private:
+	/**
+	 * The filter bank of one ratio and quality.
+	 */
+	struct PhaseTable;
+
+	/**
+	 * The filter bank for the current ratio, nullptr if there is none.
+	 */
+	std::shared_ptr<const PhaseTable> m_table;
+
+	/**
+	 * The nominal sample rate of the source, which m_table is for.
+	 */
+	SampleRate m_source_rate;
+
+	// delete copy constructor and operator=
+	PolyphaseResampleReader(const PolyphaseResampleReader&) = delete;
+	PolyphaseResampleReader& operator=(const PolyphaseResampleReader&) = delete;
+
+	/**
+	 * Looks up the filter bank for the nominal source rate and the target rate.
+	 */
+	void AUD_LOCAL updateTable();
+
+	/**
+	 * Returns the shared filter bank for a ratio, computing it if necessary.
+	 * \param L The number of phases, which is the reduced target rate.
+	 * \param M The input frames per L output frames, the reduced source rate.
+	 * \return The filter bank or nullptr if it would be too large.
+	 */
+	std::shared_ptr<const PhaseTable> AUD_LOCAL getTable(int L, int M);
+
+protected:
+	virtual void resampleBlock(double target_factor, int length, sample_t* buffer);
+
+public:
+	/**
+	 * Creates a resampling reader.
+	 * \param reader The reader to mix.
+	 * \param rate The target sampling rate.
+	 * \param quality The quality of the filter, see JOSResampleReader.
+	 */
+	PolyphaseResampleReader(std::shared_ptr<IReader> reader, SampleRate rate, ResampleQuality quality = ResampleQuality::HIGH);
+
+	/**
+	 * Sets the nominal sample rate of the source, for which the filter bank is
+	 * looked up or computed now. Until it is set, the reader always uses the
+	 * variable ratio algorithm.
+	 * \param rate The sample rate of the source without pitch or doppler effect.
+	 */
+	void setSourceRate(SampleRate rate);
+
+	/**
+	 * Retrieves the nominal sample rate of the source.
+	 * \return The sample rate set with setSourceRate, 0 if none.
+	 */
+	SampleRate getSourceRate() const;
+
+	virtual void setRate(SampleRate rate);
+};
+
+AUD_NAMESPACE_END
@@ -56,6 +56,15 @@ public:
 	 * \return The target sampling rate.
 	 */
 	virtual SampleRate getRate();
+
+	/**
+	 * Discards the buffered resampling state without seeking the source, so
+	 * that reading continues at the current position of the source reader.
+	 * This is necessary after the source reader has been replaced.
+	 * The default implementation does nothing, which suffices for readers
+	 * that don't buffer samples of the source.
+	 */
+	virtual void reset();
 };
 
 AUD_NAMESPACE_END
@@ -0,0 +1,130 @@
+/*******************************************************************************
+ * Copyright 2009-2016 Jörg Müller
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************/
+
+#pragma once
+
+/**
+ * @file BiquadCascade.h
+ * @ingroup util
+ * The BiquadCascade class.
+ */
+
+#include "respec/Specification.h"
+#include "util/Buffer.h"
+
+#include <vector>
+
+AUD_NAMESPACE_BEGIN
+
+/**
+ * This class filters interleaved blocks with a cascade of second order
+ * sections in transposed direct form II.
+ * The filter state of up to four channels is kept in one vector, so all
+ * channels of a frame are filtered together.
+ */
+class AUD_API BiquadCascade
+{
+private:
+	typedef void (*biquad_f)(const float* coefficients, int sections, float* state, sample_t* buffer, int length, int channels);
+
+	/**
+	 * The coefficients b0, b1, b2, -a1 and -a2 of each section.
+	 */
+	std::vector<float> m_coefficients;
+
+	/**
+	 * The two state variables of each section and group of up to four
+	 * channels, each one a vector of four floats.
+	 */
+	Buffer m_state;
+
+	/**
+	 * The filter functions for groups of one, two and four channels.
+	 */
+	biquad_f m_biquad[3];
+
+	/**
+	 * The channel count the state is for.
+	 */
+	Channels m_channels;
+
+	// delete copy constructor and operator=
+	BiquadCascade(const BiquadCascade&) = delete;
+	BiquadCascade& operator=(const BiquadCascade&) = delete;
+
+	/**
+	 * Returns the number of channel groups.
+	 * \param channels The channel count.
+	 * \return The group count.
+	 */
+	static int AUD_LOCAL getGroupCount(Channels channels);
+
+public:
+	/**
+	 * Creates an empty cascade, which has to get coefficients before filtering.
+	 */
+	BiquadCascade();
+
+	/**
+	 * Factors the transfer function b(z) / a(z) into second order sections.
+	 * The filter state is kept if the section count doesn't change.
+	 * \param b The input filter coefficients.
+	 * \param a The output filter coefficients.
+	 * \return Whether the coefficients could be factored, if not the cascade
+	 *         is empty.
+	 */
+	bool setCoefficients(const std::vector<float>& b, const std::vector<float>& a);
+
+	/**
+	 * Sets the second order sections directly, without factoring.
+	 * The filter state is kept if the section count doesn't change.
+	 * \param sections The coefficients b0, b1, b2, a1 and a2 of each section,
+	 *        a0 is 1.
+	 */
+	void setSections(const std::vector<float>& sections);
+
+	/**
+	 * Returns the number of second order sections.
+	 * \return The section count, zero if the cascade is empty.
+	 */
+	int getSectionCount() const;
+
+	/**
+	 * Moves the coefficients linearly towards those of another cascade,
+	 * keeping the filter state. As the stable region of a section is convex,
+	 * the sections between two stable sections are stable too.
+	 * \param target The cascade to take the coefficients from. If its section
+	 *        count differs, its coefficients are taken over immediately and
+	 *        the state is cleared.
+	 * \param factor How far to move, 1 reaches the target.
+	 */
+	void interpolate(const BiquadCascade& target, float factor);
+
+	/**
+	 * Clears the filter state.
+	 */
+	void reset();
+
+	/**
+	 * Filters a block in place.
+	 * \param buffer The interleaved samples.
+	 * \param length The number of frames.
+	 * \param channels The channel count, the state is cleared if it changes.
+	 */
+	void process(sample_t* buffer, int length, Channels channels);
+};
+
+AUD_NAMESPACE_END
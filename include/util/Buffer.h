@@ -24,6 +24,9 @@
 
 #include "Audaspace.h"
 
+#include <memory>
+#include <string>
+
 AUD_NAMESPACE_BEGIN
 
 /**
@@ -39,6 +42,12 @@ private:
 	/// The pointer to the buffer memory.
 	data_t* m_buffer;
 
+	/// Whether the buffer memory is a read-only mapping of a file.
+	bool m_mapped;
+
+	/// The buffer this buffer is a slice of, nullptr if it has its own memory.
+	std::shared_ptr<Buffer> m_parent;
+
 	// delete copy constructor and operator=
 	Buffer(const Buffer&) = delete;
 	Buffer& operator=(const Buffer&) = delete;
@@ -55,6 +64,37 @@ public:
 	 */
 	~Buffer();
 
+	/**
+	 * Creates a buffer mapping a file read-only into memory.
+	 * The pages are loaded by the operating system when they are accessed and
+	 * are shared with all other mappings of the file, so the file contents
+	 * take no additional memory. The data of the buffer must not be changed,
+	 * resizing copies it into normal memory.
+	 * \param filename The path of the file to map.
+	 * \return The buffer with the contents of the file.
+	 * \exception Exception Thrown if the file cannot be opened or mapped.
+	 */
+	static std::shared_ptr<Buffer> map(const std::string& filename);
+
+	/**
+	 * Creates a buffer referencing a part of another buffer without copying it.
+	 * The slice keeps the other buffer alive, but it must not be resized
+	 * while the slice is used. Resizing the slice copies it into its own
+	 * memory. Unlike other buffers a slice is not necessarily aligned.
+	 * \param buffer The buffer to reference.
+	 * \param offset The offset of the slice in bytes.
+	 * \param size The size of the slice in bytes.
+	 * \return The slice.
+	 * \exception Exception Thrown if the slice exceeds the buffer.
+	 */
+	static std::shared_ptr<Buffer> slice(std::shared_ptr<Buffer> buffer, long long offset, long long size);
+
+	/**
+	 * Retrieves whether the buffer is a read-only mapping of a file or a slice of one.
+	 * \return Whether the buffer is mapped.
+	 */
+	bool isMapped() const;
+
 	/**
 	 * Returns the pointer to the buffer in memory.
 	 */
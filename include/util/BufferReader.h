@@ -23,6 +23,7 @@
  */
 
 #include "IReader.h"
+#include "respec/ConverterFunctions.h"
 
 #include <memory>
 
@@ -53,6 +54,16 @@ private:
 	 */
 	Specs m_specs;
 
+	/**
+	 * The sample format of the data in the buffer.
+	 */
+	SampleFormat m_format;
+
+	/**
+	 * Converts the sample format of the buffer to float.
+	 */
+	convert_f m_convert;
+
 	// delete copy constructor and operator=
 	BufferReader(const BufferReader&) = delete;
 	BufferReader& operator=(const BufferReader&) = delete;
@@ -65,6 +76,14 @@ public:
 	 */
 	BufferReader(std::shared_ptr<Buffer> buffer, Specs specs);
 
+	/**
+	 * Creates a new buffer reader for samples of any format.
+	 * \param buffer The buffer to read from.
+	 * \param specs The specification of the sample data in the buffer.
+	 * \exception Exception Thrown if the sample format is invalid.
+	 */
+	BufferReader(std::shared_ptr<Buffer> buffer, DeviceSpecs specs);
+
 	virtual bool isSeekable() const;
 	virtual void seek(int position);
 	virtual int getLength() const;
@@ -27,6 +27,7 @@
 #include "Audaspace.h"
 
 #include <memory>
+#include <string>
 #include <vector>
 
 /**Default FFT size.*/
@@ -83,8 +84,56 @@ public:
 	*		which means faster FFTs while using this plan. If measureTime is negative, it will take all the time it needs.
 	*/
 	FFTPlan(int n, double measureTime = 0);
+
+	/**
+	* Creates a new FFTPlan object with a custom size and custom planner flags.
+	* \param n The size of the FFT plan.
+	* \param measureTime The aproximate amount of seconds that FFTW will spend searching for the optimal plan.
+	* \param flags The FFTW planner flags, FFTW_EXHAUSTIVE for the other constructors.
+	*/
+	FFTPlan(int n, double measureTime, unsigned int flags);
 	~FFTPlan();
 
+	/**
+	* Retrieves a plan from the process wide cache, creating it if necessary.
+	* Plans are shared between all users, so creating readers doesn't run the planner for a size that has been planned before.
+	* If a wisdom file is set, newly created plans are exported to it.
+	* This method is thread safe.
+	* \param n The size of the FFT plan.
+	* \param measureTime The aproximate amount of seconds that FFTW will spend searching for the optimal plan.
+	* \param flags The FFTW planner flags.
+	* \return The shared plan.
+	*/
+	static std::shared_ptr<FFTPlan> getShared(int n, double measureTime = 0, unsigned int flags = FFTW_EXHAUSTIVE);
+
+	/**
+	* Sets the file FFTW wisdom is persisted in and imports the wisdom stored in it.
+	* With the wisdom of a previous run plans are created without measuring again.
+	* \param filename The path of the wisdom file, an empty string disables the persistence.
+	* \return Whether wisdom could be imported from the file.
+	*/
+	static bool setWisdomFile(const std::string& filename);
+
+	/**
+	* Retrieves the file FFTW wisdom is persisted in.
+	* \return The path of the wisdom file, empty if there is none.
+	*/
+	static std::string getWisdomFile();
+
+	/**
+	* Imports FFTW wisdom from a file.
+	* \param filename The path of the wisdom file.
+	* \return Whether the wisdom could be imported.
+	*/
+	static bool importWisdom(const std::string& filename);
+
+	/**
+	* Exports the FFTW wisdom gathered so far to a file.
+	* \param filename The path of the wisdom file.
+	* \return Whether the wisdom could be exported.
+	*/
+	static bool exportWisdom(const std::string& filename);
+
 	/**
 	* Retrieves the size of the FFT plan.
 	* \return The size of the plan.
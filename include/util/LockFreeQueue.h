@@ -0,0 +1,128 @@
+/*******************************************************************************
+ * Copyright 2009-2016 Jörg Müller
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************/
+
+#pragma once
+
+/**
+ * @file LockFreeQueue.h
+ * @ingroup util
+ * The LockFreeQueue class.
+ */
+
+#include "Audaspace.h"
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+AUD_NAMESPACE_BEGIN
+
+/**
+ * This class is a bounded single producer single consumer queue.
+ * One thread may push while another thread pops without any locking,
+ * multiple producers or consumers have to be serialized by the caller.
+ * Popped slots are reset to a default constructed item, so resources held
+ * by an item are released by the consumer.
+ */
+template <class T>
+class LockFreeQueue
+{
+private:
+	/// The item slots, the count is a power of two.
+	std::vector<T> m_items;
+
+	/// The mask to wrap the positions into the slots.
+	size_t m_mask;
+
+	/// The read position, only written by the consumer.
+	std::atomic<size_t> m_read;
+
+	/// Keeps the positions in different cache lines.
+	char m_padding[64];
+
+	/// The write position, only written by the producer.
+	std::atomic<size_t> m_write;
+
+	// delete copy constructor and operator=
+	LockFreeQueue(const LockFreeQueue&) = delete;
+	LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+public:
+	/**
+	 * Creates a new queue.
+	 * \param size The minimum number of items the queue can hold.
+	 */
+	LockFreeQueue(size_t size) :
+		m_read(0), m_write(0)
+	{
+		size_t count = 1;
+
+		while(count < size)
+			count <<= 1;
+
+		m_items.resize(count);
+		m_mask = count - 1;
+	}
+
+	/**
+	 * Appends an item to the queue, only to be called by the producer.
+	 * \param item The item to append, it is only moved from if there is space.
+	 * \return Whether the queue had space for the item.
+	 */
+	bool push(T& item)
+	{
+		size_t write = m_write.load(std::memory_order_relaxed);
+
+		if(write - m_read.load(std::memory_order_acquire) > m_mask)
+			return false;
+
+		m_items[write & m_mask] = std::move(item);
+		m_write.store(write + 1);
+
+		return true;
+	}
+
+	/**
+	 * Removes the oldest item from the queue, only to be called by the consumer.
+	 * \param item The item to move the oldest item to.
+	 * \return Whether there was an item in the queue.
+	 */
+	bool pop(T& item)
+	{
+		size_t read = m_read.load(std::memory_order_relaxed);
+
+		if(read == m_write.load(std::memory_order_acquire))
+			return false;
+
+		item = std::move(m_items[read & m_mask]);
+		m_items[read & m_mask] = T();
+		m_read.store(read + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	/**
+	 * Returns whether the queue is empty.
+	 * \return Whether there are no items in the queue.
+	 */
+	bool empty() const
+	{
+		return m_read.load() == m_write.load();
+	}
+};
+
+AUD_NAMESPACE_END
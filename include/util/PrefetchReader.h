@@ -0,0 +1,141 @@
+/*******************************************************************************
+ * Copyright 2009-2016 Jörg Müller
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************/
+
+#pragma once
+
+/**
+ * @file PrefetchReader.h
+ * @ingroup util
+ * The PrefetchReader class.
+ */
+
+#include "IReader.h"
+
+#include <atomic>
+#include <memory>
+
+AUD_NAMESPACE_BEGIN
+
+class PrefetchThread;
+
+/**
+ * This reader decodes another reader ahead on a prefetch thread.
+ *
+ * The samples are decoded in chunks into a lock free ring buffer, so reading
+ * only copies from the ring and never waits for the source reader. This takes
+ * disk stalls and decoding spikes of file readers off the mixing thread.
+ * If the ring runs empty the missing samples are filled with silence and
+ * counted as an underrun, the playback then continues delayed by them.
+ * Seeking only flushes the ring, the source reader is seeked and the ring
+ * refilled on the prefetch thread, until then reading returns silence.
+ * The ring and the source reader are shared with the prefetch thread, which
+ * releases them once the reader is destroyed, so destroying never waits.
+ * \warning Like for any other reader read and seek must not be called
+ *          concurrently. The source reader must not be used by anything else.
+ */
+class AUD_API PrefetchReader : public IReader
+{
+private:
+	/**
+	 * The decoding state shared with the prefetch thread.
+	 */
+	class State;
+
+	/**
+	 * The decoding state.
+	 */
+	std::shared_ptr<State> m_state;
+
+	/**
+	 * The prefetch thread decoding the reader.
+	 */
+	std::shared_ptr<PrefetchThread> m_thread;
+
+	/**
+	 * The specification of the reader.
+	 */
+	Specs m_specs;
+
+	/**
+	 * The length of the reader when it was created.
+	 */
+	int m_length;
+
+	/**
+	 * Whether the reader is seekable.
+	 */
+	bool m_seekable;
+
+	/**
+	 * The position of the next sample read.
+	 */
+	int m_position;
+
+	/**
+	 * The number of underruns.
+	 */
+	std::atomic<long long> m_underruns;
+
+	/**
+	 * The number of samples filled with silence because of underruns.
+	 */
+	std::atomic<long long> m_underrunLength;
+
+	/**
+	 * An underrun counter shared with other readers, may be nullptr.
+	 */
+	std::shared_ptr<std::atomic<long long>> m_sharedUnderruns;
+
+	// delete copy constructor and operator=
+	PrefetchReader(const PrefetchReader&) = delete;
+	PrefetchReader& operator=(const PrefetchReader&) = delete;
+
+public:
+	/**
+	 * Creates a new prefetch reader and decodes the first chunk.
+	 * \param reader The reader to decode ahead.
+	 * \param thread The prefetch thread to decode on.
+	 * \param size The number of samples to decode ahead, decoded in chunks of a quarter of it.
+	 * \param underruns A counter to add the underruns to, for example to gather them for a device.
+	 */
+	PrefetchReader(std::shared_ptr<IReader> reader, std::shared_ptr<PrefetchThread> thread, int size = AUD_DEFAULT_BUFFER_SIZE * 32, std::shared_ptr<std::atomic<long long>> underruns = nullptr);
+
+	/**
+	 * Stops decoding and destroys the reader without waiting for the prefetch thread.
+	 */
+	virtual ~PrefetchReader();
+
+	/**
+	 * Retrieves how often the ring ran empty before the end of the reader.
+	 * \return The number of underruns.
+	 */
+	long long getUnderrunCount() const;
+
+	/**
+	 * Retrieves the number of samples filled with silence because of underruns.
+	 * \return The number of samples missing in time.
+	 */
+	long long getUnderrunLength() const;
+
+	virtual bool isSeekable() const;
+	virtual void seek(int position);
+	virtual int getLength() const;
+	virtual int getPosition() const;
+	virtual Specs getSpecs() const;
+	virtual void read(int& length, bool& eos, sample_t* buffer);
+};
+
+AUD_NAMESPACE_END
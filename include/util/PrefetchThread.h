@@ -0,0 +1,125 @@
+/*******************************************************************************
+ * Copyright 2009-2016 Jörg Müller
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************/
+
+#pragma once
+
+/**
+ * @file PrefetchThread.h
+ * @ingroup util
+ * The PrefetchThread class.
+ */
+
+#include "Audaspace.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+AUD_NAMESPACE_BEGIN
+
+/**
+ * This represents a persistent thread running prefetch tasks.
+ *
+ * Tasks are added once and then run whenever the thread is woken, so waking
+ * it neither allocates nor queues anything and can be done from the mixing
+ * thread. The thread holds the tasks until they finish, so they are released
+ * on it and not on the thread that stopped them.
+ */
+class AUD_API PrefetchThread
+{
+public:
+	/**
+	 * A task run by the prefetch thread.
+	 */
+	class AUD_API Task
+	{
+	public:
+		virtual ~Task() {}
+
+		/**
+		 * Does the pending work of the task, called every time the thread is woken.
+		 * \return Whether the task should be run again, otherwise it is removed and released.
+		 */
+		virtual bool run()=0;
+	};
+
+private:
+	/**
+	 * The tasks of the thread.
+	 */
+	std::vector<std::shared_ptr<Task>> m_tasks;
+
+	/**
+	 * Protects the tasks and the flags, it is never held while running a task.
+	 */
+	std::mutex m_mutex;
+
+	/**
+	 * Wakes the thread.
+	 */
+	std::condition_variable m_condition;
+
+	/**
+	 * Whether the tasks have to be run.
+	 */
+	bool m_wake;
+
+	/**
+	 * Whether the thread has to stop.
+	 */
+	bool m_stop;
+
+	/**
+	 * The thread.
+	 */
+	std::thread m_thread;
+
+	/**
+	 * Runs the tasks whenever the thread is woken.
+	 */
+	AUD_LOCAL void work();
+
+	// delete copy constructor and operator=
+	PrefetchThread(const PrefetchThread&) = delete;
+	PrefetchThread& operator=(const PrefetchThread&) = delete;
+
+public:
+	/**
+	 * Creates a new prefetch thread and starts it.
+	 */
+	PrefetchThread();
+
+	/**
+	 * Stops the thread after the running task returns and releases the remaining tasks.
+	 */
+	virtual ~PrefetchThread();
+
+	/**
+	 * Adds a task and runs it.
+	 * \param task The task to add.
+	 */
+	void add(std::shared_ptr<Task> task);
+
+	/**
+	 * Wakes the thread to run all tasks.
+	 * This doesn't allocate and only takes the lock briefly.
+	 */
+	void wake();
+};
+
+AUD_NAMESPACE_END
@@ -25,6 +25,7 @@
 #include "Audaspace.h"
 #include "Buffer.h"
 
+#include <atomic>
 #include <cstddef>
 
 AUD_NAMESPACE_BEGIN
@@ -32,6 +33,8 @@ AUD_NAMESPACE_BEGIN
 /**
  * This class is a simple ring buffer in RAM which is 32 Byte aligned and provides
  * functionality for concurrent reading and writting without locks.
+ * One thread may read while another one writes, the pointers are published
+ * with release semantics after the data is copied.
  */
 class AUD_API RingBuffer
 {
@@ -39,11 +42,11 @@ private:
 	/// The buffer storing the actual data.
 	Buffer m_buffer;
 
-	/// The reading pointer.
-	volatile size_t m_read;
+	/// The reading pointer, only changed by the reading thread.
+	std::atomic<size_t> m_read;
 
-	/// The writing pointer.
-	volatile size_t m_write;
+	/// The writing pointer, only changed by the writing thread.
+	std::atomic<size_t> m_write;
 
 	// delete copy constructor and operator=
 	RingBuffer(const RingBuffer&) = delete;
@@ -0,0 +1,109 @@
+/*******************************************************************************
+ * Copyright 2009-2016 Jörg Müller
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************/
+
+#pragma once
+
+/**
+ * @file SIMD.h
+ * @ingroup util
+ * The SIMD class and the instruction set defines used by vectorized kernels.
+ */
+
+#include "Audaspace.h"
+
+/**
+ * \def AUD_SIMD_X86
+ * Defined when compiling for an x86 processor, SSE2 and AVX2 kernels are available.
+ */
+
+/**
+ * \def AUD_SIMD_NEON
+ * Defined when compiling for a 64 bit ARM processor, NEON kernels are available.
+ */
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+	#define AUD_SIMD_X86
+#elif defined(__aarch64__) || defined(_M_ARM64)
+	#define AUD_SIMD_NEON
+#endif
+
+/**
+ * \def AUD_TARGET_SSE2
+ * Enables code generation for SSE2 in a single function.
+ */
+
+/**
+ * \def AUD_TARGET_AVX2
+ * Enables code generation for AVX2 and FMA in a single function.
+ */
+
+#if defined(__GNUC__) || defined(__clang__)
+	#define AUD_TARGET_SSE2 __attribute__((target("sse2")))
+	#define AUD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+	#define AUD_TARGET_SSE2
+	#define AUD_TARGET_AVX2
+#endif
+
+AUD_NAMESPACE_BEGIN
+
+/// The vector instruction sets the kernels can be dispatched to.
+enum SIMDLevel
+{
+	SIMD_NONE = 0,	/// Plain C++ code.
+	SIMD_SSE2,		/// x86 SSE2, 4 floats per vector.
+	SIMD_AVX2,		/// x86 AVX2 with FMA, 8 floats per vector.
+	SIMD_NEON		/// ARM NEON, 4 floats per vector.
+};
+
+/**
+ * The SIMD class detects the vector instruction sets of the processor at
+ * runtime. Classes with vectorized kernels query the level when they select
+ * their kernel functions.
+ */
+class AUD_API SIMD
+{
+private:
+	// delete copy constructor and operator=
+	SIMD(const SIMD&) = delete;
+	SIMD& operator=(const SIMD&) = delete;
+	SIMD() = delete;
+
+public:
+	/**
+	 * Returns the best instruction set supported by the processor.
+	 * \return The detected level.
+	 */
+	static SIMDLevel getSupportedLevel();
+
+	/**
+	 * Returns the instruction set kernels should currently be selected for.
+	 * \return The active level, by default the supported level.
+	 */
+	static SIMDLevel getLevel();
+
+	/**
+	 * Limits the instruction set kernels are selected for.
+	 * This is mainly useful to compare vectorized against plain code.
+	 * Objects select their kernels when they are created or reconfigured,
+	 * so the level should be set before creating them.
+	 * \param level The requested level. Levels not supported by the processor
+	 *        result in SIMD_NONE being used.
+	 */
+	static void setLevel(SIMDLevel level);
+};
+
+AUD_NAMESPACE_END
@@ -0,0 +1,93 @@
+/*******************************************************************************
+ * Copyright 2009-2016 Jörg Müller
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************/
+
+#pragma once
+
+/**
+ * @file SplitSpectrum.h
+ * @ingroup util
+ * The SplitSpectrum class.
+ */
+
+#include "Audaspace.h"
+
+AUD_NAMESPACE_BEGIN
+
+/**
+ * This class converts spectra between the interleaved layout of FFTW and
+ * the split layout the convolution classes store them in, and multiplies
+ * and accumulates split spectra with vectorized kernels.
+ * A split spectrum of n bins holds the real parts of all bins followed by
+ * their imaginary parts, each padded with zeros to getStride(n) floats.
+ */
+class AUD_API SplitSpectrum
+{
+private:
+	// delete copy constructor and operator=
+	SplitSpectrum(const SplitSpectrum&) = delete;
+	SplitSpectrum& operator=(const SplitSpectrum&) = delete;
+	SplitSpectrum() = delete;
+
+public:
+	/**
+	 * Multiplies pairs of split spectra and adds the products to an
+	 * accumulator.
+	 * \param a The first spectrum of every pair.
+	 * \param b The second spectrum of every pair.
+	 * \param count The number of pairs.
+	 * \param accumulator The split spectrum the products are added to.
+	 * \param stride The stride of the spectra.
+	 */
+	typedef void (*multiply_add_f)(const sample_t* const* a, const sample_t* const* b, int count, sample_t* accumulator, int stride);
+
+	/**
+	 * Returns the distance between the real and the imaginary parts.
+	 * \param bins The number of bins.
+	 * \return The stride, a multiple of eight floats.
+	 */
+	static int getStride(int bins);
+
+	/**
+	 * Returns the size of a split spectrum.
+	 * \param bins The number of bins.
+	 * \return The number of floats.
+	 */
+	static int getSize(int bins);
+
+	/**
+	 * Converts an interleaved spectrum to the split layout.
+	 * \param spectrum The interleaved spectrum.
+	 * \param split The split spectrum to write, including the padding.
+	 * \param bins The number of bins.
+	 */
+	static void split(const sample_t* spectrum, sample_t* split, int bins);
+
+	/**
+	 * Converts a split spectrum to the interleaved layout.
+	 * \param split The split spectrum.
+	 * \param spectrum The interleaved spectrum to write.
+	 * \param bins The number of bins.
+	 */
+	static void merge(const sample_t* split, sample_t* spectrum, int bins);
+
+	/**
+	 * Returns the multiply-accumulate kernel for SIMD::getLevel().
+	 * \return The kernel function.
+	 */
+	static multiply_add_f getMultiplyAdd();
+};
+
+AUD_NAMESPACE_END
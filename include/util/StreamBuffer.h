@@ -46,6 +46,11 @@ private:
 	 */
 	Specs m_specs;
 
+	/**
+	 * The sample format of the data in the buffer.
+	 */
+	SampleFormat m_format;
+
 	// delete copy constructor and operator=
 	StreamBuffer(const StreamBuffer&) = delete;
 	StreamBuffer& operator=(const StreamBuffer&) = delete;
@@ -67,9 +72,16 @@ public:
 	 */
 	StreamBuffer(std::shared_ptr<Buffer> buffer, Specs specs);
 
+	/**
+	 * Creates the sound from an preexisting buffer with samples of any format.
+	 * \param buffer The buffer to stream from.
+	 * \param specs The specification of the data in the buffer.
+	 */
+	StreamBuffer(std::shared_ptr<Buffer> buffer, DeviceSpecs specs);
+
 	/**
 	 * Returns the buffer to be streamed.
-	 * @return The buffer to stream.
+	 * @return The buffer to stream, with float samples unless a sample format was given.
 	 */
 	std::shared_ptr<Buffer> getBuffer();
 
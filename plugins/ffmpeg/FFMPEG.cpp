@@ -45,6 +45,11 @@ std::shared_ptr<IReader> FFMPEG::createReader(std::shared_ptr<Buffer> buffer, in
 	return std::shared_ptr<IReader>(new FFMPEGReader(buffer, stream));
 }
 
+std::shared_ptr<IReader> FFMPEG::createReader(std::shared_ptr<Buffer> buffer, Container container, Codec codec, int stream)
+{
+	return std::shared_ptr<IReader>(new FFMPEGReader(buffer, container, codec, stream));
+}
+
 std::vector<StreamInfo> FFMPEG::queryStreams(const std::string &filename)
 {
 	return FFMPEGReader(filename).queryStreams();
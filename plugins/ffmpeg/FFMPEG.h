@@ -54,6 +54,7 @@ public:
 
 	virtual std::shared_ptr<IReader> createReader(const std::string &filename, int stream = 0);
 	virtual std::shared_ptr<IReader> createReader(std::shared_ptr<Buffer> buffer, int stream = 0);
+	virtual std::shared_ptr<IReader> createReader(std::shared_ptr<Buffer> buffer, Container container, Codec codec, int stream = 0);
 	virtual std::vector<StreamInfo> queryStreams(const std::string &filename);
 	virtual std::vector<StreamInfo> queryStreams(std::shared_ptr<Buffer> buffer);
 	virtual std::shared_ptr<IWriter> createWriter(const std::string &filename, DeviceSpecs specs, Container format, Codec codec, unsigned int bitrate);
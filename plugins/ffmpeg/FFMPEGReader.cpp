@@ -18,6 +18,9 @@
 #include "Exception.h"
 
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -25,6 +28,12 @@ extern "C" {
 #include <libavutil/avutil.h>
 }
 
+// the frame size assumed for the seek preroll of codecs without a fixed one
+#define PREROLL_FRAME_SIZE 4096
+
+// identifies seek index sidecar files
+#define SEEK_INDEX_MAGIC "AUDSEEK1"
+
 AUD_NAMESPACE_BEGIN
 
 SampleFormat FFMPEGReader::convertSampleFormat(AVSampleFormat format)
@@ -46,75 +55,200 @@ SampleFormat FFMPEGReader::convertSampleFormat(AVSampleFormat format)
 	}
 }
 
-int FFMPEGReader::decode(AVPacket& packet, Buffer& buffer)
+bool FFMPEGReader::receiveFrame()
 {
-	int buf_size = buffer.getSize();
-	int buf_pos = 0;
-
-	avcodec_send_packet(m_codecCtx, &packet);
+	AVPacket packet = {};
 
 	while(true)
 	{
 		auto ret = avcodec_receive_frame(m_codecCtx, m_frame);
 
-		if(ret != 0)
-			break;
+		if(ret == 0)
+		{
+			m_frame_pos = 0;
+			m_frame_left = m_frame->nb_samples;
+			return true;
+		}
+
+		// anything but a request for more input ends the stream
+		if(ret != AVERROR(EAGAIN))
+			return false;
 
-		int data_size = av_samples_get_buffer_size(nullptr, m_codecCtx->ch_layout.nb_channels, m_frame->nb_samples, m_codecCtx->sample_fmt, 1);
+		ret = av_read_frame(m_formatCtx, &packet);
 
-		if(buf_size - buf_pos < data_size)
+		if(ret < 0)
 		{
-			buffer.resize(buf_size + data_size, true);
-			buf_size += data_size;
+			if(ret == AVERROR_EOF && m_index_contiguous)
+				m_index_complete = true;
+
+			// drain the frames the decoder still holds back
+			avcodec_send_packet(m_codecCtx, nullptr);
+			continue;
 		}
 
-		if(m_tointerleave)
+		// is it a packet from the audio stream?
+		if(packet.stream_index == m_stream)
 		{
-			int single_size = data_size / m_codecCtx->ch_layout.nb_channels / m_frame->nb_samples;
-			for(int channel = 0; channel < m_codecCtx->ch_layout.nb_channels; channel++)
-			{
-				for(int i = 0; i < m_frame->nb_samples; i++)
-				{
-					std::memcpy(((data_t*)buffer.getBuffer()) + buf_pos + ((m_codecCtx->ch_layout.nb_channels * i) + channel) * single_size,
-						   m_frame->data[channel] + i * single_size, single_size);
-				}
-			}
+			indexPacket(packet);
+			avcodec_send_packet(m_codecCtx, &packet);
 		}
-		else
-			std::memcpy(((data_t*)buffer.getBuffer()) + buf_pos, m_frame->data[0], data_size);
 
-		buf_pos += data_size;
+		av_packet_unref(&packet);
 	}
+}
+
+void FFMPEGReader::indexPacket(const AVPacket& packet)
+{
+	if(!m_index_contiguous || packet.pts == AV_NOPTS_VALUE || packet.pos < 0)
+		return;
 
-	return buf_pos;
+	// only the first packet at an offset can be sought to directly
+	if(m_index.empty() || (packet.pts > m_index.back().pts && packet.pos > m_index.back().pos))
+		m_index.push_back({packet.pts, packet.pos});
 }
 
-void FFMPEGReader::init(int stream)
+int FFMPEGReader::toPosition(int64_t pts) const
 {
-	m_position = 0;
-	m_pkgbuf_left = 0;
+	auto stream = m_formatCtx->streams[m_stream];
+
+	if(stream->start_time != AV_NOPTS_VALUE)
+		pts -= stream->start_time;
+
+	return (int)(pts * av_q2d(stream->time_base) * m_specs.rate);
+}
+
+int64_t FFMPEGReader::toTimestamp(int position) const
+{
+	auto stream = m_formatCtx->streams[m_stream];
+
+	int64_t pts = (int64_t)(position / (av_q2d(stream->time_base) * m_specs.rate));
+
+	if(stream->start_time != AV_NOPTS_VALUE)
+		pts += stream->start_time;
 
-	if(avformat_find_stream_info(m_formatCtx, nullptr) < 0)
-		AUD_THROW(FileException, "File couldn't be read, ffmpeg couldn't find the stream info.");
+	return pts;
+}
+
+int FFMPEGReader::seekIndexed(int64_t pts)
+{
+	if(m_index.empty() || (m_formatCtx->iformat->flags & AVFMT_NO_BYTE_SEEK))
+		return -1;
+
+	// the packets after the index are unknown
+	if(!m_index_complete && pts > m_index.back().pts)
+		return -1;
+
+	auto point = std::upper_bound(m_index.begin(), m_index.end(), pts, [](int64_t pts, const SeekPoint& point) { return pts < point.pts; });
 
-	// find audio stream and codec
-	m_stream = -1;
+	if(point != m_index.begin())
+		point--;
+
+	if(av_seek_frame(m_formatCtx, m_stream, point->pos, AVSEEK_FLAG_BYTE) < 0)
+		return -1;
+
+	// reading on from an indexed packet passes the end of the index in order
+	m_index_contiguous = true;
+
+	return toPosition(point->pts);
+}
 
+const AVInputFormat* FFMPEGReader::findInputFormat(Container container)
+{
+	switch(container)
+	{
+	case CONTAINER_AC3:
+		return av_find_input_format("ac3");
+	case CONTAINER_FLAC:
+		return av_find_input_format("flac");
+	case CONTAINER_MATROSKA:
+		return av_find_input_format("matroska");
+	case CONTAINER_MP2:
+	case CONTAINER_MP3:
+		return av_find_input_format("mp3");
+	case CONTAINER_OGG:
+		return av_find_input_format("ogg");
+	case CONTAINER_WAV:
+		return av_find_input_format("wav");
+	default:
+		return nullptr;
+	}
+}
+
+bool FFMPEGReader::matchesCodec(AVCodecID id, Codec codec)
+{
+	switch(codec)
+	{
+	case CODEC_AAC:
+		return id == AV_CODEC_ID_AAC;
+	case CODEC_AC3:
+		return id == AV_CODEC_ID_AC3;
+	case CODEC_FLAC:
+		return id == AV_CODEC_ID_FLAC;
+	case CODEC_MP2:
+		return id == AV_CODEC_ID_MP2;
+	case CODEC_MP3:
+		return id == AV_CODEC_ID_MP3;
+	case CODEC_PCM:
+		// the PCM codecs are the first audio codecs
+		return id >= AV_CODEC_ID_FIRST_AUDIO && id < AV_CODEC_ID_ADPCM_IMA_QT;
+	case CODEC_VORBIS:
+		return id == AV_CODEC_ID_VORBIS;
+	case CODEC_OPUS:
+		return id == AV_CODEC_ID_OPUS;
+	default:
+		return false;
+	}
+}
+
+int FFMPEGReader::findStream(int stream) const
+{
 	for(unsigned int i = 0; i < m_formatCtx->nb_streams; i++)
 	{
-		if((m_formatCtx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_AUDIO)
-			&& (m_stream < 0))
+		if(m_formatCtx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_AUDIO)
 		{
 			if(stream == 0)
-			{
-				m_stream=i;
-				break;
-			}
+				return i;
 			else
 				stream--;
 		}
 	}
 
+	return -1;
+}
+
+void FFMPEGReader::init(int stream, Codec codec)
+{
+	m_position = 0;
+	m_frame_pos = 0;
+	m_frame_left = 0;
+	m_index_contiguous = true;
+	m_index_complete = false;
+
+	// probing the stream info decodes the start of the file, which isn't necessary if the header describes the stream
+	bool probe = true;
+
+	if(codec != CODEC_INVALID)
+	{
+		m_stream = findStream(stream);
+
+		if(m_stream >= 0)
+		{
+			const AVStream* audio = m_formatCtx->streams[m_stream];
+
+			probe = !matchesCodec(audio->codecpar->codec_id, codec) || audio->codecpar->sample_rate <= 0 || audio->codecpar->ch_layout.nb_channels <= 0 ||
+					(audio->duration == AV_NOPTS_VALUE && m_formatCtx->duration == AV_NOPTS_VALUE);
+		}
+	}
+
+	if(probe)
+	{
+		if(avformat_find_stream_info(m_formatCtx, nullptr) < 0)
+			AUD_THROW(FileException, "File couldn't be read, ffmpeg couldn't find the stream info.");
+
+		// find audio stream and codec
+		m_stream = findStream(stream);
+	}
+
 	if(m_stream == -1)
 		AUD_THROW(FileException, "File couldn't be read, no audio stream found by ffmpeg.");
 
@@ -147,22 +281,27 @@ void FFMPEGReader::init(int stream)
 	{
 	case AV_SAMPLE_FMT_U8:
 		m_convert = convert_u8_float;
+		m_convert_planar = convert_planar_u8_float;
 		m_specs.format = FORMAT_U8;
 		break;
 	case AV_SAMPLE_FMT_S16:
 		m_convert = convert_s16_float;
+		m_convert_planar = convert_planar_s16_float;
 		m_specs.format = FORMAT_S16;
 		break;
 	case AV_SAMPLE_FMT_S32:
 		m_convert = convert_s32_float;
+		m_convert_planar = convert_planar_s32_float;
 		m_specs.format = FORMAT_S32;
 		break;
 	case AV_SAMPLE_FMT_FLT:
 		m_convert = convert_copy<float>;
+		m_convert_planar = convert_planar_float_float;
 		m_specs.format = FORMAT_FLOAT32;
 		break;
 	case AV_SAMPLE_FMT_DBL:
 		m_convert = convert_double_float;
+		m_convert_planar = convert_planar_double_float;
 		m_specs.format = FORMAT_FLOAT64;
 		break;
 	default:
@@ -170,10 +309,17 @@ void FFMPEGReader::init(int stream)
 	}
 
 	m_specs.rate = (SampleRate) m_codecCtx->sample_rate;
+
+	// decoders of codecs with dependencies between packets need a few frames to settle after a seek
+	const AVCodecDescriptor* descriptor = avcodec_descriptor_get(m_codecCtx->codec_id);
+
+	if(descriptor && (descriptor->props & AV_CODEC_PROP_INTRA_ONLY))
+		m_preroll = 0;
+	else
+		m_preroll = std::max(m_formatCtx->streams[m_stream]->codecpar->seek_preroll, 2 * (m_codecCtx->frame_size > 0 ? m_codecCtx->frame_size : PREROLL_FRAME_SIZE));
 }
 
 FFMPEGReader::FFMPEGReader(const std::string &filename, int stream) :
-	m_pkgbuf(),
 	m_formatCtx(nullptr),
 	m_codecCtx(nullptr),
 	m_frame(nullptr),
@@ -186,7 +332,7 @@ FFMPEGReader::FFMPEGReader(const std::string &filename, int stream) :
 
 	try
 	{
-		init(stream);
+		init(stream, CODEC_INVALID);
 	}
 	catch(Exception&)
 	{
@@ -196,7 +342,11 @@ FFMPEGReader::FFMPEGReader(const std::string &filename, int stream) :
 }
 
 FFMPEGReader::FFMPEGReader(std::shared_ptr<Buffer> buffer, int stream) :
-		m_pkgbuf(),
+	FFMPEGReader(buffer, CONTAINER_INVALID, CODEC_INVALID, stream)
+{
+}
+
+FFMPEGReader::FFMPEGReader(std::shared_ptr<Buffer> buffer, Container container, Codec codec, int stream) :
 		m_codecCtx(nullptr),
 		m_frame(nullptr),
 		m_membuffer(buffer),
@@ -214,7 +364,7 @@ FFMPEGReader::FFMPEGReader(std::shared_ptr<Buffer> buffer, int stream) :
 
 	m_formatCtx = avformat_alloc_context();
 	m_formatCtx->pb = m_aviocontext;
-	if(avformat_open_input(&m_formatCtx, "", nullptr, nullptr)!=0)
+	if(avformat_open_input(&m_formatCtx, "", findInputFormat(container), nullptr)!=0)
 	{
 		av_free(m_aviocontext);
 		AUD_THROW(FileException, "Buffer couldn't be read with ffmpeg.");
@@ -222,7 +372,7 @@ FFMPEGReader::FFMPEGReader(std::shared_ptr<Buffer> buffer, int stream) :
 
 	try
 	{
-		init(stream);
+		init(stream, codec);
 	}
 	catch(Exception&)
 	{
@@ -276,6 +426,104 @@ std::vector<StreamInfo> FFMPEGReader::queryStreams()
 	return result;
 }
 
+void FFMPEGReader::buildSeekIndex()
+{
+	if(m_index_complete)
+		return;
+
+	int position = m_position;
+	auto stream = m_formatCtx->streams[m_stream];
+
+	if(av_seek_frame(m_formatCtx, m_stream, stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0, AVSEEK_FLAG_BACKWARD) >= 0)
+	{
+		AVPacket packet = {};
+		int ret;
+
+		m_index.clear();
+		m_index_contiguous = true;
+
+		while((ret = av_read_frame(m_formatCtx, &packet)) >= 0)
+		{
+			if(packet.stream_index == m_stream)
+				indexPacket(packet);
+			av_packet_unref(&packet);
+		}
+
+		m_index_complete = ret == AVERROR_EOF;
+	}
+
+	seek(position);
+}
+
+bool FFMPEGReader::loadSeekIndex(const std::string& filename)
+{
+	std::ifstream file(filename, std::ios::binary);
+
+	char magic[sizeof(SEEK_INDEX_MAGIC) - 1];
+	int64_t size;
+	int32_t stream;
+	uint8_t complete;
+	int64_t count;
+
+	file.read(magic, sizeof(magic));
+	file.read(reinterpret_cast<char*>(&size), sizeof(size));
+	file.read(reinterpret_cast<char*>(&stream), sizeof(stream));
+	file.read(reinterpret_cast<char*>(&complete), sizeof(complete));
+	file.read(reinterpret_cast<char*>(&count), sizeof(count));
+
+	// the index has to belong to the same file and stream
+	if(!file || std::memcmp(magic, SEEK_INDEX_MAGIC, sizeof(magic)) || size != avio_size(m_formatCtx->pb) || stream != m_stream)
+		return false;
+
+	// the entries have to fill the rest of the file exactly
+	std::streampos start = file.tellg();
+	file.seekg(0, std::ios::end);
+	std::streamoff remaining = file.tellg() - start;
+	file.seekg(start);
+
+	if(!file || count < 0 || remaining < 0 || count != int64_t(remaining / sizeof(SeekPoint)) || remaining % sizeof(SeekPoint))
+		return false;
+
+	std::vector<SeekPoint> index(count);
+
+	file.read(reinterpret_cast<char*>(index.data()), count * sizeof(SeekPoint));
+
+	if(!file)
+		return false;
+
+	for(int64_t i = 1; i < count; i++)
+	{
+		if(index[i].pts <= index[i - 1].pts || index[i].pos <= index[i - 1].pos)
+			return false;
+	}
+
+	m_index = std::move(index);
+	m_index_complete = complete;
+	// the current reading position isn't known to follow the loaded index
+	m_index_contiguous = false;
+
+	return true;
+}
+
+bool FFMPEGReader::saveSeekIndex(const std::string& filename) const
+{
+	std::ofstream file(filename, std::ios::binary);
+
+	int64_t size = avio_size(m_formatCtx->pb);
+	int32_t stream = m_stream;
+	uint8_t complete = m_index_complete;
+	int64_t count = m_index.size();
+
+	file.write(SEEK_INDEX_MAGIC, sizeof(SEEK_INDEX_MAGIC) - 1);
+	file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+	file.write(reinterpret_cast<const char*>(&stream), sizeof(stream));
+	file.write(reinterpret_cast<const char*>(&complete), sizeof(complete));
+	file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+	file.write(reinterpret_cast<const char*>(m_index.data()), count * sizeof(SeekPoint));
+
+	return bool(file);
+}
+
 int FFMPEGReader::read_packet(void* opaque, uint8_t* buf, int buf_size)
 {
 	FFMPEGReader* reader = reinterpret_cast<FFMPEGReader*>(opaque);
@@ -324,63 +572,65 @@ bool FFMPEGReader::isSeekable() const
 
 void FFMPEGReader::seek(int position)
 {
-	if(position >= 0)
-	{
-		double pts_time_base = av_q2d(m_formatCtx->streams[m_stream]->time_base);
+	if(position < 0)
+		return;
 
-		uint64_t st_time = m_formatCtx->streams[m_stream]->start_time;
-		uint64_t seek_pos = (uint64_t)(position / (pts_time_base * m_specs.rate));
+	// start decoding early enough for the decoder to be settled at the target
+	int64_t pts = toTimestamp(std::max(position - m_preroll, 0));
 
-		if(st_time != AV_NOPTS_VALUE)
-			seek_pos += st_time;
+	int start = seekIndexed(pts);
+	bool indexed = start >= 0;
 
-		// a value < 0 tells us that seeking failed
-		if(av_seek_frame(m_formatCtx, m_stream, seek_pos, AVSEEK_FLAG_BACKWARD | AVSEEK_FLAG_ANY) >= 0)
+	while(true)
+	{
+		if(!indexed)
 		{
-			avcodec_flush_buffers(m_codecCtx);
-			m_position = position;
-
-			AVPacket packet;
-			bool search = true;
-
-			while(search && av_read_frame(m_formatCtx, &packet) >= 0)
+			// a value < 0 tells us that seeking failed
+			if(av_seek_frame(m_formatCtx, m_stream, pts, AVSEEK_FLAG_BACKWARD | AVSEEK_FLAG_ANY) < 0)
 			{
-				// is it a frame from the audio stream?
-				if(packet.stream_index == m_stream)
-				{
-					// decode the package
-					m_pkgbuf_left = decode(packet, m_pkgbuf);
-					search = false;
-
-					// check position
-					if(packet.pts != AV_NOPTS_VALUE)
-					{
-						// calculate real position, and read to frame!
-						m_position = (packet.pts - (st_time != AV_NOPTS_VALUE ? st_time : 0)) * pts_time_base * m_specs.rate;
-
-						if(m_position < position)
-						{
-							// read until we're at the right position
-							int length = AUD_DEFAULT_BUFFER_SIZE;
-							Buffer buffer(length * AUD_SAMPLE_SIZE(m_specs));
-							bool eos;
-							for(int len = position - m_position; len > 0; len -= AUD_DEFAULT_BUFFER_SIZE)
-							{
-								if(len < AUD_DEFAULT_BUFFER_SIZE)
-									length = len;
-								read(length, eos, buffer.getBuffer());
-							}
-						}
-					}
-				}
-				av_packet_unref(&packet);
+				fprintf(stderr, "seeking failed!\n");
+				// Seeking failed, do nothing.
+				return;
 			}
+
+			// seeking backwards never lands after the timestamp
+			m_index_contiguous = m_index_complete || (m_index.empty() ? position <= m_preroll : pts <= m_index.back().pts);
+			start = position;
 		}
-		else
+
+		avcodec_flush_buffers(m_codecCtx);
+		m_frame_left = 0;
+		m_position = start;
+
+		if(!receiveFrame())
+			return;
+
+		int64_t frame_pts = m_frame->pts != AV_NOPTS_VALUE ? m_frame->pts : m_frame->best_effort_timestamp;
+
+		// calculate real position
+		if(frame_pts != AV_NOPTS_VALUE)
+			m_position = toPosition(frame_pts);
+
+		// a byte seek into a container that has to resync may skip past the target
+		if(indexed && m_position > position)
 		{
-			fprintf(stderr, "seeking failed!\n");
-			// Seeking failed, do nothing.
+			indexed = false;
+			continue;
 		}
+
+		break;
+	}
+
+	// decode up to the exact sample
+	while(m_position < position)
+	{
+		if(m_frame_left == 0 && !receiveFrame())
+			break;
+
+		int skip = std::min(m_frame_left, position - m_position);
+		m_frame_pos += skip;
+		m_frame_left -= skip;
+		m_position += skip;
 	}
 }
 
@@ -419,50 +669,29 @@ Specs FFMPEGReader::getSpecs() const
 
 void FFMPEGReader::read(int& length, bool& eos, sample_t* buffer)
 {
-	// read packages and decode them
-	AVPacket packet = {};
-	int data_size = 0;
-	int pkgbuf_pos;
 	int left = length;
+	int channels = m_specs.channels;
 	int sample_size = AUD_DEVICE_SAMPLE_SIZE(m_specs);
 
 	sample_t* buf = buffer;
-	pkgbuf_pos = m_pkgbuf_left;
-	m_pkgbuf_left = 0;
 
-	// there may still be data in the buffer from the last call
-	if(pkgbuf_pos > 0)
+	// convert straight from the decoded frames to the output buffer
+	while(left > 0)
 	{
-		data_size = std::min(pkgbuf_pos, left * sample_size);
-		m_convert((data_t*) buf, (data_t*) m_pkgbuf.getBuffer(), data_size / AUD_FORMAT_SIZE(m_specs.format));
-		buf += data_size / AUD_FORMAT_SIZE(m_specs.format);
-		left -= data_size / sample_size;
-	}
+		if(m_frame_left == 0 && !receiveFrame())
+			break;
 
-	// for each frame read as long as there isn't enough data already
-	while((left > 0) && (av_read_frame(m_formatCtx, &packet) >= 0))
-	{
-		// is it a frame from the audio stream?
-		if(packet.stream_index == m_stream)
-		{
-			// decode the package
-			pkgbuf_pos = decode(packet, m_pkgbuf);
-
-			// copy to output buffer
-			data_size = std::min(pkgbuf_pos, left * sample_size);
-			m_convert((data_t*) buf, (data_t*) m_pkgbuf.getBuffer(), data_size / AUD_FORMAT_SIZE(m_specs.format));
-			buf += data_size / AUD_FORMAT_SIZE(m_specs.format);
-			left -= data_size / sample_size;
-		}
-		av_packet_unref(&packet);
-	}
-	// read more data than necessary?
-	if(pkgbuf_pos > data_size)
-	{
-		m_pkgbuf_left = pkgbuf_pos-data_size;
-		memmove(m_pkgbuf.getBuffer(),
-				((data_t*)m_pkgbuf.getBuffer())+data_size,
-				pkgbuf_pos-data_size);
+		int count = std::min(left, m_frame_left);
+
+		if(m_tointerleave)
+			m_convert_planar((data_t*) buf, (data_t**) m_frame->extended_data, m_frame_pos, count, channels);
+		else
+			m_convert((data_t*) buf, m_frame->extended_data[0] + m_frame_pos * sample_size, count * channels);
+
+		buf += count * channels;
+		left -= count;
+		m_frame_pos += count;
+		m_frame_left -= count;
 	}
 
 	if((eos = (left > 0)))
@@ -30,6 +30,7 @@
 #include "IReader.h"
 #include "util/Buffer.h"
 #include "file/FileInfo.h"
+#include "file/IWriter.h"
 
 #include <string>
 #include <memory>
@@ -44,13 +45,30 @@ AUD_NAMESPACE_BEGIN
 
 /**
  * This class reads a sound file via ffmpeg.
- * \warning Seeking may not be accurate! Moreover the position is updated after
- *          a buffer reading call. So calling getPosition right after seek
- *          normally results in a wrong value.
+ *
+ * Seeking decodes from a few frames before the target and discards the samples
+ * up to it, so that it is sample accurate as long as the file has timestamps.
+ * Packets read from the start of the file are recorded in a seek index that
+ * maps their timestamps to byte offsets. Seeks within the index jump to the
+ * packet directly instead of searching the file, which is much faster for
+ * formats without a seek table like VBR MP3 or Ogg. The index can be built
+ * ahead with buildSeekIndex and kept in a sidecar file next to the sound file.
  */
 class AUD_PLUGIN_API FFMPEGReader : public IReader
 {
 private:
+	/**
+	 * An entry of the seek index.
+	 */
+	struct SeekPoint
+	{
+		/// The presentation timestamp of the packet in stream time base units.
+		int64_t pts;
+
+		/// The byte offset of the packet within the file.
+		int64_t pos;
+	};
+
 	/**
 	 * The current position in samples.
 	 */
@@ -62,14 +80,14 @@ private:
 	DeviceSpecs m_specs;
 
 	/**
-	 * The buffer for package reading.
+	 * The position of the next sample to read within the current frame.
 	 */
-	Buffer m_pkgbuf;
+	int m_frame_pos;
 
 	/**
-	 * The count of samples still available from the last read package.
+	 * The count of samples still available from the current frame.
 	 */
-	int m_pkgbuf_left;
+	int m_frame_left;
 
 	/**
 	 * The AVFormatContext structure for using ffmpeg.
@@ -101,6 +119,11 @@ private:
 	 */
 	convert_f m_convert;
 
+	/**
+	 * Converter function for planar sample formats.
+	 */
+	convert_planar_f m_convert_planar;
+
 	/**
 	 * The memory file to read from.
 	 */
@@ -117,10 +140,31 @@ private:
 	long long m_membufferpos;
 
 	/**
-	 * Whether the audio data has to be interleaved after reading.
+	 * Whether the audio data is planar and has to be interleaved while reading.
 	 */
 	bool m_tointerleave;
 
+	/**
+	 * The seek index of the audio stream, sorted by timestamp and offset.
+	 */
+	std::vector<SeekPoint> m_index;
+
+	/**
+	 * Whether the packets read next directly follow the last index entry.
+	 */
+	bool m_index_contiguous;
+
+	/**
+	 * Whether the seek index covers the whole stream.
+	 */
+	bool m_index_complete;
+
+	/**
+	 * The samples to decode before a seek target so that the decoder output
+	 * is valid from the target on.
+	 */
+	int m_preroll;
+
 	/**
 	 * Converts an ffmpeg sample format to an audaspace one.
 	 * \param format The AVSampleFormat sample format.
@@ -129,18 +173,71 @@ private:
 	AUD_LOCAL static SampleFormat convertSampleFormat(AVSampleFormat format);
 
 	/**
-	 * Decodes a packet into the given buffer.
-	 * \param packet The AVPacket to decode.
-	 * \param buffer The target buffer.
-	 * \return The count of read bytes.
+	 * Receives the next frame from the decoder into m_frame, reading and
+	 * decoding packets as necessary, and resets the read cursor to its start.
+	 * \return Whether a frame was received, false at the end of the stream.
+	 */
+	AUD_LOCAL bool receiveFrame();
+
+	/**
+	 * Adds a packet of the audio stream to the seek index if it directly
+	 * follows the last entry.
+	 * \param packet The packet read from the file.
+	 */
+	AUD_LOCAL void indexPacket(const AVPacket& packet);
+
+	/**
+	 * Converts a timestamp of the audio stream to a sample position.
+	 * \param pts The timestamp in stream time base units.
+	 * \return The sample position.
+	 */
+	AUD_LOCAL int toPosition(int64_t pts) const;
+
+	/**
+	 * Converts a sample position to a timestamp of the audio stream.
+	 * \param position The sample position.
+	 * \return The timestamp in stream time base units.
 	 */
-	AUD_LOCAL int decode(AVPacket& packet, Buffer& buffer);
+	AUD_LOCAL int64_t toTimestamp(int position) const;
+
+	/**
+	 * Seeks with the seek index to the last indexed packet before a timestamp.
+	 * \param pts The timestamp to seek to in stream time base units.
+	 * \return The sample position of the packet sought to or -1 if the index
+	 *         doesn't cover the timestamp or the file can't seek by bytes.
+	 */
+	AUD_LOCAL int seekIndexed(int64_t pts);
+
+	/**
+	 * Finds the demuxer of a container format.
+	 * \param container The container format.
+	 * \return The demuxer or nullptr to probe the format.
+	 */
+	AUD_LOCAL static const AVInputFormat* findInputFormat(Container container);
+
+	/**
+	 * Checks whether an ffmpeg codec is the expected codec.
+	 * \param id The ffmpeg codec.
+	 * \param codec The expected codec.
+	 * \return Whether the codecs match.
+	 */
+	AUD_LOCAL static bool matchesCodec(AVCodecID id, Codec codec);
+
+	/**
+	 * Finds an audio stream of the file.
+	 * \param stream The index of the audio stream within the file if it contains multiple audio streams.
+	 * \return The index of the stream within the file or -1 if there is none.
+	 */
+	AUD_LOCAL int findStream(int stream) const;
 
 	/**
 	 * Initializes the object.
 	 * \param stream The index of the audio stream within the file if it contains multiple audio streams.
+	 * \param codec The expected codec of the stream, CODEC_INVALID if unknown.
+	 *        If the stream has this codec and the header of the file already
+	 *        describes it completely, the stream info isn't probed.
 	 */
-	AUD_LOCAL void init(int stream);
+	AUD_LOCAL void init(int stream, Codec codec);
 
 	// delete copy constructor and operator=
 	FFMPEGReader(const FFMPEGReader&) = delete;
@@ -165,6 +262,18 @@ public:
 	 */
 	FFMPEGReader(std::shared_ptr<Buffer> buffer, int stream = 0);
 
+	/**
+	 * Creates a new reader for a buffer whose format is known, which saves
+	 * probing the format.
+	 * \param buffer The buffer to read from.
+	 * \param container The container format of the file, CONTAINER_INVALID to probe it.
+	 * \param codec The codec of the audio stream, CODEC_INVALID if unknown.
+	 * \param stream The index of the audio stream within the file if it contains multiple audio streams.
+	 * \exception Exception Thrown if the buffer specified cannot be read
+	 *                          with ffmpeg.
+	 */
+	FFMPEGReader(std::shared_ptr<Buffer> buffer, Container container, Codec codec, int stream = 0);
+
 	/**
 	 * Destroys the reader and closes the file.
 	 */
@@ -177,6 +286,31 @@ public:
 	 */
 	virtual std::vector<StreamInfo> queryStreams();
 
+	/**
+	 * Builds the complete seek index by reading through all packets of the
+	 * file without decoding them. Without calling this the index is built
+	 * lazily while the file is played from the start.
+	 * The reading position stays the same.
+	 */
+	void buildSeekIndex();
+
+	/**
+	 * Loads the seek index from a sidecar file written by saveSeekIndex.
+	 * \param filename The path of the sidecar file.
+	 * \return Whether the index could be read and belongs to this file. If
+	 *         not, the current index is kept and built as usual.
+	 */
+	bool loadSeekIndex(const std::string& filename);
+
+	/**
+	 * Saves the seek index to a sidecar file.
+	 * The file is written in the byte order of the machine and identifies the
+	 * sound file by its size.
+	 * \param filename The path of the sidecar file.
+	 * \return Whether the index could be written.
+	 */
+	bool saveSeekIndex(const std::string& filename) const;
+
 	/**
 	 * Reads data to a memory buffer.
 	 * This function is used for avio only.
@@ -42,6 +42,12 @@ std::shared_ptr<IReader> SndFile::createReader(std::shared_ptr<Buffer> buffer, i
 	return std::shared_ptr<IReader>(new SndFileReader(buffer));
 }
 
+std::shared_ptr<IReader> SndFile::createReader(std::shared_ptr<Buffer> buffer, Container container, Codec codec, int stream)
+{
+	// libsndfile only reads the header to find the format
+	return std::shared_ptr<IReader>(new SndFileReader(buffer));
+}
+
 std::vector<StreamInfo> SndFile::queryStreams(const std::string &filename)
 {
 	return SndFileReader(filename).queryStreams();
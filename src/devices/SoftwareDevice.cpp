@@ -15,11 +15,16 @@
  ******************************************************************************/
 
 #include "devices/SoftwareDevice.h"
+#include "file/File.h"
 #include "fx/PitchReader.h"
 #include "respec/ChannelMapperReader.h"
-#include "respec/JOSResampleReader.h"
 #include "respec/LinearResampleReader.h"
 #include "respec/Mixer.h"
+#include "respec/PolyphaseResampleReader.h"
+#include "util/Barrier.h"
+#include "util/PrefetchReader.h"
+#include "util/PrefetchThread.h"
+#include "util/SIMD.h"
 #include "Exception.h"
 #include "ISound.h"
 
@@ -30,6 +35,12 @@
 #include <limits>
 #include <mutex>
 
+#if defined(AUD_SIMD_X86)
+#include <immintrin.h>
+#elif defined(AUD_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
 AUD_NAMESPACE_BEGIN
 
 enum RenderFlags
@@ -42,47 +53,712 @@ enum RenderFlags
 
 #define PITCH_MAX 10
 
+#define COMMAND_QUEUE_SIZE 1024
+
+/******************************************************************************/
+/************************* Batched 3D Update Code *****************************/
+/******************************************************************************/
+
+/*
+ * The batched update gathers the parameters of all mono sounds into arrays,
+ * calculates the distance, Doppler pitch, volume and panning angle of all
+ * sounds with the kernels below and then writes the results back. The arrays
+ * are padded to a multiple of the widest vector with zeros, so the kernels
+ * need no tail handling. The calculations follow SoftwareHandle::update()
+ * operation by operation, the padded lanes' results are never used.
+ */
+
+#define SPATIAL_ARRAY_COUNT 24
+#define SPATIAL_ALIGNMENT 8
+
+/// The arrays of the batched 3D update, each holds one value per sound.
+struct SpatialArrays
+{
+	/// The vector from the source to the listener.
+	float* sl[3];
+
+	/// The velocity of the source.
+	float* velocity[3];
+
+	/// 1 if the source is positioned absolutely, 0 if relative to the listener.
+	float* absolute;
+
+	/// 1 if the Doppler effect is rendered.
+	float* doppler;
+
+	/// 1 if the distance attenuation is rendered, afterwards also 0 if the distance is 0.
+	float* distance_on;
+
+	/// 1 if the volume is calculated, else the volume stays.
+	float* volume_on;
+
+	float* user_pitch;
+	float* user_volume;
+	float* volume_max;
+	float* volume_min;
+	float* distance_max;
+	float* distance_reference;
+	float* attenuation;
+
+	/// The gain of the cone, 1 if the cone isn't rendered.
+	float* cone;
+
+	/// Output of the clamped distance.
+	float* distance;
+
+	/// Output of the distance attenuation.
+	float* gain;
+
+	/// Output of the pitch.
+	float* pitch;
+
+	/// The current volume, overwritten with the new volume.
+	float* volume;
+
+	/// Output of the cosine of the panning angle.
+	float* angle;
+
+	/// Output of the sign of the panning angle, 0 if the sound is in line with the listener.
+	float* angle_sign;
+
+	SpatialArrays(float* data, int count, int length)
+	{
+		float** arrays[SPATIAL_ARRAY_COUNT] = {
+			&sl[0], &sl[1], &sl[2], &velocity[0], &velocity[1], &velocity[2],
+			&absolute, &doppler, &distance_on, &volume_on, &user_pitch, &user_volume,
+			&volume_max, &volume_min, &distance_max, &distance_reference, &attenuation, &cone,
+			&distance, &gain, &pitch, &volume, &angle, &angle_sign
+		};
+
+		for(int i = 0; i < SPATIAL_ARRAY_COUNT; i++)
+		{
+			*arrays[i] = data + i * length;
+			std::memset(*arrays[i] + count, 0, (length - count) * sizeof(float));
+		}
+	}
+};
+
+/// The listener axes of the panning angle, see SoftwareHandle::update().
+struct SpatialOrientation
+{
+	/// The look at vector.
+	float z[3];
+
+	/// The up vector.
+	float n[3];
+
+	/// The cross product of up and look at vectors.
+	float cross[3];
+
+	/// The squared length of the up vector.
+	float n_square;
+
+	/// The length of the look at vector.
+	float z_length;
+
+	SpatialOrientation(const Quaternion& orientation)
+	{
+		Vector3 Z = orientation.getLookAt();
+		Vector3 N = orientation.getUp();
+		Vector3 C = N.cross(Z);
+
+		for(int i = 0; i < 3; i++)
+		{
+			z[i] = Z.get()[i];
+			n[i] = N.get()[i];
+			cross[i] = C.get()[i];
+		}
+
+		n_square = N * N;
+		z_length = Z.length();
+	}
+};
+
+/// The listener and device parameters of the batched 3D update.
+struct SpatialListener
+{
+	float velocity[3];
+	float speed_of_sound;
+	float doppler_factor;
+	DistanceModel distance_model;
+
+	/// The axes for absolutely positioned sources.
+	SpatialOrientation absolute;
+
+	/// The axes for sources relative to the listener.
+	SpatialOrientation relative;
+
+	SpatialListener(const Quaternion& orientation) :
+		absolute(orientation), relative(Quaternion())
+	{
+	}
+};
+
+static bool isClamped(DistanceModel model)
+{
+	return model == DISTANCE_MODEL_INVERSE_CLAMPED || model == DISTANCE_MODEL_LINEAR_CLAMPED || model == DISTANCE_MODEL_EXPONENT_CLAMPED;
+}
+
+static void spatialize_distance_scalar(const SpatialArrays& a, int length, const SpatialListener& l)
+{
+	float max = l.speed_of_sound / l.doppler_factor;
+	bool clamped = isClamped(l.distance_model);
+
+	for(int i = 0; i < length; i++)
+	{
+		float x = a.sl[0][i], y = a.sl[1][i], z = a.sl[2][i];
+		float distance = x * x + y * y + z * z;
+		bool has_distance = distance > 0;
+
+		distance = std::sqrt(distance);
+
+		a.pitch[i] = a.user_pitch[i];
+
+		if(a.doppler[i] > 0 && has_distance)
+		{
+			float vls = a.absolute[i] * ((x * l.velocity[0] + y * l.velocity[1] + z * l.velocity[2]) / distance);
+			float vss = (x * a.velocity[0][i] + y * a.velocity[1][i] + z * a.velocity[2][i]) / distance;
+
+			if(vss >= max)
+				a.pitch[i] = PITCH_MAX;
+			else
+			{
+				if(vls > max)
+					vls = max;
+
+				a.pitch[i] = (l.speed_of_sound - l.doppler_factor * vls) / (l.speed_of_sound - l.doppler_factor * vss) * a.user_pitch[i];
+			}
+		}
+
+		float gain = 1.0f;
+		bool distance_on = a.distance_on[i] > 0 && has_distance;
+
+		if(distance_on)
+		{
+			float reference = a.distance_reference[i];
+
+			if(clamped)
+				distance = std::max(std::min(a.distance_max[i], distance), reference);
+
+			switch(l.distance_model)
+			{
+			case DISTANCE_MODEL_INVERSE:
+			case DISTANCE_MODEL_INVERSE_CLAMPED:
+				gain = reference / (reference + a.attenuation[i] * (distance - reference));
+				break;
+			case DISTANCE_MODEL_LINEAR:
+			case DISTANCE_MODEL_LINEAR_CLAMPED:
+			{
+				float temp = a.distance_max[i] - reference;
+				if(temp == 0)
+					gain = distance > reference ? 0.0f : 1.0f;
+				else
+					gain = 1.0f - a.attenuation[i] * (distance - reference) / temp;
+				break;
+			}
+			default:
+				// the exponent models are calculated afterwards
+				break;
+			}
+		}
+
+		a.distance[i] = distance;
+		a.distance_on[i] = distance_on ? 1.0f : 0.0f;
+		a.gain[i] = gain;
+
+		// Angle
+
+		const SpatialOrientation& o = a.absolute[i] > 0 ? l.absolute : l.relative;
+
+		float s = (x * o.n[0] + y * o.n[1] + z * o.n[2]) / o.n_square;
+		float ax = o.n[0] * s - x, ay = o.n[1] * s - y, az = o.n[2] * s - z;
+		float a_square = ax * ax + ay * ay + az * az;
+
+		a.angle[i] = (o.z[0] * ax + o.z[1] * ay + o.z[2] * az) / (o.z_length * std::sqrt(a_square));
+
+		if(a_square > 0)
+			a.angle_sign[i] = (o.cross[0] * ax + o.cross[1] * ay + o.cross[2] * az) > 0 ? -1.0f : 1.0f;
+		else
+			a.angle_sign[i] = 0.0f;
+	}
+}
+
+static void spatialize_volume_scalar(const SpatialArrays& a, int length)
+{
+	for(int i = 0; i < length; i++)
+	{
+		if(!(a.volume_on[i] > 0))
+			continue;
+
+		float volume = a.gain[i] * a.cone[i];
+
+		if(volume > a.volume_max[i])
+			volume = a.volume_max[i];
+		else if(volume < a.volume_min[i])
+			volume = a.volume_min[i];
+
+		a.volume[i] = volume * a.user_volume[i];
+	}
+}
+
+#if defined(AUD_SIMD_X86)
+
+AUD_TARGET_SSE2 static inline __m128 select_sse2(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+AUD_TARGET_SSE2 static void spatialize_distance_sse2(const SpatialArrays& a, int length, const SpatialListener& l)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 speed = _mm_set1_ps(l.speed_of_sound);
+	const __m128 factor = _mm_set1_ps(l.doppler_factor);
+	const __m128 max = _mm_set1_ps(l.speed_of_sound / l.doppler_factor);
+	const __m128 pitch_max = _mm_set1_ps(PITCH_MAX);
+	const __m128 lx = _mm_set1_ps(l.velocity[0]), ly = _mm_set1_ps(l.velocity[1]), lz = _mm_set1_ps(l.velocity[2]);
+	bool clamped = isClamped(l.distance_model);
+
+	for(int i = 0; i < length; i += 4)
+	{
+		__m128 x = _mm_load_ps(a.sl[0] + i), y = _mm_load_ps(a.sl[1] + i), z = _mm_load_ps(a.sl[2] + i);
+		__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+		__m128 has_distance = _mm_cmpgt_ps(distance, zero);
+
+		distance = _mm_sqrt_ps(distance);
+
+		// Doppler and pitch
+		__m128 user_pitch = _mm_load_ps(a.user_pitch + i);
+		__m128 vls = _mm_mul_ps(_mm_load_ps(a.absolute + i), _mm_div_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, lx), _mm_mul_ps(y, ly)), _mm_mul_ps(z, lz)), distance));
+		__m128 vss = _mm_div_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_load_ps(a.velocity[0] + i)), _mm_mul_ps(y, _mm_load_ps(a.velocity[1] + i))), _mm_mul_ps(z, _mm_load_ps(a.velocity[2] + i))), distance);
+		vls = _mm_min_ps(vls, max);
+
+		__m128 pitch = _mm_mul_ps(_mm_div_ps(_mm_sub_ps(speed, _mm_mul_ps(factor, vls)), _mm_sub_ps(speed, _mm_mul_ps(factor, vss))), user_pitch);
+		pitch = select_sse2(_mm_cmpge_ps(vss, max), pitch_max, pitch);
+
+		__m128 doppler = _mm_and_ps(_mm_cmpgt_ps(_mm_load_ps(a.doppler + i), zero), has_distance);
+		_mm_store_ps(a.pitch + i, select_sse2(doppler, pitch, user_pitch));
+
+		// Distance
+		__m128 distance_on = _mm_and_ps(_mm_cmpgt_ps(_mm_load_ps(a.distance_on + i), zero), has_distance);
+		__m128 reference = _mm_load_ps(a.distance_reference + i);
+		__m128 distance_max = _mm_load_ps(a.distance_max + i);
+		__m128 attenuation = _mm_load_ps(a.attenuation + i);
+		__m128 gain = one;
+
+		if(clamped)
+			distance = _mm_max_ps(_mm_min_ps(distance_max, distance), reference);
+
+		switch(l.distance_model)
+		{
+		case DISTANCE_MODEL_INVERSE:
+		case DISTANCE_MODEL_INVERSE_CLAMPED:
+			gain = _mm_div_ps(reference, _mm_add_ps(reference, _mm_mul_ps(attenuation, _mm_sub_ps(distance, reference))));
+			break;
+		case DISTANCE_MODEL_LINEAR:
+		case DISTANCE_MODEL_LINEAR_CLAMPED:
+		{
+			__m128 temp = _mm_sub_ps(distance_max, reference);
+			__m128 linear = _mm_sub_ps(one, _mm_div_ps(_mm_mul_ps(attenuation, _mm_sub_ps(distance, reference)), temp));
+			__m128 step = select_sse2(_mm_cmpgt_ps(distance, reference), zero, one);
+			gain = select_sse2(_mm_cmpeq_ps(temp, zero), step, linear);
+			break;
+		}
+		default:
+			break;
+		}
+
+		_mm_store_ps(a.distance + i, distance);
+		_mm_store_ps(a.distance_on + i, _mm_and_ps(distance_on, one));
+		_mm_store_ps(a.gain + i, select_sse2(distance_on, gain, one));
+
+		// Angle
+		__m128 absolute = _mm_cmpgt_ps(_mm_load_ps(a.absolute + i), zero);
+		__m128 nx = select_sse2(absolute, _mm_set1_ps(l.absolute.n[0]), _mm_set1_ps(l.relative.n[0]));
+		__m128 ny = select_sse2(absolute, _mm_set1_ps(l.absolute.n[1]), _mm_set1_ps(l.relative.n[1]));
+		__m128 nz = select_sse2(absolute, _mm_set1_ps(l.absolute.n[2]), _mm_set1_ps(l.relative.n[2]));
+		__m128 n_square = select_sse2(absolute, _mm_set1_ps(l.absolute.n_square), _mm_set1_ps(l.relative.n_square));
+
+		__m128 s = _mm_div_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, nx), _mm_mul_ps(y, ny)), _mm_mul_ps(z, nz)), n_square);
+		__m128 ax = _mm_sub_ps(_mm_mul_ps(nx, s), x), ay = _mm_sub_ps(_mm_mul_ps(ny, s), y), az = _mm_sub_ps(_mm_mul_ps(nz, s), z);
+		__m128 a_square = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, ax), _mm_mul_ps(ay, ay)), _mm_mul_ps(az, az));
+
+		__m128 zx = select_sse2(absolute, _mm_set1_ps(l.absolute.z[0]), _mm_set1_ps(l.relative.z[0]));
+		__m128 zy = select_sse2(absolute, _mm_set1_ps(l.absolute.z[1]), _mm_set1_ps(l.relative.z[1]));
+		__m128 zz = select_sse2(absolute, _mm_set1_ps(l.absolute.z[2]), _mm_set1_ps(l.relative.z[2]));
+		__m128 z_length = select_sse2(absolute, _mm_set1_ps(l.absolute.z_length), _mm_set1_ps(l.relative.z_length));
+		__m128 za = _mm_add_ps(_mm_add_ps(_mm_mul_ps(zx, ax), _mm_mul_ps(zy, ay)), _mm_mul_ps(zz, az));
+		_mm_store_ps(a.angle + i, _mm_div_ps(za, _mm_mul_ps(z_length, _mm_sqrt_ps(a_square))));
+
+		__m128 cx = select_sse2(absolute, _mm_set1_ps(l.absolute.cross[0]), _mm_set1_ps(l.relative.cross[0]));
+		__m128 cy = select_sse2(absolute, _mm_set1_ps(l.absolute.cross[1]), _mm_set1_ps(l.relative.cross[1]));
+		__m128 cz = select_sse2(absolute, _mm_set1_ps(l.absolute.cross[2]), _mm_set1_ps(l.relative.cross[2]));
+		__m128 ca = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, ax), _mm_mul_ps(cy, ay)), _mm_mul_ps(cz, az));
+		__m128 sign = select_sse2(_mm_cmpgt_ps(ca, zero), _mm_set1_ps(-1.0f), one);
+		_mm_store_ps(a.angle_sign + i, _mm_and_ps(_mm_cmpgt_ps(a_square, zero), sign));
+	}
+}
+
+AUD_TARGET_SSE2 static void spatialize_volume_sse2(const SpatialArrays& a, int length)
+{
+	const __m128 zero = _mm_setzero_ps();
+
+	for(int i = 0; i < length; i += 4)
+	{
+		__m128 volume = _mm_mul_ps(_mm_load_ps(a.gain + i), _mm_load_ps(a.cone + i));
+		__m128 volume_max = _mm_load_ps(a.volume_max + i);
+		__m128 volume_min = _mm_load_ps(a.volume_min + i);
+
+		__m128 clamped = select_sse2(_mm_cmplt_ps(volume, volume_min), volume_min, volume);
+		volume = select_sse2(_mm_cmpgt_ps(volume, volume_max), volume_max, clamped);
+		volume = _mm_mul_ps(volume, _mm_load_ps(a.user_volume + i));
+
+		_mm_store_ps(a.volume + i, select_sse2(_mm_cmpgt_ps(_mm_load_ps(a.volume_on + i), zero), volume, _mm_load_ps(a.volume + i)));
+	}
+}
+
+AUD_TARGET_AVX2 static void spatialize_distance_avx2(const SpatialArrays& a, int length, const SpatialListener& l)
+{
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 speed = _mm256_set1_ps(l.speed_of_sound);
+	const __m256 factor = _mm256_set1_ps(l.doppler_factor);
+	const __m256 max = _mm256_set1_ps(l.speed_of_sound / l.doppler_factor);
+	const __m256 pitch_max = _mm256_set1_ps(PITCH_MAX);
+	const __m256 lx = _mm256_set1_ps(l.velocity[0]), ly = _mm256_set1_ps(l.velocity[1]), lz = _mm256_set1_ps(l.velocity[2]);
+	bool clamped = isClamped(l.distance_model);
+
+	for(int i = 0; i < length; i += 8)
+	{
+		__m256 x = _mm256_load_ps(a.sl[0] + i), y = _mm256_load_ps(a.sl[1] + i), z = _mm256_load_ps(a.sl[2] + i);
+		__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z));
+		__m256 has_distance = _mm256_cmp_ps(distance, zero, _CMP_GT_OQ);
+
+		distance = _mm256_sqrt_ps(distance);
+
+		// Doppler and pitch
+		__m256 user_pitch = _mm256_load_ps(a.user_pitch + i);
+		__m256 vls = _mm256_mul_ps(_mm256_load_ps(a.absolute + i), _mm256_div_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, lx), _mm256_mul_ps(y, ly)), _mm256_mul_ps(z, lz)), distance));
+		__m256 vss = _mm256_div_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, _mm256_load_ps(a.velocity[0] + i)), _mm256_mul_ps(y, _mm256_load_ps(a.velocity[1] + i))), _mm256_mul_ps(z, _mm256_load_ps(a.velocity[2] + i))), distance);
+		vls = _mm256_min_ps(vls, max);
+
+		__m256 pitch = _mm256_mul_ps(_mm256_div_ps(_mm256_sub_ps(speed, _mm256_mul_ps(factor, vls)), _mm256_sub_ps(speed, _mm256_mul_ps(factor, vss))), user_pitch);
+		pitch = _mm256_blendv_ps(pitch, pitch_max, _mm256_cmp_ps(vss, max, _CMP_GE_OQ));
+
+		__m256 doppler = _mm256_and_ps(_mm256_cmp_ps(_mm256_load_ps(a.doppler + i), zero, _CMP_GT_OQ), has_distance);
+		_mm256_store_ps(a.pitch + i, _mm256_blendv_ps(user_pitch, pitch, doppler));
+
+		// Distance
+		__m256 distance_on = _mm256_and_ps(_mm256_cmp_ps(_mm256_load_ps(a.distance_on + i), zero, _CMP_GT_OQ), has_distance);
+		__m256 reference = _mm256_load_ps(a.distance_reference + i);
+		__m256 distance_max = _mm256_load_ps(a.distance_max + i);
+		__m256 attenuation = _mm256_load_ps(a.attenuation + i);
+		__m256 gain = one;
+
+		if(clamped)
+			distance = _mm256_max_ps(_mm256_min_ps(distance_max, distance), reference);
+
+		switch(l.distance_model)
+		{
+		case DISTANCE_MODEL_INVERSE:
+		case DISTANCE_MODEL_INVERSE_CLAMPED:
+			gain = _mm256_div_ps(reference, _mm256_add_ps(reference, _mm256_mul_ps(attenuation, _mm256_sub_ps(distance, reference))));
+			break;
+		case DISTANCE_MODEL_LINEAR:
+		case DISTANCE_MODEL_LINEAR_CLAMPED:
+		{
+			__m256 temp = _mm256_sub_ps(distance_max, reference);
+			__m256 linear = _mm256_sub_ps(one, _mm256_div_ps(_mm256_mul_ps(attenuation, _mm256_sub_ps(distance, reference)), temp));
+			__m256 step = _mm256_blendv_ps(one, zero, _mm256_cmp_ps(distance, reference, _CMP_GT_OQ));
+			gain = _mm256_blendv_ps(linear, step, _mm256_cmp_ps(temp, zero, _CMP_EQ_OQ));
+			break;
+		}
+		default:
+			break;
+		}
+
+		_mm256_store_ps(a.distance + i, distance);
+		_mm256_store_ps(a.distance_on + i, _mm256_and_ps(distance_on, one));
+		_mm256_store_ps(a.gain + i, _mm256_blendv_ps(one, gain, distance_on));
+
+		// Angle
+		__m256 absolute = _mm256_cmp_ps(_mm256_load_ps(a.absolute + i), zero, _CMP_GT_OQ);
+		__m256 nx = _mm256_blendv_ps(_mm256_set1_ps(l.relative.n[0]), _mm256_set1_ps(l.absolute.n[0]), absolute);
+		__m256 ny = _mm256_blendv_ps(_mm256_set1_ps(l.relative.n[1]), _mm256_set1_ps(l.absolute.n[1]), absolute);
+		__m256 nz = _mm256_blendv_ps(_mm256_set1_ps(l.relative.n[2]), _mm256_set1_ps(l.absolute.n[2]), absolute);
+		__m256 n_square = _mm256_blendv_ps(_mm256_set1_ps(l.relative.n_square), _mm256_set1_ps(l.absolute.n_square), absolute);
+
+		__m256 s = _mm256_div_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, nx), _mm256_mul_ps(y, ny)), _mm256_mul_ps(z, nz)), n_square);
+		__m256 ax = _mm256_sub_ps(_mm256_mul_ps(nx, s), x), ay = _mm256_sub_ps(_mm256_mul_ps(ny, s), y), az = _mm256_sub_ps(_mm256_mul_ps(nz, s), z);
+		__m256 a_square = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, ax), _mm256_mul_ps(ay, ay)), _mm256_mul_ps(az, az));
+
+		__m256 zx = _mm256_blendv_ps(_mm256_set1_ps(l.relative.z[0]), _mm256_set1_ps(l.absolute.z[0]), absolute);
+		__m256 zy = _mm256_blendv_ps(_mm256_set1_ps(l.relative.z[1]), _mm256_set1_ps(l.absolute.z[1]), absolute);
+		__m256 zz = _mm256_blendv_ps(_mm256_set1_ps(l.relative.z[2]), _mm256_set1_ps(l.absolute.z[2]), absolute);
+		__m256 z_length = _mm256_blendv_ps(_mm256_set1_ps(l.relative.z_length), _mm256_set1_ps(l.absolute.z_length), absolute);
+		__m256 za = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(zx, ax), _mm256_mul_ps(zy, ay)), _mm256_mul_ps(zz, az));
+		_mm256_store_ps(a.angle + i, _mm256_div_ps(za, _mm256_mul_ps(z_length, _mm256_sqrt_ps(a_square))));
+
+		__m256 cx = _mm256_blendv_ps(_mm256_set1_ps(l.relative.cross[0]), _mm256_set1_ps(l.absolute.cross[0]), absolute);
+		__m256 cy = _mm256_blendv_ps(_mm256_set1_ps(l.relative.cross[1]), _mm256_set1_ps(l.absolute.cross[1]), absolute);
+		__m256 cz = _mm256_blendv_ps(_mm256_set1_ps(l.relative.cross[2]), _mm256_set1_ps(l.absolute.cross[2]), absolute);
+		__m256 ca = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, ax), _mm256_mul_ps(cy, ay)), _mm256_mul_ps(cz, az));
+		__m256 sign = _mm256_blendv_ps(one, _mm256_set1_ps(-1.0f), _mm256_cmp_ps(ca, zero, _CMP_GT_OQ));
+		_mm256_store_ps(a.angle_sign + i, _mm256_and_ps(_mm256_cmp_ps(a_square, zero, _CMP_GT_OQ), sign));
+	}
+}
+
+AUD_TARGET_AVX2 static void spatialize_volume_avx2(const SpatialArrays& a, int length)
+{
+	const __m256 zero = _mm256_setzero_ps();
+
+	for(int i = 0; i < length; i += 8)
+	{
+		__m256 volume = _mm256_mul_ps(_mm256_load_ps(a.gain + i), _mm256_load_ps(a.cone + i));
+		__m256 volume_max = _mm256_load_ps(a.volume_max + i);
+		__m256 volume_min = _mm256_load_ps(a.volume_min + i);
+
+		__m256 clamped = _mm256_blendv_ps(volume, volume_min, _mm256_cmp_ps(volume, volume_min, _CMP_LT_OQ));
+		volume = _mm256_blendv_ps(clamped, volume_max, _mm256_cmp_ps(volume, volume_max, _CMP_GT_OQ));
+		volume = _mm256_mul_ps(volume, _mm256_load_ps(a.user_volume + i));
+
+		_mm256_store_ps(a.volume + i, _mm256_blendv_ps(_mm256_load_ps(a.volume + i), volume, _mm256_cmp_ps(_mm256_load_ps(a.volume_on + i), zero, _CMP_GT_OQ)));
+	}
+}
+
+#elif defined(AUD_SIMD_NEON)
+
+static void spatialize_distance_neon(const SpatialArrays& a, int length, const SpatialListener& l)
+{
+	const float32x4_t zero = vdupq_n_f32(0.0f);
+	const float32x4_t one = vdupq_n_f32(1.0f);
+	const float32x4_t speed = vdupq_n_f32(l.speed_of_sound);
+	const float32x4_t factor = vdupq_n_f32(l.doppler_factor);
+	const float32x4_t max = vdupq_n_f32(l.speed_of_sound / l.doppler_factor);
+	const float32x4_t pitch_max = vdupq_n_f32(PITCH_MAX);
+	const float32x4_t lx = vdupq_n_f32(l.velocity[0]), ly = vdupq_n_f32(l.velocity[1]), lz = vdupq_n_f32(l.velocity[2]);
+	bool clamped = isClamped(l.distance_model);
+
+	for(int i = 0; i < length; i += 4)
+	{
+		float32x4_t x = vld1q_f32(a.sl[0] + i), y = vld1q_f32(a.sl[1] + i), z = vld1q_f32(a.sl[2] + i);
+		float32x4_t distance = vaddq_f32(vaddq_f32(vmulq_f32(x, x), vmulq_f32(y, y)), vmulq_f32(z, z));
+		uint32x4_t has_distance = vcgtq_f32(distance, zero);
+
+		distance = vsqrtq_f32(distance);
+
+		// Doppler and pitch
+		float32x4_t user_pitch = vld1q_f32(a.user_pitch + i);
+		float32x4_t vls = vmulq_f32(vld1q_f32(a.absolute + i), vdivq_f32(vaddq_f32(vaddq_f32(vmulq_f32(x, lx), vmulq_f32(y, ly)), vmulq_f32(z, lz)), distance));
+		float32x4_t vss = vdivq_f32(vaddq_f32(vaddq_f32(vmulq_f32(x, vld1q_f32(a.velocity[0] + i)), vmulq_f32(y, vld1q_f32(a.velocity[1] + i))), vmulq_f32(z, vld1q_f32(a.velocity[2] + i))), distance);
+		vls = vbslq_f32(vcgtq_f32(vls, max), max, vls);
+
+		float32x4_t pitch = vmulq_f32(vdivq_f32(vsubq_f32(speed, vmulq_f32(factor, vls)), vsubq_f32(speed, vmulq_f32(factor, vss))), user_pitch);
+		pitch = vbslq_f32(vcgeq_f32(vss, max), pitch_max, pitch);
+
+		uint32x4_t doppler = vandq_u32(vcgtq_f32(vld1q_f32(a.doppler + i), zero), has_distance);
+		vst1q_f32(a.pitch + i, vbslq_f32(doppler, pitch, user_pitch));
+
+		// Distance
+		uint32x4_t distance_on = vandq_u32(vcgtq_f32(vld1q_f32(a.distance_on + i), zero), has_distance);
+		float32x4_t reference = vld1q_f32(a.distance_reference + i);
+		float32x4_t distance_max = vld1q_f32(a.distance_max + i);
+		float32x4_t attenuation = vld1q_f32(a.attenuation + i);
+		float32x4_t gain = one;
+
+		if(clamped)
+		{
+			distance = vbslq_f32(vcltq_f32(distance_max, distance), distance_max, distance);
+			distance = vbslq_f32(vcltq_f32(distance, reference), reference, distance);
+		}
+
+		switch(l.distance_model)
+		{
+		case DISTANCE_MODEL_INVERSE:
+		case DISTANCE_MODEL_INVERSE_CLAMPED:
+			gain = vdivq_f32(reference, vaddq_f32(reference, vmulq_f32(attenuation, vsubq_f32(distance, reference))));
+			break;
+		case DISTANCE_MODEL_LINEAR:
+		case DISTANCE_MODEL_LINEAR_CLAMPED:
+		{
+			float32x4_t temp = vsubq_f32(distance_max, reference);
+			float32x4_t linear = vsubq_f32(one, vdivq_f32(vmulq_f32(attenuation, vsubq_f32(distance, reference)), temp));
+			float32x4_t step = vbslq_f32(vcgtq_f32(distance, reference), zero, one);
+			gain = vbslq_f32(vceqq_f32(temp, zero), step, linear);
+			break;
+		}
+		default:
+			break;
+		}
+
+		vst1q_f32(a.distance + i, distance);
+		vst1q_f32(a.distance_on + i, vbslq_f32(distance_on, one, zero));
+		vst1q_f32(a.gain + i, vbslq_f32(distance_on, gain, one));
+
+		// Angle
+		uint32x4_t absolute = vcgtq_f32(vld1q_f32(a.absolute + i), zero);
+		float32x4_t nx = vbslq_f32(absolute, vdupq_n_f32(l.absolute.n[0]), vdupq_n_f32(l.relative.n[0]));
+		float32x4_t ny = vbslq_f32(absolute, vdupq_n_f32(l.absolute.n[1]), vdupq_n_f32(l.relative.n[1]));
+		float32x4_t nz = vbslq_f32(absolute, vdupq_n_f32(l.absolute.n[2]), vdupq_n_f32(l.relative.n[2]));
+		float32x4_t n_square = vbslq_f32(absolute, vdupq_n_f32(l.absolute.n_square), vdupq_n_f32(l.relative.n_square));
+
+		float32x4_t s = vdivq_f32(vaddq_f32(vaddq_f32(vmulq_f32(x, nx), vmulq_f32(y, ny)), vmulq_f32(z, nz)), n_square);
+		float32x4_t ax = vsubq_f32(vmulq_f32(nx, s), x), ay = vsubq_f32(vmulq_f32(ny, s), y), az = vsubq_f32(vmulq_f32(nz, s), z);
+		float32x4_t a_square = vaddq_f32(vaddq_f32(vmulq_f32(ax, ax), vmulq_f32(ay, ay)), vmulq_f32(az, az));
+
+		float32x4_t zx = vbslq_f32(absolute, vdupq_n_f32(l.absolute.z[0]), vdupq_n_f32(l.relative.z[0]));
+		float32x4_t zy = vbslq_f32(absolute, vdupq_n_f32(l.absolute.z[1]), vdupq_n_f32(l.relative.z[1]));
+		float32x4_t zz = vbslq_f32(absolute, vdupq_n_f32(l.absolute.z[2]), vdupq_n_f32(l.relative.z[2]));
+		float32x4_t z_length = vbslq_f32(absolute, vdupq_n_f32(l.absolute.z_length), vdupq_n_f32(l.relative.z_length));
+		float32x4_t za = vaddq_f32(vaddq_f32(vmulq_f32(zx, ax), vmulq_f32(zy, ay)), vmulq_f32(zz, az));
+		vst1q_f32(a.angle + i, vdivq_f32(za, vmulq_f32(z_length, vsqrtq_f32(a_square))));
+
+		float32x4_t cx = vbslq_f32(absolute, vdupq_n_f32(l.absolute.cross[0]), vdupq_n_f32(l.relative.cross[0]));
+		float32x4_t cy = vbslq_f32(absolute, vdupq_n_f32(l.absolute.cross[1]), vdupq_n_f32(l.relative.cross[1]));
+		float32x4_t cz = vbslq_f32(absolute, vdupq_n_f32(l.absolute.cross[2]), vdupq_n_f32(l.relative.cross[2]));
+		float32x4_t ca = vaddq_f32(vaddq_f32(vmulq_f32(cx, ax), vmulq_f32(cy, ay)), vmulq_f32(cz, az));
+		float32x4_t sign = vbslq_f32(vcgtq_f32(ca, zero), vdupq_n_f32(-1.0f), one);
+		vst1q_f32(a.angle_sign + i, vbslq_f32(vcgtq_f32(a_square, zero), sign, zero));
+	}
+}
+
+static void spatialize_volume_neon(const SpatialArrays& a, int length)
+{
+	const float32x4_t zero = vdupq_n_f32(0.0f);
+
+	for(int i = 0; i < length; i += 4)
+	{
+		float32x4_t volume = vmulq_f32(vld1q_f32(a.gain + i), vld1q_f32(a.cone + i));
+		float32x4_t volume_max = vld1q_f32(a.volume_max + i);
+		float32x4_t volume_min = vld1q_f32(a.volume_min + i);
+
+		float32x4_t clamped = vbslq_f32(vcltq_f32(volume, volume_min), volume_min, volume);
+		volume = vbslq_f32(vcgtq_f32(volume, volume_max), volume_max, clamped);
+		volume = vmulq_f32(volume, vld1q_f32(a.user_volume + i));
+
+		vst1q_f32(a.volume + i, vbslq_f32(vcgtq_f32(vld1q_f32(a.volume_on + i), zero), volume, vld1q_f32(a.volume + i)));
+	}
+}
+
+#endif
+
 /******************************************************************************/
 /********************** SoftwareHandle Handle Code ************************/
 /******************************************************************************/
 
+SoftwareDevice::SoundList::SoundList() :
+	first(nullptr), last(nullptr), size(0)
+{
+}
+
+bool SoftwareDevice::SoundList::empty() const
+{
+	return first == nullptr;
+}
+
+bool SoftwareDevice::SoundList::contains(SoftwareHandle* sound) const
+{
+	return sound->m_list == this;
+}
+
+void SoftwareDevice::SoundList::push_back(SoftwareHandle* sound)
+{
+	sound->m_list = this;
+	sound->m_prev = last;
+	sound->m_next = nullptr;
+
+	if(last)
+		last->m_next = sound;
+	else
+		first = sound;
+
+	last = sound;
+	size++;
+}
+
+void SoftwareDevice::SoundList::remove(SoftwareHandle* sound)
+{
+	if(sound->m_prev)
+		sound->m_prev->m_next = sound->m_next;
+	else
+		first = sound->m_next;
+
+	if(sound->m_next)
+		sound->m_next->m_prev = sound->m_prev;
+	else
+		last = sound->m_prev;
+
+	sound->m_list = nullptr;
+	sound->m_prev = nullptr;
+	sound->m_next = nullptr;
+	size--;
+}
+
+SoftwareDevice::HandleCommand::HandleCommand(CommandType type) :
+	type(type), value(0), flag(false), count(0), position(0), callback(nullptr), data(nullptr)
+{
+}
+
 bool SoftwareDevice::SoftwareHandle::pause(bool keep)
 {
 	if(m_status)
 	{
 		std::lock_guard<ILockable> lock(*m_device);
 
-		if(m_status == STATUS_PLAYING)
+		if(m_status == STATUS_PLAYING && m_device->m_playingSounds.contains(this))
 		{
-			for(auto it = m_device->m_playingSounds.begin(); it != m_device->m_playingSounds.end(); it++)
-			{
-				if(it->get() == this)
-				{
-					std::shared_ptr<SoftwareHandle> This = *it;
-
-					m_device->m_playingSounds.erase(it);
-					m_device->m_pausedSounds.push_back(This);
+			m_device->m_playingSounds.remove(this);
+			m_device->m_pausedSounds.push_back(this);
 
-					if(m_device->m_playingSounds.empty())
-						m_device->playing(m_device->m_playback = false);
+			if(m_device->m_playingSounds.empty())
+				m_device->playing(m_device->m_playback = false);
 
-					m_status = keep ? STATUS_STOPPED : STATUS_PAUSED;
+			m_status = keep ? STATUS_STOPPED : STATUS_PAUSED;
 
-					return true;
-				}
-			}
+			return true;
 		}
 	}
 
 	return false;
 }
 
-SoftwareDevice::SoftwareHandle::SoftwareHandle(SoftwareDevice* device, std::shared_ptr<IReader> reader, std::shared_ptr<PitchReader> pitch, std::shared_ptr<ResampleReader> resampler, std::shared_ptr<ChannelMapperReader> mapper, bool keep) :
-	m_reader(reader), m_pitch(pitch), m_resampler(resampler), m_mapper(mapper), m_first_reading(true), m_keep(keep), m_user_pitch(1.0f), m_user_volume(1.0f), m_user_pan(0.0f), m_volume(0.0f), m_old_volume(0.0f), m_loopcount(0),
-	m_relative(true), m_volume_max(1.0f), m_volume_min(0), m_distance_max(std::numeric_limits<float>::max()),
-	m_distance_reference(1.0f), m_attenuation(1.0f), m_cone_angle_outer(M_PI), m_cone_angle_inner(M_PI), m_cone_volume_outer(0),
-	m_flags(RENDER_CONE), m_stop(nullptr), m_stop_data(nullptr), m_status(STATUS_PLAYING), m_device(device)
+SoftwareDevice::SoftwareHandle::SoftwareHandle(SoftwareDevice* device, std::shared_ptr<PitchReader> pitch, std::shared_ptr<ResampleReader> resampler, std::shared_ptr<ChannelMapperReader> mapper, ResampleQuality quality) :
+	m_reader(mapper), m_pitch(pitch), m_resampler(resampler), m_mapper(mapper), m_quality(quality), m_list(nullptr), m_prev(nullptr), m_next(nullptr), m_status(STATUS_INVALID), m_device(device), m_position(0), m_source_length(-1)
+{
+	reset(false);
+}
+
+void SoftwareDevice::SoftwareHandle::reset(bool keep)
 {
+	m_first_reading = true;
+	m_keep = keep;
+	m_user_pitch = 1.0f;
+	m_user_volume = 1.0f;
+	m_user_pan = 0.0f;
+	m_volume = 0.0f;
+	m_old_volume = 0.0f;
+	m_loopcount = 0;
+	m_location = Vector3();
+	m_velocity = Vector3();
+	m_orientation = Quaternion();
+	m_relative = true;
+	m_volume_max = 1.0f;
+	m_volume_min = 0;
+	m_distance_max = std::numeric_limits<float>::max();
+	m_distance_reference = 1.0f;
+	m_attenuation = 1.0f;
+	m_cone_angle_outer = M_PI;
+	m_cone_angle_inner = M_PI;
+	m_cone_volume_outer = 0;
+	m_flags = RENDER_CONE;
+	m_stop = nullptr;
+	m_stop_data = nullptr;
+	m_position = 0;
+	m_priority = 0;
+	m_virtual = false;
+	m_virtual_position = 0;
+	m_rendered = false;
+	m_pitch->setPitch(1.0f);
 }
 
 void SoftwareDevice::SoftwareHandle::update()
@@ -260,44 +936,46 @@ void SoftwareDevice::SoftwareHandle::setSpecs(Specs specs)
 	m_resampler->setRate(specs.rate);
 }
 
-bool SoftwareDevice::SoftwareHandle::pause()
+int SoftwareDevice::SoftwareHandle::getSamplePosition()
 {
-	return pause(false);
+	if(m_virtual)
+		return m_virtual_position * m_device->m_specs.rate / m_pitch->getSpecs().rate;
+
+	return m_reader->getPosition();
 }
 
-bool SoftwareDevice::SoftwareHandle::resume()
+void SoftwareDevice::SoftwareHandle::updateVirtualPosition()
 {
-	if(m_status)
-	{
-		std::lock_guard<ILockable> lock(*m_device);
-
-		if(m_status == STATUS_PAUSED)
-		{
-			for(auto it = m_device->m_pausedSounds.begin(); it != m_device->m_pausedSounds.end(); it++)
-			{
-				if(it->get() == this)
-				{
-					std::shared_ptr<SoftwareHandle> This = *it;
-
-					m_device->m_pausedSounds.erase(it);
+	m_virtual_position = m_reader->getPosition() * m_pitch->getSpecs().rate / m_device->m_specs.rate;
+}
 
-					m_device->m_playingSounds.push_back(This);
+bool SoftwareDevice::SoftwareHandle::advance(int length)
+{
+	// the pitch reader's rate includes the pitch
+	m_virtual_position += length * m_pitch->getSpecs().rate / m_device->m_specs.rate;
 
-					if(!m_device->m_playback)
-						m_device->playing(m_device->m_playback = true);
-					m_status = STATUS_PLAYING;
+	// the source isn't read while the sound is virtual, so its current length may not be the end
+	if(m_source_length <= 0)
+		return false;
 
-					return true;
-				}
-			}
+	while(m_virtual_position >= m_source_length)
+	{
+		if(!m_loopcount)
+		{
+			m_virtual_position = m_source_length;
+			return true;
 		}
 
+		if(m_loopcount > 0)
+			m_loopcount--;
+
+		m_virtual_position -= m_source_length;
 	}
 
 	return false;
 }
 
-bool SoftwareDevice::SoftwareHandle::stop()
+bool SoftwareDevice::SoftwareHandle::invalidate()
 {
 	if(!m_status)
 		return false;
@@ -307,78 +985,248 @@ bool SoftwareDevice::SoftwareHandle::stop()
 	if(!m_status)
 		return false;
 
-	m_status = STATUS_INVALID;
+	bool result = true;
 
-	for(auto it = m_device->m_playingSounds.begin(); it != m_device->m_playingSounds.end(); it++)
+	if(m_device->m_playingSounds.contains(this))
 	{
-		if(it->get() == this)
-		{
-			std::shared_ptr<SoftwareHandle> This = *it;
+		m_device->m_playingSounds.remove(this);
 
-			m_device->m_playingSounds.erase(it);
+		if(m_device->m_playingSounds.empty())
+			m_device->playing(m_device->m_playback = false);
+	}
+	else if(m_device->m_pausedSounds.contains(this))
+		m_device->m_pausedSounds.remove(this);
+	else
+		result = false;
 
-			if(m_device->m_playingSounds.empty())
-				m_device->playing(m_device->m_playback = false);
+	m_pitch->setReader(nullptr);
+
+	// the handle may be reused as soon as it is invalid, so this comes last
+	m_status = STATUS_INVALID;
+
+	return result;
+}
+
+bool SoftwareDevice::SoftwareHandle::apply(const HandleCommand& command)
+{
+	if(!m_status)
+		return false;
+
+	switch(command.type)
+	{
+	case COMMAND_PLAY:
+	{
+		std::lock_guard<ILockable> lock(*m_device);
+
+		if(m_list)
+			return false;
+
+		m_device->m_playingSounds.push_back(this);
+
+		if(!m_device->m_playback)
+			m_device->playing(m_device->m_playback = true);
+
+		return true;
+	}
+	case COMMAND_PAUSE:
+		return pause(false);
+	case COMMAND_RESUME:
+	{
+		std::lock_guard<ILockable> lock(*m_device);
+
+		if(m_status == STATUS_PAUSED && m_device->m_pausedSounds.contains(this))
+		{
+			m_device->m_pausedSounds.remove(this);
+			m_device->m_playingSounds.push_back(this);
+
+			if(!m_device->m_playback)
+				m_device->playing(m_device->m_playback = true);
+			m_status = STATUS_PLAYING;
 
 			return true;
 		}
+
+		return false;
 	}
+	case COMMAND_STOP:
+		return invalidate();
+	case COMMAND_KEEP:
+	{
+		std::lock_guard<ILockable> lock(*m_device);
+
+		if(!m_status)
+			return false;
+
+		m_keep = command.flag;
 
-	for(auto it = m_device->m_pausedSounds.begin(); it != m_device->m_pausedSounds.end(); it++)
+		return true;
+	}
+	case COMMAND_SEEK:
 	{
-		if(it->get() == this)
-		{
-			std::shared_ptr<SoftwareHandle> This = *it;
+		std::lock_guard<ILockable> lock(*m_device);
 
-			m_device->m_pausedSounds.erase(it);
+		if(!m_status)
+			return false;
 
-			return true;
+		m_pitch->setPitch(m_user_pitch);
+		m_reader->seek((int)(command.position * m_reader->getSpecs().rate));
+
+		if(m_virtual)
+			m_virtual_position = m_pitch->getPosition();
+
+		m_position = getSamplePosition();
+
+		if(m_status == STATUS_STOPPED)
+			m_status = STATUS_PAUSED;
+
+		return true;
+	}
+	case COMMAND_VOLUME:
+		m_user_volume = command.value;
+
+		if(command.value == 0)
+		{
+			m_old_volume = m_volume = command.value;
+			m_flags |= RENDER_VOLUME;
 		}
+		else
+			m_flags &= ~RENDER_VOLUME;
+
+		return true;
+	case COMMAND_PITCH:
+		if(command.value > 0.0f)
+			m_user_pitch = command.value;
+		return true;
+	case COMMAND_PANNING:
+		m_user_pan = command.value;
+		return true;
+	case COMMAND_LOOP_COUNT:
+		if(m_status == STATUS_STOPPED && (command.count > m_loopcount || command.count < 0))
+			m_status = STATUS_PAUSED;
+
+		m_loopcount = command.count;
+
+		return true;
+	case COMMAND_STOP_CALLBACK:
+	{
+		std::lock_guard<ILockable> lock(*m_device);
+
+		if(!m_status)
+			return false;
+
+		m_stop = command.callback;
+		m_stop_data = command.data;
+
+		return true;
 	}
+	case COMMAND_LOCATION:
+		m_location = command.vector;
+		return true;
+	case COMMAND_VELOCITY:
+		m_velocity = command.vector;
+		return true;
+	case COMMAND_ORIENTATION:
+		m_orientation = command.quaternion;
+		return true;
+	case COMMAND_RELATIVE:
+		m_relative = command.flag;
+		return true;
+	case COMMAND_VOLUME_MAXIMUM:
+		m_volume_max = command.value;
+		return true;
+	case COMMAND_VOLUME_MINIMUM:
+		m_volume_min = command.value;
+		return true;
+	case COMMAND_DISTANCE_MAXIMUM:
+		m_distance_max = command.value;
+		return true;
+	case COMMAND_DISTANCE_REFERENCE:
+		m_distance_reference = command.value;
+		return true;
+	case COMMAND_ATTENUATION:
+		m_attenuation = command.value;
+
+		if(command.value == 0)
+			m_flags |= RENDER_DISTANCE;
+		else
+			m_flags &= ~RENDER_DISTANCE;
+
+		return true;
+	case COMMAND_CONE_ANGLE_OUTER:
+		m_cone_angle_outer = command.value * M_PI / 360.0f;
+		return true;
+	case COMMAND_CONE_ANGLE_INNER:
+		if(command.value >= 360)
+			m_flags |= RENDER_CONE;
+		else
+			m_flags &= ~RENDER_CONE;
 
-	return false;
-}
+		m_cone_angle_inner = command.value * M_PI / 360.0f;
 
-bool SoftwareDevice::SoftwareHandle::getKeep()
-{
-	if(m_status)
-		return m_keep;
+		return true;
+	case COMMAND_CONE_VOLUME_OUTER:
+		m_cone_volume_outer = command.value;
+		return true;
+	case COMMAND_PRIORITY:
+		m_priority = command.count;
+		return true;
+	}
 
 	return false;
 }
 
-bool SoftwareDevice::SoftwareHandle::setKeep(bool keep)
+bool SoftwareDevice::SoftwareHandle::execute(HandleCommand& command)
 {
 	if(!m_status)
 		return false;
 
-	std::lock_guard<ILockable> lock(*m_device);
-
-	if(!m_status)
-		return false;
+	if(m_device->m_queueCommands)
+	{
+		command.handle = shared_from_this();
+		return m_device->queueCommand(command);
+	}
 
-	m_keep = keep;
+	return apply(command);
+}
 
-	return true;
+bool SoftwareDevice::SoftwareHandle::pause()
+{
+	HandleCommand command(COMMAND_PAUSE);
+	return execute(command);
 }
 
-bool SoftwareDevice::SoftwareHandle::seek(double position)
+bool SoftwareDevice::SoftwareHandle::resume()
 {
-	if(!m_status)
-		return false;
+	HandleCommand command(COMMAND_RESUME);
+	return execute(command);
+}
 
-	std::lock_guard<ILockable> lock(*m_device);
+bool SoftwareDevice::SoftwareHandle::stop()
+{
+	HandleCommand command(COMMAND_STOP);
+	return execute(command);
+}
 
-	if(!m_status)
-		return false;
+bool SoftwareDevice::SoftwareHandle::getKeep()
+{
+	if(m_status)
+		return m_keep;
 
-	m_pitch->setPitch(m_user_pitch);
-	m_reader->seek((int)(position * m_reader->getSpecs().rate));
+	return false;
+}
 
-	if(m_status == STATUS_STOPPED)
-		m_status = STATUS_PAUSED;
+bool SoftwareDevice::SoftwareHandle::setKeep(bool keep)
+{
+	HandleCommand command(COMMAND_KEEP);
+	command.flag = keep;
+	return execute(command);
+}
 
-	return true;
+bool SoftwareDevice::SoftwareHandle::seek(double position)
+{
+	HandleCommand command(COMMAND_SEEK);
+	command.position = position;
+	return execute(command);
 }
 
 double SoftwareDevice::SoftwareHandle::getPosition()
@@ -386,12 +1234,15 @@ double SoftwareDevice::SoftwareHandle::getPosition()
 	if(!m_status)
 		return false;
 
+	if(m_device->m_queueCommands)
+		return m_position / (double)m_device->m_specs.rate;
+
 	std::lock_guard<ILockable> lock(*m_device);
 
 	if(!m_status)
 		return 0.0f;
 
-	double position = m_reader->getPosition() / (double)m_device->m_specs.rate;
+	double position = getSamplePosition() / (double)m_device->m_specs.rate;
 
 	return position;
 }
@@ -408,19 +1259,9 @@ float SoftwareDevice::SoftwareHandle::getVolume()
 
 bool SoftwareDevice::SoftwareHandle::setVolume(float volume)
 {
-	if(!m_status)
-		return false;
-	m_user_volume = volume;
-
-	if(volume == 0)
-	{
-		m_old_volume = m_volume = volume;
-		m_flags |= RENDER_VOLUME;
-	}
-	else
-		m_flags &= ~RENDER_VOLUME;
-
-	return true;
+	HandleCommand command(COMMAND_VOLUME);
+	command.value = volume;
+	return execute(command);
 }
 
 float SoftwareDevice::SoftwareHandle::getPitch()
@@ -430,11 +1271,9 @@ float SoftwareDevice::SoftwareHandle::getPitch()
 
 bool SoftwareDevice::SoftwareHandle::setPitch(float pitch)
 {
-	if(!m_status)
-		return false;
-	if(pitch > 0.0f)
-		m_user_pitch = pitch;
-	return true;
+	HandleCommand command(COMMAND_PITCH);
+	command.value = pitch;
+	return execute(command);
 }
 
 int SoftwareDevice::SoftwareHandle::getLoopCount()
@@ -446,31 +1285,17 @@ int SoftwareDevice::SoftwareHandle::getLoopCount()
 
 bool SoftwareDevice::SoftwareHandle::setLoopCount(int count)
 {
-	if(!m_status)
-		return false;
-
-	if(m_status == STATUS_STOPPED && (count > m_loopcount || count < 0))
-		m_status = STATUS_PAUSED;
-
-	m_loopcount = count;
-
-	return true;
+	HandleCommand command(COMMAND_LOOP_COUNT);
+	command.count = count;
+	return execute(command);
 }
 
 bool SoftwareDevice::SoftwareHandle::setStopCallback(stopCallback callback, void* data)
 {
-	if(!m_status)
-		return false;
-
-	std::lock_guard<ILockable> lock(*m_device);
-
-	if(!m_status)
-		return false;
-
-	m_stop = callback;
-	m_stop_data = data;
-
-	return true;
+	HandleCommand command(COMMAND_STOP_CALLBACK);
+	command.callback = callback;
+	command.data = data;
+	return execute(command);
 }
 
 
@@ -489,12 +1314,9 @@ Vector3 SoftwareDevice::SoftwareHandle::getLocation()
 
 bool SoftwareDevice::SoftwareHandle::setLocation(const Vector3& location)
 {
-	if(!m_status)
-		return false;
-
-	m_location = location;
-
-	return true;
+	HandleCommand command(COMMAND_LOCATION);
+	command.vector = location;
+	return execute(command);
 }
 
 Vector3 SoftwareDevice::SoftwareHandle::getVelocity()
@@ -507,12 +1329,9 @@ Vector3 SoftwareDevice::SoftwareHandle::getVelocity()
 
 bool SoftwareDevice::SoftwareHandle::setVelocity(const Vector3& velocity)
 {
-	if(!m_status)
-		return false;
-
-	m_velocity = velocity;
-
-	return true;
+	HandleCommand command(COMMAND_VELOCITY);
+	command.vector = velocity;
+	return execute(command);
 }
 
 Quaternion SoftwareDevice::SoftwareHandle::getOrientation()
@@ -525,12 +1344,9 @@ Quaternion SoftwareDevice::SoftwareHandle::getOrientation()
 
 bool SoftwareDevice::SoftwareHandle::setOrientation(const Quaternion& orientation)
 {
-	if(!m_status)
-		return false;
-
-	m_orientation = orientation;
-
-	return true;
+	HandleCommand command(COMMAND_ORIENTATION);
+	command.quaternion = orientation;
+	return execute(command);
 }
 
 bool SoftwareDevice::SoftwareHandle::isRelative()
@@ -543,12 +1359,9 @@ bool SoftwareDevice::SoftwareHandle::isRelative()
 
 bool SoftwareDevice::SoftwareHandle::setRelative(bool relative)
 {
-	if(!m_status)
-		return false;
-
-	m_relative = relative;
-
-	return true;
+	HandleCommand command(COMMAND_RELATIVE);
+	command.flag = relative;
+	return execute(command);
 }
 
 float SoftwareDevice::SoftwareHandle::getVolumeMaximum()
@@ -561,12 +1374,9 @@ float SoftwareDevice::SoftwareHandle::getVolumeMaximum()
 
 bool SoftwareDevice::SoftwareHandle::setVolumeMaximum(float volume)
 {
-	if(!m_status)
-		return false;
-
-	m_volume_max = volume;
-
-	return true;
+	HandleCommand command(COMMAND_VOLUME_MAXIMUM);
+	command.value = volume;
+	return execute(command);
 }
 
 float SoftwareDevice::SoftwareHandle::getVolumeMinimum()
@@ -579,12 +1389,9 @@ float SoftwareDevice::SoftwareHandle::getVolumeMinimum()
 
 bool SoftwareDevice::SoftwareHandle::setVolumeMinimum(float volume)
 {
-	if(!m_status)
-		return false;
-
-	m_volume_min = volume;
-
-	return true;
+	HandleCommand command(COMMAND_VOLUME_MINIMUM);
+	command.value = volume;
+	return execute(command);
 }
 
 float SoftwareDevice::SoftwareHandle::getDistanceMaximum()
@@ -597,12 +1404,9 @@ float SoftwareDevice::SoftwareHandle::getDistanceMaximum()
 
 bool SoftwareDevice::SoftwareHandle::setDistanceMaximum(float distance)
 {
-	if(!m_status)
-		return false;
-
-	m_distance_max = distance;
-
-	return true;
+	HandleCommand command(COMMAND_DISTANCE_MAXIMUM);
+	command.value = distance;
+	return execute(command);
 }
 
 float SoftwareDevice::SoftwareHandle::getDistanceReference()
@@ -615,12 +1419,9 @@ float SoftwareDevice::SoftwareHandle::getDistanceReference()
 
 bool SoftwareDevice::SoftwareHandle::setDistanceReference(float distance)
 {
-	if(!m_status)
-		return false;
-
-	m_distance_reference = distance;
-
-	return true;
+	HandleCommand command(COMMAND_DISTANCE_REFERENCE);
+	command.value = distance;
+	return execute(command);
 }
 
 float SoftwareDevice::SoftwareHandle::getAttenuation()
@@ -633,17 +1434,9 @@ float SoftwareDevice::SoftwareHandle::getAttenuation()
 
 bool SoftwareDevice::SoftwareHandle::setAttenuation(float factor)
 {
-	if(!m_status)
-		return false;
-
-	m_attenuation = factor;
-
-	if(factor == 0)
-		m_flags |= RENDER_DISTANCE;
-	else
-		m_flags &= ~RENDER_DISTANCE;
-
-	return true;
+	HandleCommand command(COMMAND_ATTENUATION);
+	command.value = factor;
+	return execute(command);
 }
 
 float SoftwareDevice::SoftwareHandle::getConeAngleOuter()
@@ -656,12 +1449,9 @@ float SoftwareDevice::SoftwareHandle::getConeAngleOuter()
 
 bool SoftwareDevice::SoftwareHandle::setConeAngleOuter(float angle)
 {
-	if(!m_status)
-		return false;
-
-	m_cone_angle_outer = angle * M_PI / 360.0f;
-
-	return true;
+	HandleCommand command(COMMAND_CONE_ANGLE_OUTER);
+	command.value = angle;
+	return execute(command);
 }
 
 float SoftwareDevice::SoftwareHandle::getConeAngleInner()
@@ -674,17 +1464,9 @@ float SoftwareDevice::SoftwareHandle::getConeAngleInner()
 
 bool SoftwareDevice::SoftwareHandle::setConeAngleInner(float angle)
 {
-	if(!m_status)
-		return false;
-
-	if(angle >= 360)
-		m_flags |= RENDER_CONE;
-	else
-		m_flags &= ~RENDER_CONE;
-
-	m_cone_angle_inner = angle * M_PI / 360.0f;
-
-	return true;
+	HandleCommand command(COMMAND_CONE_ANGLE_INNER);
+	command.value = angle;
+	return execute(command);
 }
 
 float SoftwareDevice::SoftwareHandle::getConeVolumeOuter()
@@ -697,12 +1479,9 @@ float SoftwareDevice::SoftwareHandle::getConeVolumeOuter()
 
 bool SoftwareDevice::SoftwareHandle::setConeVolumeOuter(float volume)
 {
-	if(!m_status)
-		return false;
-
-	m_cone_volume_outer = volume;
-
-	return true;
+	HandleCommand command(COMMAND_CONE_VOLUME_OUTER);
+	command.value = volume;
+	return execute(command);
 }
 
 /******************************************************************************/
@@ -727,184 +1506,844 @@ void SoftwareDevice::destroy()
 		playing(m_playback = false);
 
 	stopAll();
+
+	setThreadCount(1);
+
+	std::lock_guard<std::mutex> lock(m_voiceMutex);
+
+	m_voices.clear();
+	m_voiceCursor = 0;
 }
 
-void SoftwareDevice::mix(data_t* buffer, int length)
+bool SoftwareDevice::renderSound(SoftwareHandle* sound, Mixer& mixer, sample_t* buffer, int length)
 {
-	m_buffer.assureSize(length * AUD_SAMPLE_SIZE(m_specs));
-
-	std::lock_guard<ILockable> lock(*this);
+	// get the buffer from the source
+	int pos = 0;
+	int len = length;
+	bool eos = false;
 
+	try
 	{
-		std::shared_ptr<SoftwareDevice::SoftwareHandle> sound;
-		int len;
-		int pos;
-		bool eos;
-		std::list<std::shared_ptr<SoftwareDevice::SoftwareHandle> > stopSounds;
-		std::list<std::shared_ptr<SoftwareDevice::SoftwareHandle> > pauseSounds;
-		sample_t* buf = m_buffer.getBuffer();
-
-		m_mixer->clear(length);
+		sound->m_reader->read(len, eos, buffer);
 
-		// for all sounds
-		for(auto& sound : m_playingSounds)
+		// in case of looping
+		while(pos + len < length && sound->m_loopcount && eos)
 		{
-			// get the buffer from the source
-			pos = 0;
-			len = length;
-			eos = false;
-
-			// update 3D Info
-			sound->update();
-
-			try
-			{
-				sound->m_reader->read(len, eos, buf);
-
-				// in case of looping
-				while(pos + len < length && sound->m_loopcount && eos)
-				{
-					m_mixer->mix(buf, pos, len, sound->m_volume, sound->m_old_volume);
-
-					sound->m_old_volume = sound->m_volume;
-
-					pos += len;
-
-					if(sound->m_loopcount > 0)
-						sound->m_loopcount--;
+			mixer.mix(buffer, pos, len, sound->m_volume, sound->m_old_volume);
 
-					sound->m_reader->seek(0);
+			sound->m_old_volume = sound->m_volume;
 
-					len = length - pos;
-					sound->m_reader->read(len, eos, buf);
+			pos += len;
 
-					// prevent endless loop
-					if(!len)
-						break;
-				}
-			}
-			catch(Exception& e)
-			{
-				len = 0;
-				std::cerr << "Caught exception while reading sound data during playback with software mixing: " << e.getMessage() << std::endl;
-			}
+			if(sound->m_loopcount > 0)
+				sound->m_loopcount--;
 
-			m_mixer->mix(buf, pos, len, sound->m_volume, sound->m_old_volume);
+			sound->m_reader->seek(0);
 
-			// in case the end of the sound is reached
-			if(eos && !sound->m_loopcount)
-			{
-				if(sound->m_stop)
-					sound->m_stop(sound->m_stop_data);
+			len = length - pos;
+			sound->m_reader->read(len, eos, buffer);
 
-				if(sound->m_keep)
-					pauseSounds.push_back(sound);
-				else
-					stopSounds.push_back(sound);
-			}
+			// prevent endless loop
+			if(!len)
+				break;
 		}
+	}
+	catch(Exception& e)
+	{
+		len = 0;
+		std::cerr << "Caught exception while reading sound data during playback with software mixing: " << e.getMessage() << std::endl;
+	}
 
-		// superpose
-		m_mixer->read(buffer, m_volume);
-
-		// cleanup
-		for(auto& sound : pauseSounds)
-			sound->pause(true);
-
-		for(auto& sound :  stopSounds)
-			sound->stop();
+	mixer.mix(buffer, pos, len, sound->m_volume, sound->m_old_volume);
 
-		pauseSounds.clear();
-		stopSounds.clear();
-	}
+	// in case the end of the sound is reached
+	return eos && !sound->m_loopcount;
 }
 
-void SoftwareDevice::setPanning(IHandle* handle, float pan)
+void SoftwareDevice::renderSounds(Mixer* mixer, sample_t* buffer, int length, int begin, int end)
 {
-	SoftwareDevice::SoftwareHandle* h = dynamic_cast<SoftwareDevice::SoftwareHandle*>(handle);
-	h->m_user_pan = pan;
+	for(int i = begin; i < end; i++)
+		m_renderEnded[i] = renderSound(m_renderSounds[i], *mixer, buffer, length);
 }
 
-void SoftwareDevice::setQuality(ResampleQuality quality)
+void SoftwareDevice::renderThread(int index)
 {
-	m_quality = quality;
-}
+	while(true)
+	{
+		m_renderStart->wait();
 
-void SoftwareDevice::setSpecs(Specs specs)
-{
-	m_specs.specs = specs;
-	m_mixer->setSpecs(specs);
+		if(m_renderStop)
+			return;
 
-	for(auto& sound : m_playingSounds)
-	{
-		sound->setSpecs(specs);
-	}
+		if(index < m_renderThreads)
+			renderSounds(m_threadMixers[index - 1].get(), m_threadBuffers[index - 1]->getBuffer(), m_renderLength, index * m_renderCount / m_renderThreads, (index + 1) * m_renderCount / m_renderThreads);
 
-	for(auto& sound : m_pausedSounds)
-	{
-		sound->setSpecs(specs);
+		m_renderEnd->wait();
 	}
 }
 
-void SoftwareDevice::setSpecs(DeviceSpecs specs)
+void SoftwareDevice::stopThreads()
 {
-	m_specs = specs;
-	m_mixer->setSpecs(specs);
+	if(m_threads.empty())
+		return;
 
-	for(auto& sound : m_playingSounds)
-	{
-		sound->setSpecs(specs.specs);
-	}
+	m_renderStop = true;
+	m_renderStart->wait();
 
-	for(auto& sound : m_pausedSounds)
-	{
-		sound->setSpecs(specs.specs);
-	}
-}
+	for(auto& thread : m_threads)
+		thread.join();
 
-SoftwareDevice::SoftwareDevice()
-{
+	m_threads.clear();
+	m_renderStop = false;
 }
 
-DeviceSpecs SoftwareDevice::getSpecs() const
+void SoftwareDevice::mix(data_t* buffer, int length)
 {
-	return m_specs;
-}
+	std::lock_guard<ILockable> lock(*this);
 
-std::shared_ptr<IHandle> SoftwareDevice::play(std::shared_ptr<IReader> reader, bool keep)
-{
-	// prepare the reader
-	// pitch
+	int size = length * AUD_SAMPLE_SIZE(m_specs);
 
-	std::shared_ptr<PitchReader> pitch = std::shared_ptr<PitchReader>(new PitchReader(reader, 1));
-	reader = std::shared_ptr<IReader>(pitch);
+	// all mixing buffers grow together, so that they only allocate when the length grows
+	if(m_buffer.getSize() < size)
+	{
+		DeviceSpecs specs = m_specs;
+		specs.format = FORMAT_FLOAT32;
 
-	std::shared_ptr<ResampleReader> resampler;
+		m_buffer.assureSize(size);
+		m_mixer->clear(length);
 
-	// resample
-	if (m_quality == ResampleQuality::FASTEST)
-	{
-		resampler = std::shared_ptr<ResampleReader>(new LinearResampleReader(reader, m_specs.rate));
+		for(auto& mixer : m_threadMixers)
+		{
+			mixer->setSpecs(specs);
+			mixer->clear(length);
+		}
+
+		for(auto& threadBuffer : m_threadBuffers)
+			threadBuffer->assureSize(size);
+
+		m_allocations++;
 	}
-	else
+
+	if(m_queueCommands)
+		applyCommands();
+
 	{
-		resampler = std::shared_ptr<ResampleReader>(new JOSResampleReader(reader, m_specs.rate, m_quality));
-	}
-	reader = std::shared_ptr<IReader>(resampler);
+		sample_t* buf = m_buffer.getBuffer();
 
-	// rechannel
-	std::shared_ptr<ChannelMapperReader> mapper = std::shared_ptr<ChannelMapperReader>(new ChannelMapperReader(reader, m_specs.channels));
-	reader = std::shared_ptr<IReader>(mapper);
+		m_mixer->clear(length);
 
-	if(!reader.get())
-		return std::shared_ptr<IHandle>();
+		int count = m_playingSounds.size;
 
-	// play sound
-	std::shared_ptr<SoftwareDevice::SoftwareHandle> sound = std::shared_ptr<SoftwareDevice::SoftwareHandle>(new SoftwareDevice::SoftwareHandle(this, reader, pitch, resampler, mapper, keep));
+		reserveMixing(count);
 
-	std::lock_guard<ILockable> lock(*this);
+		m_renderSounds.clear();
 
-	m_playingSounds.push_back(sound);
+		for(SoftwareHandle* sound = m_playingSounds.first; sound; sound = sound->m_next)
+			m_renderSounds.push_back(sound);
+
+		// update 3D Info
+		if(m_batchUpdate)
+			updateSounds();
+		else
+		{
+			for(SoftwareHandle* sound : m_renderSounds)
+				sound->update();
+		}
+
+		m_renderEnded.resize(count);
+
+		int real = virtualizeSounds(length);
+		int threads = std::min<int>(m_threadCount, real);
+
+		if(threads > 1)
+		{
+			DeviceSpecs specs = m_specs;
+			specs.format = FORMAT_FLOAT32;
+
+			for(int t = 1; t < threads; t++)
+			{
+				m_threadMixers[t - 1]->setSpecs(specs);
+				m_threadMixers[t - 1]->clear(length);
+			}
+
+			m_renderThreads = threads;
+			m_renderCount = real;
+			m_renderLength = length;
+
+			// the barriers wake the worker threads without allocating, the mixing thread renders the first range itself
+			m_renderStart->wait();
+			renderSounds(m_mixer.get(), buf, length, 0, real / threads);
+			m_renderEnd->wait();
+
+			// reduce the thread results in a fixed order
+			for(int t = 1; t < threads; t++)
+			{
+				sample_t* threadBuffer = m_threadBuffers[t - 1]->getBuffer();
+
+				m_threadMixers[t - 1]->read(reinterpret_cast<data_t*>(threadBuffer), 1.0f);
+				m_mixer->mix(threadBuffer, 0, length, 1.0f);
+			}
+		}
+		else
+			renderSounds(m_mixer.get(), buf, length, 0, real);
+
+		// in case the end of the sound is reached
+		m_pauseSounds.clear();
+		m_stopSounds.clear();
+
+		for(int i = 0; i < count; i++)
+		{
+			SoftwareHandle* sound = m_renderSounds[i];
+
+			// sounds that faded out continue virtually
+			if(sound->m_virtual && i < real)
+				sound->updateVirtualPosition();
+
+			sound->m_rendered = i < real && !sound->m_virtual;
+
+			if(m_queueCommands)
+				sound->m_position = sound->getSamplePosition();
+
+			if(!m_renderEnded[i])
+				continue;
+
+			if(sound->m_stop)
+				sound->m_stop(sound->m_stop_data);
+
+			if(sound->m_keep)
+				m_pauseSounds.push_back(sound);
+			else
+				m_stopSounds.push_back(sound);
+		}
+
+		// superpose
+		m_mixer->read(buffer, m_volume);
+
+		// cleanup
+		for(SoftwareHandle* sound : m_pauseSounds)
+			sound->pause(true);
+
+		for(SoftwareHandle* sound : m_stopSounds)
+			sound->invalidate();
+	}
+
+	// commands queued while playback stopped are not applied by another mixing call
+	if(m_queueCommands && !m_playback && !m_commands->empty())
+		applyCommands();
+}
+
+int SoftwareDevice::virtualizeSounds(int length)
+{
+	auto begin = m_renderSounds.begin();
+	auto end = m_renderSounds.end();
+
+	float threshold = m_audibilityThreshold;
+
+	// sounds that cannot seek have to be read to advance
+	auto audible = std::partition(begin, end, [threshold](SoftwareHandle* sound) {
+		return threshold <= 0 || std::max(std::fabs(sound->m_volume), std::fabs(sound->m_old_volume)) >= threshold || !sound->m_reader->isSeekable();
+	});
+
+	int real = audible - begin;
+	int limit = real;
+
+	if(m_maximumRealVoices > 0 && real > m_maximumRealVoices)
+	{
+		limit = m_maximumRealVoices;
+
+		std::nth_element(begin, begin + limit, audible, [](SoftwareHandle* a, SoftwareHandle* b) {
+			if(a->m_priority != b->m_priority)
+				return a->m_priority > b->m_priority;
+			return a->m_volume > b->m_volume;
+		});
+
+		// the culled sounds that were mixed are rendered once more to fade out
+		real = std::partition(begin + limit, audible, [](SoftwareHandle* sound) {
+			return sound->m_rendered || !sound->m_reader->isSeekable();
+		}) - begin;
+	}
+
+	int count = m_renderSounds.size();
+
+	for(int i = 0; i < count; i++)
+	{
+		SoftwareHandle* sound = m_renderSounds[i];
+
+		if(i >= real)
+		{
+			if(!sound->m_virtual)
+			{
+				sound->updateVirtualPosition();
+				sound->m_virtual = true;
+			}
+
+			m_renderEnded[i] = sound->advance(length);
+		}
+		else if(i >= limit && sound->m_reader->isSeekable())
+		{
+			sound->m_volume = 0;
+			sound->m_virtual = true;
+		}
+		else if(sound->m_virtual)
+		{
+			// continue at the virtual position and fade in
+			sound->m_pitch->seek(int(sound->m_virtual_position));
+			sound->m_resampler->reset();
+			sound->m_old_volume = 0;
+			sound->m_virtual = false;
+		}
+	}
+
+	return real;
+}
+
+void SoftwareDevice::reserveMixing(int count)
+{
+	if(int(m_renderSounds.capacity()) >= count)
+		return;
+
+	count = std::max<int>(count, 2 * m_renderSounds.capacity());
+
+	m_renderSounds.reserve(count);
+	m_renderEnded.reserve(count);
+	m_pauseSounds.reserve(count);
+	m_stopSounds.reserve(count);
+	m_spatialSounds.reserve(count);
+	m_allocations++;
+}
+
+void SoftwareDevice::updateSounds()
+{
+	m_spatialSounds.clear();
+
+	for(SoftwareHandle* sound : m_renderSounds)
+	{
+		if(sound->m_pitch->getSpecs().channels == CHANNELS_MONO)
+			m_spatialSounds.push_back(sound);
+		else
+			sound->update();
+	}
+
+	int count = m_spatialSounds.size();
+
+	if(count == 0)
+		return;
+
+	int length = (count + SPATIAL_ALIGNMENT - 1) / SPATIAL_ALIGNMENT * SPATIAL_ALIGNMENT;
+	int size = length * SPATIAL_ARRAY_COUNT * sizeof(float);
+
+	if(m_spatialBuffer.getSize() < size)
+	{
+		m_spatialBuffer.assureSize(std::max<long long>(size, 2 * m_spatialBuffer.getSize()));
+		m_allocations++;
+	}
+
+	SpatialArrays arrays(reinterpret_cast<float*>(m_spatialBuffer.getBuffer()), count, length);
+
+	SpatialListener listener(m_orientation);
+	listener.velocity[0] = m_velocity.x();
+	listener.velocity[1] = m_velocity.y();
+	listener.velocity[2] = m_velocity.z();
+	listener.speed_of_sound = m_speed_of_sound;
+	listener.doppler_factor = m_doppler_factor;
+	listener.distance_model = m_distance_model;
+
+	// gather the parameters
+
+	for(int i = 0; i < count; i++)
+	{
+		SoftwareHandle* sound = m_spatialSounds[i];
+
+		Vector3 SL;
+		if(sound->m_relative)
+			SL = -sound->m_location;
+		else
+			SL = m_location - sound->m_location;
+
+		int flags = ~(sound->m_flags | m_flags);
+
+		arrays.sl[0][i] = SL.x();
+		arrays.sl[1][i] = SL.y();
+		arrays.sl[2][i] = SL.z();
+		arrays.velocity[0][i] = sound->m_velocity.x();
+		arrays.velocity[1][i] = sound->m_velocity.y();
+		arrays.velocity[2][i] = sound->m_velocity.z();
+		arrays.absolute[i] = sound->m_relative ? 0.0f : 1.0f;
+		arrays.doppler[i] = (flags & RENDER_DOPPLER) ? 1.0f : 0.0f;
+		arrays.distance_on[i] = (flags & RENDER_DISTANCE) ? 1.0f : 0.0f;
+		arrays.volume_on[i] = (flags & RENDER_VOLUME) ? 1.0f : 0.0f;
+		arrays.user_pitch[i] = sound->m_user_pitch;
+		arrays.user_volume[i] = sound->m_user_volume;
+		arrays.volume_max[i] = sound->m_volume_max;
+		arrays.volume_min[i] = sound->m_volume_min;
+		arrays.distance_max[i] = sound->m_distance_max;
+		arrays.distance_reference[i] = sound->m_distance_reference;
+		arrays.attenuation[i] = sound->m_attenuation;
+		arrays.volume[i] = sound->m_volume;
+
+		float cone = 1.0f;
+
+		if((flags & RENDER_VOLUME) && (flags & RENDER_CONE))
+		{
+			Vector3 SZ = sound->m_orientation.getLookAt();
+
+			float phi = std::acos(float(SZ * SL / (SZ.length() * SL.length())));
+			float t = (phi - sound->m_cone_angle_inner) / (sound->m_cone_angle_outer - sound->m_cone_angle_inner);
+
+			if(t > 0)
+			{
+				if(t > 1)
+					cone = sound->m_cone_volume_outer;
+				else
+					cone = 1 + t * (sound->m_cone_volume_outer - 1);
+			}
+		}
+
+		arrays.cone[i] = cone;
+	}
+
+	// calculate distance, pitch and volume
+
+	switch(SIMD::getLevel())
+	{
+#if defined(AUD_SIMD_X86)
+	case SIMD_AVX2:
+		spatialize_distance_avx2(arrays, length, listener);
+		break;
+	case SIMD_SSE2:
+		spatialize_distance_sse2(arrays, length, listener);
+		break;
+#elif defined(AUD_SIMD_NEON)
+	case SIMD_NEON:
+		spatialize_distance_neon(arrays, length, listener);
+		break;
+#endif
+	default:
+		spatialize_distance_scalar(arrays, count, listener);
+		break;
+	}
+
+	if(m_distance_model == DISTANCE_MODEL_EXPONENT || m_distance_model == DISTANCE_MODEL_EXPONENT_CLAMPED)
+	{
+		for(int i = 0; i < count; i++)
+		{
+			if(arrays.distance_on[i] > 0)
+			{
+				if(arrays.distance_reference[i] == 0)
+					arrays.gain[i] = 0;
+				else
+					arrays.gain[i] = std::pow(arrays.distance[i] / arrays.distance_reference[i], -arrays.attenuation[i]);
+			}
+		}
+	}
+
+	switch(SIMD::getLevel())
+	{
+#if defined(AUD_SIMD_X86)
+	case SIMD_AVX2:
+		spatialize_volume_avx2(arrays, length);
+		break;
+	case SIMD_SSE2:
+		spatialize_volume_sse2(arrays, length);
+		break;
+#elif defined(AUD_SIMD_NEON)
+	case SIMD_NEON:
+		spatialize_volume_neon(arrays, length);
+		break;
+#endif
+	default:
+		spatialize_volume_scalar(arrays, count);
+		break;
+	}
+
+	// scatter the results
+
+	for(int i = 0; i < count; i++)
+	{
+		SoftwareHandle* sound = m_spatialSounds[i];
+
+		sound->m_old_volume = sound->m_volume;
+		sound->m_volume = arrays.volume[i];
+
+		// we don't know a previous volume if this source has never been read before
+		if(sound->m_first_reading)
+		{
+			sound->m_old_volume = sound->m_volume;
+			sound->m_first_reading = false;
+		}
+
+		sound->m_pitch->setPitch(arrays.pitch[i]);
+
+		// 3D Cue
+
+		if(arrays.angle_sign[i] != 0)
+			sound->m_mapper->setMonoAngle(arrays.angle_sign[i] * std::acos(arrays.angle[i]));
+		else
+			sound->m_mapper->setMonoAngle(sound->m_relative ? sound->m_user_pan * M_PI / 2.0 : 0);
+	}
+}
+
+std::shared_ptr<ResampleReader> SoftwareDevice::createResampler(std::shared_ptr<IReader> reader)
+{
+	if(m_quality == ResampleQuality::FASTEST)
+		return std::shared_ptr<ResampleReader>(new LinearResampleReader(reader, m_specs.rate));
+
+	// uses the phase tables of the source rate set when playing while there is no pitch and doppler effect
+	return std::shared_ptr<ResampleReader>(new PolyphaseResampleReader(reader, m_specs.rate, m_quality));
+}
+
+std::shared_ptr<SoftwareDevice::SoftwareHandle> SoftwareDevice::createVoice()
+{
+	std::shared_ptr<PitchReader> pitch = std::shared_ptr<PitchReader>(new PitchReader(nullptr, 1));
+	std::shared_ptr<ResampleReader> resampler = createResampler(pitch);
+	std::shared_ptr<ChannelMapperReader> mapper = std::shared_ptr<ChannelMapperReader>(new ChannelMapperReader(resampler, m_specs.channels));
+
+	std::shared_ptr<SoftwareHandle> voice = std::shared_ptr<SoftwareHandle>(new SoftwareHandle(this, pitch, resampler, mapper, m_quality));
+
+	m_voices.push_back(voice);
+	m_allocations++;
+
+	return voice;
+}
+
+std::shared_ptr<SoftwareDevice::SoftwareHandle> SoftwareDevice::acquireVoice(std::shared_ptr<IReader> reader, bool keep)
+{
+	std::lock_guard<std::mutex> lock(m_voiceMutex);
+
+	std::shared_ptr<SoftwareHandle> voice;
+	int count = m_voices.size();
+
+	// a handle can be reused when it is stopped and nobody but the device references it
+	for(int i = 0; i < count; i++)
+	{
+		int index = (m_voiceCursor + i) % count;
+
+		if(m_voices[index]->m_status == STATUS_INVALID && m_voices[index].use_count() == 1)
+		{
+			// the last other owner may have released the handle in another thread
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			voice = m_voices[index];
+			m_voiceCursor = (index + 1) % count;
+			break;
+		}
+	}
+
+	if(!voice)
+		voice = createVoice();
+
+	if(voice->m_quality != m_quality)
+	{
+		voice->m_resampler = createResampler(voice->m_pitch);
+		voice->m_mapper->setReader(voice->m_resampler);
+		voice->m_quality = m_quality;
+		m_allocations++;
+	}
+
+	voice->m_pitch->setReader(reader);
+	voice->m_resampler->reset();
+
+	if(voice->m_resampler->getRate() != m_specs.rate || voice->m_mapper->getChannels() != m_specs.channels)
+		voice->setSpecs(m_specs.specs);
+
+	// the phase tables are prepared here instead of while mixing and are used while the pitch is 1 without doppler effect
+	PolyphaseResampleReader* polyphase = dynamic_cast<PolyphaseResampleReader*>(voice->m_resampler.get());
+
+	if(polyphase)
+		polyphase->setSourceRate(reader->getSpecs().rate);
+
+	voice->reset(keep);
+	voice->m_source_length = reader->getLength();
+	voice->m_status = STATUS_PLAYING;
+
+	return voice;
+}
+
+bool SoftwareDevice::queueCommand(HandleCommand& command)
+{
+	bool queued;
+
+	{
+		std::lock_guard<std::mutex> lock(m_commandMutex);
+
+		queued = m_commands->push(command);
+	}
+
+	if(queued && m_playback)
+		return true;
+
+	// the queue is full or no mixing call is going to apply it
+	std::lock_guard<ILockable> lock(*this);
+
+	applyCommands();
+
+	if(queued)
+		return true;
+
+	return command.handle->apply(command);
+}
+
+void SoftwareDevice::applyCommands()
+{
+	HandleCommand command;
+
+	while(m_commands->pop(command))
+	{
+		command.handle->apply(command);
+		command.handle = nullptr;
+	}
+}
+
+void SoftwareDevice::setPanning(IHandle* handle, float pan)
+{
+	SoftwareDevice::SoftwareHandle* h = dynamic_cast<SoftwareDevice::SoftwareHandle*>(handle);
+
+	HandleCommand command(COMMAND_PANNING);
+	command.value = pan;
+	h->execute(command);
+}
+
+void SoftwareDevice::setPriority(IHandle* handle, int priority)
+{
+	SoftwareDevice::SoftwareHandle* h = dynamic_cast<SoftwareDevice::SoftwareHandle*>(handle);
+
+	HandleCommand command(COMMAND_PRIORITY);
+	command.count = priority;
+	h->execute(command);
+}
+
+int SoftwareDevice::getPriority(IHandle* handle)
+{
+	SoftwareDevice::SoftwareHandle* h = dynamic_cast<SoftwareDevice::SoftwareHandle*>(handle);
+
+	return h->m_priority;
+}
+
+bool SoftwareDevice::isVirtual(IHandle* handle)
+{
+	SoftwareDevice::SoftwareHandle* h = dynamic_cast<SoftwareDevice::SoftwareHandle*>(handle);
+
+	return h->m_virtual;
+}
+
+void SoftwareDevice::setQuality(ResampleQuality quality)
+{
+	m_quality = quality;
+}
+
+void SoftwareDevice::setThreadCount(unsigned int count)
+{
+	std::lock_guard<ILockable> lock(*this);
+
+	if(count < 1)
+		count = 1;
+
+	if(count == m_threadCount)
+		return;
+
+	stopThreads();
+
+	m_threadCount = count;
+	m_threadMixers.clear();
+	m_threadBuffers.clear();
+	m_renderStart = nullptr;
+	m_renderEnd = nullptr;
+
+	if(count > 1)
+	{
+		DeviceSpecs specs = m_specs;
+		specs.format = FORMAT_FLOAT32;
+
+		// the buffers get the size of the mixing buffer, so mixing doesn't allocate
+		int length = m_buffer.getSize() / AUD_SAMPLE_SIZE(m_specs);
+
+		m_renderStart = std::make_shared<Barrier>(count);
+		m_renderEnd = std::make_shared<Barrier>(count);
+
+		for(unsigned int i = 1; i < count; i++)
+		{
+			m_threadMixers.push_back(std::make_shared<Mixer>(specs));
+			m_threadMixers.back()->clear(length);
+			m_threadBuffers.push_back(std::make_shared<Buffer>(m_buffer.getSize()));
+		}
+
+		for(unsigned int i = 1; i < count; i++)
+			m_threads.emplace_back(&SoftwareDevice::renderThread, this, int(i));
+
+		m_allocations++;
+	}
+}
+
+unsigned int SoftwareDevice::getThreadCount() const
+{
+	return m_threadCount;
+}
+
+void SoftwareDevice::setCommandQueueEnabled(bool queue)
+{
+	std::lock_guard<ILockable> lock(*this);
+
+	if(queue && !m_commands)
+	{
+		m_commands = std::make_shared<LockFreeQueue<HandleCommand> >(COMMAND_QUEUE_SIZE);
+		m_allocations++;
+	}
+
+	m_queueCommands = queue;
+
+	if(!queue && m_commands)
+		applyCommands();
+}
+
+bool SoftwareDevice::isCommandQueueEnabled() const
+{
+	return m_queueCommands;
+}
+
+void SoftwareDevice::setMaximumRealVoices(int count)
+{
+	m_maximumRealVoices = std::max(count, 0);
+}
+
+int SoftwareDevice::getMaximumRealVoices() const
+{
+	return m_maximumRealVoices;
+}
+
+void SoftwareDevice::setAudibilityThreshold(float threshold)
+{
+	m_audibilityThreshold = threshold;
+}
+
+float SoftwareDevice::getAudibilityThreshold() const
+{
+	return m_audibilityThreshold;
+}
+
+void SoftwareDevice::setBatchUpdateEnabled(bool enabled)
+{
+	std::lock_guard<ILockable> lock(*this);
+
+	m_batchUpdate = enabled;
+}
+
+bool SoftwareDevice::isBatchUpdateEnabled() const
+{
+	return m_batchUpdate;
+}
+
+void SoftwareDevice::reserveVoices(int count)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_voiceMutex);
+
+		if(int(m_voices.capacity()) < count)
+		{
+			m_voices.reserve(count);
+			m_allocations++;
+		}
+
+		while(int(m_voices.size()) < count)
+			createVoice();
+	}
+
+	std::lock_guard<ILockable> lock(*this);
+
+	reserveMixing(count);
+}
+
+long long SoftwareDevice::getAllocationCount() const
+{
+	return m_allocations;
+}
+
+void SoftwareDevice::setPrefetchEnabled(bool enabled)
+{
+	if(enabled == isPrefetchEnabled())
+		return;
+
+	// one thread is enough as decoding is mostly waiting for the disk, readers
+	// still playing keep the old thread until they end
+	std::atomic_store(&m_prefetchThread, enabled ? std::make_shared<PrefetchThread>() : std::shared_ptr<PrefetchThread>());
+}
+
+bool SoftwareDevice::isPrefetchEnabled() const
+{
+	return std::atomic_load(&m_prefetchThread) != nullptr;
+}
+
+long long SoftwareDevice::getPrefetchUnderrunCount() const
+{
+	return *m_prefetchUnderruns;
+}
+
+void SoftwareDevice::setSpecs(Specs specs)
+{
+	if(m_queueCommands)
+	{
+		std::lock_guard<ILockable> lock(*this);
+		applyCommands();
+	}
+
+	m_specs.specs = specs;
+	m_mixer->setSpecs(specs);
+
+	for(SoftwareHandle* sound = m_playingSounds.first; sound; sound = sound->m_next)
+		sound->setSpecs(specs);
+
+	for(SoftwareHandle* sound = m_pausedSounds.first; sound; sound = sound->m_next)
+		sound->setSpecs(specs);
+}
+
+void SoftwareDevice::setSpecs(DeviceSpecs specs)
+{
+	if(m_queueCommands)
+	{
+		std::lock_guard<ILockable> lock(*this);
+		applyCommands();
+	}
+
+	m_specs = specs;
+	m_mixer->setSpecs(specs);
+
+	for(SoftwareHandle* sound = m_playingSounds.first; sound; sound = sound->m_next)
+		sound->setSpecs(specs.specs);
+
+	for(SoftwareHandle* sound = m_pausedSounds.first; sound; sound = sound->m_next)
+		sound->setSpecs(specs.specs);
+}
+
+SoftwareDevice::SoftwareDevice() :
+	m_voiceCursor(0), m_allocations(0), m_playback(false), m_threadCount(1), m_renderThreads(1), m_renderCount(0), m_renderLength(0), m_renderStop(false), m_queueCommands(false), m_maximumRealVoices(0), m_audibilityThreshold(0), m_batchUpdate(true),
+	m_prefetchUnderruns(std::make_shared<std::atomic<long long> >(0))
+{
+}
+
+DeviceSpecs SoftwareDevice::getSpecs() const
+{
+	return m_specs;
+}
+
+std::shared_ptr<IHandle> SoftwareDevice::play(std::shared_ptr<IReader> reader, bool keep)
+{
+	if(!reader.get())
+		return std::shared_ptr<IHandle>();
+
+	// take a handle with a prepared reader chain
+	std::shared_ptr<SoftwareDevice::SoftwareHandle> sound = acquireVoice(reader, keep);
+
+	if(m_queueCommands)
+	{
+		HandleCommand command(COMMAND_PLAY);
+		command.handle = sound;
+		queueCommand(command);
+
+		return std::shared_ptr<IHandle>(sound);
+	}
+
+	std::lock_guard<ILockable> lock(*this);
+
+	m_playingSounds.push_back(sound.get());
 
 	if(!m_playback)
 		playing(m_playback = true);
@@ -914,18 +2353,27 @@ std::shared_ptr<IHandle> SoftwareDevice::play(std::shared_ptr<IReader> reader, b
 
 std::shared_ptr<IHandle> SoftwareDevice::play(std::shared_ptr<ISound> sound, bool keep)
 {
-	return play(sound->createReader(), keep);
+	std::shared_ptr<IReader> reader = sound->createReader();
+	std::shared_ptr<PrefetchThread> prefetchThread = std::atomic_load(&m_prefetchThread);
+
+	if(prefetchThread && std::dynamic_pointer_cast<File>(sound))
+		reader = std::make_shared<PrefetchReader>(reader, prefetchThread, AUD_DEFAULT_BUFFER_SIZE * 32, m_prefetchUnderruns);
+
+	return play(reader, keep);
 }
 
 void SoftwareDevice::stopAll()
 {
 	std::lock_guard<ILockable> lock(*this);
 
+	if(m_queueCommands)
+		applyCommands();
+
 	while(!m_playingSounds.empty())
-		m_playingSounds.front()->stop();
+		m_playingSounds.first->invalidate();
 
 	while(!m_pausedSounds.empty())
-		m_pausedSounds.front()->stop();
+		m_pausedSounds.first->invalidate();
 }
 
 void SoftwareDevice::lock()
@@ -24,16 +24,26 @@
 AUD_NAMESPACE_BEGIN
 
 File::File(const std::string &filename, int stream) :
-	m_filename(filename), m_stream(stream)
+	m_filename(filename), m_stream(stream), m_container(CONTAINER_INVALID), m_codec(CODEC_INVALID)
 {
 }
 
 File::File(const data_t* buffer, int size, int stream) :
-	m_buffer(new Buffer(size)), m_stream(stream)
+	m_buffer(new Buffer(size)), m_stream(stream), m_container(CONTAINER_INVALID), m_codec(CODEC_INVALID)
 {
 	std::memcpy(m_buffer->getBuffer(), buffer, size);
 }
 
+File::File(std::shared_ptr<Buffer> buffer, int stream) :
+	m_buffer(buffer), m_stream(stream), m_container(CONTAINER_INVALID), m_codec(CODEC_INVALID)
+{
+}
+
+File::File(std::shared_ptr<Buffer> buffer, Container container, Codec codec, int stream) :
+	m_buffer(buffer), m_stream(stream), m_container(container), m_codec(codec)
+{
+}
+
 std::vector<StreamInfo> File::queryStreams()
 {
 	if(m_buffer.get())
@@ -45,7 +55,7 @@ std::vector<StreamInfo> File::queryStreams()
 std::shared_ptr<IReader> File::createReader()
 {
 	if(m_buffer.get())
-		return FileManager::createReader(m_buffer, m_stream);
+		return FileManager::createReader(m_buffer, m_container, m_codec, m_stream);
 	else
 		return FileManager::createReader(m_filename, m_stream);
 }
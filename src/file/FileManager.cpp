@@ -17,8 +17,11 @@
 #include "file/FileManager.h"
 #include "file/IFileInput.h"
 #include "file/IFileOutput.h"
+#include "util/Buffer.h"
 #include "Exception.h"
 
+#include <mutex>
+
 AUD_NAMESPACE_BEGIN
 
 std::list<std::shared_ptr<IFileInput>>& FileManager::inputs()
@@ -33,6 +36,12 @@ std::list<std::shared_ptr<IFileOutput>>& FileManager::outputs()
 	return outputs;
 }
 
+std::map<std::string, std::weak_ptr<Buffer>>& FileManager::mappings()
+{
+	static std::map<std::string, std::weak_ptr<Buffer>> mappings;
+	return mappings;
+}
+
 void FileManager::registerInput(std::shared_ptr<IFileInput> input)
 {
 	inputs().push_back(input);
@@ -71,6 +80,51 @@ std::shared_ptr<IReader> FileManager::createReader(std::shared_ptr<Buffer> buffe
 	AUD_THROW(FileException, "The file couldn't be read with any installed file reader.");
 }
 
+std::shared_ptr<IReader> FileManager::createReader(std::shared_ptr<Buffer> buffer, Container container, Codec codec, int stream)
+{
+	if(container != CONTAINER_INVALID)
+	{
+		for(std::shared_ptr<IFileInput> input : inputs())
+		{
+			try
+			{
+				return input->createReader(buffer, container, codec, stream);
+			}
+			catch(Exception&) {}
+		}
+	}
+
+	// the hint might be wrong, so the file is probed as a last resort
+	return createReader(buffer, stream);
+}
+
+std::shared_ptr<Buffer> FileManager::mapFile(const std::string &filename)
+{
+	static std::mutex mutex;
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto& files = mappings();
+
+	std::shared_ptr<Buffer> buffer = files[filename].lock();
+
+	if(buffer)
+		return buffer;
+
+	// forget the files that aren't mapped anymore
+	for(auto it = files.begin(); it != files.end();)
+	{
+		if(it->second.expired() && it->first != filename)
+			it = files.erase(it);
+		else
+			it++;
+	}
+
+	buffer = Buffer::map(filename);
+	files[filename] = buffer;
+
+	return buffer;
+}
+
 std::vector<StreamInfo> FileManager::queryStreams(const std::string &filename)
 {
 	for(std::shared_ptr<IFileInput> input : inputs())
@@ -0,0 +1,178 @@
+/*******************************************************************************
+ * Copyright 2009-2016 Jörg Müller
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************/
+
+
+#include "file/SoundBank.h"
+#include "file/File.h"
+#include "file/FileManager.h"
+#include "util/Buffer.h"
+#include "util/StreamBuffer.h"
+#include "Exception.h"
+
+#include <cstdint>
+#include <cstring>
+
+AUD_NAMESPACE_BEGIN
+
+SoundBank::SoundBank(const std::string& filename) :
+	m_buffer(FileManager::mapFile(filename))
+{
+	readIndex();
+}
+
+SoundBank::SoundBank(std::shared_ptr<Buffer> buffer) :
+	m_buffer(buffer)
+{
+	readIndex();
+}
+
+void SoundBank::readIndex()
+{
+	const data_t* data = reinterpret_cast<const data_t*>(m_buffer->getBuffer());
+	long long size = m_buffer->getSize();
+	long long position = 0;
+
+	auto read = [&](void* target, long long length) {
+		if(position + length > size)
+			AUD_THROW(FileException, "The sound bank index is truncated.");
+
+		std::memcpy(target, data + position, length);
+		position += length;
+	};
+
+	char magic[sizeof(AUD_SOUNDBANK_MAGIC) - 1];
+	uint32_t order;
+	uint32_t count;
+
+	read(magic, sizeof(magic));
+
+	if(std::memcmp(magic, AUD_SOUNDBANK_MAGIC, sizeof(magic)))
+		AUD_THROW(FileException, "The file is not a sound bank.");
+
+	read(&order, sizeof(order));
+
+	if(order != 0x01020304)
+		AUD_THROW(FileException, "The sound bank was written on a machine with another byte order.");
+
+	read(&count, sizeof(count));
+
+	for(uint32_t i = 0; i < count; i++)
+	{
+		uint32_t length;
+		read(&length, sizeof(length));
+
+		if(length > size - position)
+			AUD_THROW(FileException, "The sound bank index is truncated.");
+
+		std::string name(reinterpret_cast<const char*>(data + position), length);
+		position += length;
+
+		uint8_t encoding;
+		uint8_t format;
+		uint8_t container;
+		uint8_t codec;
+		uint16_t channels;
+		double rate;
+		int64_t offset;
+		int64_t data_size;
+
+		read(&encoding, sizeof(encoding));
+		read(&format, sizeof(format));
+		read(&container, sizeof(container));
+		read(&codec, sizeof(codec));
+		read(&channels, sizeof(channels));
+		read(&rate, sizeof(rate));
+		read(&offset, sizeof(offset));
+		read(&data_size, sizeof(data_size));
+
+		if(encoding != ENCODING_PCM && encoding != ENCODING_FILE)
+			AUD_THROW(FileException, "The sound bank contains a sound with an unknown encoding.");
+
+		if(offset < 0 || data_size < 0 || offset > size || data_size > size - offset)
+			AUD_THROW(FileException, "The sound bank contains a sound outside of the file.");
+
+		Entry entry;
+		entry.encoding = Encoding(encoding);
+		entry.specs.format = SampleFormat(format);
+		entry.specs.channels = Channels(channels);
+		entry.specs.rate = rate;
+		entry.container = Container(container);
+		entry.codec = Codec(codec);
+		entry.offset = offset;
+		entry.size = data_size;
+
+		if(encoding == ENCODING_PCM)
+		{
+			switch(entry.specs.format)
+			{
+			case FORMAT_U8:
+			case FORMAT_S16:
+			case FORMAT_S24:
+			case FORMAT_S32:
+			case FORMAT_FLOAT32:
+			case FORMAT_FLOAT64:
+				break;
+			default:
+				AUD_THROW(FileException, "The sound bank contains a sound with an invalid sample format.");
+			}
+
+			if(channels == 0 || rate <= 0)
+				AUD_THROW(FileException, "The sound bank contains a sound with invalid specifications.");
+		}
+		else if(container > CONTAINER_WAV || codec > CODEC_OPUS)
+		{
+			// a hint from a newer version is dropped and the file probed
+			entry.container = CONTAINER_INVALID;
+			entry.codec = CODEC_INVALID;
+		}
+
+		m_entries[name] = entry;
+	}
+}
+
+std::vector<std::string> SoundBank::getNames() const
+{
+	std::vector<std::string> names;
+
+	for(auto& entry : m_entries)
+		names.push_back(entry.first);
+
+	return names;
+}
+
+bool SoundBank::contains(const std::string& name) const
+{
+	return m_entries.find(name) != m_entries.end();
+}
+
+std::shared_ptr<ISound> SoundBank::getSound(const std::string& name) const
+{
+	auto it = m_entries.find(name);
+
+	if(it == m_entries.end())
+		AUD_THROW(FileException, "The sound bank doesn't contain a sound with this name.");
+
+	const Entry& entry = it->second;
+
+	std::shared_ptr<Buffer> data = Buffer::slice(m_buffer, entry.offset, entry.size);
+
+	if(entry.encoding == ENCODING_PCM)
+		return std::make_shared<StreamBuffer>(data, entry.specs);
+
+	return std::make_shared<File>(data, entry.container, entry.codec);
+}
+
+AUD_NAMESPACE_END
@@ -0,0 +1,259 @@
+/*******************************************************************************
+ * Copyright 2009-2016 Jörg Müller
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************/
+
+
+#include "file/SoundBankWriter.h"
+#include "respec/ConverterFunctions.h"
+#include "util/Buffer.h"
+#include "util/StreamBuffer.h"
+#include "Exception.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+AUD_NAMESPACE_BEGIN
+
+SoundBankWriter::SoundBankWriter()
+{
+}
+
+void SoundBankWriter::add(const Entry& entry)
+{
+	if(entry.name.empty())
+		AUD_THROW(StateException, "Sounds in a sound bank need a name.");
+
+	for(const Entry& other : m_entries)
+	{
+		if(other.name == entry.name)
+			AUD_THROW(StateException, "The sound bank already contains a sound with this name.");
+	}
+
+	m_entries.push_back(entry);
+}
+
+void SoundBankWriter::detectFormat(const Buffer& data, Container& container, Codec& codec)
+{
+	const unsigned char* header = reinterpret_cast<const unsigned char*>(data.getBuffer());
+	long long size = data.getSize();
+
+	container = CONTAINER_INVALID;
+	codec = CODEC_INVALID;
+
+	auto matches = [&](long long offset, const char* magic, long long length) {
+		return offset + length <= size && !std::memcmp(header + offset, magic, length);
+	};
+
+	if(matches(0, "RIFF", 4) && matches(8, "WAVE", 4))
+	{
+		container = CONTAINER_WAV;
+
+		// integer, float and extensible format tags of the usual first chunk
+		if(matches(12, "fmt ", 4) && size >= 22)
+		{
+			int tag = header[20] | (header[21] << 8);
+
+			if(tag == 0x0001 || tag == 0x0003 || tag == 0xFFFE)
+				codec = CODEC_PCM;
+		}
+	}
+	else if(matches(0, "fLaC", 4))
+	{
+		container = CONTAINER_FLAC;
+		codec = CODEC_FLAC;
+	}
+	else if(matches(0, "OggS", 4) && size > 26)
+	{
+		container = CONTAINER_OGG;
+
+		// the first packet follows the segment table of the first page
+		long long packet = 27 + header[26];
+
+		if(matches(packet, "\x01vorbis", 7))
+			codec = CODEC_VORBIS;
+		else if(matches(packet, "OpusHead", 8))
+			codec = CODEC_OPUS;
+		else if(matches(packet, "\x7f" "FLAC", 5))
+			codec = CODEC_FLAC;
+	}
+	else if(matches(0, "\x1a\x45\xdf\xa3", 4))
+		container = CONTAINER_MATROSKA;
+	else if(matches(0, "\x0b\x77", 2) && size > 5 && (header[5] >> 3) <= 10)
+	{
+		// higher bitstream ids are E-AC-3
+		container = CONTAINER_AC3;
+		codec = CODEC_AC3;
+	}
+	else if(matches(0, "ID3", 3))
+		container = CONTAINER_MP3;
+	else if(size > 1 && header[0] == 0xFF && (header[1] & 0xE0) == 0xE0)
+	{
+		// the layer bits of the first MPEG audio frame
+		switch((header[1] >> 1) & 3)
+		{
+		case 1:
+			container = CONTAINER_MP3;
+			codec = CODEC_MP3;
+			break;
+		case 2:
+			container = CONTAINER_MP2;
+			codec = CODEC_MP2;
+			break;
+		}
+	}
+}
+
+void SoundBankWriter::addFile(const std::string& name, const std::string& filename)
+{
+	Entry entry;
+	entry.name = name;
+	entry.encoding = SoundBank::ENCODING_FILE;
+	entry.specs.format = FORMAT_INVALID;
+	entry.specs.channels = CHANNELS_INVALID;
+	entry.specs.rate = RATE_INVALID;
+	entry.data = Buffer::map(filename);
+
+	detectFormat(*entry.data, entry.container, entry.codec);
+
+	add(entry);
+}
+
+void SoundBankWriter::addSound(const std::string& name, std::shared_ptr<ISound> sound, SampleFormat format)
+{
+	convert_f convert;
+
+	switch(format)
+	{
+	case FORMAT_U8:
+		convert = convert_float_u8;
+		break;
+	case FORMAT_S16:
+		convert = convert_float_s16;
+		break;
+	case FORMAT_S24:
+#ifdef __BIG_ENDIAN__
+		convert = convert_float_s24_be;
+#else
+		convert = convert_float_s24_le;
+#endif
+		break;
+	case FORMAT_S32:
+		convert = convert_float_s32;
+		break;
+	case FORMAT_FLOAT32:
+		convert = convert_copy<float>;
+		break;
+	case FORMAT_FLOAT64:
+		convert = convert_float_double;
+		break;
+	default:
+		AUD_THROW(StateException, "The sample format for the sound bank is invalid.");
+	}
+
+	StreamBuffer stream(sound);
+	std::shared_ptr<Buffer> samples = stream.getBuffer();
+
+	Entry entry;
+	entry.name = name;
+	entry.encoding = SoundBank::ENCODING_PCM;
+	entry.specs.specs = stream.getSpecs();
+	entry.specs.format = format;
+	entry.container = CONTAINER_INVALID;
+	entry.codec = CODEC_INVALID;
+
+	long long count = samples->getSize() / sizeof(sample_t);
+
+	entry.data = std::make_shared<Buffer>(count * AUD_FORMAT_SIZE(format));
+	convert(reinterpret_cast<data_t*>(entry.data->getBuffer()), reinterpret_cast<data_t*>(samples->getBuffer()), count);
+
+	add(entry);
+}
+
+int SoundBankWriter::getSoundCount() const
+{
+	return m_entries.size();
+}
+
+void SoundBankWriter::write(const std::string& filename) const
+{
+	uint32_t order = 0x01020304;
+	uint32_t count = m_entries.size();
+
+	// the index size determines the offset of the first sound
+	long long offset = sizeof(AUD_SOUNDBANK_MAGIC) - 1 + sizeof(order) + sizeof(count);
+
+	for(const Entry& entry : m_entries)
+		offset += sizeof(uint32_t) + entry.name.size() + 4 * sizeof(uint8_t) + sizeof(uint16_t) + sizeof(double) + 2 * sizeof(int64_t);
+
+	std::vector<int64_t> offsets;
+
+	for(const Entry& entry : m_entries)
+	{
+		offset += (AUD_SOUNDBANK_ALIGNMENT - offset % AUD_SOUNDBANK_ALIGNMENT) % AUD_SOUNDBANK_ALIGNMENT;
+		offsets.push_back(offset);
+		offset += entry.data->getSize();
+	}
+
+	std::ofstream file(filename, std::ios::binary);
+
+	if(!file)
+		AUD_THROW(FileException, "The sound bank file couldn't be opened for writing.");
+
+	file.write(AUD_SOUNDBANK_MAGIC, sizeof(AUD_SOUNDBANK_MAGIC) - 1);
+	file.write(reinterpret_cast<const char*>(&order), sizeof(order));
+	file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+
+	for(size_t i = 0; i < m_entries.size(); i++)
+	{
+		const Entry& entry = m_entries[i];
+
+		uint32_t length = entry.name.size();
+		uint8_t encoding = entry.encoding;
+		uint8_t format = entry.specs.format;
+		uint8_t container = entry.container;
+		uint8_t codec = entry.codec;
+		uint16_t channels = entry.specs.channels;
+		double rate = entry.specs.rate;
+		int64_t size = entry.data->getSize();
+
+		file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+		file.write(entry.name.data(), length);
+		file.write(reinterpret_cast<const char*>(&encoding), sizeof(encoding));
+		file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+		file.write(reinterpret_cast<const char*>(&container), sizeof(container));
+		file.write(reinterpret_cast<const char*>(&codec), sizeof(codec));
+		file.write(reinterpret_cast<const char*>(&channels), sizeof(channels));
+		file.write(reinterpret_cast<const char*>(&rate), sizeof(rate));
+		file.write(reinterpret_cast<const char*>(&offsets[i]), sizeof(offsets[i]));
+		file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+	}
+
+	for(size_t i = 0; i < m_entries.size(); i++)
+	{
+		const Entry& entry = m_entries[i];
+
+		// pad to the aligned offset
+		while(file.tellp() < offsets[i])
+			file.put(0);
+
+		file.write(reinterpret_cast<const char*>(entry.data->getBuffer()), entry.data->getSize());
+	}
+
+	if(!file)
+		AUD_THROW(FileException, "The sound bank file couldn't be written.");
+}
+
+AUD_NAMESPACE_END
@@ -0,0 +1,294 @@
+/*******************************************************************************
+* Copyright 2015-2016 Juan Francisco Crespo Galán
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+******************************************************************************/
+
+
+#include "fx/Ambisonics.h"
+
+#include <algorithm>
+#include <cmath>
+
+#define SAMPLING_POINTS 32
+
+AUD_NAMESPACE_BEGIN
+
+/*
+ * Evaluates the SN3D real spherical harmonics in ACN order for a unit vector
+ * with x to the front, y to the left and z upwards.
+ */
+static void harmonics(int order, double x, double y, double z, double* result)
+{
+	const double sqrt3 = std::sqrt(3.0);
+
+	result[0] = 1;
+
+	if(order < 1)
+		return;
+
+	result[1] = y;
+	result[2] = z;
+	result[3] = x;
+
+	if(order < 2)
+		return;
+
+	result[4] = sqrt3 * x * y;
+	result[5] = sqrt3 * y * z;
+	result[6] = (3 * z * z - 1) / 2;
+	result[7] = sqrt3 * x * z;
+	result[8] = sqrt3 / 2 * (x * x - y * y);
+
+	if(order < 3)
+		return;
+
+	result[9] = std::sqrt(5.0 / 8.0) * y * (3 * x * x - y * y);
+	result[10] = std::sqrt(15.0) * x * y * z;
+	result[11] = std::sqrt(3.0 / 8.0) * y * (5 * z * z - 1);
+	result[12] = z * (5 * z * z - 3) / 2;
+	result[13] = std::sqrt(3.0 / 8.0) * x * (5 * z * z - 1);
+	result[14] = std::sqrt(15.0) / 2 * z * (x * x - y * y);
+	result[15] = std::sqrt(5.0 / 8.0) * x * (x * x - 3 * y * y);
+}
+
+static void direction(float azimuth, float elevation, double* vector)
+{
+	double phi = azimuth * M_PI / 180.0;
+	double theta = elevation * M_PI / 180.0;
+
+	// the azimuth runs clockwise, the y axis points to the left
+	vector[0] = std::cos(theta) * std::cos(phi);
+	vector[1] = -std::cos(theta) * std::sin(phi);
+	vector[2] = std::sin(theta);
+}
+
+/*
+ * Evenly spread directions on the sphere (spherical Fibonacci lattice).
+ */
+static void samplingPoint(int index, int count, double* vector)
+{
+	double z = 1.0 - (2.0 * index + 1.0) / count;
+	double r = std::sqrt(1.0 - z * z);
+	double phi = index * M_PI * (3.0 - std::sqrt(5.0));
+
+	vector[0] = r * std::cos(phi);
+	vector[1] = r * std::sin(phi);
+	vector[2] = z;
+}
+
+int Ambisonics::getChannelCount(int order)
+{
+	return (order + 1) * (order + 1);
+}
+
+void Ambisonics::encode(int order, float azimuth, float elevation, float* gains)
+{
+	double vector[3];
+	double result[(MAX_ORDER + 1) * (MAX_ORDER + 1)];
+
+	direction(azimuth, elevation, vector);
+	harmonics(order, vector[0], vector[1], vector[2], result);
+
+	for(int i = 0; i < getChannelCount(order); i++)
+		gains[i] = float(result[i]);
+}
+
+/*
+ * The least squares projection from the harmonics of the sampling points to
+ * the harmonics of each order. It only depends on the fixed sampling points,
+ * so it is calculated once and rotating only evaluates the rotated points.
+ */
+struct Projection
+{
+	/// For each order the (2l+1) x SAMPLING_POINTS matrix (Y^T Y)^-1 Y^T.
+	double matrix[Ambisonics::MAX_ORDER + 1][(2 * Ambisonics::MAX_ORDER + 1) * SAMPLING_POINTS];
+
+	Projection()
+	{
+		double harmonic[SAMPLING_POINTS][(Ambisonics::MAX_ORDER + 1) * (Ambisonics::MAX_ORDER + 1)];
+
+		for(int k = 0; k < SAMPLING_POINTS; k++)
+		{
+			double point[3];
+			samplingPoint(k, SAMPLING_POINTS, point);
+			harmonics(Ambisonics::MAX_ORDER, point[0], point[1], point[2], harmonic[k]);
+		}
+
+		for(int l = 1; l <= Ambisonics::MAX_ORDER; l++)
+		{
+			const int n = 2 * l + 1;
+			const int offset = l * l;
+
+			// Gauss-Jordan elimination of the normal equations Y^T Y P = Y^T
+			double a[(2 * Ambisonics::MAX_ORDER + 1) * (2 * Ambisonics::MAX_ORDER + 1)];
+			double* b = matrix[l];
+
+			for(int i = 0; i < n; i++)
+			{
+				for(int j = 0; j < n; j++)
+				{
+					a[i * n + j] = 0;
+
+					for(int k = 0; k < SAMPLING_POINTS; k++)
+						a[i * n + j] += harmonic[k][offset + i] * harmonic[k][offset + j];
+				}
+
+				for(int k = 0; k < SAMPLING_POINTS; k++)
+					b[i * SAMPLING_POINTS + k] = harmonic[k][offset + i];
+			}
+
+			for(int c = 0; c < n; c++)
+			{
+				int pivot = c;
+
+				for(int r = c + 1; r < n; r++)
+					if(std::fabs(a[r * n + c]) > std::fabs(a[pivot * n + c]))
+						pivot = r;
+
+				for(int j = 0; j < n; j++)
+					std::swap(a[c * n + j], a[pivot * n + j]);
+				for(int k = 0; k < SAMPLING_POINTS; k++)
+					std::swap(b[c * SAMPLING_POINTS + k], b[pivot * SAMPLING_POINTS + k]);
+
+				double scale = 1.0 / a[c * n + c];
+
+				for(int j = 0; j < n; j++)
+					a[c * n + j] *= scale;
+				for(int k = 0; k < SAMPLING_POINTS; k++)
+					b[c * SAMPLING_POINTS + k] *= scale;
+
+				for(int r = 0; r < n; r++)
+				{
+					if(r == c)
+						continue;
+
+					double factor = a[r * n + c];
+
+					for(int j = 0; j < n; j++)
+						a[r * n + j] -= factor * a[c * n + j];
+					for(int k = 0; k < SAMPLING_POINTS; k++)
+						b[r * SAMPLING_POINTS + k] -= factor * b[c * SAMPLING_POINTS + k];
+				}
+			}
+		}
+	}
+};
+
+void Ambisonics::getRotation(int order, const Quaternion& orientation, float* matrix)
+{
+	static const Projection projection;
+
+	const int channels = getChannelCount(order);
+
+	Vector3 front = orientation.getLookAt();
+	Vector3 up = orientation.getUp();
+	front = front * (1.0f / front.length());
+	up = up * (1.0f / up.length());
+	Vector3 right = front.cross(up);
+
+	// the x, y and z axes of the harmonics in the coordinate system of the library
+	const Vector3 axes[3] = {Vector3(0, 0, -1), Vector3(-1, 0, 0), Vector3(0, 1, 0)};
+	double rotation[3][3];
+
+	for(int j = 0; j < 3; j++)
+	{
+		rotation[0][j] = axes[j] * front;
+		rotation[1][j] = -(axes[j] * right);
+		rotation[2][j] = axes[j] * up;
+	}
+
+	for(int i = 0; i < channels * channels; i++)
+		matrix[i] = 0;
+
+	matrix[0] = 1;
+
+	/*
+	 * The harmonics of each order are rotated among themselves. The block of
+	 * an order is the least squares fit from the harmonics of the sampling
+	 * points to those of the rotated points, which is exact as the harmonics
+	 * of an order span a rotation invariant space.
+	 */
+	double after[SAMPLING_POINTS][(MAX_ORDER + 1) * (MAX_ORDER + 1)];
+
+	for(int k = 0; k < SAMPLING_POINTS; k++)
+	{
+		double point[3];
+		double rotated[3];
+
+		samplingPoint(k, SAMPLING_POINTS, point);
+
+		for(int i = 0; i < 3; i++)
+			rotated[i] = rotation[i][0] * point[0] + rotation[i][1] * point[1] + rotation[i][2] * point[2];
+
+		harmonics(order, rotated[0], rotated[1], rotated[2], after[k]);
+	}
+
+	for(int l = 1; l <= order; l++)
+	{
+		const int n = 2 * l + 1;
+		const int offset = l * l;
+		const double* p = projection.matrix[l];
+
+		// the fit is the transposed rotation of the block
+		for(int i = 0; i < n; i++)
+		{
+			for(int j = 0; j < n; j++)
+			{
+				double sum = 0;
+
+				for(int k = 0; k < SAMPLING_POINTS; k++)
+					sum += p[i * SAMPLING_POINTS + k] * after[k][offset + j];
+
+				matrix[(offset + j) * channels + offset + i] = float(sum);
+			}
+		}
+	}
+}
+
+void Ambisonics::getDecoder(int order, const float* azimuths, const float* elevations, int speakers, float* matrix)
+{
+	const int channels = getChannelCount(order);
+
+	// max-rE weights: the Legendre polynomials at the largest root of the next order's polynomial
+	double rE = std::cos(2.406809 / (order + 1.51));
+	double legendre[MAX_ORDER + 1] = {1, rE, (3 * rE * rE - 1) / 2, (5 * rE * rE * rE - 3 * rE) / 2};
+
+	for(int s = 0; s < speakers; s++)
+	{
+		double vector[3];
+		double result[(MAX_ORDER + 1) * (MAX_ORDER + 1)];
+
+		direction(azimuths[s], elevations[s], vector);
+		harmonics(order, vector[0], vector[1], vector[2], result);
+
+		for(int l = 0; l <= order; l++)
+			for(int c = l * l; c < (l + 1) * (l + 1); c++)
+				matrix[s * channels + c] = float((2 * l + 1) * legendre[l] * result[c] / speakers);
+	}
+}
+
+void Ambisonics::getVirtualSpeakers(int count, float* azimuths, float* elevations)
+{
+	for(int s = 0; s < count; s++)
+	{
+		double vector[3];
+
+		samplingPoint(s, count, vector);
+
+		azimuths[s] = float(std::fmod(-std::atan2(vector[1], vector[0]) * 180.0 / M_PI + 360.0, 360.0));
+		elevations[s] = float(std::asin(vector[2]) * 180.0 / M_PI);
+	}
+}
+
+AUD_NAMESPACE_END
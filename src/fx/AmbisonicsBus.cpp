@@ -0,0 +1,233 @@
+/*******************************************************************************
+* Copyright 2015-2016 Juan Francisco Crespo Galán
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+******************************************************************************/
+
+
+#include "fx/AmbisonicsBus.h"
+#include "fx/AmbisonicsBusReader.h"
+#include "fx/Ambisonics.h"
+#include "Exception.h"
+
+#ifdef WITH_CONVOLUTION
+#include "fx/HRTF.h"
+#include "fx/ImpulseResponse.h"
+#include "util/FFTPlan.h"
+#endif
+
+#include <cmath>
+
+#define VIRTUAL_SPEAKERS 64
+
+AUD_NAMESPACE_BEGIN
+
+/// The speaker azimuths of each channel layout, like for the ChannelMapperReader.
+static const float SPEAKER_AZIMUTHS[][CHANNELS_SURROUND71] =
+{
+	{0},
+	{-90, 90},
+	{-90, 90, 0},
+	{-45, 45, -135, 135},
+	{-30, 30, 0, -110, 110},
+	{-30, 30, 0, 0, -110, 110},
+	{-30, 30, 0, 0, 180, -110, 110},
+	{-30, 30, 0, 0, -110, 110, -150, 150}
+};
+
+/// The LFE channel of each channel layout, which gets no signal.
+static const int LFE_CHANNELS[] = {-1, -1, 2, -1, -1, 3, 3, 3};
+
+AmbisonicsBus::AmbisonicsBus(int order, Specs specs) :
+	m_order(order), m_specs(specs)
+{
+	if(order < 1 || order > Ambisonics::MAX_ORDER)
+		AUD_THROW(StateException, "The ambisonics order must be between 1 and 3");
+	if(specs.channels < CHANNELS_MONO || specs.channels > CHANNELS_SURROUND71)
+		AUD_THROW(StateException, "The speaker layout isn't supported");
+
+	int channels = Ambisonics::getChannelCount(order);
+	int speakers = specs.channels;
+
+	m_decoder.resize(speakers * channels);
+
+	if(specs.channels == CHANNELS_MONO)
+	{
+		m_decoder[0] = 1;
+		return;
+	}
+
+	/*
+	 * The few speakers of the usual layouts can't be decoded to directly, so
+	 * the sound field is decoded to evenly spread virtual speakers, which are
+	 * then panned between the two neighbouring real speakers with the same
+	 * constant power law as the ChannelMapperReader.
+	 */
+	const float* azimuths = SPEAKER_AZIMUTHS[speakers - 1];
+	int lfe = LFE_CHANNELS[speakers - 1];
+
+	std::vector<float> virtualAzimuths(VIRTUAL_SPEAKERS);
+	std::vector<float> virtualElevations(VIRTUAL_SPEAKERS);
+	std::vector<float> decoder(VIRTUAL_SPEAKERS * channels);
+
+	Ambisonics::getVirtualSpeakers(VIRTUAL_SPEAKERS, virtualAzimuths.data(), virtualElevations.data());
+	Ambisonics::getDecoder(order, virtualAzimuths.data(), virtualElevations.data(), VIRTUAL_SPEAKERS, decoder.data());
+
+	for(int v = 0; v < VIRTUAL_SPEAKERS; v++)
+	{
+		int left = -1;
+		int right = -1;
+		float leftDistance = 360;
+		float rightDistance = 360;
+
+		for(int s = 0; s < speakers; s++)
+		{
+			if(s == lfe)
+				continue;
+
+			float distance = std::fmod(virtualAzimuths[v] - azimuths[s] + 720.0f, 360.0f);
+
+			if(distance < leftDistance)
+			{
+				leftDistance = distance;
+				left = s;
+			}
+
+			distance = std::fmod(azimuths[s] - virtualAzimuths[v] + 720.0f, 360.0f);
+
+			if(distance < rightDistance)
+			{
+				rightDistance = distance;
+				right = s;
+			}
+		}
+
+		float angle = leftDistance + rightDistance;
+		float leftGain = angle > 0 ? std::cos(float(M_PI_2) * leftDistance / angle) : 1;
+		float rightGain = angle > 0 ? std::cos(float(M_PI_2) * rightDistance / angle) : 0;
+
+		for(int c = 0; c < channels; c++)
+		{
+			m_decoder[left * channels + c] += leftGain * decoder[v * channels + c];
+			m_decoder[right * channels + c] += rightGain * decoder[v * channels + c];
+		}
+	}
+
+	// a source in front of the listener is played with unit power
+	std::vector<float> gains(channels);
+	Ambisonics::encode(order, 0, 0, gains.data());
+
+	double power = 0;
+
+	for(int s = 0; s < speakers; s++)
+	{
+		double gain = 0;
+
+		for(int c = 0; c < channels; c++)
+			gain += m_decoder[s * channels + c] * gains[c];
+
+		power += gain * gain;
+	}
+
+	for(float& gain : m_decoder)
+		gain = float(gain / std::sqrt(power));
+}
+
+#ifdef WITH_CONVOLUTION
+AmbisonicsBus::AmbisonicsBus(int order, std::shared_ptr<HRTF> hrtfs) :
+	AmbisonicsBus(order, hrtfs, FFTPlan::getShared(DEFAULT_N))
+{
+}
+
+AmbisonicsBus::AmbisonicsBus(int order, std::shared_ptr<HRTF> hrtfs, std::shared_ptr<FFTPlan> plan) :
+	m_order(order), m_plan(plan)
+{
+	if(order < 1 || order > Ambisonics::MAX_ORDER)
+		AUD_THROW(StateException, "The ambisonics order must be between 1 and 3");
+	if(hrtfs->isEmpty())
+		AUD_THROW(StateException, "The provided HRTF object is empty");
+
+	m_specs = hrtfs->getSpecs();
+	m_specs.channels = CHANNELS_STEREO;
+
+	int channels = Ambisonics::getChannelCount(order);
+
+	// twice as many evenly spread virtual speakers as channels
+	int speakers = 2 * channels;
+	std::vector<float> azimuths(speakers);
+	std::vector<float> elevations(speakers);
+	std::vector<std::shared_ptr<ImpulseResponse>> left;
+	std::vector<std::shared_ptr<ImpulseResponse>> right;
+
+	Ambisonics::getVirtualSpeakers(speakers, azimuths.data(), elevations.data());
+
+	for(int s = 0; s < speakers; s++)
+	{
+		// the decoder uses the directions of the HRTFs actually chosen
+		auto pair = hrtfs->getImpulseResponse(azimuths[s], elevations[s]);
+
+		left.push_back(pair.first);
+		right.push_back(pair.second);
+	}
+
+	std::vector<float> decoder(speakers * channels);
+	Ambisonics::getDecoder(order, azimuths.data(), elevations.data(), speakers, decoder.data());
+
+	for(int c = 0; c < channels; c++)
+	{
+		std::vector<float> weights(speakers);
+
+		for(int s = 0; s < speakers; s++)
+			weights[s] = decoder[s * channels + c];
+
+		m_filters.push_back(std::make_pair(std::make_shared<ImpulseResponse>(left, weights), std::make_shared<ImpulseResponse>(right, weights)));
+	}
+}
+#endif
+
+std::shared_ptr<IReader> AmbisonicsBus::createReader()
+{
+	std::vector<std::pair<std::shared_ptr<IReader>, std::shared_ptr<Source>>> readers;
+
+	for(auto& sound : m_sounds)
+		readers.push_back(std::make_pair(sound.first->createReader(), sound.second));
+
+#ifdef WITH_CONVOLUTION
+	if(m_plan)
+		return std::make_shared<AmbisonicsBusReader>(readers, m_order, m_specs, m_filters, m_plan, m_listener);
+#endif
+
+	return std::make_shared<AmbisonicsBusReader>(readers, m_order, m_specs, m_decoder, m_listener);
+}
+
+void AmbisonicsBus::addSound(std::shared_ptr<ISound> sound, std::shared_ptr<Source> source)
+{
+	m_sounds.push_back(std::make_pair(sound, source));
+}
+
+void AmbisonicsBus::clear()
+{
+	m_sounds.clear();
+}
+
+void AmbisonicsBus::setListener(std::shared_ptr<I3DDevice> listener)
+{
+	m_listener = listener;
+}
+
+int AmbisonicsBus::getOrder() const
+{
+	return m_order;
+}
+
+AUD_NAMESPACE_END
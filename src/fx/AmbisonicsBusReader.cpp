@@ -0,0 +1,369 @@
+/*******************************************************************************
+* Copyright 2015-2016 Juan Francisco Crespo Galán
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+******************************************************************************/
+
+
+#include "fx/AmbisonicsBusReader.h"
+#include "fx/Ambisonics.h"
+#include "Exception.h"
+
+#ifdef WITH_CONVOLUTION
+#include "fx/ImpulseResponse.h"
+#include "util/FFTPlan.h"
+#endif
+
+#include <algorithm>
+#include <cstring>
+
+#define SPEAKER_BLOCK_SIZE 512
+
+AUD_NAMESPACE_BEGIN
+
+AmbisonicsBusReader::AmbisonicsBusReader(const std::vector<std::pair<std::shared_ptr<IReader>, std::shared_ptr<Source>>>& readers, int order, Specs specs, const std::vector<float>& decoder, std::weak_ptr<I3DDevice> listener) :
+	m_order(order), m_channels(Ambisonics::getChannelCount(order)), m_specs(specs), m_blockSize(SPEAKER_BLOCK_SIZE), m_decoder(decoder), m_listener(listener),
+	m_head(0), m_spectrumSize(0), m_multiplyAdd(nullptr)
+{
+	initialize(readers);
+}
+
+#ifdef WITH_CONVOLUTION
+AmbisonicsBusReader::AmbisonicsBusReader(const std::vector<std::pair<std::shared_ptr<IReader>, std::shared_ptr<Source>>>& readers, int order, Specs specs, const std::vector<std::pair<std::shared_ptr<ImpulseResponse>, std::shared_ptr<ImpulseResponse>>>& filters, std::shared_ptr<FFTPlan> plan, std::weak_ptr<I3DDevice> listener) :
+	m_order(order), m_channels(Ambisonics::getChannelCount(order)), m_specs(specs), m_blockSize(plan->getSize() / 2), m_filters(filters), m_plan(plan), m_listener(listener),
+	m_head(0), m_spectrumSize(SplitSpectrum::getSize(plan->getSize() / 2 + 1)), m_multiplyAdd(SplitSpectrum::getMultiplyAdd())
+{
+	int parts = 0;
+
+	for(auto& filter : m_filters)
+		parts = std::max(parts, int(std::max(filter.first->getChannel(0)->size(), filter.second->getChannel(0)->size())));
+
+	for(int c = 0; c < m_channels; c++)
+	{
+		m_history.push_back(std::unique_ptr<Buffer>(new Buffer(2 * m_blockSize * sizeof(sample_t))));
+		m_delayLines.push_back(std::vector<std::vector<sample_t>>(parts, std::vector<sample_t>(m_spectrumSize)));
+	}
+
+	m_fft.assureSize((m_blockSize + 1) * 2 * sizeof(sample_t));
+	m_accumulator.assureSize(m_spectrumSize * sizeof(sample_t));
+
+	initialize(readers);
+}
+#endif
+
+void AmbisonicsBusReader::initialize(const std::vector<std::pair<std::shared_ptr<IReader>, std::shared_ptr<Source>>>& readers)
+{
+	for(auto& reader : readers)
+	{
+		if(reader.first->getSpecs().channels != CHANNELS_MONO)
+			AUD_THROW(StateException, "The sounds must have only one channel");
+		if(reader.first->getSpecs().rate != m_specs.rate)
+			AUD_THROW(StateException, "The sounds and the bus must have the same rate");
+
+		Voice voice;
+		voice.reader = reader.first;
+		voice.source = reader.second;
+		voice.gains.resize(m_channels);
+		voice.eos = false;
+
+		m_voices.push_back(voice);
+	}
+
+	m_gains.resize(m_channels);
+	m_rotation[0].resize(m_channels * m_channels);
+	m_rotation[1].resize(m_channels * m_channels);
+
+	m_input.assureSize(m_blockSize * sizeof(sample_t));
+	m_field.assureSize(m_channels * m_blockSize * sizeof(sample_t));
+	m_rotated.assureSize(m_channels * m_blockSize * sizeof(sample_t));
+	m_outBuffer.assureSize(m_blockSize * m_specs.channels * sizeof(sample_t));
+
+	seek(0);
+}
+
+bool AmbisonicsBusReader::isSeekable() const
+{
+	for(auto& voice : m_voices)
+		if(!voice.reader->isSeekable())
+			return false;
+
+	return true;
+}
+
+void AmbisonicsBusReader::seek(int position)
+{
+	for(auto& voice : m_voices)
+	{
+		if(voice.reader->getPosition() != position)
+			voice.reader->seek(position);
+
+		// the first block starts at the current gains
+		Ambisonics::encode(m_order, voice.source->getAzimuth(), voice.source->getElevation(), voice.gains.data());
+
+		for(float& gain : voice.gains)
+			gain *= voice.source->getVolume();
+
+		voice.eos = false;
+	}
+
+	for(auto& history : m_history)
+		std::memset(history->getBuffer(), 0, history->getSize());
+
+	for(auto& delayLine : m_delayLines)
+		for(auto& spectrum : delayLine)
+			std::fill(spectrum.begin(), spectrum.end(), 0.0f);
+
+	auto listener = m_listener.lock();
+	m_orientation = listener ? listener->getListenerOrientation() : Quaternion();
+	Ambisonics::getRotation(m_order, m_orientation, m_rotation[1].data());
+	m_rotation[0] = m_rotation[1];
+
+	m_head = 0;
+	m_position = position;
+	m_outLength = m_outPosition = 0;
+	m_tail = -1;
+	m_eos = m_voices.empty();
+}
+
+int AmbisonicsBusReader::getLength() const
+{
+	int length = 0;
+
+	for(auto& voice : m_voices)
+	{
+		int len = voice.reader->getLength();
+
+		if(len < 0)
+			return -1;
+
+		length = std::max(length, len);
+	}
+
+	return length;
+}
+
+int AmbisonicsBusReader::getPosition() const
+{
+	return m_position;
+}
+
+Specs AmbisonicsBusReader::getSpecs() const
+{
+	return m_specs;
+}
+
+void AmbisonicsBusReader::read(int& length, bool& eos, sample_t* buffer)
+{
+	int channels = m_specs.channels;
+	int written = 0;
+
+	while(written < length)
+	{
+		if(m_outPosition == m_outLength)
+		{
+			if(m_eos)
+				break;
+
+			processBlock();
+		}
+
+		int len = std::min(length - written, m_outLength - m_outPosition);
+		std::memcpy(buffer + written * channels, m_outBuffer.getBuffer() + m_outPosition * channels, len * channels * sizeof(sample_t));
+		m_outPosition += len;
+		written += len;
+	}
+
+	length = written;
+	m_position += written;
+	eos = m_eos && m_outPosition == m_outLength;
+}
+
+bool AmbisonicsBusReader::encodeBlock()
+{
+	sample_t* field = m_field.getBuffer();
+	sample_t* input = m_input.getBuffer();
+	bool playing = false;
+
+	std::memset(field, 0, m_channels * m_blockSize * sizeof(sample_t));
+
+	for(auto& voice : m_voices)
+	{
+		if(voice.eos)
+			continue;
+
+		int len = m_blockSize;
+		voice.reader->read(len, voice.eos, input);
+
+		if(len < m_blockSize)
+			voice.eos = true;
+		else if(!voice.eos)
+			playing = true;
+
+		Ambisonics::encode(m_order, voice.source->getAzimuth(), voice.source->getElevation(), m_gains.data());
+
+		float volume = voice.source->getVolume();
+
+		// the gains are interpolated over the block, so moving sources don't click
+		for(int c = 0; c < m_channels; c++)
+		{
+			float gain = voice.gains[c];
+			float step = (m_gains[c] * volume - gain) / m_blockSize;
+			sample_t* channel = field + c * m_blockSize;
+
+			for(int i = 0; i < len; i++)
+				channel[i] += (gain + step * (i + 1)) * input[i];
+
+			voice.gains[c] = m_gains[c] * volume;
+		}
+	}
+
+	auto listener = m_listener.lock();
+	Quaternion orientation = listener ? listener->getListenerOrientation() : Quaternion();
+
+	m_rotation[0] = m_rotation[1];
+
+	if(orientation.w() != m_orientation.w() || orientation.x() != m_orientation.x() || orientation.y() != m_orientation.y() || orientation.z() != m_orientation.z())
+	{
+		m_orientation = orientation;
+		Ambisonics::getRotation(m_order, m_orientation, m_rotation[1].data());
+	}
+
+	sample_t* rotated = m_rotated.getBuffer();
+	std::memset(rotated, 0, m_channels * m_blockSize * sizeof(sample_t));
+
+	// the matrix is interpolated from the last block's, the orders are rotated separately so most entries are zero
+	for(int c = 0; c < m_channels; c++)
+		for(int k = 0; k < m_channels; k++)
+		{
+			float start = m_rotation[0][c * m_channels + k];
+			float step = (m_rotation[1][c * m_channels + k] - start) / m_blockSize;
+
+			if(start == 0 && step == 0)
+				continue;
+
+			const sample_t* in = field + k * m_blockSize;
+			sample_t* out = rotated + c * m_blockSize;
+
+			for(int i = 0; i < m_blockSize; i++)
+				out[i] += (start + step * (i + 1)) * in[i];
+		}
+
+	return playing;
+}
+
+void AmbisonicsBusReader::decodeSpeakers()
+{
+	int speakers = m_specs.channels;
+	const sample_t* rotated = m_rotated.getBuffer();
+	sample_t* out = m_outBuffer.getBuffer();
+
+	std::memset(out, 0, m_blockSize * speakers * sizeof(sample_t));
+
+	for(int s = 0; s < speakers; s++)
+		for(int c = 0; c < m_channels; c++)
+		{
+			float gain = m_decoder[s * m_channels + c];
+
+			if(gain == 0)
+				continue;
+
+			const sample_t* in = rotated + c * m_blockSize;
+
+			for(int i = 0; i < m_blockSize; i++)
+				out[i * speakers + s] += gain * in[i];
+		}
+}
+
+#ifdef WITH_CONVOLUTION
+void AmbisonicsBusReader::decodeBinaural()
+{
+	const sample_t* rotated = m_rotated.getBuffer();
+	sample_t* fft = m_fft.getBuffer();
+	sample_t* out = m_outBuffer.getBuffer();
+	int count = m_delayLines[0].size();
+
+	m_head = (m_head == 0 ? count : m_head) - 1;
+
+	for(int ear = 0; ear < 2; ear++)
+	{
+		m_spectra[ear][0].clear();
+		m_spectra[ear][1].clear();
+	}
+
+	for(int c = 0; c < m_channels; c++)
+	{
+		sample_t* history = m_history[c]->getBuffer();
+
+		std::memcpy(history + m_blockSize, rotated + c * m_blockSize, m_blockSize * sizeof(sample_t));
+		std::memcpy(fft, history, 2 * m_blockSize * sizeof(sample_t));
+		std::memcpy(history, history + m_blockSize, m_blockSize * sizeof(sample_t));
+
+		m_plan->FFT(fft);
+		SplitSpectrum::split(fft, m_delayLines[c][m_head].data(), m_blockSize + 1);
+
+		for(int ear = 0; ear < 2; ear++)
+		{
+			auto& parts = *(ear == 0 ? m_filters[c].first : m_filters[c].second)->getChannel(0);
+
+			// partition p is multiplied with the spectrum of the block p blocks ago
+			for(size_t p = 0; p < parts.size(); p++)
+			{
+				m_spectra[ear][0].push_back(m_delayLines[c][(m_head + p) % count].data());
+				m_spectra[ear][1].push_back(parts[p]->data());
+			}
+		}
+	}
+
+	sample_t* accumulator = m_accumulator.getBuffer();
+
+	for(int ear = 0; ear < 2; ear++)
+	{
+		std::memset(accumulator, 0, m_spectrumSize * sizeof(sample_t));
+		m_multiplyAdd(m_spectra[ear][0].data(), m_spectra[ear][1].data(), m_spectra[ear][0].size(), accumulator, m_spectrumSize / 2);
+
+		SplitSpectrum::merge(accumulator, fft, m_blockSize + 1);
+		m_plan->IFFT(fft);
+
+		// overlap-save: only the second half is free of circular aliasing
+		for(int i = 0; i < m_blockSize; i++)
+			out[i * 2 + ear] = fft[m_blockSize + i];
+	}
+}
+#endif
+
+void AmbisonicsBusReader::processBlock()
+{
+	bool playing = encodeBlock();
+
+#ifdef WITH_CONVOLUTION
+	if(m_plan)
+		decodeBinaural();
+	else
+#endif
+		decodeSpeakers();
+
+	// after the last sound ended the filters still ring for all but one of their partitions
+	if(!playing)
+	{
+		if(m_tail < 0)
+			m_tail = m_plan ? int(m_delayLines[0].size()) - 1 : 0;
+		else if(m_tail > 0)
+			m_tail--;
+	}
+
+	m_outLength = m_blockSize;
+	m_outPosition = 0;
+	m_eos = m_tail == 0;
+}
+
+AUD_NAMESPACE_END
@@ -105,20 +105,29 @@ void BaseIIRFilterReader::read(int& length, bool& eos, sample_t* buffer)
 
 	m_reader->read(length, eos, buffer);
 
-	for(m_channel = 0; m_channel < m_specs.channels; m_channel++)
+	if(filterBlock(buffer, length, m_specs.channels))
+		return;
+
+	// the history positions advance once per frame, so every channel finds its own past samples
+	for(int i = 0; i < length; i++)
 	{
-		for(int i = 0; i < length; i++)
+		for(m_channel = 0; m_channel < m_specs.channels; m_channel++)
 		{
 			m_x[m_xpos * m_specs.channels + m_channel] = buffer[i * m_specs.channels + m_channel];
 			m_y[m_ypos * m_specs.channels + m_channel] = buffer[i * m_specs.channels + m_channel] = filter();
-
-			m_xpos = m_xlen ? (m_xpos + 1) % m_xlen : 0;
-			m_ypos = m_ylen ? (m_ypos + 1) % m_ylen : 0;
 		}
+
+		m_xpos = m_xlen ? (m_xpos + 1) % m_xlen : 0;
+		m_ypos = m_ylen ? (m_ypos + 1) % m_ylen : 0;
 	}
 }
 
-void BaseIIRFilterReader::sampleRateChanged(SampleRate rate)
+bool BaseIIRFilterReader::filterBlock(sample_t*, int, Channels)
+{
+	return false;
+}
+
+void BaseIIRFilterReader::sampleRateChanged(SampleRate)
 {
 }
 
@@ -0,0 +1,58 @@
+/*******************************************************************************
+* Copyright 2015-2016 Juan Francisco Crespo Galán
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+******************************************************************************/
+
+
+#include "fx/BinauralBus.h"
+#include "fx/BinauralBusReader.h"
+
+AUD_NAMESPACE_BEGIN
+
+BinauralBus::BinauralBus(std::shared_ptr<HRTF> hrtfs) :
+	BinauralBus(hrtfs, FFTPlan::getShared(DEFAULT_N))
+{
+}
+
+BinauralBus::BinauralBus(std::shared_ptr<HRTF> hrtfs, std::shared_ptr<FFTPlan> plan) :
+	m_hrtfs(hrtfs), m_plan(plan)
+{
+}
+
+std::shared_ptr<IReader> BinauralBus::createReader()
+{
+	std::vector<std::pair<std::shared_ptr<IReader>, std::shared_ptr<Source>>> readers;
+
+	for(auto& sound : m_sounds)
+		readers.push_back(std::make_pair(sound.first->createReader(), sound.second));
+
+	return std::make_shared<BinauralBusReader>(readers, m_hrtfs, m_plan);
+}
+
+void BinauralBus::addSound(std::shared_ptr<ISound> sound, std::shared_ptr<Source> source)
+{
+	m_sounds.push_back(std::make_pair(sound, source));
+}
+
+void BinauralBus::clear()
+{
+	m_sounds.clear();
+}
+
+std::shared_ptr<HRTF> BinauralBus::getHRTFs()
+{
+	return m_hrtfs;
+}
+
+AUD_NAMESPACE_END
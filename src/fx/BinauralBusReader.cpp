@@ -0,0 +1,346 @@
+/*******************************************************************************
+* Copyright 2015-2016 Juan Francisco Crespo Galán
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+******************************************************************************/
+
+
+#include "fx/BinauralBusReader.h"
+#include "Exception.h"
+
+#include <algorithm>
+#include <cstring>
+
+#define NUM_OUTCHANNELS 2
+
+AUD_NAMESPACE_BEGIN
+
+enum
+{
+	STEADY,
+	FADE_IN,
+	FADE_OUT
+};
+
+BinauralBusReader::BinauralBusReader(const std::vector<std::pair<std::shared_ptr<IReader>, std::shared_ptr<Source>>>& readers, std::shared_ptr<HRTF> hrtfs, std::shared_ptr<FFTPlan> plan) :
+	m_hrtfs(hrtfs), m_plan(plan), m_N(plan->getSize()), m_L(plan->getSize() / 2), m_spectrumSize(SplitSpectrum::getSize(plan->getSize() / 2 + 1)),
+	m_multiplyAdd(SplitSpectrum::getMultiplyAdd()), m_outLength(0), m_outPosition(0), m_position(0), m_eos(false)
+{
+	if(m_hrtfs->isEmpty())
+		AUD_THROW(StateException, "The provided HRTF object is empty");
+
+	for(auto& reader : readers)
+	{
+		if(reader.first->getSpecs().channels != CHANNELS_MONO)
+			AUD_THROW(StateException, "The sounds must have only one channel");
+		if(reader.first->getSpecs().rate != m_hrtfs->getSpecs().rate)
+			AUD_THROW(StateException, "The sounds and the HRTFs must have the same rate");
+
+		std::unique_ptr<Voice> voice(new Voice());
+		voice->reader = reader.first;
+		voice->source = reader.second;
+		voice->realAzimuth = voice->azimuth = voice->source->getAzimuth();
+		voice->realElevation = voice->elevation = voice->source->getElevation();
+		voice->hrtfs = m_hrtfs->getImpulseResponse(voice->realAzimuth, voice->realElevation);
+		voice->input.assureSize(m_N * sizeof(sample_t));
+		std::memset(voice->input.getBuffer(), 0, m_N * sizeof(sample_t));
+		voice->head = 0;
+		voice->eos = false;
+		voice->tail = 0;
+
+		assureDelayLine(*voice, std::max(voice->hrtfs.first->getChannel(0)->size(), voice->hrtfs.second->getChannel(0)->size()));
+
+		m_voices.push_back(std::move(voice));
+	}
+
+	m_fft.assureSize((m_N / 2 + 1) * 2 * sizeof(sample_t));
+
+	for(int ear = 0; ear < NUM_OUTCHANNELS; ear++)
+		for(int i = 0; i < 3; i++)
+			m_accumulators[ear][i].assureSize(m_spectrumSize * sizeof(sample_t));
+
+	for(int i = 0; i < 3; i++)
+		m_signals[i].assureSize(m_L * sizeof(sample_t));
+
+	m_outBuffer.assureSize(m_L * NUM_OUTCHANNELS * sizeof(sample_t));
+}
+
+bool BinauralBusReader::isSeekable() const
+{
+	for(auto& voice : m_voices)
+		if(!voice->reader->isSeekable())
+			return false;
+
+	return true;
+}
+
+void BinauralBusReader::seek(int position)
+{
+	for(auto& voice : m_voices)
+	{
+		voice->reader->seek(position);
+		std::memset(voice->input.getBuffer(), 0, m_N * sizeof(sample_t));
+
+		for(auto& spectrum : voice->delayLine)
+			std::fill(spectrum.begin(), spectrum.end(), 0.0f);
+
+		voice->previous = std::make_pair(nullptr, nullptr);
+		voice->head = 0;
+		voice->eos = false;
+		voice->tail = 0;
+	}
+
+	m_position = position;
+	m_outLength = m_outPosition = 0;
+	m_eos = false;
+}
+
+int BinauralBusReader::getLength() const
+{
+	int length = 0;
+
+	for(auto& voice : m_voices)
+	{
+		int len = voice->reader->getLength();
+
+		if(len < 0)
+			return -1;
+
+		length = std::max(length, len);
+	}
+
+	return length;
+}
+
+int BinauralBusReader::getPosition() const
+{
+	return m_position;
+}
+
+Specs BinauralBusReader::getSpecs() const
+{
+	Specs specs = m_hrtfs->getSpecs();
+	specs.channels = CHANNELS_STEREO;
+	return specs;
+}
+
+void BinauralBusReader::read(int& length, bool& eos, sample_t* buffer)
+{
+	int written = 0;
+
+	while(written < length)
+	{
+		if(m_outPosition == m_outLength)
+		{
+			if(m_eos)
+				break;
+
+			processBlock();
+
+			if(m_outLength == 0)
+				break;
+		}
+
+		int len = std::min(length - written, m_outLength - m_outPosition);
+		std::memcpy(buffer + written * NUM_OUTCHANNELS, m_outBuffer.getBuffer() + m_outPosition * NUM_OUTCHANNELS, len * NUM_OUTCHANNELS * sizeof(sample_t));
+		m_outPosition += len;
+		written += len;
+	}
+
+	length = written;
+	m_position += written;
+	eos = m_eos && m_outPosition == m_outLength;
+}
+
+bool BinauralBusReader::checkSource(Voice& voice)
+{
+	if(voice.azimuth == voice.source->getAzimuth() && voice.elevation == voice.source->getElevation())
+		return false;
+
+	float azimuth = voice.source->getAzimuth();
+	float elevation = voice.source->getElevation();
+	float az = azimuth;
+	float el = elevation;
+	bool complete;
+	auto hrtfs = m_hrtfs->getImpulseResponse(az, el, complete);
+
+	// the HRTFs in use stay until the interpolated ones are ready and the source is checked again in the next block
+	if(!complete)
+		return false;
+
+	voice.azimuth = azimuth;
+	voice.elevation = elevation;
+
+	if(az == voice.realAzimuth && el == voice.realElevation)
+		return false;
+
+	voice.realAzimuth = az;
+	voice.realElevation = el;
+	voice.previous = voice.hrtfs;
+	voice.hrtfs = hrtfs;
+
+	return true;
+}
+
+void BinauralBusReader::assureDelayLine(Voice& voice, int parts)
+{
+	int count = voice.delayLine.size();
+
+	if(parts <= count)
+		return;
+
+	// keep the order of the spectra and append the new, older partitions at the end
+	std::vector<std::vector<sample_t>> delayLine;
+
+	for(int p = 0; p < count; p++)
+		delayLine.push_back(std::move(voice.delayLine[(voice.head + p) % count]));
+
+	delayLine.resize(parts, std::vector<sample_t>(m_spectrumSize));
+
+	voice.delayLine = std::move(delayLine);
+	voice.head = 0;
+}
+
+void BinauralBusReader::processBlock()
+{
+	for(int ear = 0; ear < NUM_OUTCHANNELS; ear++)
+		for(int i = 0; i < 3; i++)
+		{
+			m_spectra[ear][i][0].clear();
+			m_spectra[ear][i][1].clear();
+		}
+
+	bool active = false;
+	bool finished = true;
+	sample_t* fft = m_fft.getBuffer();
+
+	for(auto& voice : m_voices)
+	{
+		if(voice->eos && voice->tail == 0)
+			continue;
+
+		active = true;
+		sample_t* input = voice->input.getBuffer() + m_L;
+		int len = 0;
+
+		if(voice->eos)
+			voice->tail--;
+		else
+		{
+			len = m_L;
+			voice->reader->read(len, voice->eos, input);
+
+			float volume = voice->source->getVolume();
+			for(int i = 0; i < len; i++)
+				input[i] *= volume;
+
+			if(len < m_L)
+				voice->eos = true;
+
+			// the last input block is heard through all partitions of the HRTFs
+			if(voice->eos)
+				voice->tail = int(voice->delayLine.size()) - 1;
+
+			checkSource(*voice);
+		}
+
+		std::memset(input + len, 0, (m_L - len) * sizeof(sample_t));
+
+		if(!voice->eos || voice->tail > 0)
+			finished = false;
+
+		std::shared_ptr<ImpulseResponse> hrtfs[2][2] = {{voice->hrtfs.first, voice->hrtfs.second}, {voice->previous.first, voice->previous.second}};
+		bool transition = voice->previous.first != nullptr;
+
+		for(auto& row : hrtfs)
+			for(auto& hrtf : row)
+				if(hrtf)
+					assureDelayLine(*voice, hrtf->getChannel(0)->size());
+
+		int count = voice->delayLine.size();
+
+		std::memcpy(fft, voice->input.getBuffer(), m_N * sizeof(sample_t));
+		std::memcpy(voice->input.getBuffer(), input, m_L * sizeof(sample_t));
+		m_plan->FFT(fft);
+
+		voice->head = (voice->head == 0 ? count : voice->head) - 1;
+		SplitSpectrum::split(fft, voice->delayLine[voice->head].data(), m_L + 1);
+
+		for(int ear = 0; ear < NUM_OUTCHANNELS; ear++)
+			for(int h = 0; h < (transition ? 2 : 1); h++)
+			{
+				auto& parts = *hrtfs[h][ear]->getChannel(0);
+				auto& spectra = m_spectra[ear][transition ? (h == 0 ? FADE_IN : FADE_OUT) : STEADY];
+
+				// partition p is multiplied with the spectrum of the input block p blocks ago
+				for(size_t p = 0; p < parts.size(); p++)
+				{
+					spectra[0].push_back(voice->delayLine[(voice->head + p) % count].data());
+					spectra[1].push_back(parts[p]->data());
+				}
+			}
+
+		voice->previous = std::make_pair(nullptr, nullptr);
+	}
+
+	m_outPosition = 0;
+
+	if(!active)
+	{
+		m_outLength = 0;
+		m_eos = true;
+		return;
+	}
+
+	sample_t* out = m_outBuffer.getBuffer();
+
+	for(int ear = 0; ear < NUM_OUTCHANNELS; ear++)
+	{
+		for(int i = 0; i < 3; i++)
+		{
+			sample_t* signal = m_signals[i].getBuffer();
+			auto& spectra = m_spectra[ear][i];
+
+			if(spectra[0].empty())
+			{
+				std::memset(signal, 0, m_L * sizeof(sample_t));
+				continue;
+			}
+
+			sample_t* accumulator = m_accumulators[ear][i].getBuffer();
+			std::memset(accumulator, 0, m_spectrumSize * sizeof(sample_t));
+			m_multiplyAdd(spectra[0].data(), spectra[1].data(), spectra[0].size(), accumulator, m_spectrumSize / 2);
+
+			SplitSpectrum::merge(accumulator, fft, m_L + 1);
+			m_plan->IFFT(fft);
+
+			// overlap-save: only the second half is free of circular aliasing
+			std::memcpy(signal, fft + m_L, m_L * sizeof(sample_t));
+		}
+
+		const sample_t* steady = m_signals[STEADY].getBuffer();
+		const sample_t* fadeIn = m_signals[FADE_IN].getBuffer();
+		const sample_t* fadeOut = m_signals[FADE_OUT].getBuffer();
+
+		for(int i = 0; i < m_L; i++)
+		{
+			float volume = (i + 1) / float(m_L);
+			out[i * NUM_OUTCHANNELS + ear] = steady[i] + fadeIn[i] * volume + fadeOut[i] * (1.0f - volume);
+		}
+	}
+
+	m_outLength = m_L;
+	m_eos = finished;
+}
+
+AUD_NAMESPACE_END
@@ -156,9 +156,20 @@ bool BinauralReader::checkSource()
 {
 	if((m_Azimuth != m_source->getAzimuth() || m_Elevation != m_source->getElevation()) && (!m_eosReader && !m_eosTail))
 	{
-		float az = m_Azimuth = m_source->getAzimuth();
-		float el = m_Elevation = m_source->getElevation();
-		auto irs = m_hrtfs->getImpulseResponse(az, el);
+		float azimuth = m_source->getAzimuth();
+		float elevation = m_source->getElevation();
+		float az = azimuth;
+		float el = elevation;
+		bool complete;
+		auto irs = m_hrtfs->getImpulseResponse(az, el, complete);
+
+		// the HRTFs in use stay until the interpolated ones are ready and the source is checked again in the next block
+		if(!complete)
+			return false;
+
+		m_Azimuth = azimuth;
+		m_Elevation = elevation;
+
 		if(az != m_RealAzimuth || el != m_RealElevation)
 		{
 			m_RealAzimuth = az;
@@ -24,5 +24,10 @@ Butterworth::Butterworth(std::shared_ptr<ISound> sound, float frequency) :
 {
 }
 
+Butterworth::Butterworth(std::shared_ptr<ISound> sound, std::shared_ptr<AnimateableProperty> frequency, float fps) :
+	DynamicIIRFilter(sound, std::shared_ptr<IDynamicIIRFilterCalculator>(new ButterworthCalculator(frequency, fps)))
+{
+}
+
 
 AUD_NAMESPACE_END
@@ -15,6 +15,7 @@
  ******************************************************************************/
 
 #include "fx/ButterworthCalculator.h"
+#include "sequence/AnimateableProperty.h"
 
 #include <cmath>
 
@@ -24,31 +25,70 @@
 AUD_NAMESPACE_BEGIN
 
 ButterworthCalculator::ButterworthCalculator(float frequency) :
-	m_frequency(frequency)
+	m_frequency(frequency),
+	m_fps(0)
+{
+}
+
+ButterworthCalculator::ButterworthCalculator(std::shared_ptr<AnimateableProperty> frequency, float fps) :
+	m_frequency(0),
+	m_frequency_property(frequency),
+	m_fps(fps)
 {
 }
 
 void ButterworthCalculator::recalculateCoefficients(SampleRate rate, std::vector<float> &b, std::vector<float> &a)
 {
-	float omega = 2 * std::tan(m_frequency * M_PI / rate);
+	float sections[10];
+	calculate(rate, 0, sections);
+
+	// the product of the two sections
+	b.assign(5, 0);
+	a.assign(5, 0);
+
+	for(int i = 0; i < 3; i++)
+	{
+		for(int j = 0; j < 3; j++)
+		{
+			b[i + j] += sections[i] * sections[5 + j];
+			a[i + j] += (i ? sections[2 + i] : 1) * (j ? sections[7 + j] : 1);
+		}
+	}
+}
+
+bool ButterworthCalculator::animateSections(SampleRate rate, double time, std::vector<float> &sections)
+{
+	float coefficients[10];
+	calculate(rate, time, coefficients);
+	sections.insert(sections.end(), coefficients, coefficients + 10);
+	return m_frequency_property != nullptr;
+}
+
+void ButterworthCalculator::calculate(SampleRate rate, double time, float* sections)
+{
+	float frequency = m_frequency;
+
+	if(m_frequency_property)
+		m_frequency_property->read(time * m_fps, &frequency);
+
+	float omega = 2 * std::tan(frequency * M_PI / rate);
 	float o2 = omega * omega;
-	float o4 = o2 * o2;
-	float x1 = o2 + 2.0f * (float)BWPB41 * omega + 4.0f;
-	float x2 = o2 + 2.0f * (float)BWPB42 * omega + 4.0f;
-	float y1 = o2 - 2.0f * (float)BWPB41 * omega + 4.0f;
-	float y2 = o2 - 2.0f * (float)BWPB42 * omega + 4.0f;
 	float o228 = 2.0f * o2 - 8.0f;
-	float norm = x1 * x2;
-	a.push_back(1);
-	a.push_back((x1 + x2) * o228 / norm);
-	a.push_back((x1 * y2 + x2 * y1 + o228 * o228) / norm);
-	a.push_back((y1 + y2) * o228 / norm);
-	a.push_back(y1 * y2 / norm);
-	b.push_back(o4 / norm);
-	b.push_back(4 * o4 / norm);
-	b.push_back(6 * o4 / norm);
-	b.push_back(b[1]);
-	b.push_back(b[0]);
+
+	// bilinear transform of the two sections of the analog prototype, the one with the higher Q comes last
+	const float damping[2] = {(float)BWPB42, (float)BWPB41};
+
+	for(int i = 0; i < 2; i++)
+	{
+		float x = o2 + 2.0f * damping[i] * omega + 4.0f;
+		float y = o2 - 2.0f * damping[i] * omega + 4.0f;
+		float* section = sections + i * 5;
+		section[0] = o2 / x;
+		section[1] = 2 * o2 / x;
+		section[2] = section[0];
+		section[3] = o228 / x;
+		section[4] = y / x;
+	}
 }
 
 AUD_NAMESPACE_END
@@ -22,21 +22,25 @@
 #include <cstring>
 
 AUD_NAMESPACE_BEGIN
-Convolver::Convolver(std::shared_ptr<std::vector<std::shared_ptr<std::vector<std::complex<sample_t>>>>> ir, int irLength, std::shared_ptr<ThreadPool> threadPool, std::shared_ptr<FFTPlan> plan) :
+Convolver::Convolver(std::shared_ptr<std::vector<std::shared_ptr<std::vector<sample_t>>>> ir, int irLength, std::shared_ptr<ThreadPool> threadPool, std::shared_ptr<FFTPlan> plan) :
 	m_N(plan->getSize()), m_M(plan->getSize()/2), m_L(plan->getSize()/2), m_irBuffers(ir), m_numThreads(std::min(threadPool->getNumOfThreads(), static_cast<unsigned int>(m_irBuffers->size() - 1))), m_threadPool(threadPool), m_irLength(irLength), m_tailCounter(0), m_eos(false)
 	
 {
 	m_resetFlag = false;
 	m_futures.resize(m_numThreads);
-	for(int i = 0; i < m_irBuffers->size(); i++)
+	m_spectrumSize = SplitSpectrum::getSize((m_N / 2) + 1);
+	m_multiplyAdd = SplitSpectrum::getMultiplyAdd();
+	for(size_t i = 0; i < m_irBuffers->size(); i++)
 	{
 		m_fftConvolvers.push_back(std::unique_ptr<FFTConvolver>(new FFTConvolver((*m_irBuffers)[i], plan)));
-		m_delayLine.push_front((fftwf_complex*)std::calloc((m_N / 2) + 1, sizeof(fftwf_complex)));
+		m_delayLine.push_front((sample_t*)std::calloc(m_spectrumSize, sizeof(sample_t)));
+		m_irParts.push_back((*m_irBuffers)[i]->data());
 	}
+	m_delayParts.assign(m_delayLine.begin(), m_delayLine.end());
 
-	m_accBuffer = (fftwf_complex*)std::calloc((m_N / 2) + 1, sizeof(fftwf_complex));
+	m_accBuffer = (sample_t*)std::calloc(m_spectrumSize, sizeof(sample_t));
 	for(int i = 0; i < m_numThreads; i++)
-		m_threadAccBuffers.push_back((fftwf_complex*)std::calloc((m_N / 2) + 1, sizeof(fftwf_complex)));
+		m_threadAccBuffers.push_back((sample_t*)std::calloc(m_spectrumSize, sizeof(sample_t)));
 }
 
 Convolver::~Convolver()
@@ -77,20 +81,21 @@ void Convolver::getNext(sample_t* inBuffer, sample_t* outBuffer, int& length, bo
 			fut.get();
 	
 	if(inBuffer != nullptr)
-		m_fftConvolvers[0]->getNextFDL(inBuffer, reinterpret_cast<std::complex<sample_t>*>(m_accBuffer), length, m_delayLine[0]);
+		m_fftConvolvers[0]->getNextFDL(inBuffer, m_accBuffer, length, m_delayLine[0]);
 	else
 	{
 		m_tailCounter++;
 		std::memset(outBuffer, 0, m_L*sizeof(sample_t));
-		m_fftConvolvers[0]->getNextFDL(outBuffer, reinterpret_cast<std::complex<sample_t>*>(m_accBuffer), length, m_delayLine[0]);
+		m_fftConvolvers[0]->getNextFDL(outBuffer, m_accBuffer, length, m_delayLine[0]);
 	}
 	m_delayLine.push_front(m_delayLine.back());
 	m_delayLine.pop_back();
+	m_delayParts.assign(m_delayLine.begin(), m_delayLine.end());
 	length = m_L;
 	m_fftConvolvers[0]->IFFT_FDL(m_accBuffer, outBuffer, length);
-	std::memset(m_accBuffer, 0, ((m_N / 2) + 1)*sizeof(fftwf_complex));
+	std::memset(m_accBuffer, 0, m_spectrumSize*sizeof(sample_t));
 
-	if(m_tailCounter >= m_delayLine.size() && inBuffer == nullptr)
+	if(m_tailCounter >= static_cast<int>(m_delayLine.size()) && inBuffer == nullptr)
 	{
 		eos = m_eos = true;
 		length = m_irLength%m_M;
@@ -98,7 +103,7 @@ void Convolver::getNext(sample_t* inBuffer, sample_t* outBuffer, int& length, bo
 			length = m_M;
 	}
 	else
-		for(int i = 0; i < m_futures.size(); i++)
+		for(size_t i = 0; i < m_futures.size(); i++)
 			m_futures[i] = m_threadPool->enqueue(&Convolver::threadFunction, this, i);
 }
 
@@ -109,27 +114,30 @@ void Convolver::reset()
 		if(fut.valid())
 			fut.get();
 
-	for(int i = 0; i < m_delayLine.size();i++)
-		std::memset(m_delayLine[i], 0, ((m_N / 2) + 1)*sizeof(fftwf_complex));
-	for(int i = 0; i < m_fftConvolvers.size(); i++)
+	for(size_t i = 0; i < m_delayLine.size(); i++)
+		std::memset(m_delayLine[i], 0, m_spectrumSize*sizeof(sample_t));
+	for(size_t i = 0; i < m_fftConvolvers.size(); i++)
 		m_fftConvolvers[i]->clear();
-	std::memset(m_accBuffer, 0, ((m_N / 2) + 1)*sizeof(fftwf_complex));
+	std::memset(m_accBuffer, 0, m_spectrumSize*sizeof(sample_t));
 	m_tailCounter = 0;
 	m_eos = false;
 	m_resetFlag = false;
 }
 
-std::shared_ptr<std::vector<std::shared_ptr<std::vector<std::complex<sample_t>>>>> Convolver::getImpulseResponse()
+std::shared_ptr<std::vector<std::shared_ptr<std::vector<sample_t>>>> Convolver::getImpulseResponse()
 {
 	return m_irBuffers;
 }
 
-void Convolver::setImpulseResponse(std::shared_ptr<std::vector<std::shared_ptr<std::vector<std::complex<sample_t>>>>> ir)
+void Convolver::setImpulseResponse(std::shared_ptr<std::vector<std::shared_ptr<std::vector<sample_t>>>> ir)
 {
 	reset();
 	m_irBuffers = ir;
-	for(int i = 0; i < m_irBuffers->size(); i++)
+	for(size_t i = 0; i < m_irBuffers->size(); i++)
+	{
 		m_fftConvolvers[i]->setImpulseResponse((*m_irBuffers)[i]);
+		m_irParts[i] = (*m_irBuffers)[i]->data();
+	}
 }
 
 bool Convolver::threadFunction(int id)
@@ -139,17 +147,14 @@ bool Convolver::threadFunction(int id)
 	int start = id*share + 1;
 	int end = std::min(start + share, total);
 
-	std::memset(m_threadAccBuffers[id], 0, ((m_N / 2) + 1)*sizeof(fftwf_complex));
+	std::memset(m_threadAccBuffers[id], 0, m_spectrumSize*sizeof(sample_t));
 
-	for(int i = start; i < end && !m_resetFlag; i++)
-		m_fftConvolvers[i]->getNextFDL(reinterpret_cast<std::complex<sample_t>*>(m_delayLine[i]), reinterpret_cast<std::complex<sample_t>*>(m_threadAccBuffers[id]));
+	if(start < end && !m_resetFlag)
+		m_multiplyAdd(m_delayParts.data() + start, m_irParts.data() + start, end - start, m_threadAccBuffers[id], m_spectrumSize / 2);
 
 	m_sumMutex.lock();
-	for(int i = 0; (i < m_N / 2 + 1) && !m_resetFlag; i++)
-	{
-		m_accBuffer[i][0] += m_threadAccBuffers[id][i][0];
-		m_accBuffer[i][1] += m_threadAccBuffers[id][i][1];
-	}
+	for(int i = 0; (i < m_spectrumSize) && !m_resetFlag; i++)
+		m_accBuffer[i] += m_threadAccBuffers[id][i];
 	m_sumMutex.unlock();
 	return true;
 }
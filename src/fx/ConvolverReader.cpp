@@ -26,24 +26,39 @@ AUD_NAMESPACE_BEGIN
 ConvolverReader::ConvolverReader(std::shared_ptr<IReader> reader, std::shared_ptr<ImpulseResponse> ir, std::shared_ptr<ThreadPool> threadPool, std::shared_ptr<FFTPlan> plan) :
 	m_position(0), m_reader(reader), m_ir(ir), m_N(plan->getSize()), m_eosReader(false), m_eosTail(false), m_inChannels(reader->getSpecs().channels), m_irChannels(ir->getSpecs().channels), m_threadPool(threadPool)
 {
-	m_nChannelThreads = std::min((int)threadPool->getNumOfThreads(), m_inChannels);
-	m_futures.resize(m_nChannelThreads);
+	m_M = m_L = m_N / 2;
+
+	initialize();
 
 	int irLength = m_ir->getLength();
+	for(int i = 0; i < m_inChannels; i++)
+		m_convolvers.push_back(std::unique_ptr<Convolver>(new Convolver(ir->getChannel(m_irChannels > 1 ? i : 0), irLength, m_threadPool, plan)));
+}
+
+ConvolverReader::ConvolverReader(std::shared_ptr<IReader> reader, std::shared_ptr<ImpulseResponse> ir, std::shared_ptr<ThreadPool> threadPool, int blockSize) :
+	m_position(0), m_reader(reader), m_ir(ir), m_N(blockSize * 2), m_eosReader(false), m_eosTail(false), m_inChannels(reader->getSpecs().channels), m_irChannels(ir->getSpecs().channels), m_threadPool(threadPool)
+{
+	if(blockSize <= 0)
+		AUD_THROW(StateException, "The block size of the convolution must be positive");
+
+	m_M = m_L = blockSize;
+
+	initialize();
+
+	for(int i = 0; i < m_inChannels; i++)
+		m_nonUniformConvolvers.push_back(std::unique_ptr<NonUniformConvolver>(new NonUniformConvolver(ir->getPartitions(m_irChannels > 1 ? i : 0, blockSize), m_threadPool)));
+}
+
+void ConvolverReader::initialize()
+{
+	m_nChannelThreads = std::min((int)m_threadPool->getNumOfThreads(), m_inChannels);
+	m_futures.resize(m_nChannelThreads);
+
 	if(m_irChannels != 1 && m_irChannels != m_inChannels)
 		AUD_THROW(StateException, "The impulse response and the sound must either have the same amount of channels or the impulse response must be mono");
 	if(m_reader->getSpecs().rate != m_ir->getSpecs().rate)
 		AUD_THROW(StateException, "The sound and the impulse response. must have the same rate");
 
-	m_M = m_L = m_N / 2;
-	
-	if(m_irChannels > 1)
-		for(int i = 0; i < m_inChannels; i++)
-			m_convolvers.push_back(std::unique_ptr<Convolver>(new Convolver(ir->getChannel(i), irLength, m_threadPool, plan)));
-	else
-		for(int i = 0; i < m_inChannels; i++)
-			m_convolvers.push_back(std::unique_ptr<Convolver>(new Convolver(ir->getChannel(0), irLength, m_threadPool, plan)));
-
 	for(int i = 0; i < m_inChannels; i++)
 		m_vecInOut.push_back((sample_t*)std::malloc(m_L*sizeof(sample_t)));
 	m_outBuffer = (sample_t*)std::malloc(m_L*m_inChannels*sizeof(sample_t));
@@ -66,8 +81,10 @@ void ConvolverReader::seek(int position)
 {
 	m_position = position;
 	m_reader->seek(position);
-	for(int i = 0; i < m_inChannels; i++)
-		m_convolvers[i]->reset();
+	for(auto& convolver : m_convolvers)
+		convolver->reset();
+	for(auto& convolver : m_nonUniformConvolvers)
+		convolver->reset();
 	m_eosTail = false;
 	m_eosReader = false;
 	m_outBufferPos = m_eOutBufLen = m_outBufLen;
@@ -192,10 +209,13 @@ int ConvolverReader::threadFunction(int id, bool input)
 	
 	int l=m_lastLengthIn;
 	for(int i = start; i < end; i++)
-		if(input)
-			m_convolvers[i]->getNext(m_vecInOut[i], m_vecInOut[i], l, m_eosTail);
+	{
+		sample_t* inBuffer = input ? m_vecInOut[i] : nullptr;
+		if(m_nonUniformConvolvers.empty())
+			m_convolvers[i]->getNext(inBuffer, m_vecInOut[i], l, m_eosTail);
 		else
-			m_convolvers[i]->getNext(nullptr, m_vecInOut[i], l, m_eosTail);
+			m_nonUniformConvolvers[i]->getNext(inBuffer, m_vecInOut[i], l, m_eosTail);
+	}
 	
 	return l;
 }
@@ -23,17 +23,25 @@
 AUD_NAMESPACE_BEGIN
 
 ConvolverSound::ConvolverSound(std::shared_ptr<ISound> sound, std::shared_ptr<ImpulseResponse> impulseResponse, std::shared_ptr<ThreadPool> threadPool) :
-	ConvolverSound(sound, impulseResponse, threadPool, std::make_shared<FFTPlan>(0.0))
+	ConvolverSound(sound, impulseResponse, threadPool, FFTPlan::getShared(DEFAULT_N))
 {
 }
 
 ConvolverSound::ConvolverSound(std::shared_ptr<ISound> sound, std::shared_ptr<ImpulseResponse> impulseResponse, std::shared_ptr<ThreadPool> threadPool, std::shared_ptr<FFTPlan> plan) :
-	m_sound(sound), m_impulseResponse(impulseResponse), m_threadPool(threadPool), m_plan(plan)
+	m_sound(sound), m_impulseResponse(impulseResponse), m_threadPool(threadPool), m_plan(plan), m_blockSize(0)
+{
+}
+
+ConvolverSound::ConvolverSound(std::shared_ptr<ISound> sound, std::shared_ptr<ImpulseResponse> impulseResponse, std::shared_ptr<ThreadPool> threadPool, int blockSize) :
+	m_sound(sound), m_impulseResponse(impulseResponse), m_threadPool(threadPool), m_blockSize(blockSize)
 {
 }
 
 std::shared_ptr<IReader> ConvolverSound::createReader()
 {
+	if(!m_plan)
+		return std::make_shared<ConvolverReader>(m_sound->createReader(), m_impulseResponse, m_threadPool, m_blockSize);
+
 	return std::make_shared<ConvolverReader>(m_sound->createReader(), m_impulseResponse, m_threadPool, m_plan);
 }
 
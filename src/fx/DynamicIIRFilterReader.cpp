@@ -17,20 +17,99 @@
 #include "fx/DynamicIIRFilterReader.h"
 #include "fx/IDynamicIIRFilterCalculator.h"
 
+#include <algorithm>
+
+/// The frames after which animated coefficients are recalculated.
+#define RAMP_LENGTH 256
+
+/// The frames filtered with the same coefficients while moving towards the target.
+#define RAMP_STEP 16
+
 AUD_NAMESPACE_BEGIN
 
 DynamicIIRFilterReader::DynamicIIRFilterReader(std::shared_ptr<IReader> reader, std::shared_ptr<IDynamicIIRFilterCalculator> calculator) :
 	IIRFilterReader(reader, std::vector<float>(), std::vector<float>()),
-	m_calculator(calculator)
+	m_calculator(calculator),
+	m_animated(false),
+	m_ramping(false),
+	m_position(-1)
 {
 	sampleRateChanged(reader->getSpecs().rate);
 }
 
 void DynamicIIRFilterReader::sampleRateChanged(SampleRate rate)
 {
-	std::vector<float> a, b;
-	m_calculator->recalculateCoefficients(rate, b, a);
-	setCoefficients(b, a);
+	m_target_sections.clear();
+	m_animated = m_calculator->animateSections(rate, 0, m_target_sections);
+
+	if(m_target_sections.empty())
+	{
+		std::vector<float> a, b;
+		m_calculator->recalculateCoefficients(rate, b, a);
+		setCoefficients(b, a);
+		m_animated = false;
+	}
+	else
+	{
+		m_cascade.setSections(m_target_sections);
+		m_target.setSections(m_target_sections);
+		m_biquads = true;
+	}
+
+	m_position = -1;
+}
+
+bool DynamicIIRFilterReader::filterBlock(sample_t* buffer, int length, Channels channels)
+{
+	if(!m_animated)
+		return IIRFilterReader::filterBlock(buffer, length, channels);
+
+	SampleRate rate = m_reader->getSpecs().rate;
+	int position = m_reader->getPosition() - length;
+	bool jump = position != m_position;
+
+	for(int start = 0; start < length; start += RAMP_LENGTH)
+	{
+		int ramp = std::min(RAMP_LENGTH, length - start);
+
+		// the target are the sections at the end of the ramp
+		m_next_sections.clear();
+		m_calculator->animateSections(rate, double(position + start + ramp) / rate, m_next_sections);
+
+		if(m_next_sections != m_target_sections)
+		{
+			m_target_sections.swap(m_next_sections);
+			m_target.setSections(m_target_sections);
+			m_ramping = true;
+		}
+
+		if(jump)
+		{
+			m_cascade.interpolate(m_target, 1);
+			m_ramping = false;
+			jump = false;
+		}
+
+		if(!m_ramping)
+		{
+			m_cascade.process(buffer + start * channels, ramp, channels);
+			continue;
+		}
+
+		for(int step = 0; step < ramp; step += RAMP_STEP)
+		{
+			int steps = (ramp - step + RAMP_STEP - 1) / RAMP_STEP;
+
+			m_cascade.interpolate(m_target, 1.0f / steps);
+			m_cascade.process(buffer + (start + step) * channels, std::min(RAMP_STEP, ramp - step), channels);
+		}
+
+		m_ramping = false;
+	}
+
+	m_position = position + length;
+
+	return true;
 }
 
 AUD_NAMESPACE_END
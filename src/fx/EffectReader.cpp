@@ -27,6 +27,11 @@ EffectReader::~EffectReader()
 {
 }
 
+void EffectReader::setReader(std::shared_ptr<IReader> reader)
+{
+	m_reader = reader;
+}
+
 bool EffectReader::isSeekable() const
 {
 	return m_reader->isSeekable();
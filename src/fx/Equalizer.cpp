@@ -16,6 +16,7 @@
 
 #include "fx/Equalizer.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstring>
 #include <fstream>
@@ -34,7 +35,13 @@
 
 AUD_NAMESPACE_BEGIN
 
-Equalizer::Equalizer(std::shared_ptr<ISound> sound, std::shared_ptr<Buffer> bufEQ, int externalSizeEq, float maxFreqEq, int sizeConversion) : m_sound(sound), m_bufEQ(bufEQ)
+Equalizer::Equalizer(std::shared_ptr<ISound> sound, std::shared_ptr<Buffer> bufEQ, int externalSizeEq, float maxFreqEq, int sizeConversion) :
+	Equalizer(sound, bufEQ, externalSizeEq, maxFreqEq, sizeConversion, nullptr)
+{
+}
+
+Equalizer::Equalizer(std::shared_ptr<ISound> sound, std::shared_ptr<Buffer> bufEQ, int externalSizeEq, float maxFreqEq, int sizeConversion, std::shared_ptr<ThreadPool> threadPool) :
+	m_sound(sound), m_bufEQ(bufEQ), m_rate(0), m_length(0), m_maxFreq(0), m_threadPool(threadPool)
 {
 	this->maxFreqEq = maxFreqEq;
 	this->external_size_eq = externalSizeEq;
@@ -48,9 +55,40 @@ Equalizer::~Equalizer()
 
 std::shared_ptr<IReader> Equalizer::createReader()
 {
-	std::shared_ptr<FFTPlan> fp = std::shared_ptr<FFTPlan>(new FFTPlan(filter_length));
-	// 2 threads to start with
-	return std::shared_ptr<ConvolverReader>(new ConvolverReader(m_sound->createReader(), createImpulseResponse(), std::shared_ptr<ThreadPool>(new ThreadPool(2)), fp));
+	std::shared_ptr<IReader> reader = m_sound->createReader();
+	std::shared_ptr<ImpulseResponse> impulseResponse = getImpulseResponse(reader->getSpecs().rate);
+	std::shared_ptr<ThreadPool> threadPool;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		// 2 threads to start with
+		if(!m_threadPool)
+			m_threadPool = std::shared_ptr<ThreadPool>(new ThreadPool(2));
+
+		threadPool = m_threadPool;
+	}
+
+	return std::shared_ptr<ConvolverReader>(new ConvolverReader(reader, impulseResponse, threadPool, FFTPlan::getShared(filter_length)));
+}
+
+std::shared_ptr<ImpulseResponse> Equalizer::getImpulseResponse(SampleRate sampleRate)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	const float* curve = m_bufEQ->getBuffer();
+
+	if(m_impulseResponse && m_rate == sampleRate && m_length == filter_length && m_maxFreq == maxFreqEq && m_curve.size() == size_t(external_size_eq) &&
+	   std::equal(m_curve.begin(), m_curve.end(), curve))
+		return m_impulseResponse;
+
+	m_impulseResponse = createImpulseResponse(sampleRate);
+	m_curve.assign(curve, curve + external_size_eq);
+	m_rate = sampleRate;
+	m_length = filter_length;
+	m_maxFreq = maxFreqEq;
+
+	return m_impulseResponse;
 }
 
 float calculateValueArray(float* data, float minX, float maxX, int length, float posX)
@@ -82,16 +120,11 @@ void complex_prod(float a, float b, float c, float d, float* r, float* imag)
  *
  * The implementation is based on scikit-signal
  */
-std::shared_ptr<ImpulseResponse> Equalizer::createImpulseResponse()
+std::shared_ptr<ImpulseResponse> Equalizer::createImpulseResponse(SampleRate sampleRate)
 {
-	std::shared_ptr<FFTPlan> fp = std::shared_ptr<FFTPlan>(new FFTPlan(filter_length));
+	std::shared_ptr<FFTPlan> fp = FFTPlan::getShared(filter_length);
 	fftwf_complex* buffer = (fftwf_complex*) fp->getBuffer();
 	std::memset(buffer, 0, filter_length * sizeof(fftwf_complex));
-	std::shared_ptr<IReader> soundReader = m_sound.get()->createReader();
-	Specs specsSound = soundReader.get()->getSpecs();
-
-	int sampleRate = specsSound.rate;
-
 	for(unsigned i = 0; i < filter_length / 2; i++)
 	{
 		double freq = (((float) i) / (float) filter_length) * (float) sampleRate;
@@ -184,7 +217,7 @@ std::shared_ptr<Buffer> Equalizer::minimumPhaseFilterHomomorphic(std::shared_ptr
 		lWork = (int) pow(2, ceil(log2((float) (2 * (lOriginal - 1) / 0.01))));
 	}
 
-	std::shared_ptr<FFTPlan> fp = std::shared_ptr<FFTPlan>(new FFTPlan(lWork, 0.1));
+	std::shared_ptr<FFTPlan> fp = FFTPlan::getShared(lWork, 0.1);
 	fftwf_complex* buffer = (fftwf_complex*) fp->getBuffer();
 	sample_t* b_work = (sample_t*) buffer;
 	// Padding with 0
@@ -275,7 +308,7 @@ std::shared_ptr<Buffer> Equalizer::minimumPhaseFilterHilbert(std::shared_ptr<Buf
 		lWork = (int) pow(2, ceil(log2((float) (2 * (lOriginal - 1) / 0.01))));
 	}
 
-	std::shared_ptr<FFTPlan> fp = std::shared_ptr<FFTPlan>(new FFTPlan(lWork, 0.1));
+	std::shared_ptr<FFTPlan> fp = FFTPlan::getShared(lWork, 0.1);
 	fftwf_complex* buffer = (fftwf_complex*) fp->getBuffer();
 	sample_t* b_work = (sample_t*) buffer;
 	// Padding with 0
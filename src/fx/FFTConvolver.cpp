@@ -15,19 +15,21 @@
 ******************************************************************************/
 
 #include "fx/FFTConvolver.h"
+#include "util/SplitSpectrum.h"
 
 #include <cstring>
 #include <cstdlib>
 
 AUD_NAMESPACE_BEGIN
 
-FFTConvolver::FFTConvolver(std::shared_ptr<std::vector<std::complex<sample_t>>> ir, std::shared_ptr<FFTPlan> plan) :
+FFTConvolver::FFTConvolver(std::shared_ptr<std::vector<sample_t>> ir, std::shared_ptr<FFTPlan> plan) :
 	m_plan(plan), m_N(plan->getSize()), m_M(plan->getSize()/2), m_L(plan->getSize()/2), m_irBuffer(ir), m_tailPos(0)
 {
 	m_tail = (float*)calloc(m_M - 1, sizeof(float));
 	m_realBufLen = ((m_N / 2) + 1) * 2;
 	m_inBuffer = nullptr;
 	m_shiftBuffer = (sample_t*)std::calloc(m_N, sizeof(sample_t));
+	m_multiplyAdd = SplitSpectrum::getMultiplyAdd();
 }
 
 FFTConvolver::~FFTConvolver()
@@ -52,10 +54,7 @@ void FFTConvolver::getNext(const sample_t* inBuffer, sample_t* outBuffer, int& l
 	std::memcpy(m_inBuffer, inBuffer, length*sizeof(sample_t));
 
 	m_plan->FFT(m_inBuffer);
-	for(int i = 0; i < m_realBufLen / 2; i++)
-	{
-		m_inBuffer[i] = m_inBuffer[i] * (*m_irBuffer)[i] / sample_t(m_N);
-	}
+	multiply(reinterpret_cast<sample_t*>(m_inBuffer));
 	m_plan->IFFT(m_inBuffer);
 
 	for(int i = 0; i < m_M - 1; i++)
@@ -82,10 +81,7 @@ void FFTConvolver::getNext(const sample_t* inBuffer, sample_t* outBuffer, int& l
 
 	m_plan->FFT(m_inBuffer);
 	std::memcpy(transformedData, m_inBuffer, (m_realBufLen / 2)*sizeof(fftwf_complex));
-	for(int i = 0; i < m_realBufLen / 2; i++)
-	{
-		m_inBuffer[i] = m_inBuffer[i] * (*m_irBuffer)[i] / sample_t(m_N);
-	}
+	multiply(reinterpret_cast<sample_t*>(m_inBuffer));
 	m_plan->IFFT(m_inBuffer);
 
 	for(int i = 0; i < m_M - 1; i++)
@@ -108,10 +104,8 @@ void FFTConvolver::getNext(const fftwf_complex* inBuffer, sample_t* outBuffer, i
 		m_inBuffer = reinterpret_cast<std::complex<sample_t>*>(m_plan->getBuffer());
 
 	std::memset(m_inBuffer, 0, m_realBufLen * sizeof(fftwf_complex));
-	for(int i = 0; i < m_realBufLen / 2; i++)
-	{
-		m_inBuffer[i] = m_inBuffer[i] * (*m_irBuffer)[i] / sample_t(m_N);
-	}
+	std::memcpy(m_inBuffer, inBuffer, (m_realBufLen / 2)*sizeof(fftwf_complex));
+	multiply(reinterpret_cast<sample_t*>(m_inBuffer));
 	m_plan->IFFT(m_inBuffer);
 
 	for(int i = 0; i < m_M - 1; i++)
@@ -152,7 +146,7 @@ void FFTConvolver::clear()
 	std::memset(m_tail, 0, m_M - 1);
 }
 
-void FFTConvolver::IFFT_FDL(const fftwf_complex* inBuffer, sample_t* outBuffer, int& length)
+void FFTConvolver::IFFT_FDL(const sample_t* inBuffer, sample_t* outBuffer, int& length)
 {
 	if(length > m_L || length <= 0)
 	{
@@ -163,20 +157,18 @@ void FFTConvolver::IFFT_FDL(const fftwf_complex* inBuffer, sample_t* outBuffer,
 		m_inBuffer = reinterpret_cast<std::complex<sample_t>*>(m_plan->getBuffer());
 
 	std::memset(m_inBuffer, 0, m_realBufLen * sizeof(fftwf_complex));
-	std::memcpy(m_inBuffer, inBuffer, (m_realBufLen / 2)*sizeof(fftwf_complex));
+	SplitSpectrum::merge(inBuffer, reinterpret_cast<sample_t*>(m_inBuffer), m_realBufLen / 2);
 	m_plan->IFFT(m_inBuffer);
 	std::memcpy(outBuffer, ((sample_t*)m_inBuffer)+m_L, length*sizeof(sample_t));
 }
 
-void FFTConvolver::getNextFDL(const std::complex<sample_t>* inBuffer, std::complex<sample_t>* accBuffer)
+void FFTConvolver::getNextFDL(const sample_t* inBuffer, sample_t* accBuffer)
 {
-	for(int i = 0; i < m_realBufLen / 2; i++)
-	{
-		accBuffer[i] += (inBuffer[i] * (*m_irBuffer)[i]) / sample_t(m_N);
-	}
+	const sample_t* ir = m_irBuffer->data();
+	m_multiplyAdd(&inBuffer, &ir, 1, accBuffer, SplitSpectrum::getStride(m_realBufLen / 2));
 }
 
-void FFTConvolver::getNextFDL(const sample_t* inBuffer, std::complex<sample_t>* accBuffer, int& length, fftwf_complex* transformedData)
+void FFTConvolver::getNextFDL(const sample_t* inBuffer, sample_t* accBuffer, int& length, sample_t* transformedData)
 {
 	if(length > m_L || length <= 0)
 	{
@@ -188,27 +180,39 @@ void FFTConvolver::getNextFDL(const sample_t* inBuffer, std::complex<sample_t>*
 
 	std::memcpy(m_shiftBuffer, m_shiftBuffer + m_L, m_L*sizeof(sample_t));
 	std::memcpy(m_shiftBuffer + m_L, inBuffer, length*sizeof(sample_t));
+	std::memset(m_shiftBuffer + m_L + length, 0, (m_L - length)*sizeof(sample_t));
 
 	std::memset(m_inBuffer, 0, m_realBufLen * sizeof(fftwf_complex));
 	std::memcpy(m_inBuffer, m_shiftBuffer, (m_L+length)*sizeof(sample_t));
 
 	m_plan->FFT(m_inBuffer);
-	std::memcpy(transformedData, m_inBuffer, (m_realBufLen / 2)*sizeof(fftwf_complex));
-	for(int i = 0; i < m_realBufLen / 2; i++)
-	{
-		accBuffer[i] += (m_inBuffer[i] * (*m_irBuffer)[i]) / sample_t(m_N);
-	}
+	SplitSpectrum::split(reinterpret_cast<sample_t*>(m_inBuffer), transformedData, m_realBufLen / 2);
+	getNextFDL(transformedData, accBuffer);
 }
 
 
-void FFTConvolver::setImpulseResponse(std::shared_ptr<std::vector<std::complex<sample_t>>> ir)
+void FFTConvolver::setImpulseResponse(std::shared_ptr<std::vector<sample_t>> ir)
 {
 	clear();
 	m_irBuffer = ir;
 }
 
-std::shared_ptr<std::vector<std::complex<sample_t>>> FFTConvolver::getImpulseResponse()
+std::shared_ptr<std::vector<sample_t>> FFTConvolver::getImpulseResponse()
 {
 	return m_irBuffer;
 }
+
+void FFTConvolver::multiply(sample_t* spectrum)
+{
+	const sample_t* ir = m_irBuffer->data();
+	int stride = SplitSpectrum::getStride(m_realBufLen / 2);
+
+	for(int i = 0; i < m_realBufLen / 2; i++)
+	{
+		sample_t re = spectrum[2 * i];
+		sample_t im = spectrum[2 * i + 1];
+		spectrum[2 * i] = re * ir[i] - im * ir[stride + i];
+		spectrum[2 * i + 1] = re * ir[stride + i] + im * ir[i];
+	}
+}
 AUD_NAMESPACE_END
@@ -17,20 +17,38 @@
 #include "fx/HRTF.h"
 #include "Exception.h"
 
+#include <algorithm>
 #include <cmath>
 
+#define MAX_CACHED_DIRECTIONS 2048
+#define MAX_REQUESTS 64
+
 AUD_NAMESPACE_BEGIN
 HRTF::HRTF() :
-	HRTF(std::make_shared<FFTPlan>(0.0))
+	HRTF(FFTPlan::getShared(DEFAULT_N))
 {
 }
 
 HRTF::HRTF(std::shared_ptr<FFTPlan> plan) :
-	m_plan(plan)
+	m_interpolation(false), m_plan(plan), m_generation(0), m_stop(false)
 {
 	m_specs.channels = CHANNELS_INVALID;
 	m_specs.rate = 0;
 	m_empty = true;
+	m_requests.reserve(MAX_REQUESTS);
+}
+
+HRTF::~HRTF()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_cacheMutex);
+		m_stop = true;
+	}
+
+	m_condition.notify_all();
+
+	if(m_worker.joinable())
+		m_worker.join();
 }
 
 bool HRTF::addImpulseResponse(std::shared_ptr<StreamBuffer> impulseResponse, float azimuth, float elevation)
@@ -44,70 +62,310 @@ bool HRTF::addImpulseResponse(std::shared_ptr<StreamBuffer> impulseResponse, flo
 	if((spec.channels != CHANNELS_MONO) || (spec.rate != m_specs.rate && m_specs.rate > 0.0))
 		return false;
 
-	m_hrtfs[elevation][azimuth] = std::make_shared<ImpulseResponse>(impulseResponse, m_plan);
+	std::shared_ptr<ImpulseResponse> hrtf = std::make_shared<ImpulseResponse>(impulseResponse, m_plan);
+
+	auto ring = std::lower_bound(m_rings.begin(), m_rings.end(), elevation, [](const Ring& ring, float elevation) { return ring.elevation < elevation; });
+
+	if(ring == m_rings.end() || ring->elevation != elevation)
+	{
+		ring = m_rings.insert(ring, Ring());
+		ring->elevation = elevation;
+
+		int base = int(std::floor(m_rings.front().elevation));
+		m_elevationIndex.resize(int(std::floor(m_rings.back().elevation)) - base + 1);
+
+		for(int i = 0, j = -1; i < int(m_elevationIndex.size()); i++)
+		{
+			while(j + 1 < int(m_rings.size()) && m_rings[j + 1].elevation <= base + i)
+				j++;
+			m_elevationIndex[i] = j;
+		}
+	}
+
+	auto position = std::lower_bound(ring->azimuths.begin(), ring->azimuths.end(), azimuth);
+	int index = position - ring->azimuths.begin();
+
+	if(position != ring->azimuths.end() && *position == azimuth)
+		ring->hrtfs[index] = hrtf;
+	else
+	{
+		ring->azimuths.insert(position, azimuth);
+		ring->hrtfs.insert(ring->hrtfs.begin() + index, hrtf);
+	}
+
+	ring->index.resize(360);
+
+	for(int i = 0, j = -1; i < int(ring->index.size()); i++)
+	{
+		while(j + 1 < int(ring->azimuths.size()) && ring->azimuths[j + 1] <= i)
+			j++;
+		ring->index[i] = j;
+	}
+
 	m_specs.channels = CHANNELS_MONO;
 	m_specs.rate = spec.rate;
 	m_empty = false;
+
+	std::lock_guard<std::mutex> lock(m_cacheMutex);
+	m_cache.clear();
+	m_recent.clear();
+	m_requests.clear();
+	m_generation++;
+
 	return true;
 }
 
 std::pair<std::shared_ptr<ImpulseResponse>, std::shared_ptr<ImpulseResponse>> HRTF::getImpulseResponse(float &azimuth, float &elevation)
 {
-	if(m_hrtfs.empty())
+	bool complete;
+	return lookup(azimuth, elevation, true, complete);
+}
+
+std::pair<std::shared_ptr<ImpulseResponse>, std::shared_ptr<ImpulseResponse>> HRTF::getImpulseResponse(float &azimuth, float &elevation, bool &complete)
+{
+	return lookup(azimuth, elevation, false, complete);
+}
+
+std::pair<std::shared_ptr<ImpulseResponse>, std::shared_ptr<ImpulseResponse>> HRTF::lookup(float& azimuth, float& elevation, bool wait, bool& complete)
+{
+	complete = true;
+
+	if(m_rings.empty())
 		return std::make_pair(nullptr, nullptr);
 	azimuth = std::fmod(azimuth, 360);
 	if(azimuth < 0)
 		azimuth += 360;
 
 	std::shared_ptr<ImpulseResponse> R, L;
-	float az = 0, el = 0, dif=0, minDif=360;
 
-	for(auto elem : m_hrtfs)
+	if(m_interpolation)
 	{
-		dif = std::fabs(elevation - elem.first);
-		if(dif < minDif)
+		// whole degrees avoid changing the convolvers for every tiny movement
+		float azR = std::fmod(std::round(azimuth), 360);
+		float elR = std::min(std::max(std::round(elevation), m_rings.front().elevation), m_rings.back().elevation);
+
+		R = getCached(azR, elR, wait);
+		L = getCached(azR == 0 ? 0 : 360 - azR, elR, wait);
+
+		if(R && L)
 		{
-			minDif = dif;
-			el = elem.first;
+			azimuth = azR;
+			elevation = elR;
+
+			return std::make_pair(L, R);
 		}
+
+		// the closest measured HRTFs are used until the worker thread interpolated the direction
+		complete = false;
 	}
-	elevation = el;
-	dif = 0; 
-	minDif = 360;
-	
-	for(auto elem : m_hrtfs[elevation])
+
+	R = getNearest(azimuth, elevation);
+
+	float azL = 360 - azimuth;
+	if(azL == 360)
+		azL = 0;
+	float elL = elevation;
+
+	L = getNearest(azL, elL);
+
+	return std::make_pair(L, R);
+}
+
+void HRTF::setInterpolation(bool interpolation)
+{
+	m_interpolation = interpolation;
+
+	if(interpolation && !m_worker.joinable())
+		m_worker = std::thread(&HRTF::work, this);
+}
+
+bool HRTF::getInterpolation() const
+{
+	return m_interpolation;
+}
+
+int HRTF::findRing(float elevation) const
+{
+	if(elevation < m_rings.front().elevation)
+		return -1;
+
+	int cell = std::min(int(std::floor(elevation) - std::floor(m_rings.front().elevation)), int(m_elevationIndex.size()) - 1);
+	int i = m_elevationIndex[cell];
+
+	while(i + 1 < int(m_rings.size()) && m_rings[i + 1].elevation <= elevation)
+		i++;
+
+	return i;
+}
+
+int HRTF::findAzimuth(const Ring& ring, float azimuth)
+{
+	int i = ring.index[std::min(int(azimuth), 359)];
+
+	while(i + 1 < int(ring.azimuths.size()) && ring.azimuths[i + 1] <= azimuth)
+		i++;
+
+	return i;
+}
+
+std::shared_ptr<ImpulseResponse> HRTF::getNearest(float& azimuth, float& elevation) const
+{
+	int r = findRing(elevation);
+
+	if(r < 0)
+		r = 0;
+	else if(r + 1 < int(m_rings.size()) && m_rings[r + 1].elevation - elevation < elevation - m_rings[r].elevation)
+		r++;
+
+	const Ring& ring = m_rings[r];
+	int n = ring.azimuths.size();
+	int a = findAzimuth(ring, azimuth);
+	int low = a < 0 ? n - 1 : a;
+	int high = (a + 1) % n;
+
+	// the azimuth wraps around, so the distance to both neighbours is measured on the circle
+	if(std::fmod(ring.azimuths[high] - azimuth + 360, 360) < std::fmod(azimuth - ring.azimuths[low] + 360, 360))
+		low = high;
+
+	azimuth = ring.azimuths[low];
+	elevation = ring.elevation;
+
+	return ring.hrtfs[low];
+}
+
+std::shared_ptr<ImpulseResponse> HRTF::getInterpolated(float azimuth, float elevation) const
+{
+	int r = findRing(elevation);
+	int rings[2] = {std::max(r, 0), r + 1};
+	float ringWeights[2] = {1, 0};
+
+	if(r >= 0 && r + 1 < int(m_rings.size()))
+	{
+		ringWeights[1] = (elevation - m_rings[r].elevation) / (m_rings[r + 1].elevation - m_rings[r].elevation);
+		ringWeights[0] = 1 - ringWeights[1];
+	}
+
+	std::vector<std::shared_ptr<ImpulseResponse>> hrtfs;
+	std::vector<float> weights;
+
+	for(int i = 0; i < 2; i++)
 	{
-		dif = std::fabs(azimuth - elem.first);
-		if(dif < minDif)
+		if(ringWeights[i] <= 0)
+			continue;
+
+		const Ring& ring = m_rings[rings[i]];
+		int n = ring.azimuths.size();
+		int a = findAzimuth(ring, azimuth);
+		int low = a < 0 ? n - 1 : a;
+		int high = (a + 1) % n;
+
+		float span = std::fmod(ring.azimuths[high] - ring.azimuths[low] + 360, 360);
+		float t = span > 0 ? std::fmod(azimuth - ring.azimuths[low] + 360, 360) / span : 0;
+
+		if(1 - t > 0)
 		{
-			minDif = dif;
-			az = elem.first;
-			R = elem.second;
+			hrtfs.push_back(ring.hrtfs[low]);
+			weights.push_back(ringWeights[i] * (1 - t));
+		}
+
+		if(t > 0)
+		{
+			hrtfs.push_back(ring.hrtfs[high]);
+			weights.push_back(ringWeights[i] * t);
 		}
 	}
-	azimuth = az;
-	float azL = 360 - azimuth;
-	if(azL == 360)
-		azL = 0;
 
-	auto iter = m_hrtfs[elevation].find(azL);
-	if(iter != m_hrtfs[elevation].end())
-		L = iter->second;
-	else
+	if(hrtfs.size() == 1)
+		return hrtfs[0];
+
+	return std::make_shared<ImpulseResponse>(hrtfs, weights);
+}
+
+std::shared_ptr<ImpulseResponse> HRTF::getCached(float azimuth, float elevation, bool wait)
+{
+	std::pair<float, float> key(azimuth, elevation);
+	unsigned int generation;
+
 	{
-		dif = 0;
-		minDif = 360;
-		for(auto elem : m_hrtfs[elevation])
+		std::lock_guard<std::mutex> lock(m_cacheMutex);
+
+		auto it = m_cache.find(key);
+		if(it != m_cache.end())
+		{
+			m_recent.splice(m_recent.begin(), m_recent, it->second.second);
+			return it->second.first;
+		}
+
+		if(!wait)
 		{
-			dif = std::fabs(azL - elem.first);
-			if(dif < minDif)
+			// the requests have a fixed capacity, so that this doesn't allocate, a dropped request is repeated by the caller
+			if(m_requests.size() < MAX_REQUESTS && std::find(m_requests.begin(), m_requests.end(), key) == m_requests.end())
 			{
-				minDif = dif;
-				L = elem.second;
+				m_requests.push_back(key);
+				m_condition.notify_one();
 			}
+
+			return nullptr;
 		}
+
+		generation = m_generation;
+	}
+
+	// the interpolation takes long, so other threads aren't blocked meanwhile
+	std::shared_ptr<ImpulseResponse> hrtf = getInterpolated(azimuth, elevation);
+
+	std::lock_guard<std::mutex> lock(m_cacheMutex);
+
+	if(generation == m_generation)
+		insert(key, hrtf);
+
+	return hrtf;
+}
+
+void HRTF::insert(const std::pair<float, float>& direction, std::shared_ptr<ImpulseResponse> hrtf)
+{
+	if(m_cache.find(direction) != m_cache.end())
+		return;
+
+	m_recent.push_front(direction);
+	m_cache[direction] = std::make_pair(hrtf, m_recent.begin());
+
+	if(m_cache.size() > MAX_CACHED_DIRECTIONS)
+	{
+		m_cache.erase(m_recent.back());
+		m_recent.pop_back();
+	}
+}
+
+void HRTF::work()
+{
+	std::unique_lock<std::mutex> lock(m_cacheMutex);
+
+	for(;;)
+	{
+		m_condition.wait(lock, [this]() { return m_stop || !m_requests.empty(); });
+
+		if(m_stop)
+			return;
+
+		// the newest request is most likely still needed, it stays in the list until it is cached so that it isn't requested twice
+		std::pair<float, float> key = m_requests.back();
+		unsigned int generation = m_generation;
+
+		lock.unlock();
+
+		std::shared_ptr<ImpulseResponse> hrtf = getInterpolated(key.first, key.second);
+
+		lock.lock();
+
+		auto request = std::find(m_requests.begin(), m_requests.end(), key);
+		if(request != m_requests.end())
+			m_requests.erase(request);
+
+		// evicted HRTFs are freed here and not on the threads reading
+		if(generation == m_generation)
+			insert(key, hrtf);
 	}
-	return std::make_pair(L, R);
 }
 
 Specs HRTF::getSpecs()
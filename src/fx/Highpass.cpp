@@ -25,4 +25,9 @@ Highpass::Highpass(std::shared_ptr<ISound> sound, float frequency, float Q) :
 {
 }
 
+Highpass::Highpass(std::shared_ptr<ISound> sound, std::shared_ptr<AnimateableProperty> frequency, std::shared_ptr<AnimateableProperty> Q, float fps) :
+        DynamicIIRFilter(sound, std::shared_ptr<IDynamicIIRFilterCalculator>(new HighpassCalculator(frequency, Q, fps)))
+{
+}
+
 AUD_NAMESPACE_END
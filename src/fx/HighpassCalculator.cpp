@@ -15,6 +15,7 @@
  ******************************************************************************/
 
 #include "fx/HighpassCalculator.h"
+#include "sequence/AnimateableProperty.h"
 
 #include <cmath>
 
@@ -22,22 +23,60 @@ AUD_NAMESPACE_BEGIN
 
 HighpassCalculator::HighpassCalculator(float frequency, float Q) :
 	m_frequency(frequency),
-	m_Q(Q)
+	m_Q(Q),
+	m_fps(0)
+{
+}
+
+HighpassCalculator::HighpassCalculator(std::shared_ptr<AnimateableProperty> frequency, std::shared_ptr<AnimateableProperty> Q, float fps) :
+	m_frequency(0),
+	m_Q(1),
+	m_frequency_property(frequency),
+	m_Q_property(Q),
+	m_fps(fps)
 {
 }
 
 void HighpassCalculator::recalculateCoefficients(SampleRate rate, std::vector<float> &b, std::vector<float> &a)
 {
-	float w0 = 2.0 * M_PI * (SampleRate)m_frequency / rate;
-	float alpha = (float)(std::sin(w0) / (2.0 * (double)m_Q));
+	float section[5];
+	calculate(rate, 0, section);
+	a.push_back(1);
+	a.push_back(section[3]);
+	a.push_back(section[4]);
+	b.push_back(section[0]);
+	b.push_back(section[1]);
+	b.push_back(section[2]);
+}
+
+bool HighpassCalculator::animateSections(SampleRate rate, double time, std::vector<float> &sections)
+{
+	float section[5];
+	calculate(rate, time, section);
+	sections.insert(sections.end(), section, section + 5);
+	return m_frequency_property != nullptr;
+}
+
+void HighpassCalculator::calculate(SampleRate rate, double time, float* section)
+{
+	float frequency = m_frequency;
+	float Q = m_Q;
+
+	if(m_frequency_property)
+	{
+		m_frequency_property->read(time * m_fps, &frequency);
+		m_Q_property->read(time * m_fps, &Q);
+	}
+
+	float w0 = 2.0 * M_PI * (SampleRate)frequency / rate;
+	float alpha = (float)(std::sin(w0) / (2.0 * (double)Q));
 	float norm = 1 + alpha;
 	float c = std::cos(w0);
-	a.push_back(1);
-	a.push_back(-2 * c / norm);
-	a.push_back((1 - alpha) / norm);
-	b.push_back((1 + c) / (2 * norm));
-	b.push_back((-1 - c) / norm);
-	b.push_back(b[0]);
+	section[0] = (1 + c) / (2 * norm);
+	section[1] = (-1 - c) / norm;
+	section[2] = section[0];
+	section[3] = -2 * c / norm;
+	section[4] = (1 - alpha) / norm;
 }
 
 AUD_NAMESPACE_END
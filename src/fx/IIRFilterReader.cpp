@@ -29,6 +29,8 @@ IIRFilterReader::IIRFilterReader(std::shared_ptr<IReader> reader, const std::vec
 			m_b[i] /= m_a[0];
 		m_a[0] = 1;
 	}
+
+	m_biquads = m_cascade.setCoefficients(m_b, m_a);
 }
 
 sample_t IIRFilterReader::filter()
@@ -48,6 +50,17 @@ void IIRFilterReader::setCoefficients(const std::vector<float>& b, const std::ve
 	setLengths(b.size(), a.size());
 	m_a = a;
 	m_b = b;
+	m_biquads = m_cascade.setCoefficients(m_b, m_a);
+}
+
+bool IIRFilterReader::filterBlock(sample_t* buffer, int length, Channels channels)
+{
+	if(!m_biquads)
+		return false;
+
+	m_cascade.process(buffer, length, channels);
+
+	return true;
 }
 
 AUD_NAMESPACE_END
@@ -15,6 +15,8 @@
 ******************************************************************************/
 
 #include "fx/ImpulseResponse.h"
+#include "util/SplitSpectrum.h"
+#include "Exception.h"
 
 #include <algorithm>
 #include <cstring>
@@ -23,7 +25,7 @@
 
 AUD_NAMESPACE_BEGIN
 ImpulseResponse::ImpulseResponse(std::shared_ptr<StreamBuffer> impulseResponse) :
-	ImpulseResponse(impulseResponse, std::make_shared<FFTPlan>(0.0))
+	ImpulseResponse(impulseResponse, FFTPlan::getShared(DEFAULT_N))
 {
 }
 
@@ -34,6 +36,58 @@ ImpulseResponse::ImpulseResponse(std::shared_ptr<StreamBuffer> impulseResponse,
 	processImpulseResponse(impulseResponse->createReader(), plan);
 }
 
+ImpulseResponse::ImpulseResponse(const std::vector<std::shared_ptr<ImpulseResponse>>& impulseResponses, const std::vector<float>& weights)
+{
+	if(impulseResponses.empty() || impulseResponses.size() != weights.size())
+		AUD_THROW(StateException, "Every impulse response needs a weight");
+
+	m_specs = impulseResponses[0]->m_specs;
+	m_length = 0;
+	size_t partSize = (*impulseResponses[0]->m_processedIR[0])[0]->size();
+
+	for(auto& impulseResponse : impulseResponses)
+	{
+		if(impulseResponse->m_specs.channels != m_specs.channels || impulseResponse->m_specs.rate != m_specs.rate)
+			AUD_THROW(StateException, "The impulse responses don't have the same specs");
+		if((*impulseResponse->m_processedIR[0])[0]->size() != partSize)
+			AUD_THROW(StateException, "The impulse responses weren't processed with FFT plans of the same size");
+
+		m_length = std::max(m_length, impulseResponse->m_length);
+	}
+
+	m_samples.resize(m_specs.channels, std::vector<sample_t>(m_length));
+
+	for(int i = 0; i < m_specs.channels; i++)
+	{
+		auto parts = std::make_shared<std::vector<std::shared_ptr<std::vector<sample_t>>>>();
+
+		for(size_t k = 0; k < impulseResponses.size(); k++)
+		{
+			auto& source = *impulseResponses[k]->m_processedIR[i];
+			float weight = weights[k];
+
+			while(parts->size() < source.size())
+				parts->push_back(std::make_shared<std::vector<sample_t>>(partSize));
+
+			for(size_t h = 0; h < source.size(); h++)
+			{
+				sample_t* target = (*parts)[h]->data();
+				const sample_t* part = source[h]->data();
+
+				for(size_t j = 0; j < partSize; j++)
+					target[j] += weight * part[j];
+			}
+
+			const std::vector<sample_t>& samples = impulseResponses[k]->m_samples[i];
+
+			for(size_t j = 0; j < samples.size(); j++)
+				m_samples[i][j] += weight * samples[j];
+		}
+
+		m_processedIR.push_back(parts);
+	}
+}
+
 Specs ImpulseResponse::getSpecs()
 {
 	return m_specs;
@@ -44,11 +98,24 @@ int ImpulseResponse::getLength()
 	return m_length;
 }
 
-std::shared_ptr<std::vector<std::shared_ptr<std::vector<std::complex<sample_t>>>>> ImpulseResponse::getChannel(int n)
+std::shared_ptr<std::vector<std::shared_ptr<std::vector<sample_t>>>> ImpulseResponse::getChannel(int n)
 {
 	return m_processedIR[n];
 }
 
+std::shared_ptr<const NonUniformPartitions> ImpulseResponse::getPartitions(int n, int blockSize)
+{
+	std::lock_guard<std::mutex> lock(m_partitionsMutex);
+
+	auto& partitions = m_partitions[blockSize];
+
+	if(partitions.empty())
+		for(auto& samples : m_samples)
+			partitions.push_back(std::make_shared<NonUniformPartitions>(samples.data(), m_length, blockSize));
+
+	return partitions[n];
+}
+
 void ImpulseResponse::processImpulseResponse(std::shared_ptr<IReader> reader, std::shared_ptr<FFTPlan> plan)
 {
 	m_specs.channels = reader->getSpecs().channels;
@@ -61,13 +128,18 @@ void ImpulseResponse::processImpulseResponse(std::shared_ptr<IReader> reader, st
 
 	for(int i = 0; i < m_specs.channels; i++)
 	{
-		m_processedIR.push_back(std::make_shared<std::vector<std::shared_ptr<std::vector<std::complex<sample_t>>>>>());
+		m_processedIR.push_back(std::make_shared<std::vector<std::shared_ptr<std::vector<sample_t>>>>());
 		for(int j = 0; j < numParts; j++)
-			(*m_processedIR[i]).push_back(std::make_shared<std::vector<std::complex<sample_t>>>((N / 2) + 1));
+			(*m_processedIR[i]).push_back(std::make_shared<std::vector<sample_t>>(SplitSpectrum::getSize((N / 2) + 1)));
 	}
 	length += reader->getSpecs().rate;
 	reader->read(length, eos, buffer);
 
+	m_samples.resize(m_specs.channels, std::vector<sample_t>(m_length));
+	for(int i = 0; i < m_specs.channels; i++)
+		for(int j = 0; j < std::min(length, m_length); j++)
+			m_samples[i][j] = buffer[j * m_specs.channels + i];
+
 
 	void* bufferFFT = plan->getBuffer();
 	for(int i = 0; i < m_specs.channels; i++)
@@ -84,10 +156,9 @@ void ImpulseResponse::processImpulseResponse(std::shared_ptr<IReader> reader, st
 				k++;
 			}
 			plan->FFT(bufferFFT);
-			for(int j = 0; j < (N / 2) + 1; j++)
-			{
-				(*(*m_processedIR[i])[h])[j] = reinterpret_cast<std::complex<sample_t>*>(bufferFFT)[j];
-			}
+			for(int j = 0; j < ((N / 2) + 1) * 2; j++)
+				((float*)bufferFFT)[j] /= N;
+			SplitSpectrum::split((float*)bufferFFT, (*m_processedIR[i])[h]->data(), (N / 2) + 1);
 			partStart += N / 2 * m_specs.channels;
 		}
 	}
@@ -24,4 +24,9 @@ Lowpass::Lowpass(std::shared_ptr<ISound> sound, float frequency, float Q) :
 {
 }
 
+Lowpass::Lowpass(std::shared_ptr<ISound> sound, std::shared_ptr<AnimateableProperty> frequency, std::shared_ptr<AnimateableProperty> Q, float fps) :
+		DynamicIIRFilter(sound, std::shared_ptr<IDynamicIIRFilterCalculator>(new LowpassCalculator(frequency, Q, fps)))
+{
+}
+
 AUD_NAMESPACE_END
@@ -0,0 +1,213 @@
+/*******************************************************************************
+* Copyright 2015-2016 Juan Francisco Crespo Galán
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+******************************************************************************/
+
+#include "fx/NonUniformConvolver.h"
+#include "Exception.h"
+
+#include <algorithm>
+#include <cstring>
+
+#define MIN_THREAD_SIZE 1024
+
+AUD_NAMESPACE_BEGIN
+NonUniformConvolver::NonUniformConvolver(std::shared_ptr<const NonUniformPartitions> partitions, std::shared_ptr<ThreadPool> threadPool) :
+	m_partitions(partitions), m_blockSize(partitions->getBlockSize()), m_threadPool(threadPool), m_multiplyAdd(SplitSpectrum::getMultiplyAdd())
+{
+	for(const NonUniformPartitions::Segment& partition : m_partitions->getSegments())
+	{
+		std::unique_ptr<SegmentState> segment(new SegmentState());
+		int size = partition.size;
+		int spectrumSize = SplitSpectrum::getSize(size + 1);
+
+		segment->partitions = &partition;
+		segment->input.assureSize(2 * size * sizeof(sample_t));
+		segment->fft.assureSize((size + 1) * 2 * sizeof(sample_t));
+		segment->delayLine.assureSize(partition.count * spectrumSize * sizeof(sample_t));
+		segment->accumulator.assureSize(spectrumSize * sizeof(sample_t));
+		segment->inputs.resize(partition.count);
+
+		for(int i = 0; i < partition.count; i++)
+			segment->spectra.push_back(partition.spectra.data() + i * spectrumSize);
+		segment->output[0].assureSize(size * sizeof(sample_t));
+		segment->output[1].assureSize(size * sizeof(sample_t));
+
+		// small segments aren't worth the synchronization
+		segment->threaded = m_threadPool && !m_segments.empty() && size >= MIN_THREAD_SIZE;
+
+		m_segments.push_back(std::move(segment));
+	}
+
+	reset();
+}
+
+NonUniformConvolver::~NonUniformConvolver()
+{
+	wait();
+}
+
+void NonUniformConvolver::getNext(sample_t* inBuffer, sample_t* outBuffer, int& length, bool& eos)
+{
+	if(length > m_blockSize)
+		AUD_THROW(StateException, "The length can't be larger than the block size of the convolver");
+
+	if(m_eos)
+	{
+		length = 0;
+		eos = m_eos;
+		return;
+	}
+
+	eos = false;
+
+	int inLength = inBuffer != nullptr ? std::max(length, 0) : 0;
+	long long end = m_inputLength + inLength + m_partitions->getLength() - 1;
+
+	if(inBuffer == nullptr && m_outputLength >= end)
+	{
+		length = 0;
+		eos = m_eos = true;
+		return;
+	}
+
+	for(auto& segment : m_segments)
+	{
+		sample_t* input = segment->input.getBuffer() + segment->partitions->size + segment->fill;
+		if(inLength > 0)
+			std::memcpy(input, inBuffer, inLength * sizeof(sample_t));
+		std::memset(input + inLength, 0, (m_blockSize - inLength) * sizeof(sample_t));
+		segment->fill += m_blockSize;
+	}
+
+	for(size_t i = 0; i < m_segments.size(); i++)
+	{
+		SegmentState* segment = m_segments[i].get();
+		int size = segment->partitions->size;
+
+		if(i > 0)
+		{
+			const sample_t* output = segment->output[segment->current].getBuffer() + segment->position;
+			for(int j = 0; j < m_blockSize; j++)
+				outBuffer[j] += output[j];
+			segment->position += m_blockSize;
+		}
+
+		if(segment->fill < size)
+			continue;
+
+		if(segment->future.valid())
+			segment->future.get();
+
+		sample_t* input = segment->input.getBuffer();
+		std::memcpy(segment->fft.getBuffer(), input, 2 * size * sizeof(sample_t));
+		std::memcpy(input, input + size, size * sizeof(sample_t));
+		segment->fill = 0;
+
+		// the head is convolved into the current block, the output of the other segments starts after one more of their blocks
+		if(i == 0)
+		{
+			processSegment(segment, outBuffer);
+			continue;
+		}
+
+		segment->current ^= 1;
+		segment->position = 0;
+
+		sample_t* output = segment->output[segment->current ^ 1].getBuffer();
+
+		if(segment->threaded)
+			segment->future = m_threadPool->enqueue(&NonUniformConvolver::processSegment, this, segment, output);
+		else
+			processSegment(segment, output);
+	}
+
+	m_inputLength += inLength;
+	m_outputLength += m_blockSize;
+
+	length = m_blockSize;
+
+	// a block shorter than the block size ends the input
+	if(inLength < m_blockSize && m_outputLength >= end)
+	{
+		length -= int(m_outputLength - end);
+		eos = m_eos = true;
+	}
+}
+
+void NonUniformConvolver::reset()
+{
+	wait();
+
+	for(auto& segment : m_segments)
+	{
+		int size = segment->partitions->size;
+
+		std::memset(segment->input.getBuffer(), 0, 2 * size * sizeof(sample_t));
+		std::memset(segment->delayLine.getBuffer(), 0, segment->delayLine.getSize());
+		std::memset(segment->output[0].getBuffer(), 0, size * sizeof(sample_t));
+		std::memset(segment->output[1].getBuffer(), 0, size * sizeof(sample_t));
+		segment->fill = 0;
+		segment->head = 0;
+		segment->current = 0;
+		segment->position = 0;
+	}
+
+	m_inputLength = 0;
+	m_outputLength = 0;
+	m_eos = false;
+}
+
+int NonUniformConvolver::getBlockSize() const
+{
+	return m_blockSize;
+}
+
+void NonUniformConvolver::processSegment(SegmentState* segment, sample_t* output)
+{
+	const NonUniformPartitions::Segment& partitions = *segment->partitions;
+	int size = partitions.size;
+	int count = partitions.count;
+	int spectrumSize = SplitSpectrum::getSize(size + 1);
+
+	sample_t* fft = segment->fft.getBuffer();
+	sample_t* delayLine = segment->delayLine.getBuffer();
+	sample_t* accumulator = segment->accumulator.getBuffer();
+
+	partitions.plan->FFT(fft);
+
+	segment->head = (segment->head == 0 ? count : segment->head) - 1;
+	SplitSpectrum::split(fft, delayLine + segment->head * spectrumSize, size + 1);
+
+	// partition p is multiplied with the spectrum of the input block p blocks ago
+	for(int p = 0; p < count; p++)
+		segment->inputs[p] = delayLine + ((segment->head + p) % count) * spectrumSize;
+
+	std::memset(accumulator, 0, spectrumSize * sizeof(sample_t));
+	m_multiplyAdd(segment->inputs.data(), segment->spectra.data(), count, accumulator, spectrumSize / 2);
+
+	SplitSpectrum::merge(accumulator, fft, size + 1);
+	partitions.plan->IFFT(fft);
+
+	// overlap-save: only the second half is free of circular aliasing
+	std::memcpy(output, fft + size, size * sizeof(sample_t));
+}
+
+void NonUniformConvolver::wait()
+{
+	for(auto& segment : m_segments)
+		if(segment->future.valid())
+			segment->future.get();
+}
+AUD_NAMESPACE_END
@@ -0,0 +1,99 @@
+/*******************************************************************************
+* Copyright 2015-2016 Juan Francisco Crespo Galán
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+******************************************************************************/
+
+#include "fx/NonUniformPartitions.h"
+#include "util/SplitSpectrum.h"
+#include "Exception.h"
+
+#include <algorithm>
+#include <cstring>
+
+#define MAX_PARTITION_SIZE 8192
+
+AUD_NAMESPACE_BEGIN
+NonUniformPartitions::NonUniformPartitions(const sample_t* ir, int length, int blockSize) :
+	m_blockSize(blockSize), m_length(length)
+{
+	if(blockSize <= 0)
+		AUD_THROW(StateException, "The block size of a non uniform convolution must be positive");
+
+	int maxSize = std::max(blockSize, MAX_PARTITION_SIZE);
+	int size = blockSize;
+	int offset = 0;
+
+	do
+	{
+		int next = size * 2 <= maxSize ? size * 2 : size;
+		int remaining = (std::max(length - offset, 1) + size - 1) / size;
+
+		Segment segment;
+		segment.size = size;
+		segment.offset = offset;
+
+		// the next segment starts at twice its partition size, the last one takes the rest
+		if(next == size)
+			segment.count = remaining;
+		else
+			segment.count = std::min((2 * next - offset) / size, remaining);
+
+		segment.plan = FFTPlan::getShared(2 * size);
+		int spectrumSize = SplitSpectrum::getSize(size + 1);
+		segment.spectra.resize(segment.count * spectrumSize);
+
+		void* bufferFFT = segment.plan->getBuffer();
+		float scale = 1.0f / (2 * size);
+
+		for(int i = 0; i < segment.count; i++)
+		{
+			int start = offset + i * size;
+			int len = std::max(std::min(size, length - start), 0);
+
+			std::memset(bufferFFT, 0, (size + 1) * 2 * sizeof(float));
+			std::memcpy(bufferFFT, ir + start, len * sizeof(sample_t));
+			segment.plan->FFT(bufferFFT);
+
+			sample_t* spectrum = reinterpret_cast<sample_t*>(bufferFFT);
+			for(int j = 0; j < (size + 1) * 2; j++)
+				spectrum[j] *= scale;
+
+			SplitSpectrum::split(spectrum, segment.spectra.data() + i * spectrumSize, size + 1);
+		}
+
+		segment.plan->freeBuffer(bufferFFT);
+
+		offset += segment.count * size;
+		size = next;
+
+		m_segments.push_back(std::move(segment));
+	}
+	while(offset < length);
+}
+
+int NonUniformPartitions::getBlockSize() const
+{
+	return m_blockSize;
+}
+
+int NonUniformPartitions::getLength() const
+{
+	return m_length;
+}
+
+const std::vector<NonUniformPartitions::Segment>& NonUniformPartitions::getSegments() const
+{
+	return m_segments;
+}
+AUD_NAMESPACE_END
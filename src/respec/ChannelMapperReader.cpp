@@ -15,23 +15,329 @@
  ******************************************************************************/
 
 #include "respec/ChannelMapperReader.h"
+#include "util/SIMD.h"
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <limits>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#if defined(AUD_SIMD_X86)
+#include <immintrin.h>
+#elif defined(AUD_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+#define COLUMN_SIZE 8
 
 AUD_NAMESPACE_BEGIN
 
+struct ChannelMapperReader::Mapping
+{
+	/// The source channel count.
+	Channels source;
+
+	/// The target channel count.
+	Channels target;
+
+	/// The angle of a mono source, zero for other sources.
+	float angle;
+
+	/// The target x source matrix.
+	std::vector<float> matrix;
+
+	/// The start of the nonzero terms of each target channel and their end.
+	std::vector<int> term_start;
+
+	/// The source channel of each nonzero term.
+	std::vector<int> term_source;
+
+	/// The gain of each nonzero term.
+	std::vector<float> term_gain;
+
+	/// The source channel of each column with nonzero entries.
+	std::vector<int> column_source;
+
+	/// These columns with COLUMN_SIZE gains each, padded with zeros.
+	Buffer column_gains;
+};
+
+typedef ChannelMapperReader::Mapping Mapping;
+
+/*
+ * The mapping functions map length frames from in to out, which may not
+ * overlap. All of them add the terms of a target channel in the order of the
+ * source channels like the matrix vector product, but skip the zero terms.
+ */
+
+static void map_terms(const Mapping& mapping, const sample_t* in, int length, sample_t* out)
+{
+	const int* start = mapping.term_start.data();
+	const int* source = mapping.term_source.data();
+	const float* gain = mapping.term_gain.data();
+	int source_channels = mapping.source;
+	int target_channels = mapping.target;
+
+	for(int i = 0; i < length; i++)
+	{
+		for(int j = 0; j < target_channels; j++)
+		{
+			sample_t sum = 0;
+
+			for(int t = start[j]; t < start[j + 1]; t++)
+				sum += gain[t] * in[source[t]];
+
+			out[j] = sum;
+		}
+
+		in += source_channels;
+		out += target_channels;
+	}
+}
+
+/*
+ * The column functions add the nonzero source columns of the matrix to a
+ * target frame, so that the target channels can be processed together.
+ */
+
+template <int T>
+static void map_columns(const Mapping& mapping, const sample_t* in, int length, sample_t* out)
+{
+	const float* gains = reinterpret_cast<const float*>(mapping.column_gains.getBuffer());
+	const int* source = mapping.column_source.data();
+	int columns = mapping.column_source.size();
+	int source_channels = mapping.source;
+
+	for(int i = 0; i < length; i++)
+	{
+		sample_t sum[T] = {};
+
+		for(int c = 0; c < columns; c++)
+		{
+			sample_t sample = in[source[c]];
+
+			for(int j = 0; j < T; j++)
+				sum[j] += gains[c * COLUMN_SIZE + j] * sample;
+		}
+
+		for(int j = 0; j < T; j++)
+			out[j] = sum[j];
+
+		in += source_channels;
+		out += T;
+	}
+}
+
+static void (*const map_columns_scalar[])(const Mapping&, const sample_t*, int, sample_t*) = {
+	map_columns<1>, map_columns<2>, map_columns<3>, map_columns<4>, map_columns<5>, map_columns<6>, map_columns<7>, map_columns<8>
+};
+
+static void map_mono_stereo_scalar(const Mapping& mapping, const sample_t* in, int length, sample_t* out)
+{
+	float left = mapping.matrix[0];
+	float right = mapping.matrix[1];
+
+	for(int i = 0; i < length; i++)
+	{
+		out[i * 2] = left * in[i];
+		out[i * 2 + 1] = right * in[i];
+	}
+}
+
+static void map_stereo_mono_scalar(const Mapping& mapping, const sample_t* in, int length, sample_t* out)
+{
+	float left = mapping.matrix[0];
+	float right = mapping.matrix[1];
+
+	for(int i = 0; i < length; i++)
+		out[i] = left * in[i * 2] + right * in[i * 2 + 1];
+}
+
+#if defined(AUD_SIMD_X86)
+
+AUD_TARGET_SSE2 static void map_mono_stereo_sse2(const Mapping& mapping, const sample_t* in, int length, sample_t* out)
+{
+	const __m128 gains = _mm_setr_ps(mapping.matrix[0], mapping.matrix[1], mapping.matrix[0], mapping.matrix[1]);
+	int i = 0;
+
+	for(; i + 4 <= length; i += 4)
+	{
+		__m128 samples = _mm_loadu_ps(in + i);
+
+		_mm_storeu_ps(out + i * 2, _mm_mul_ps(_mm_unpacklo_ps(samples, samples), gains));
+		_mm_storeu_ps(out + i * 2 + 4, _mm_mul_ps(_mm_unpackhi_ps(samples, samples), gains));
+	}
+
+	map_mono_stereo_scalar(mapping, in + i, length - i, out + i * 2);
+}
+
+AUD_TARGET_SSE2 static void map_stereo_mono_sse2(const Mapping& mapping, const sample_t* in, int length, sample_t* out)
+{
+	const __m128 left = _mm_set1_ps(mapping.matrix[0]);
+	const __m128 right = _mm_set1_ps(mapping.matrix[1]);
+	int i = 0;
+
+	for(; i + 4 <= length; i += 4)
+	{
+		__m128 a = _mm_loadu_ps(in + i * 2);
+		__m128 b = _mm_loadu_ps(in + i * 2 + 4);
+
+		__m128 l = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 r = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+
+		_mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(left, l), _mm_mul_ps(right, r)));
+	}
+
+	map_stereo_mono_scalar(mapping, in + i * 2, length - i, out + i);
+}
+
+/*
+ * The vector column functions compute a whole target frame per vector. A store
+ * may write past the frame into the next one, which is overwritten afterwards,
+ * so the last frames are mapped by map_terms.
+ */
+
+template <int N>
+AUD_TARGET_SSE2 static void map_columns_sse2(const Mapping& mapping, const sample_t* in, int length, sample_t* out)
+{
+	const float* gains = reinterpret_cast<const float*>(mapping.column_gains.getBuffer());
+	const int* source = mapping.column_source.data();
+	int columns = mapping.column_source.size();
+	int source_channels = mapping.source;
+	int target_channels = mapping.target;
+	int i = 0;
+
+	// N vectors hold up to 4 * N target channels
+	for(; i * target_channels + 4 * N <= length * target_channels; i++)
+	{
+		const sample_t* frame = in + i * source_channels;
+		__m128 sum[N];
+
+		for(int v = 0; v < N; v++)
+			sum[v] = _mm_setzero_ps();
+
+		for(int c = 0; c < columns; c++)
+		{
+			__m128 sample = _mm_set1_ps(frame[source[c]]);
+
+			for(int v = 0; v < N; v++)
+				sum[v] = _mm_add_ps(sum[v], _mm_mul_ps(_mm_load_ps(gains + c * COLUMN_SIZE + v * 4), sample));
+		}
+
+		for(int v = 0; v < N; v++)
+			_mm_storeu_ps(out + i * target_channels + v * 4, sum[v]);
+	}
+
+	map_terms(mapping, in + i * source_channels, length - i, out + i * target_channels);
+}
+
+AUD_TARGET_AVX2 static void map_columns_avx2(const Mapping& mapping, const sample_t* in, int length, sample_t* out)
+{
+	const float* gains = reinterpret_cast<const float*>(mapping.column_gains.getBuffer());
+	const int* source = mapping.column_source.data();
+	int columns = mapping.column_source.size();
+	int source_channels = mapping.source;
+	int target_channels = mapping.target;
+	int i = 0;
+
+	for(; i * target_channels + COLUMN_SIZE <= length * target_channels; i++)
+	{
+		const sample_t* frame = in + i * source_channels;
+		__m256 sum = _mm256_setzero_ps();
+
+		for(int c = 0; c < columns; c++)
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_load_ps(gains + c * COLUMN_SIZE), _mm256_broadcast_ss(frame + source[c])));
+
+		_mm256_storeu_ps(out + i * target_channels, sum);
+	}
+
+	map_terms(mapping, in + i * source_channels, length - i, out + i * target_channels);
+}
+
+#elif defined(AUD_SIMD_NEON)
+
+static void map_mono_stereo_neon(const Mapping& mapping, const sample_t* in, int length, sample_t* out)
+{
+	const float32x4_t gains = vcombine_f32(vld1_f32(mapping.matrix.data()), vld1_f32(mapping.matrix.data()));
+	int i = 0;
+
+	for(; i + 4 <= length; i += 4)
+	{
+		float32x4_t samples = vld1q_f32(in + i);
+		float32x4x2_t pairs = vzipq_f32(samples, samples);
+
+		vst1q_f32(out + i * 2, vmulq_f32(pairs.val[0], gains));
+		vst1q_f32(out + i * 2 + 4, vmulq_f32(pairs.val[1], gains));
+	}
+
+	map_mono_stereo_scalar(mapping, in + i, length - i, out + i * 2);
+}
+
+static void map_stereo_mono_neon(const Mapping& mapping, const sample_t* in, int length, sample_t* out)
+{
+	const float32x4_t left = vdupq_n_f32(mapping.matrix[0]);
+	const float32x4_t right = vdupq_n_f32(mapping.matrix[1]);
+	int i = 0;
+
+	for(; i + 4 <= length; i += 4)
+	{
+		float32x4x2_t frames = vld2q_f32(in + i * 2);
+
+		vst1q_f32(out + i, vaddq_f32(vmulq_f32(left, frames.val[0]), vmulq_f32(right, frames.val[1])));
+	}
+
+	map_stereo_mono_scalar(mapping, in + i * 2, length - i, out + i);
+}
+
+template <int N>
+static void map_columns_neon(const Mapping& mapping, const sample_t* in, int length, sample_t* out)
+{
+	const float* gains = reinterpret_cast<const float*>(mapping.column_gains.getBuffer());
+	const int* source = mapping.column_source.data();
+	int columns = mapping.column_source.size();
+	int source_channels = mapping.source;
+	int target_channels = mapping.target;
+	int i = 0;
+
+	// N vectors hold up to 4 * N target channels
+	for(; i * target_channels + 4 * N <= length * target_channels; i++)
+	{
+		const sample_t* frame = in + i * source_channels;
+		float32x4_t sum[N];
+
+		for(int v = 0; v < N; v++)
+			sum[v] = vdupq_n_f32(0);
+
+		for(int c = 0; c < columns; c++)
+		{
+			float32x4_t sample = vdupq_n_f32(frame[source[c]]);
+
+			for(int v = 0; v < N; v++)
+				sum[v] = vaddq_f32(sum[v], vmulq_f32(vld1q_f32(gains + c * COLUMN_SIZE + v * 4), sample));
+		}
+
+		for(int v = 0; v < N; v++)
+			vst1q_f32(out + i * target_channels + v * 4, sum[v]);
+	}
+
+	map_terms(mapping, in + i * source_channels, length - i, out + i * target_channels);
+}
+
+#endif
+
 ChannelMapperReader::ChannelMapperReader(std::shared_ptr<IReader> reader,
 												 Channels channels) :
 		EffectReader(reader), m_target_channels(channels),
-	m_source_channels(CHANNELS_INVALID), m_mapping(nullptr), m_map_size(0), m_mono_angle(0)
+	m_source_channels(CHANNELS_INVALID), m_map(nullptr), m_mono_angle(0)
 {
 }
 
 ChannelMapperReader::~ChannelMapperReader()
 {
-	delete[] m_mapping;
 }
 
 Channels ChannelMapperReader::getSourceChannels() const
@@ -59,10 +365,10 @@ float ChannelMapperReader::getMapping(int source, int target)
 		calculateMapping();
 	}
 
-	if(source < 0 || source >= source_channels || target < 0 || target >= m_target_channels)
+	if(!m_mapping || source < 0 || source >= source_channels || target < 0 || target >= m_target_channels)
 		return std::numeric_limits<float>::quiet_NaN();
 
-	return m_mapping[target * source_channels + source];
+	return m_mapping->matrix[target * source_channels + source];
 }
 
 void ChannelMapperReader::setMonoAngle(float angle)
@@ -88,18 +394,90 @@ float ChannelMapperReader::angleDistance(float alpha, float beta)
 
 void ChannelMapperReader::calculateMapping()
 {
-	if(m_map_size < m_source_channels * m_target_channels)
+	if(m_source_channels == CHANNELS_INVALID || m_target_channels == CHANNELS_INVALID)
+	{
+		m_mapping = nullptr;
+		m_map = nullptr;
+		return;
+	}
+
+	float angle = m_source_channels == CHANNELS_MONO ? m_mono_angle : 0;
+
+	// nothing changed, for example a 3D source that didn't move
+	if(m_mapping && m_mapping->source == m_source_channels && m_mapping->target == m_target_channels && m_mapping->angle == angle)
+		return;
+
+	if(m_source_channels == CHANNELS_MONO)
+	{
+		// the angle of a mono source changes while it moves, so its mapping is calculated in place
+		if(!m_own_mapping)
+			m_own_mapping = std::make_shared<Mapping>();
+
+		m_own_mapping->source = m_source_channels;
+		m_own_mapping->target = m_target_channels;
+		m_own_mapping->angle = angle;
+		fillMapping(*m_own_mapping);
+
+		m_mapping = m_own_mapping;
+	}
+	else
 	{
-		delete[] m_mapping;
-		m_mapping = new float[m_source_channels * m_target_channels];
-		m_map_size = m_source_channels * m_target_channels;
+		typedef std::pair<Channels, Channels> Key;
+
+		static std::mutex mutex;
+		static std::map<Key, std::shared_ptr<const Mapping>> mappings;
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		std::shared_ptr<const Mapping>& mapping = mappings[Key(m_source_channels, m_target_channels)];
+
+		if(!mapping)
+		{
+			std::shared_ptr<Mapping> new_mapping = std::make_shared<Mapping>();
+			new_mapping->source = m_source_channels;
+			new_mapping->target = m_target_channels;
+			new_mapping->angle = angle;
+			fillMapping(*new_mapping);
+
+			mapping = new_mapping;
+		}
+
+		m_mapping = mapping;
 	}
 
-	for(int i = 0; i < m_source_channels * m_target_channels; i++)
-		m_mapping[i] = 0;
+	bool mono_stereo = m_source_channels == CHANNELS_MONO && m_target_channels == CHANNELS_STEREO;
+	bool stereo_mono = m_source_channels == CHANNELS_STEREO && m_target_channels == CHANNELS_MONO;
 
-	const Channels source_channel_count = std::min(m_source_channels, CHANNELS_SURROUND71);
-	const Channels target_channel_count = std::min(m_target_channels, CHANNELS_SURROUND71);
+	switch(SIMD::getLevel())
+	{
+#if defined(AUD_SIMD_X86)
+	case SIMD_AVX2:
+		m_map = mono_stereo ? map_mono_stereo_sse2 : stereo_mono ? map_stereo_mono_sse2 : m_target_channels <= COLUMN_SIZE ? map_columns_avx2 : map_terms;
+		break;
+	case SIMD_SSE2:
+		m_map = mono_stereo ? map_mono_stereo_sse2 : stereo_mono ? map_stereo_mono_sse2 : m_target_channels <= 4 ? map_columns_sse2<1> : m_target_channels <= COLUMN_SIZE ? map_columns_sse2<2> : map_terms;
+		break;
+#elif defined(AUD_SIMD_NEON)
+	case SIMD_NEON:
+		m_map = mono_stereo ? map_mono_stereo_neon : stereo_mono ? map_stereo_mono_neon : m_target_channels <= 4 ? map_columns_neon<1> : m_target_channels <= COLUMN_SIZE ? map_columns_neon<2> : map_terms;
+		break;
+#endif
+	default:
+		m_map = mono_stereo ? map_mono_stereo_scalar : stereo_mono ? map_stereo_mono_scalar : m_target_channels <= COLUMN_SIZE ? map_columns_scalar[m_target_channels - 1] : map_terms;
+		break;
+	}
+}
+
+void ChannelMapperReader::fillMapping(Mapping& mapping)
+{
+	int source_count = mapping.source;
+	int target_count = mapping.target;
+
+	std::vector<float>& matrix = mapping.matrix;
+	matrix.assign(source_count * target_count, 0);
+
+	const Channels source_channel_count = std::min(mapping.source, CHANNELS_SURROUND71);
+	const Channels target_channel_count = std::min(mapping.target, CHANNELS_SURROUND71);
 
 	const Channel* source_channels = CHANNEL_MAPS[source_channel_count - 1];
 	const Channel* target_channels = CHANNEL_MAPS[target_channel_count - 1];
@@ -119,7 +497,7 @@ void ChannelMapperReader::calculateMapping()
 	const float* target_angles = CHANNEL_ANGLES[target_channel_count - 1];
 
 	if(source_channel_count == CHANNELS_MONO)
-		source_angles = &m_mono_angle;
+		source_angles = &mapping.angle;
 
 	int channel_left, channel_right;
 	float angle_left, angle_right, angle;
@@ -129,7 +507,7 @@ void ChannelMapperReader::calculateMapping()
 		if(source_channels[i] == CHANNEL_LFE)
 		{
 			if(lfe != -1)
-				m_mapping[lfe * m_source_channels + i] = 1;
+				matrix[lfe * source_count + i] = 1;
 
 			continue;
 		}
@@ -164,16 +542,64 @@ void ChannelMapperReader::calculateMapping()
 		angle = angle_right - angle_left;
 		if(channel_right == -1 || angle == 0)
 		{
-			m_mapping[channel_left * m_source_channels + i] = 1;
+			matrix[channel_left * source_count + i] = 1;
 		}
 		else if(channel_left == -1)
 		{
-			m_mapping[channel_right * m_source_channels + i] = 1;
+			matrix[channel_right * source_count + i] = 1;
 		}
 		else
 		{
-			m_mapping[channel_left * m_source_channels + i] = std::cos(M_PI_2 * angle_left / angle);
-			m_mapping[channel_right * m_source_channels + i] = std::cos(M_PI_2 * angle_right / angle);
+			matrix[channel_left * source_count + i] = std::cos(M_PI_2 * angle_left / angle);
+			matrix[channel_right * source_count + i] = std::cos(M_PI_2 * angle_right / angle);
+		}
+	}
+
+	// the nonzero terms of each target channel for map_terms
+	mapping.term_start.resize(target_count + 1);
+	mapping.term_source.clear();
+	mapping.term_gain.clear();
+
+	for(int j = 0; j < target_count; j++)
+	{
+		mapping.term_start[j] = mapping.term_source.size();
+
+		for(int i = 0; i < source_count; i++)
+		{
+			if(matrix[j * source_count + i] != 0)
+			{
+				mapping.term_source.push_back(i);
+				mapping.term_gain.push_back(matrix[j * source_count + i]);
+			}
+		}
+	}
+
+	mapping.term_start[target_count] = mapping.term_source.size();
+
+	// the nonzero columns for the vector functions, only used up to COLUMN_SIZE target channels
+	mapping.column_source.clear();
+
+	if(target_count <= COLUMN_SIZE)
+	{
+		for(int i = 0; i < source_count; i++)
+		{
+			for(int j = 0; j < target_count; j++)
+			{
+				if(matrix[j * source_count + i] != 0)
+				{
+					mapping.column_source.push_back(i);
+					break;
+				}
+			}
+		}
+
+		mapping.column_gains.assureSize(std::max<int>(mapping.column_source.size(), 1) * COLUMN_SIZE * sizeof(float));
+		float* gains = reinterpret_cast<float*>(mapping.column_gains.getBuffer());
+
+		for(size_t c = 0; c < mapping.column_source.size(); c++)
+		{
+			for(int j = 0; j < COLUMN_SIZE; j++)
+				gains[c * COLUMN_SIZE + j] = j < target_count ? matrix[j * source_count + mapping.column_source[c]] : 0;
 		}
 	}
 }
@@ -206,18 +632,8 @@ void ChannelMapperReader::read(int& length, bool& eos, sample_t* buffer)
 
 	m_reader->read(length, eos, in);
 
-	sample_t sum;
-
-	for(int i = 0; i < length; i++)
-	{
-		for(int j = 0; j < m_target_channels; j++)
-		{
-			sum = 0;
-			for(int k = 0; k < m_source_channels; k++)
-				sum += m_mapping[j * m_source_channels + k] * in[i * m_source_channels + k];
-			buffer[i * m_target_channels + j] = sum;
-		}
-	}
+	if(m_map)
+		m_map(*m_mapping, in, length, buffer);
 }
 
 const Channel ChannelMapperReader::MONO_MAP[] =
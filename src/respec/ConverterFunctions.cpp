@@ -15,9 +15,16 @@
  ******************************************************************************/
 
 #include "respec/ConverterFunctions.h"
+#include "util/SIMD.h"
 
 #include <stdint.h>
 
+#if defined(AUD_SIMD_X86)
+#include <immintrin.h>
+#elif defined(AUD_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
 #define U8_0		0x80
 #define S16_MAX		((int16_t)0x7FFF)
 #define S16_MIN		((int16_t)0x8000)
@@ -30,6 +37,583 @@
 
 AUD_NAMESPACE_BEGIN
 
+/*
+ * The vector kernels convert blocks of CONVERT_BLOCK samples, the public
+ * functions convert the remaining samples with the scalar code. Conversions
+ * to a bigger sample size run backwards and conversions to a smaller or the
+ * same size forwards, like the scalar code, so that converting in place
+ * stays possible. Each block is completely loaded before it is stored and the
+ * kernels never access memory outside the blocks. The results are the same
+ * as the ones of the scalar code, which is why the divisions are kept unless
+ * they are by a power of two.
+ */
+
+#define CONVERT_BLOCK 16
+
+/// The vector kernels of one SIMD level, nullptr where there is none.
+struct ConvertKernels
+{
+	convert_f u8_float;
+	convert_f s16_float;
+	convert_f s24_float_be;
+	convert_f s24_float_le;
+	convert_f s32_float;
+	convert_f float_u8;
+	convert_f float_s16;
+	convert_f float_s24_be;
+	convert_f float_s24_le;
+	convert_f float_s32;
+};
+
+#if defined(AUD_SIMD_X86)
+
+AUD_TARGET_SSE2 static inline __m128i select_sse2(__m128 mask, __m128i a, __m128i b)
+{
+	__m128i m = _mm_castps_si128(mask);
+	return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b));
+}
+
+AUD_TARGET_SSE2 static void convert_u8_float_sse2(data_t* target, data_t* source, int length)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i offset = _mm_set1_epi32(U8_0);
+	const __m128 scale = _mm_set1_ps(1.0f / U8_0);
+	float* t = (float*) target;
+
+	for(int i = length - CONVERT_BLOCK; i >= 0; i -= CONVERT_BLOCK)
+	{
+		__m128i s = _mm_loadu_si128((__m128i*)(source + i));
+		__m128i lo = _mm_unpacklo_epi8(s, zero);
+		__m128i hi = _mm_unpackhi_epi8(s, zero);
+
+		__m128i v[4] = {_mm_unpacklo_epi16(lo, zero), _mm_unpackhi_epi16(lo, zero), _mm_unpacklo_epi16(hi, zero), _mm_unpackhi_epi16(hi, zero)};
+
+		for(int j = 0; j < 4; j++)
+			_mm_storeu_ps(t + i + j * 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(v[j], offset)), scale));
+	}
+}
+
+AUD_TARGET_SSE2 static void convert_s16_float_sse2(data_t* target, data_t* source, int length)
+{
+	const __m128 scale = _mm_set1_ps(S16_FLT);
+	int16_t* s = (int16_t*) source;
+	float* t = (float*) target;
+
+	for(int i = length - CONVERT_BLOCK; i >= 0; i -= CONVERT_BLOCK)
+	{
+		__m128i a = _mm_loadu_si128((__m128i*)(s + i));
+		__m128i b = _mm_loadu_si128((__m128i*)(s + i + 8));
+
+		// sign extension by shifting the samples into the upper half
+		__m128i v[4] = {_mm_srai_epi32(_mm_unpacklo_epi16(a, a), 16), _mm_srai_epi32(_mm_unpackhi_epi16(a, a), 16), _mm_srai_epi32(_mm_unpacklo_epi16(b, b), 16), _mm_srai_epi32(_mm_unpackhi_epi16(b, b), 16)};
+
+		for(int j = 0; j < 4; j++)
+			_mm_storeu_ps(t + i + j * 4, _mm_div_ps(_mm_cvtepi32_ps(v[j]), scale));
+	}
+}
+
+AUD_TARGET_SSE2 static void convert_s32_float_sse2(data_t* target, data_t* source, int length)
+{
+	// S32_FLT is a power of two
+	const __m128 scale = _mm_set1_ps(1.0f / S32_FLT);
+	int32_t* s = (int32_t*) source;
+	float* t = (float*) target;
+
+	for(int i = 0; i < length; i += 4)
+		_mm_storeu_ps(t + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((__m128i*)(s + i))), scale));
+}
+
+AUD_TARGET_SSE2 static void convert_float_u8_sse2(data_t* target, data_t* source, int length)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(FLT_MAX);
+	const __m128 two = _mm_set1_ps(2.0f);
+	const __m128 scale = _mm_set1_ps(127);
+	float* s = (float*) source;
+
+	for(int i = 0; i < length; i += CONVERT_BLOCK)
+	{
+		__m128i v[4];
+
+		for(int j = 0; j < 4; j++)
+		{
+			__m128 t = _mm_add_ps(_mm_loadu_ps(s + i + j * 4), one);
+			__m128i u = _mm_cvttps_epi32(_mm_mul_ps(t, scale));
+			u = select_sse2(_mm_cmple_ps(t, zero), _mm_setzero_si128(), u);
+			v[j] = select_sse2(_mm_cmpge_ps(t, two), _mm_set1_epi32(255), u);
+		}
+
+		_mm_storeu_si128((__m128i*)(target + i), _mm_packus_epi16(_mm_packs_epi32(v[0], v[1]), _mm_packs_epi32(v[2], v[3])));
+	}
+}
+
+AUD_TARGET_SSE2 static void convert_float_s16_sse2(data_t* target, data_t* source, int length)
+{
+	const __m128 min = _mm_set1_ps(FLT_MIN);
+	const __m128 max = _mm_set1_ps(FLT_MAX);
+	const __m128 scale = _mm_set1_ps(S16_MAX);
+	int16_t* t = (int16_t*) target;
+	float* s = (float*) source;
+
+	for(int i = 0; i < length; i += CONVERT_BLOCK)
+	{
+		__m128i v[4];
+
+		for(int j = 0; j < 4; j++)
+		{
+			__m128 f = _mm_loadu_ps(s + i + j * 4);
+			__m128i u = _mm_cvttps_epi32(_mm_mul_ps(f, scale));
+			u = select_sse2(_mm_cmple_ps(f, min), _mm_set1_epi32(S16_MIN), u);
+			v[j] = select_sse2(_mm_cmpge_ps(f, max), _mm_set1_epi32(S16_MAX), u);
+		}
+
+		_mm_storeu_si128((__m128i*)(t + i), _mm_packs_epi32(v[0], v[1]));
+		_mm_storeu_si128((__m128i*)(t + i + 8), _mm_packs_epi32(v[2], v[3]));
+	}
+}
+
+/// Converts four floats to FORMAT_S32, the truncation saturates to S32_MIN below -1.
+AUD_TARGET_SSE2 static inline __m128i float_s32_sse2(__m128 f)
+{
+	__m128i u = _mm_cvttps_epi32(_mm_mul_ps(f, _mm_set1_ps(S32_MAX)));
+	return select_sse2(_mm_cmpge_ps(f, _mm_set1_ps(FLT_MAX)), _mm_set1_epi32(S32_MAX), u);
+}
+
+AUD_TARGET_SSE2 static void convert_float_s32_sse2(data_t* target, data_t* source, int length)
+{
+	int32_t* t = (int32_t*) target;
+	float* s = (float*) source;
+
+	for(int i = 0; i < length; i += 4)
+		_mm_storeu_si128((__m128i*)(t + i), float_s32_sse2(_mm_loadu_ps(s + i)));
+}
+
+AUD_TARGET_AVX2 static void convert_u8_float_avx2(data_t* target, data_t* source, int length)
+{
+	const __m256i offset = _mm256_set1_epi32(U8_0);
+	const __m256 scale = _mm256_set1_ps(1.0f / U8_0);
+	float* t = (float*) target;
+
+	for(int i = length - CONVERT_BLOCK; i >= 0; i -= CONVERT_BLOCK)
+	{
+		__m128i s = _mm_loadu_si128((__m128i*)(source + i));
+		__m256i a = _mm256_cvtepu8_epi32(s);
+		__m256i b = _mm256_cvtepu8_epi32(_mm_srli_si128(s, 8));
+
+		_mm256_storeu_ps(t + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(a, offset)), scale));
+		_mm256_storeu_ps(t + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(b, offset)), scale));
+	}
+}
+
+AUD_TARGET_AVX2 static void convert_s16_float_avx2(data_t* target, data_t* source, int length)
+{
+	const __m256 scale = _mm256_set1_ps(S16_FLT);
+	int16_t* s = (int16_t*) source;
+	float* t = (float*) target;
+
+	for(int i = length - CONVERT_BLOCK; i >= 0; i -= CONVERT_BLOCK)
+	{
+		__m256i a = _mm256_cvtepi16_epi32(_mm_loadu_si128((__m128i*)(s + i)));
+		__m256i b = _mm256_cvtepi16_epi32(_mm_loadu_si128((__m128i*)(s + i + 8)));
+
+		_mm256_storeu_ps(t + i, _mm256_div_ps(_mm256_cvtepi32_ps(a), scale));
+		_mm256_storeu_ps(t + i + 8, _mm256_div_ps(_mm256_cvtepi32_ps(b), scale));
+	}
+}
+
+/// Converts 16 24 bit samples using a shuffle mask that moves three bytes to the top of each integer.
+AUD_TARGET_AVX2 static void convert_s24_float_avx2(data_t* target, data_t* source, int length, __m128i mask)
+{
+	const __m256 scale = _mm256_set1_ps(1.0f / S32_FLT);
+	float* t = (float*) target;
+
+	for(int i = length - CONVERT_BLOCK; i >= 0; i -= CONVERT_BLOCK)
+	{
+		data_t* s = source + i * 3;
+		__m128i a = _mm_loadu_si128((__m128i*)s);
+		__m128i b = _mm_loadu_si128((__m128i*)(s + 16));
+		__m128i c = _mm_loadu_si128((__m128i*)(s + 32));
+
+		// move the four groups of 12 bytes to the beginning of a register each
+		__m128i g0 = _mm_shuffle_epi8(a, mask);
+		__m128i g1 = _mm_shuffle_epi8(_mm_alignr_epi8(b, a, 12), mask);
+		__m128i g2 = _mm_shuffle_epi8(_mm_alignr_epi8(c, b, 8), mask);
+		__m128i g3 = _mm_shuffle_epi8(_mm_srli_si128(c, 4), mask);
+
+		_mm256_storeu_ps(t + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_set_m128i(g1, g0)), scale));
+		_mm256_storeu_ps(t + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_set_m128i(g3, g2)), scale));
+	}
+}
+
+AUD_TARGET_AVX2 static void convert_s24_float_be_avx2(data_t* target, data_t* source, int length)
+{
+	convert_s24_float_avx2(target, source, length, _mm_setr_epi8(-1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9));
+}
+
+AUD_TARGET_AVX2 static void convert_s24_float_le_avx2(data_t* target, data_t* source, int length)
+{
+	convert_s24_float_avx2(target, source, length, _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11));
+}
+
+AUD_TARGET_AVX2 static void convert_s32_float_avx2(data_t* target, data_t* source, int length)
+{
+	const __m256 scale = _mm256_set1_ps(1.0f / S32_FLT);
+	int32_t* s = (int32_t*) source;
+	float* t = (float*) target;
+
+	for(int i = 0; i < length; i += 8)
+		_mm256_storeu_ps(t + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_loadu_si256((__m256i*)(s + i))), scale));
+}
+
+AUD_TARGET_AVX2 static void convert_float_u8_avx2(data_t* target, data_t* source, int length)
+{
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(FLT_MAX);
+	const __m256 two = _mm256_set1_ps(2.0f);
+	const __m256 scale = _mm256_set1_ps(127);
+	float* s = (float*) source;
+
+	for(int i = 0; i < length; i += CONVERT_BLOCK)
+	{
+		__m256i v[2];
+
+		for(int j = 0; j < 2; j++)
+		{
+			__m256 t = _mm256_add_ps(_mm256_loadu_ps(s + i + j * 8), one);
+			__m256i u = _mm256_cvttps_epi32(_mm256_mul_ps(t, scale));
+			u = _mm256_blendv_epi8(u, _mm256_setzero_si256(), _mm256_castps_si256(_mm256_cmp_ps(t, zero, _CMP_LE_OQ)));
+			v[j] = _mm256_blendv_epi8(u, _mm256_set1_epi32(255), _mm256_castps_si256(_mm256_cmp_ps(t, two, _CMP_GE_OQ)));
+		}
+
+		// the packing works per 128 bit lane, so the 64 bit blocks have to be reordered
+		__m256i p = _mm256_permute4x64_epi64(_mm256_packs_epi32(v[0], v[1]), 0xD8);
+		_mm_storeu_si128((__m128i*)(target + i), _mm_packus_epi16(_mm256_castsi256_si128(p), _mm256_extracti128_si256(p, 1)));
+	}
+}
+
+AUD_TARGET_AVX2 static void convert_float_s16_avx2(data_t* target, data_t* source, int length)
+{
+	const __m256 min = _mm256_set1_ps(FLT_MIN);
+	const __m256 max = _mm256_set1_ps(FLT_MAX);
+	const __m256 scale = _mm256_set1_ps(S16_MAX);
+	int16_t* t = (int16_t*) target;
+	float* s = (float*) source;
+
+	for(int i = 0; i < length; i += CONVERT_BLOCK)
+	{
+		__m256i v[2];
+
+		for(int j = 0; j < 2; j++)
+		{
+			__m256 f = _mm256_loadu_ps(s + i + j * 8);
+			__m256i u = _mm256_cvttps_epi32(_mm256_mul_ps(f, scale));
+			u = _mm256_blendv_epi8(u, _mm256_set1_epi32(S16_MIN), _mm256_castps_si256(_mm256_cmp_ps(f, min, _CMP_LE_OQ)));
+			v[j] = _mm256_blendv_epi8(u, _mm256_set1_epi32(S16_MAX), _mm256_castps_si256(_mm256_cmp_ps(f, max, _CMP_GE_OQ)));
+		}
+
+		_mm256_storeu_si256((__m256i*)(t + i), _mm256_permute4x64_epi64(_mm256_packs_epi32(v[0], v[1]), 0xD8));
+	}
+}
+
+/// Converts eight floats to FORMAT_S32, the truncation saturates to S32_MIN below -1.
+AUD_TARGET_AVX2 static inline __m256i float_s32_avx2(__m256 f)
+{
+	__m256i u = _mm256_cvttps_epi32(_mm256_mul_ps(f, _mm256_set1_ps(S32_MAX)));
+	return _mm256_blendv_epi8(u, _mm256_set1_epi32(S32_MAX), _mm256_castps_si256(_mm256_cmp_ps(f, _mm256_set1_ps(FLT_MAX), _CMP_GE_OQ)));
+}
+
+/// Converts 16 floats to 24 bit samples using a shuffle mask that moves the top three bytes of each integer together.
+AUD_TARGET_AVX2 static void convert_float_s24_avx2(data_t* target, data_t* source, int length, __m128i mask)
+{
+	float* s = (float*) source;
+
+	for(int i = 0; i < length; i += CONVERT_BLOCK)
+	{
+		__m256i a = float_s32_avx2(_mm256_loadu_ps(s + i));
+		__m256i b = float_s32_avx2(_mm256_loadu_ps(s + i + 8));
+
+		__m128i g0 = _mm_shuffle_epi8(_mm256_castsi256_si128(a), mask);
+		__m128i g1 = _mm_shuffle_epi8(_mm256_extracti128_si256(a, 1), mask);
+		__m128i g2 = _mm_shuffle_epi8(_mm256_castsi256_si128(b), mask);
+		__m128i g3 = _mm_shuffle_epi8(_mm256_extracti128_si256(b, 1), mask);
+
+		// join the four groups of 12 bytes
+		data_t* t = target + i * 3;
+		_mm_storeu_si128((__m128i*)t, _mm_or_si128(g0, _mm_slli_si128(g1, 12)));
+		_mm_storeu_si128((__m128i*)(t + 16), _mm_or_si128(_mm_srli_si128(g1, 4), _mm_slli_si128(g2, 8)));
+		_mm_storeu_si128((__m128i*)(t + 32), _mm_or_si128(_mm_srli_si128(g2, 8), _mm_slli_si128(g3, 4)));
+	}
+}
+
+AUD_TARGET_AVX2 static void convert_float_s24_be_avx2(data_t* target, data_t* source, int length)
+{
+	convert_float_s24_avx2(target, source, length, _mm_setr_epi8(3, 2, 1, 7, 6, 5, 11, 10, 9, 15, 14, 13, -1, -1, -1, -1));
+}
+
+AUD_TARGET_AVX2 static void convert_float_s24_le_avx2(data_t* target, data_t* source, int length)
+{
+	convert_float_s24_avx2(target, source, length, _mm_setr_epi8(1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, -1, -1, -1, -1));
+}
+
+AUD_TARGET_AVX2 static void convert_float_s32_avx2(data_t* target, data_t* source, int length)
+{
+	int32_t* t = (int32_t*) target;
+	float* s = (float*) source;
+
+	for(int i = 0; i < length; i += 8)
+		_mm256_storeu_si256((__m256i*)(t + i), float_s32_avx2(_mm256_loadu_ps(s + i)));
+}
+
+#elif defined(AUD_SIMD_NEON)
+
+static void convert_u8_float_neon(data_t* target, data_t* source, int length)
+{
+	const int32x4_t offset = vdupq_n_s32(U8_0);
+	const float32x4_t scale = vdupq_n_f32(1.0f / U8_0);
+	float* t = (float*) target;
+
+	for(int i = length - CONVERT_BLOCK; i >= 0; i -= CONVERT_BLOCK)
+	{
+		uint8x16_t s = vld1q_u8(source + i);
+		uint16x8_t lo = vmovl_u8(vget_low_u8(s));
+		uint16x8_t hi = vmovl_u8(vget_high_u8(s));
+
+		uint32x4_t v[4] = {vmovl_u16(vget_low_u16(lo)), vmovl_u16(vget_high_u16(lo)), vmovl_u16(vget_low_u16(hi)), vmovl_u16(vget_high_u16(hi))};
+
+		for(int j = 0; j < 4; j++)
+			vst1q_f32(t + i + j * 4, vmulq_f32(vcvtq_f32_s32(vsubq_s32(vreinterpretq_s32_u32(v[j]), offset)), scale));
+	}
+}
+
+static void convert_s16_float_neon(data_t* target, data_t* source, int length)
+{
+	const float32x4_t scale = vdupq_n_f32(S16_FLT);
+	int16_t* s = (int16_t*) source;
+	float* t = (float*) target;
+
+	for(int i = length - CONVERT_BLOCK; i >= 0; i -= CONVERT_BLOCK)
+	{
+		int16x8_t a = vld1q_s16(s + i);
+		int16x8_t b = vld1q_s16(s + i + 8);
+
+		int32x4_t v[4] = {vmovl_s16(vget_low_s16(a)), vmovl_s16(vget_high_s16(a)), vmovl_s16(vget_low_s16(b)), vmovl_s16(vget_high_s16(b))};
+
+		for(int j = 0; j < 4; j++)
+			vst1q_f32(t + i + j * 4, vdivq_f32(vcvtq_f32_s32(v[j]), scale));
+	}
+}
+
+/// Joins the bytes of 24 bit samples into the top three bytes of integers, from the most significant byte on.
+static inline void join_s24_neon(float* t, uint8x16_t high, uint8x16_t middle, uint8x16_t low)
+{
+	const float32x4_t scale = vdupq_n_f32(1.0f / S32_FLT);
+
+	uint8x16x2_t lm = vzipq_u8(vdupq_n_u8(0), low);
+	uint8x16x2_t mh = vzipq_u8(middle, high);
+
+	for(int j = 0; j < 2; j++)
+	{
+		uint16x8x2_t v = vzipq_u16(vreinterpretq_u16_u8(lm.val[j]), vreinterpretq_u16_u8(mh.val[j]));
+
+		for(int k = 0; k < 2; k++)
+			vst1q_f32(t + j * 8 + k * 4, vmulq_f32(vcvtq_f32_s32(vreinterpretq_s32_u16(v.val[k])), scale));
+	}
+}
+
+static void convert_s24_float_be_neon(data_t* target, data_t* source, int length)
+{
+	float* t = (float*) target;
+
+	for(int i = length - CONVERT_BLOCK; i >= 0; i -= CONVERT_BLOCK)
+	{
+		uint8x16x3_t s = vld3q_u8(source + i * 3);
+		join_s24_neon(t + i, s.val[0], s.val[1], s.val[2]);
+	}
+}
+
+static void convert_s24_float_le_neon(data_t* target, data_t* source, int length)
+{
+	float* t = (float*) target;
+
+	for(int i = length - CONVERT_BLOCK; i >= 0; i -= CONVERT_BLOCK)
+	{
+		uint8x16x3_t s = vld3q_u8(source + i * 3);
+		join_s24_neon(t + i, s.val[2], s.val[1], s.val[0]);
+	}
+}
+
+static void convert_s32_float_neon(data_t* target, data_t* source, int length)
+{
+	const float32x4_t scale = vdupq_n_f32(1.0f / S32_FLT);
+	int32_t* s = (int32_t*) source;
+	float* t = (float*) target;
+
+	for(int i = 0; i < length; i += 4)
+		vst1q_f32(t + i, vmulq_f32(vcvtq_f32_s32(vld1q_s32(s + i)), scale));
+}
+
+static void convert_float_u8_neon(data_t* target, data_t* source, int length)
+{
+	const float32x4_t zero = vdupq_n_f32(0.0f);
+	const float32x4_t one = vdupq_n_f32(FLT_MAX);
+	const float32x4_t two = vdupq_n_f32(2.0f);
+	const float32x4_t scale = vdupq_n_f32(127);
+	float* s = (float*) source;
+
+	for(int i = 0; i < length; i += CONVERT_BLOCK)
+	{
+		uint16x4_t v[4];
+
+		for(int j = 0; j < 4; j++)
+		{
+			float32x4_t t = vaddq_f32(vld1q_f32(s + i + j * 4), one);
+			int32x4_t u = vcvtq_s32_f32(vmulq_f32(t, scale));
+			u = vbslq_s32(vcleq_f32(t, zero), vdupq_n_s32(0), u);
+			u = vbslq_s32(vcgeq_f32(t, two), vdupq_n_s32(255), u);
+			v[j] = vqmovun_s32(u);
+		}
+
+		uint8x8_t lo = vqmovn_u16(vcombine_u16(v[0], v[1]));
+		uint8x8_t hi = vqmovn_u16(vcombine_u16(v[2], v[3]));
+		vst1q_u8(target + i, vcombine_u8(lo, hi));
+	}
+}
+
+static void convert_float_s16_neon(data_t* target, data_t* source, int length)
+{
+	const float32x4_t min = vdupq_n_f32(FLT_MIN);
+	const float32x4_t max = vdupq_n_f32(FLT_MAX);
+	const float32x4_t scale = vdupq_n_f32(S16_MAX);
+	int16_t* t = (int16_t*) target;
+	float* s = (float*) source;
+
+	for(int i = 0; i < length; i += CONVERT_BLOCK)
+	{
+		int16x4_t v[4];
+
+		for(int j = 0; j < 4; j++)
+		{
+			float32x4_t f = vld1q_f32(s + i + j * 4);
+			int32x4_t u = vcvtq_s32_f32(vmulq_f32(f, scale));
+			u = vbslq_s32(vcleq_f32(f, min), vdupq_n_s32(S16_MIN), u);
+			u = vbslq_s32(vcgeq_f32(f, max), vdupq_n_s32(S16_MAX), u);
+			v[j] = vqmovn_s32(u);
+		}
+
+		vst1q_s16(t + i, vcombine_s16(v[0], v[1]));
+		vst1q_s16(t + i + 8, vcombine_s16(v[2], v[3]));
+	}
+}
+
+/// Converts four floats to FORMAT_S32, the conversion saturates to S32_MIN below -1.
+static inline int32x4_t float_s32_neon(float32x4_t f)
+{
+	int32x4_t u = vcvtq_s32_f32(vmulq_f32(f, vdupq_n_f32(S32_MAX)));
+	return vbslq_s32(vcgeq_f32(f, vdupq_n_f32(FLT_MAX)), vdupq_n_s32(S32_MAX), u);
+}
+
+/// Splits 16 floats into the high, middle and low bytes of 24 bit samples.
+static inline void split_s24_neon(float* s, uint8x16_t& high, uint8x16_t& middle, uint8x16_t& low)
+{
+	uint8x16_t v[4];
+
+	for(int j = 0; j < 4; j++)
+		v[j] = vreinterpretq_u8_s32(float_s32_neon(vld1q_f32(s + j * 4)));
+
+	// the bytes of each integer are little endian, the lowest byte is dropped
+	uint8x16x2_t a = vuzpq_u8(v[0], v[1]);
+	uint8x16x2_t b = vuzpq_u8(v[2], v[3]);
+	uint8x16x2_t even = vuzpq_u8(a.val[0], b.val[0]);
+	uint8x16x2_t odd = vuzpq_u8(a.val[1], b.val[1]);
+
+	low = odd.val[0];
+	middle = even.val[1];
+	high = odd.val[1];
+}
+
+static void convert_float_s24_be_neon(data_t* target, data_t* source, int length)
+{
+	float* s = (float*) source;
+
+	for(int i = 0; i < length; i += CONVERT_BLOCK)
+	{
+		uint8x16x3_t t;
+		split_s24_neon(s + i, t.val[0], t.val[1], t.val[2]);
+		vst3q_u8(target + i * 3, t);
+	}
+}
+
+static void convert_float_s24_le_neon(data_t* target, data_t* source, int length)
+{
+	float* s = (float*) source;
+
+	for(int i = 0; i < length; i += CONVERT_BLOCK)
+	{
+		uint8x16x3_t t;
+		split_s24_neon(s + i, t.val[2], t.val[1], t.val[0]);
+		vst3q_u8(target + i * 3, t);
+	}
+}
+
+static void convert_float_s32_neon(data_t* target, data_t* source, int length)
+{
+	int32_t* t = (int32_t*) target;
+	float* s = (float*) source;
+
+	for(int i = 0; i < length; i += 4)
+		vst1q_s32(t + i, float_s32_neon(vld1q_f32(s + i)));
+}
+
+#endif
+
+static const ConvertKernels* getKernels()
+{
+#if defined(AUD_SIMD_X86)
+	// there are no 24 bit kernels for SSE2 as they need byte shuffles
+	static const ConvertKernels sse2 = {
+		convert_u8_float_sse2, convert_s16_float_sse2, nullptr, nullptr, convert_s32_float_sse2,
+		convert_float_u8_sse2, convert_float_s16_sse2, nullptr, nullptr, convert_float_s32_sse2
+	};
+	static const ConvertKernels avx2 = {
+		convert_u8_float_avx2, convert_s16_float_avx2, convert_s24_float_be_avx2, convert_s24_float_le_avx2, convert_s32_float_avx2,
+		convert_float_u8_avx2, convert_float_s16_avx2, convert_float_s24_be_avx2, convert_float_s24_le_avx2, convert_float_s32_avx2
+	};
+#elif defined(AUD_SIMD_NEON)
+	static const ConvertKernels neon = {
+		convert_u8_float_neon, convert_s16_float_neon, convert_s24_float_be_neon, convert_s24_float_le_neon, convert_s32_float_neon,
+		convert_float_u8_neon, convert_float_s16_neon, convert_float_s24_be_neon, convert_float_s24_le_neon, convert_float_s32_neon
+	};
+#endif
+
+	switch(SIMD::getLevel())
+	{
+#if defined(AUD_SIMD_X86)
+	case SIMD_AVX2:
+		return &avx2;
+	case SIMD_SSE2:
+		return &sse2;
+#elif defined(AUD_SIMD_NEON)
+	case SIMD_NEON:
+		return &neon;
+#endif
+	default:
+		return nullptr;
+	}
+}
+
+/// Returns the number of samples the vector kernel converts and the kernel.
+static int getKernel(convert_f ConvertKernels::* member, int length, convert_f& kernel)
+{
+	const ConvertKernels* kernels = getKernels();
+
+	kernel = kernels ? kernels->*member : nullptr;
+
+	if(!kernel)
+		return 0;
+
+	return length - length % CONVERT_BLOCK;
+}
+
 void convert_u8_s16(data_t* target, data_t* source, int length)
 {
 	int16_t* t = (int16_t*) target;
@@ -66,9 +650,13 @@ void convert_u8_s32(data_t* target, data_t* source, int length)
 
 void convert_u8_float(data_t* target, data_t* source, int length)
 {
+	convert_f kernel;
+	int vector = getKernel(&ConvertKernels::u8_float, length, kernel);
 	float* t = (float*) target;
-	for(int i = length - 1; i >= 0; i--)
+	for(int i = length - 1; i >= vector; i--)
 		t[i] = (((int32_t)source[i]) - U8_0) / ((float)U8_0);
+	if(vector)
+		kernel(target, source, vector);
 }
 
 void convert_u8_double(data_t* target, data_t* source, int length)
@@ -121,10 +709,14 @@ void convert_s16_s32(data_t* target, data_t* source, int length)
 
 void convert_s16_float(data_t* target, data_t* source, int length)
 {
+	convert_f kernel;
+	int vector = getKernel(&ConvertKernels::s16_float, length, kernel);
 	int16_t* s = (int16_t*) source;
 	float* t = (float*) target;
-	for(int i = length - 1; i >= 0; i--)
+	for(int i = length - 1; i >= vector; i--)
 		t[i] = s[i] / S16_FLT;
+	if(vector)
+		kernel(target, source, vector);
 }
 
 void convert_s16_double(data_t* target, data_t* source, int length)
@@ -182,24 +774,32 @@ void convert_s24_s32_le(data_t* target, data_t* source, int length)
 
 void convert_s24_float_be(data_t* target, data_t* source, int length)
 {
+	convert_f kernel;
+	int vector = getKernel(&ConvertKernels::s24_float_be, length, kernel);
 	float* t = (float*) target;
 	int32_t s;
-	for(int i = length - 1; i >= 0; i--)
+	for(int i = length - 1; i >= vector; i--)
 	{
 		s = source[i*3] << 24 | source[i*3+1] << 16 | source[i*3+2] << 8;
 		t[i] = s / S32_FLT;
 	}
+	if(vector)
+		kernel(target, source, vector);
 }
 
 void convert_s24_float_le(data_t* target, data_t* source, int length)
 {
+	convert_f kernel;
+	int vector = getKernel(&ConvertKernels::s24_float_le, length, kernel);
 	float* t = (float*) target;
 	int32_t s;
-	for(int i = length - 1; i >= 0; i--)
+	for(int i = length - 1; i >= vector; i--)
 	{
 		s = source[i*3+2] << 24 | source[i*3+1] << 16 | source[i*3] << 8;
 		t[i] = s / S32_FLT;
 	}
+	if(vector)
+		kernel(target, source, vector);
 }
 
 void convert_s24_double_be(data_t* target, data_t* source, int length)
@@ -267,9 +867,13 @@ void convert_s32_s24_le(data_t* target, data_t* source, int length)
 
 void convert_s32_float(data_t* target, data_t* source, int length)
 {
+	convert_f kernel;
+	int vector = getKernel(&ConvertKernels::s32_float, length, kernel);
+	if(vector)
+		kernel(target, source, vector);
 	int32_t* s = (int32_t*) source;
 	float* t = (float*) target;
-	for(int i = 0; i < length; i++)
+	for(int i = vector; i < length; i++)
 		t[i] = s[i] / S32_FLT;
 }
 
@@ -283,9 +887,13 @@ void convert_s32_double(data_t* target, data_t* source, int length)
 
 void convert_float_u8(data_t* target, data_t* source, int length)
 {
+	convert_f kernel;
+	int vector = getKernel(&ConvertKernels::float_u8, length, kernel);
+	if(vector)
+		kernel(target, source, vector);
 	float* s = (float*) source;
 	float t;
-	for(int i = 0; i < length; i++)
+	for(int i = vector; i < length; i++)
 	{
 		t = s[i] + FLT_MAX;
 		if(t <= 0.0f)
@@ -299,9 +907,13 @@ void convert_float_u8(data_t* target, data_t* source, int length)
 
 void convert_float_s16(data_t* target, data_t* source, int length)
 {
+	convert_f kernel;
+	int vector = getKernel(&ConvertKernels::float_s16, length, kernel);
+	if(vector)
+		kernel(target, source, vector);
 	int16_t* t = (int16_t*) target;
 	float* s = (float*) source;
-	for(int i = 0; i < length; i++)
+	for(int i = vector; i < length; i++)
 	{
 		if(s[i] <= FLT_MIN)
 			t[i] = S16_MIN;
@@ -314,9 +926,13 @@ void convert_float_s16(data_t* target, data_t* source, int length)
 
 void convert_float_s24_be(data_t* target, data_t* source, int length)
 {
+	convert_f kernel;
+	int vector = getKernel(&ConvertKernels::float_s24_be, length, kernel);
+	if(vector)
+		kernel(target, source, vector);
 	int32_t t;
 	float* s = (float*) source;
-	for(int i = 0; i < length; i++)
+	for(int i = vector; i < length; i++)
 	{
 		if(s[i] <= FLT_MIN)
 			t = S32_MIN;
@@ -332,9 +948,13 @@ void convert_float_s24_be(data_t* target, data_t* source, int length)
 
 void convert_float_s24_le(data_t* target, data_t* source, int length)
 {
+	convert_f kernel;
+	int vector = getKernel(&ConvertKernels::float_s24_le, length, kernel);
+	if(vector)
+		kernel(target, source, vector);
 	int32_t t;
 	float* s = (float*) source;
-	for(int i = 0; i < length; i++)
+	for(int i = vector; i < length; i++)
 	{
 		if(s[i] <= FLT_MIN)
 			t = S32_MIN;
@@ -350,9 +970,13 @@ void convert_float_s24_le(data_t* target, data_t* source, int length)
 
 void convert_float_s32(data_t* target, data_t* source, int length)
 {
+	convert_f kernel;
+	int vector = getKernel(&ConvertKernels::float_s32, length, kernel);
+	if(vector)
+		kernel(target, source, vector);
 	int32_t* t = (int32_t*) target;
 	float* s = (float*) source;
-	for(int i = 0; i < length; i++)
+	for(int i = vector; i < length; i++)
 	{
 		if(s[i] <= FLT_MIN)
 			t[i] = S32_MIN;
@@ -461,4 +1085,60 @@ void convert_double_float(data_t* target, data_t* source, int length)
 		t[i] = s[i];
 }
 
+/*
+ * The planar conversions read each channel sequentially and write it with the
+ * channel count as stride, so the deinterleaving and the conversion happen in
+ * the same pass over the data.
+ */
+
+template <class T, class F>
+static inline void convert_planar(data_t* target, data_t** source, int offset, int length, int channels, F convert)
+{
+	float* t = (float*) target;
+
+	if(channels == 2)
+	{
+		T* left = ((T*) source[0]) + offset;
+		T* right = ((T*) source[1]) + offset;
+		for(int i = 0; i < length; i++)
+		{
+			t[i*2] = convert(left[i]);
+			t[i*2+1] = convert(right[i]);
+		}
+		return;
+	}
+
+	for(int channel = 0; channel < channels; channel++)
+	{
+		T* s = ((T*) source[channel]) + offset;
+		for(int i = 0; i < length; i++)
+			t[i*channels+channel] = convert(s[i]);
+	}
+}
+
+void convert_planar_u8_float(data_t* target, data_t** source, int offset, int length, int channels)
+{
+	convert_planar<uint8_t>(target, source, offset, length, channels, [](uint8_t s) { return (((int32_t)s) - U8_0) / ((float)U8_0); });
+}
+
+void convert_planar_s16_float(data_t* target, data_t** source, int offset, int length, int channels)
+{
+	convert_planar<int16_t>(target, source, offset, length, channels, [](int16_t s) { return s / S16_FLT; });
+}
+
+void convert_planar_s32_float(data_t* target, data_t** source, int offset, int length, int channels)
+{
+	convert_planar<int32_t>(target, source, offset, length, channels, [](int32_t s) { return s / S32_FLT; });
+}
+
+void convert_planar_float_float(data_t* target, data_t** source, int offset, int length, int channels)
+{
+	convert_planar<float>(target, source, offset, length, channels, [](float s) { return s; });
+}
+
+void convert_planar_double_float(data_t* target, data_t** source, int offset, int length, int channels)
+{
+	convert_planar<double>(target, source, offset, length, channels, [](double s) { return float(s); });
+}
+
 AUD_NAMESPACE_END
@@ -15,11 +15,16 @@
  ******************************************************************************/
 
 #include "respec/JOSResampleReader.h"
+#include "util/SIMD.h"
 
 #include <algorithm>
 #include <cmath>
 #include <cstring>
 
+#if defined(AUD_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
 #if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
 #include <immintrin.h>
 static inline int lrint_impl(double x)
@@ -45,12 +50,209 @@ static inline int lrint_impl(double x)
 
 AUD_NAMESPACE_BEGIN
 
+/*
+ * The vector path of the resampler first interpolates the filter taps of an
+ * output sample for all input samples it depends on, the left wing in
+ * ascending order followed by the right wing in ascending order. The
+ * accumulation kernels then multiply these taps with the interleaved input
+ * samples, summing in float instead of double.
+ *
+ * The fixed point filter position of the taps of a wing changes by a
+ * constant increment, so one interpolation kernel serves both wings for
+ * upsampling and downsampling.
+ */
+
+static void interpolate_scalar(const float* coeff, unsigned int P, int P_increment, int count, float* taps)
+{
+	for(int i = 0; i < count; i++)
+	{
+		unsigned int l = fp_to_int(P);
+		double eta = fp_rest_to_double(P);
+		taps[i] = coeff[l] + eta * (coeff[l+1] - coeff[l]);
+		P += P_increment;
+	}
+}
+
+static void accumulate_scalar(const float* taps, const sample_t* data, int frames, int channels, float* sums)
+{
+	std::memset(sums, 0, channels * sizeof(float));
+
+	for(int i = 0; i < frames; i++)
+	{
+		for(int channel = 0; channel < channels; channel++)
+			sums[channel] += taps[i] * data[i * channels + channel];
+	}
+}
+
+#if defined(AUD_SIMD_X86)
+
+AUD_TARGET_AVX2 static void interpolate_avx2(const float* coeff, unsigned int P, int P_increment, int count, float* taps)
+{
+	const __m256i mask = _mm256_set1_epi32((1 << SHIFT_BITS) - 1);
+	const __m256 scale = _mm256_set1_ps(1.0f / (1 << SHIFT_BITS));
+	const __m256i increment = _mm256_set1_epi32(P_increment * 8);
+	__m256i position = _mm256_add_epi32(_mm256_set1_epi32(P), _mm256_mullo_epi32(_mm256_set1_epi32(P_increment), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+	int i = 0;
+
+	for(; i + 8 <= count; i += 8)
+	{
+		__m256i l = _mm256_srli_epi32(position, SHIFT_BITS);
+		__m256 eta = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(position, mask)), scale);
+		__m256 a = _mm256_i32gather_ps(coeff, l, 4);
+		__m256 b = _mm256_i32gather_ps(coeff + 1, l, 4);
+		_mm256_storeu_ps(taps + i, _mm256_fmadd_ps(eta, _mm256_sub_ps(b, a), a));
+		position = _mm256_add_epi32(position, increment);
+	}
+
+	interpolate_scalar(coeff, P + unsigned(P_increment) * i, P_increment, count - i, taps + i);
+}
+
+AUD_TARGET_AVX2 static void accumulate_mono_avx2(const float* taps, const sample_t* data, int frames, int, float* sums)
+{
+	__m256 a = _mm256_setzero_ps();
+	__m256 b = _mm256_setzero_ps();
+	int i = 0;
+
+	for(; i + 16 <= frames; i += 16)
+	{
+		a = _mm256_fmadd_ps(_mm256_loadu_ps(taps + i), _mm256_loadu_ps(data + i), a);
+		b = _mm256_fmadd_ps(_mm256_loadu_ps(taps + i + 8), _mm256_loadu_ps(data + i + 8), b);
+	}
+
+	if(i + 8 <= frames)
+	{
+		a = _mm256_fmadd_ps(_mm256_loadu_ps(taps + i), _mm256_loadu_ps(data + i), a);
+		i += 8;
+	}
+
+	a = _mm256_add_ps(a, b);
+
+	__m128 c = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+	c = _mm_add_ps(c, _mm_movehl_ps(c, c));
+	c = _mm_add_ss(c, _mm_shuffle_ps(c, c, 1));
+
+	float sum = _mm_cvtss_f32(c);
+
+	for(; i < frames; i++)
+		sum += taps[i] * data[i];
+
+	sums[0] = sum;
+}
+
+AUD_TARGET_AVX2 static void accumulate_stereo_avx2(const float* taps, const sample_t* data, int frames, int, float* sums)
+{
+	__m256 a = _mm256_setzero_ps();
+	__m256 b = _mm256_setzero_ps();
+	int i = 0;
+
+	for(; i + 8 <= frames; i += 8)
+	{
+		__m128 t = _mm_loadu_ps(taps + i);
+		__m128 u = _mm_loadu_ps(taps + i + 4);
+		a = _mm256_fmadd_ps(_mm256_set_m128(_mm_unpackhi_ps(t, t), _mm_unpacklo_ps(t, t)), _mm256_loadu_ps(data + i * 2), a);
+		b = _mm256_fmadd_ps(_mm256_set_m128(_mm_unpackhi_ps(u, u), _mm_unpacklo_ps(u, u)), _mm256_loadu_ps(data + i * 2 + 8), b);
+	}
+
+	a = _mm256_add_ps(a, b);
+
+	__m128 c = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+	c = _mm_add_ps(c, _mm_movehl_ps(c, c));
+
+	float left = _mm_cvtss_f32(c);
+	float right = _mm_cvtss_f32(_mm_shuffle_ps(c, c, 1));
+
+	for(; i < frames; i++)
+	{
+		left += taps[i] * data[i * 2];
+		right += taps[i] * data[i * 2 + 1];
+	}
+
+	sums[0] = left;
+	sums[1] = right;
+}
+
+AUD_TARGET_AVX2 static void accumulate_channels_avx2(const float* taps, const sample_t* data, int frames, int channels, float* sums)
+{
+	// up to eight channels fit in a vector
+	__m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(channels), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+	__m256 a = _mm256_setzero_ps();
+	__m256 b = _mm256_setzero_ps();
+	int i = 0;
+
+	for(; i + 2 <= frames; i += 2)
+	{
+		a = _mm256_fmadd_ps(_mm256_broadcast_ss(taps + i), _mm256_maskload_ps(data + i * channels, mask), a);
+		b = _mm256_fmadd_ps(_mm256_broadcast_ss(taps + i + 1), _mm256_maskload_ps(data + (i + 1) * channels, mask), b);
+	}
+
+	if(i < frames)
+		a = _mm256_fmadd_ps(_mm256_broadcast_ss(taps + i), _mm256_maskload_ps(data + i * channels, mask), a);
+
+	_mm256_maskstore_ps(sums, mask, _mm256_add_ps(a, b));
+}
+
+#elif defined(AUD_SIMD_NEON)
+
+static void accumulate_mono_neon(const float* taps, const sample_t* data, int frames, int, float* sums)
+{
+	float32x4_t a = vdupq_n_f32(0.0f);
+	float32x4_t b = vdupq_n_f32(0.0f);
+	int i = 0;
+
+	for(; i + 8 <= frames; i += 8)
+	{
+		a = vfmaq_f32(a, vld1q_f32(taps + i), vld1q_f32(data + i));
+		b = vfmaq_f32(b, vld1q_f32(taps + i + 4), vld1q_f32(data + i + 4));
+	}
+
+	float sum = vaddvq_f32(vaddq_f32(a, b));
+
+	for(; i < frames; i++)
+		sum += taps[i] * data[i];
+
+	sums[0] = sum;
+}
+
+static void accumulate_stereo_neon(const float* taps, const sample_t* data, int frames, int, float* sums)
+{
+	float32x4_t a = vdupq_n_f32(0.0f);
+	float32x4_t b = vdupq_n_f32(0.0f);
+	int i = 0;
+
+	for(; i + 4 <= frames; i += 4)
+	{
+		float32x4_t t = vld1q_f32(taps + i);
+		float32x4x2_t w = vzipq_f32(t, t);
+		a = vfmaq_f32(a, w.val[0], vld1q_f32(data + i * 2));
+		b = vfmaq_f32(b, w.val[1], vld1q_f32(data + i * 2 + 4));
+	}
+
+	a = vaddq_f32(a, b);
+	float32x2_t c = vadd_f32(vget_low_f32(a), vget_high_f32(a));
+
+	float left = vget_lane_f32(c, 0);
+	float right = vget_lane_f32(c, 1);
+
+	for(; i < frames; i++)
+	{
+		left += taps[i] * data[i * 2];
+		right += taps[i] * data[i * 2 + 1];
+	}
+
+	sums[0] = left;
+	sums[1] = right;
+}
+
+#endif
+
 JOSResampleReader::JOSResampleReader(std::shared_ptr<IReader> reader, SampleRate rate, ResampleQuality quality) :
 	ResampleReader(reader, rate),
 	m_channels(CHANNELS_INVALID),
 	m_n(0),
 	m_P(0),
 	m_cache_valid(0),
+	m_interpolate(nullptr),
+	m_accumulate(nullptr),
 	m_last_factor(0)
 {
 	switch(quality)
@@ -127,9 +329,20 @@ void JOSResampleReader::resample(double target_factor, int length, sample_t* buf
 
 	unsigned int P_increment;
 
+	// the factor ramp does nothing for a constant ratio
+	bool constant = m_last_factor == target_factor;
+	factor = target_factor;
+	double n_increment = std::floor(1.0 / factor);
+	double P_rest = std::fmod(1.0 / factor, 1.0);
+
 	for(unsigned int t = 0; t < length; t++)
 	{
-		factor = (m_last_factor * (length - t - 1) + target_factor * (t + 1)) / length;
+		if(!constant)
+		{
+			factor = (m_last_factor * (length - t - 1) + target_factor * (t + 1)) / length;
+			n_increment = std::floor(1.0 / factor);
+			P_rest = std::fmod(1.0 / factor, 1.0);
+		}
 
 		std::memset(sums, 0, sizeof(double) * m_channels);
 
@@ -226,8 +439,8 @@ void JOSResampleReader::resample(double target_factor, int length, sample_t* buf
 			}
 		}
 
-		m_P += std::fmod(1.0 / factor, 1.0);
-		m_n += std::floor(1.0 / factor);
+		m_P += P_rest;
+		m_n += n_increment;
 
 		while(m_P >= 1.0)
 		{
@@ -237,6 +450,105 @@ void JOSResampleReader::resample(double target_factor, int length, sample_t* buf
 	}
 }
 
+void JOSResampleReader::resample_taps(double target_factor, int length, sample_t* buffer)
+{
+	const sample_t* buf = m_buffer.getBuffer();
+
+	unsigned int P;
+	int left, right;
+	double f_increment, factor;
+
+	m_sums.assureSize(m_channels * sizeof(float));
+	float* sums = reinterpret_cast<float*>(m_sums.getBuffer());
+	const float* coeff = m_coeff;
+	float* taps;
+
+	unsigned int P_increment;
+
+	// the factor ramp does nothing for a constant ratio
+	bool constant = m_last_factor == target_factor;
+	factor = target_factor;
+	double n_increment = std::floor(1.0 / factor);
+	double P_rest = std::fmod(1.0 / factor, 1.0);
+
+	for(int t = 0; t < length; t++)
+	{
+		if(!constant)
+		{
+			factor = (m_last_factor * (length - t - 1) + target_factor * (t + 1)) / length;
+			n_increment = std::floor(1.0 / factor);
+			P_rest = std::fmod(1.0 / factor, 1.0);
+		}
+
+		if(factor >= 1)
+		{
+			P = double_to_fp(m_P * m_L);
+
+			left = std::floor(m_len / double(m_L) - m_P) - 1;
+			if(int(m_n) < left)
+				left = m_n;
+
+			right = std::floor((m_len - 1) / double(m_L) + m_P) - 1;
+			if(m_cache_valid - int(m_n) - 2 < right)
+				right = std::max(m_cache_valid - int(m_n) - 2, -1);
+
+			m_taps.assureSize((left + right + 2) * sizeof(float));
+			taps = reinterpret_cast<float*>(m_taps.getBuffer());
+
+			m_interpolate(coeff, P + int_to_fp(m_L) * left, -int_to_fp(m_L), left + 1, taps);
+			m_interpolate(coeff, int_to_fp(m_L) - P, int_to_fp(m_L), right + 1, taps + left + 1);
+		}
+		else
+		{
+			f_increment = factor * m_L;
+			P_increment = double_to_fp(f_increment);
+			P = double_to_fp(m_P * f_increment);
+
+			left = (int_to_fp(m_len) - P) / P_increment - 1;
+			if(int(m_n) < left)
+				left = m_n;
+
+			// the right wing starts where the left one would continue
+			unsigned int P_right = P_increment - P;
+
+			right = (int_to_fp(m_len) - P_right) / P_increment - 1;
+			if(m_cache_valid - int(m_n) - 2 < right)
+				right = std::max(m_cache_valid - int(m_n) - 2, -1);
+
+			m_taps.assureSize((left + right + 2) * sizeof(float));
+			taps = reinterpret_cast<float*>(m_taps.getBuffer());
+
+			m_interpolate(coeff, P + P_increment * left, -int(P_increment), left + 1, taps);
+			m_interpolate(coeff, P_right, P_increment, right + 1, taps + left + 1);
+		}
+
+		m_accumulate(taps, buf + (m_n - left) * m_channels, left + right + 2, m_channels, sums);
+
+		for(int channel = 0; channel < m_channels; channel++)
+		{
+			if(factor >= 1)
+				*buffer = sums[channel];
+			else
+				*buffer = factor * sums[channel];
+			buffer++;
+		}
+
+		m_P += P_rest;
+		m_n += n_increment;
+
+		while(m_P >= 1.0)
+		{
+			m_P -= 1.0;
+			m_n++;
+		}
+	}
+}
+
+void JOSResampleReader::resampleBlock(double target_factor, int length, sample_t* buffer)
+{
+	(this->*m_resample)(target_factor, length, buffer);
+}
+
 void JOSResampleReader::resample_generic(double target_factor, int length, sample_t* buffer)
 {
 	struct OpGeneric
@@ -356,6 +668,32 @@ void JOSResampleReader::read(int& length, bool& eos, sample_t* buffer)
 			m_resample = &JOSResampleReader::resample_generic;
 			break;
 		}
+
+		// the polyphase reader accumulates its precomputed taps at every level
+		m_accumulate = accumulate_scalar;
+
+		// the taps are only worth it if their interpolation or the accumulation is vectorized
+		switch(SIMD::getLevel())
+		{
+#if defined(AUD_SIMD_X86)
+		case SIMD_AVX2:
+			m_resample = &JOSResampleReader::resample_taps;
+			m_interpolate = interpolate_avx2;
+			m_accumulate = m_channels == CHANNELS_MONO ? accumulate_mono_avx2 : m_channels == CHANNELS_STEREO ? accumulate_stereo_avx2 : m_channels <= 8 ? accumulate_channels_avx2 : accumulate_scalar;
+			break;
+#elif defined(AUD_SIMD_NEON)
+		case SIMD_NEON:
+			if(m_channels == CHANNELS_MONO || m_channels == CHANNELS_STEREO)
+			{
+				m_resample = &JOSResampleReader::resample_taps;
+				m_interpolate = interpolate_scalar;
+				m_accumulate = m_channels == CHANNELS_MONO ? accumulate_mono_neon : accumulate_stereo_neon;
+			}
+			break;
+#endif
+		default:
+			break;
+		}
 	}
 
 	if(m_last_factor == 0)
@@ -431,7 +769,7 @@ void JOSResampleReader::read(int& length, bool& eos, sample_t* buffer)
 		}
 	}
 
-	(this->*m_resample)(target_factor, length, buffer);
+	resampleBlock(target_factor, length, buffer);
 
 	m_last_factor = target_factor;
 
@@ -15,28 +15,192 @@
  ******************************************************************************/
 
 #include "respec/LinearResampleReader.h"
+#include "util/SIMD.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 
+#if defined(AUD_SIMD_X86)
+#include <immintrin.h>
+#elif defined(AUD_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+#define FP_BITS 32
+#define FP_ONE (1ull << FP_BITS)
+#define fp_to_int(x) (int((x) >> FP_BITS))
+#define fp_to_fraction(x) (float(((x) >> 8) & 0xFFFFFF) * (1.0f / (1 << 24)))
+
 AUD_NAMESPACE_BEGIN
 
+/*
+ * The interpolation functions produce length frames, the first at the fixed
+ * point source position, which advances by step per frame. Every output
+ * frame reads the two frames around its position, even if it is an integer.
+ */
+
+template <int C>
+static void resample_frames(const sample_t* buf, unsigned long long position, unsigned long long step, int length, int channels, sample_t* buffer)
+{
+	if(C)
+		channels = C;
+
+	for(int i = 0; i < length; i++)
+	{
+		const sample_t* low = buf + fp_to_int(position) * channels;
+		const sample_t* high = low + channels;
+		float fraction = fp_to_fraction(position);
+
+		for(int channel = 0; channel < channels; channel++)
+			buffer[channel] = low[channel] + fraction * (high[channel] - low[channel]);
+
+		buffer += channels;
+		position += step;
+	}
+}
+
+#if defined(AUD_SIMD_X86)
+
+AUD_TARGET_SSE2 static void resample_stereo_sse2(const sample_t* buf, unsigned long long position, unsigned long long step, int length, int, sample_t* buffer)
+{
+	const __m128 zero = _mm_setzero_ps();
+	int i = 0;
+
+	for(; i + 2 <= length; i += 2)
+	{
+		const sample_t* a = buf + fp_to_int(position) * 2;
+		float fa = fp_to_fraction(position);
+		position += step;
+
+		const sample_t* b = buf + fp_to_int(position) * 2;
+		float fb = fp_to_fraction(position);
+		position += step;
+
+		__m128 low = _mm_loadh_pi(_mm_loadl_pi(zero, reinterpret_cast<const __m64*>(a)), reinterpret_cast<const __m64*>(b));
+		__m128 high = _mm_loadh_pi(_mm_loadl_pi(zero, reinterpret_cast<const __m64*>(a + 2)), reinterpret_cast<const __m64*>(b + 2));
+		__m128 fraction = _mm_setr_ps(fa, fa, fb, fb);
+
+		_mm_storeu_ps(buffer + i * 2, _mm_add_ps(low, _mm_mul_ps(fraction, _mm_sub_ps(high, low))));
+	}
+
+	resample_frames<2>(buf, position, step, length - i, 2, buffer + i * 2);
+}
+
+/**
+ * Computes the frame indices and fractions of four positions, which are
+ * kept as 64 bit lanes.
+ */
+AUD_TARGET_AVX2 static inline void positions_avx2(__m256i position, __m128i& index, __m128& fraction)
+{
+	const __m256i pack = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+	const __m256i mask = _mm256_set1_epi64x(0xFFFFFF);
+
+	index = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(_mm256_srli_epi64(position, FP_BITS), pack));
+	__m128i bits = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(_mm256_and_si256(_mm256_srli_epi64(position, 8), mask), pack));
+	fraction = _mm_mul_ps(_mm_cvtepi32_ps(bits), _mm_set1_ps(1.0f / (1 << 24)));
+}
+
+AUD_TARGET_AVX2 static void resample_mono_avx2(const sample_t* buf, unsigned long long position, unsigned long long step, int length, int, sample_t* buffer)
+{
+	__m256i positions = _mm256_setr_epi64x(position, position + step, position + 2 * step, position + 3 * step);
+	const __m256i increment = _mm256_set1_epi64x(4 * step);
+	int i = 0;
+
+	for(; i + 4 <= length; i += 4)
+	{
+		__m128i index;
+		__m128 fraction;
+		positions_avx2(positions, index, fraction);
+
+		__m128 low = _mm_i32gather_ps(buf, index, 4);
+		__m128 high = _mm_i32gather_ps(buf + 1, index, 4);
+
+		_mm_storeu_ps(buffer + i, _mm_add_ps(low, _mm_mul_ps(fraction, _mm_sub_ps(high, low))));
+
+		positions = _mm256_add_epi64(positions, increment);
+	}
+
+	resample_frames<1>(buf, position + i * step, step, length - i, 1, buffer + i);
+}
+
+AUD_TARGET_AVX2 static void resample_stereo_avx2(const sample_t* buf, unsigned long long position, unsigned long long step, int length, int, sample_t* buffer)
+{
+	__m256i positions = _mm256_setr_epi64x(position, position + step, position + 2 * step, position + 3 * step);
+	const __m256i increment = _mm256_set1_epi64x(4 * step);
+	const __m256i duplicate = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+	const __m256d mask = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+
+	// a stereo frame is gathered as one double
+	const double* frames = reinterpret_cast<const double*>(buf);
+	int i = 0;
+
+	for(; i + 4 <= length; i += 4)
+	{
+		__m128i index;
+		__m128 fraction;
+		positions_avx2(positions, index, fraction);
+
+		__m256 low = _mm256_castpd_ps(_mm256_mask_i32gather_pd(_mm256_setzero_pd(), frames, index, mask, 8));
+		__m256 high = _mm256_castpd_ps(_mm256_mask_i32gather_pd(_mm256_setzero_pd(), frames + 1, index, mask, 8));
+		__m256 fractions = _mm256_permutevar8x32_ps(_mm256_castps128_ps256(fraction), duplicate);
+
+		_mm256_storeu_ps(buffer + i * 2, _mm256_add_ps(low, _mm256_mul_ps(fractions, _mm256_sub_ps(high, low))));
+
+		positions = _mm256_add_epi64(positions, increment);
+	}
+
+	resample_frames<2>(buf, position + i * step, step, length - i, 2, buffer + i * 2);
+}
+
+#elif defined(AUD_SIMD_NEON)
+
+static void resample_stereo_neon(const sample_t* buf, unsigned long long position, unsigned long long step, int length, int, sample_t* buffer)
+{
+	int i = 0;
+
+	for(; i + 2 <= length; i += 2)
+	{
+		const sample_t* a = buf + fp_to_int(position) * 2;
+		float fa = fp_to_fraction(position);
+		position += step;
+
+		const sample_t* b = buf + fp_to_int(position) * 2;
+		float fb = fp_to_fraction(position);
+		position += step;
+
+		float32x4_t low = vcombine_f32(vld1_f32(a), vld1_f32(b));
+		float32x4_t high = vcombine_f32(vld1_f32(a + 2), vld1_f32(b + 2));
+		float32x4_t fraction = vcombine_f32(vdup_n_f32(fa), vdup_n_f32(fb));
+
+		vst1q_f32(buffer + i * 2, vaddq_f32(low, vmulq_f32(fraction, vsubq_f32(high, low))));
+	}
+
+	resample_frames<2>(buf, position, step, length - i, 2, buffer + i * 2);
+}
+
+#endif
+
 LinearResampleReader::LinearResampleReader(std::shared_ptr<IReader> reader, SampleRate rate) :
 	ResampleReader(reader, rate),
-	m_channels(reader->getSpecs().channels),
+	m_channels(CHANNELS_INVALID),
 	m_cache_pos(0),
-	m_cache_ok(false)
+	m_cache_ok(false),
+	m_resample(nullptr)
 {
-	Specs specs = { rate, m_channels };
-	m_cache.resize(2 * AUD_SAMPLE_SIZE(specs));
+}
+
+void LinearResampleReader::reset()
+{
+	m_cache_ok = false;
+	m_cache_pos = 0;
 }
 
 void LinearResampleReader::seek(int position)
 {
 	position = std::floor(position * double(m_reader->getSpecs().rate) / double(m_rate));
 	m_reader->seek(position);
-	m_cache_ok = false;
-	m_cache_pos = 0;
+	reset();
 }
 
 int LinearResampleReader::getLength() const
@@ -46,7 +210,7 @@ int LinearResampleReader::getLength() const
 
 int LinearResampleReader::getPosition() const
 {
-	return std::floor((m_reader->getPosition() + (m_cache_ok ? m_cache_pos - 1 : 0))
+	return std::floor((m_reader->getPosition() + (m_cache_ok ? double(m_cache_pos) / FP_ONE - 1 : 0))
 				 * m_rate / m_reader->getSpecs().rate);
 }
 
@@ -66,21 +230,60 @@ void LinearResampleReader::read(int& length, bool& eos, sample_t* buffer)
 
 	int samplesize = AUD_SAMPLE_SIZE(specs);
 	int size = length;
-	float factor = m_rate / m_reader->getSpecs().rate;
-	float spos = 0.0f;
-	sample_t low, high;
 	eos = false;
 
+	// the source frames per output frame
+	unsigned long long step = std::llround(double(specs.rate) / double(m_rate) * FP_ONE);
+
 	// check for channels changed
 
 	if(specs.channels != m_channels)
 	{
-		m_cache.resize(2 * samplesize);
+		m_cache.assureSize(2 * samplesize);
 		m_channels = specs.channels;
 		m_cache_ok = false;
+
+		switch(m_channels)
+		{
+		case CHANNELS_MONO:
+			m_resample = resample_frames<1>;
+			break;
+		case CHANNELS_STEREO:
+			m_resample = resample_frames<2>;
+			break;
+		case CHANNELS_SURROUND51:
+			m_resample = resample_frames<6>;
+			break;
+		default:
+			m_resample = resample_frames<0>;
+			break;
+		}
+
+		switch(SIMD::getLevel())
+		{
+#if defined(AUD_SIMD_X86)
+		case SIMD_AVX2:
+			if(m_channels == CHANNELS_MONO)
+				m_resample = resample_mono_avx2;
+			else if(m_channels == CHANNELS_STEREO)
+				m_resample = resample_stereo_avx2;
+			break;
+		case SIMD_SSE2:
+			if(m_channels == CHANNELS_STEREO)
+				m_resample = resample_stereo_sse2;
+			break;
+#elif defined(AUD_SIMD_NEON)
+		case SIMD_NEON:
+			if(m_channels == CHANNELS_STEREO)
+				m_resample = resample_stereo_neon;
+			break;
+#endif
+		default:
+			break;
+		}
 	}
 
-	if(factor == 1 && (!m_cache_ok || m_cache_pos == 1))
+	if(step == FP_ONE && (!m_cache_ok || m_cache_pos == FP_ONE))
 	{
 		// can read directly!
 		m_reader->read(length, eos, buffer);
@@ -88,85 +291,59 @@ void LinearResampleReader::read(int& length, bool& eos, sample_t* buffer)
 		if(length > 0)
 		{
 			std::memcpy(m_cache.getBuffer() + m_channels, buffer + m_channels * (length - 1), samplesize);
-			m_cache_pos = 1;
+			m_cache_pos = FP_ONE;
 			m_cache_ok = true;
 		}
 
 		return;
 	}
 
-	int len;
-	sample_t* buf;
-
-	if(m_cache_ok)
-	{
-		int need = std::ceil(length / factor + m_cache_pos) - 1;
+	// the cache holds two frames, at the start of the stream a silent one is prepended
+	int cached = m_cache_ok ? 2 : 1;
+	unsigned long long position = m_cache_ok ? m_cache_pos + step : FP_ONE;
 
-		len = need;
+	// all frames up to the high frame of the last output frame
+	int need = fp_to_int(position + (length - 1) * step + FP_ONE - 1) + 1 - cached;
+	int len = need;
 
-		m_buffer.assureSize((len + 2) * samplesize);
-		buf = m_buffer.getBuffer();
+	// one frame more to interpolate the last frame if its position is an integer
+	m_buffer.assureSize((cached + len + 1) * samplesize);
+	sample_t* buf = m_buffer.getBuffer();
 
+	if(m_cache_ok)
 		std::memcpy(buf, m_cache.getBuffer(), 2 * samplesize);
-		m_reader->read(len, eos, buf + 2 * m_channels);
-
-		if(len < need)
-			length = std::floor((len + 1 - m_cache_pos) * factor);
-	}
 	else
-	{
-		m_cache_pos = 1 - 1 / factor;
-
-		int need = std::ceil(length / factor + m_cache_pos);
-
-		len = need;
-
-		m_buffer.assureSize((len + 1) * samplesize);
-		buf = m_buffer.getBuffer();
-
 		std::memset(buf, 0, samplesize);
-		m_reader->read(len, eos, buf + m_channels);
 
-		if(len == 0)
-		{
-			length = 0;
-			return;
-		}
+	m_reader->read(len, eos, buf + cached * m_channels);
 
-		if(len < need)
-		{
-			length = std::floor((len - m_cache_pos) * factor);
-		}
+	if(!m_cache_ok && len == 0)
+	{
+		length = 0;
+		return;
+	}
 
-		m_cache_ok = true;
+	std::memset(buf + (cached + len) * m_channels, 0, samplesize);
+
+	if(len < need)
+	{
+		// only produce the frames that have both input frames
+		unsigned long long available = (unsigned long long)(cached + len - 1) << FP_BITS;
+		length = available < position ? 0 : int((available - position) / step) + 1;
 	}
 
 	if(length == 0)
 		return;
 
-	for(int channel = 0; channel < m_channels; channel++)
-	{
-		for(int i = 0; i < length; i++)
-		{
-			spos = (i + 1) / factor + m_cache_pos;
-
-			low = buf[(int)std::floor(spos) * m_channels + channel];
-			high = buf[(int)std::ceil(spos) * m_channels + channel];
+	m_resample(buf, position, step, length, m_channels, buffer);
 
-			buffer[i * m_channels + channel] = low + (spos - std::floor(spos)) * (high - low);
-		}
-	}
+	// keep the frames around the last position, which then lies in (0, 1]
+	unsigned long long last = position + (length - 1) * step;
+	int frame = fp_to_int(last - 1);
 
-	if(std::floor(spos) == spos)
-	{
-		std::memcpy(m_cache.getBuffer() + m_channels, buf + int(std::floor(spos)) * m_channels, samplesize);
-		m_cache_pos = 1;
-	}
-	else
-	{
-		std::memcpy(m_cache.getBuffer(), buf + int(std::floor(spos)) * m_channels, 2 * samplesize);
-		m_cache_pos = spos - std::floor(spos);
-	}
+	std::memcpy(m_cache.getBuffer(), buf + frame * m_channels, 2 * samplesize);
+	m_cache_pos = last - ((unsigned long long)frame << FP_BITS);
+	m_cache_ok = true;
 
 	eos &= length < size;
 }
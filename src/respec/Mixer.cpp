@@ -15,14 +15,231 @@
  ******************************************************************************/
 
 #include "respec/Mixer.h"
+#include "util/SIMD.h"
 
 #include <algorithm>
 #include <cstring>
 
+#if defined(AUD_SIMD_X86)
+#include <immintrin.h>
+#elif defined(AUD_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
 AUD_NAMESPACE_BEGIN
 
-Mixer::Mixer(DeviceSpecs specs)
+static void mix_scalar(sample_t* target, const sample_t* source, int length, float volume)
+{
+	for(int i = 0; i < length; i++)
+		target[i] += source[i] * volume;
+}
+
+static void mix_ramp_scalar(sample_t* target, const sample_t* source, int frames, int channels, float volume, float step)
+{
+	for(int i = 0; i < frames; i++)
+	{
+		float v = volume + i * step;
+
+		for(int c = 0; c < channels; c++)
+			target[i * channels + c] += source[i * channels + c] * v;
+	}
+}
+
+static void scale_scalar(sample_t* buffer, int length, float volume)
+{
+	for(int i = 0; i < length; i++)
+		buffer[i] *= volume;
+}
+
+/*
+ * The ramp kernels process blocks of as many frames as a vector has lanes.
+ * Such a block consists of channels vectors and the per lane volume offsets
+ * of each of these vectors are the same for all blocks, so they are
+ * calculated once upfront.
+ */
+
+#if defined(AUD_SIMD_X86)
+
+AUD_TARGET_SSE2 static void mix_sse2(sample_t* target, const sample_t* source, int length, float volume)
+{
+	__m128 v = _mm_set1_ps(volume);
+	int i = 0;
+
+	for(; i + 4 <= length; i += 4)
+		_mm_storeu_ps(target + i, _mm_add_ps(_mm_loadu_ps(target + i), _mm_mul_ps(_mm_loadu_ps(source + i), v)));
+
+	mix_scalar(target + i, source + i, length - i, volume);
+}
+
+AUD_TARGET_SSE2 static void mix_ramp_sse2(sample_t* target, const sample_t* source, int frames, int channels, float volume, float step)
+{
+	__m128 offsets[CHANNELS_SURROUND71];
+
+	for(int k = 0; k < channels; k++)
+		offsets[k] = _mm_set_ps(((k * 4 + 3) / channels) * step, ((k * 4 + 2) / channels) * step, ((k * 4 + 1) / channels) * step, ((k * 4) / channels) * step);
+
+	int i = 0;
+
+	for(; i + 4 <= frames; i += 4)
+	{
+		__m128 v = _mm_set1_ps(volume + i * step);
+
+		for(int k = 0; k < channels; k++)
+		{
+			int j = i * channels + k * 4;
+			_mm_storeu_ps(target + j, _mm_add_ps(_mm_loadu_ps(target + j), _mm_mul_ps(_mm_loadu_ps(source + j), _mm_add_ps(v, offsets[k]))));
+		}
+	}
+
+	mix_ramp_scalar(target + i * channels, source + i * channels, frames - i, channels, volume + i * step, step);
+}
+
+AUD_TARGET_SSE2 static void scale_sse2(sample_t* buffer, int length, float volume)
+{
+	__m128 v = _mm_set1_ps(volume);
+	int i = 0;
+
+	for(; i + 4 <= length; i += 4)
+		_mm_storeu_ps(buffer + i, _mm_mul_ps(_mm_loadu_ps(buffer + i), v));
+
+	scale_scalar(buffer + i, length - i, volume);
+}
+
+AUD_TARGET_AVX2 static void mix_avx2(sample_t* target, const sample_t* source, int length, float volume)
+{
+	__m256 v = _mm256_set1_ps(volume);
+	int i = 0;
+
+	for(; i + 8 <= length; i += 8)
+		_mm256_storeu_ps(target + i, _mm256_fmadd_ps(_mm256_loadu_ps(source + i), v, _mm256_loadu_ps(target + i)));
+
+	mix_scalar(target + i, source + i, length - i, volume);
+}
+
+AUD_TARGET_AVX2 static void mix_ramp_avx2(sample_t* target, const sample_t* source, int frames, int channels, float volume, float step)
 {
+	__m256 offsets[CHANNELS_SURROUND71];
+
+	for(int k = 0; k < channels; k++)
+	{
+		float lanes[8];
+
+		for(int l = 0; l < 8; l++)
+			lanes[l] = ((k * 8 + l) / channels) * step;
+
+		offsets[k] = _mm256_loadu_ps(lanes);
+	}
+
+	int i = 0;
+
+	for(; i + 8 <= frames; i += 8)
+	{
+		__m256 v = _mm256_set1_ps(volume + i * step);
+
+		for(int k = 0; k < channels; k++)
+		{
+			int j = i * channels + k * 8;
+			_mm256_storeu_ps(target + j, _mm256_fmadd_ps(_mm256_loadu_ps(source + j), _mm256_add_ps(v, offsets[k]), _mm256_loadu_ps(target + j)));
+		}
+	}
+
+	mix_ramp_scalar(target + i * channels, source + i * channels, frames - i, channels, volume + i * step, step);
+}
+
+AUD_TARGET_AVX2 static void scale_avx2(sample_t* buffer, int length, float volume)
+{
+	__m256 v = _mm256_set1_ps(volume);
+	int i = 0;
+
+	for(; i + 8 <= length; i += 8)
+		_mm256_storeu_ps(buffer + i, _mm256_mul_ps(_mm256_loadu_ps(buffer + i), v));
+
+	scale_scalar(buffer + i, length - i, volume);
+}
+
+#elif defined(AUD_SIMD_NEON)
+
+static void mix_neon(sample_t* target, const sample_t* source, int length, float volume)
+{
+	float32x4_t v = vdupq_n_f32(volume);
+	int i = 0;
+
+	for(; i + 4 <= length; i += 4)
+		vst1q_f32(target + i, vfmaq_f32(vld1q_f32(target + i), vld1q_f32(source + i), v));
+
+	mix_scalar(target + i, source + i, length - i, volume);
+}
+
+static void mix_ramp_neon(sample_t* target, const sample_t* source, int frames, int channels, float volume, float step)
+{
+	float32x4_t offsets[CHANNELS_SURROUND71];
+
+	for(int k = 0; k < channels; k++)
+	{
+		float lanes[4];
+
+		for(int l = 0; l < 4; l++)
+			lanes[l] = ((k * 4 + l) / channels) * step;
+
+		offsets[k] = vld1q_f32(lanes);
+	}
+
+	int i = 0;
+
+	for(; i + 4 <= frames; i += 4)
+	{
+		float32x4_t v = vdupq_n_f32(volume + i * step);
+
+		for(int k = 0; k < channels; k++)
+		{
+			int j = i * channels + k * 4;
+			vst1q_f32(target + j, vfmaq_f32(vld1q_f32(target + j), vld1q_f32(source + j), vaddq_f32(v, offsets[k])));
+		}
+	}
+
+	mix_ramp_scalar(target + i * channels, source + i * channels, frames - i, channels, volume + i * step, step);
+}
+
+static void scale_neon(sample_t* buffer, int length, float volume)
+{
+	float32x4_t v = vdupq_n_f32(volume);
+	int i = 0;
+
+	for(; i + 4 <= length; i += 4)
+		vst1q_f32(buffer + i, vmulq_f32(vld1q_f32(buffer + i), v));
+
+	scale_scalar(buffer + i, length - i, volume);
+}
+
+#endif
+
+Mixer::Mixer(DeviceSpecs specs) :
+	m_length(0), m_mix(mix_scalar), m_mix_ramp(mix_ramp_scalar), m_scale(scale_scalar)
+{
+	switch(SIMD::getLevel())
+	{
+#if defined(AUD_SIMD_X86)
+	case SIMD_AVX2:
+		m_mix = mix_avx2;
+		m_mix_ramp = mix_ramp_avx2;
+		m_scale = scale_avx2;
+		break;
+	case SIMD_SSE2:
+		m_mix = mix_sse2;
+		m_mix_ramp = mix_ramp_sse2;
+		m_scale = scale_sse2;
+		break;
+#elif defined(AUD_SIMD_NEON)
+	case SIMD_NEON:
+		m_mix = mix_neon;
+		m_mix_ramp = mix_ramp_neon;
+		m_scale = scale_neon;
+		break;
+#endif
+	default:
+		break;
+	}
+
 	setSpecs(specs);
 }
 
@@ -86,8 +303,7 @@ void Mixer::mix(sample_t* buffer, int start, int length, float volume)
 	length = (std::min(m_length, length + start) - start) * m_specs.channels;
 	start *= m_specs.channels;
 
-	for(int i = 0; i < length; i++)
-		out[i + start] += buffer[i] * volume;
+	m_mix(out + start, buffer, length, volume);
 }
 
 void Mixer::mix(sample_t* buffer, int start, int length, float volume_to, float volume_from)
@@ -96,21 +312,28 @@ void Mixer::mix(sample_t* buffer, int start, int length, float volume_to, float
 
 	length = (std::min(m_length, length + start) - start);
 
-	for(int i = 0; i < length; i++)
-	{
-		float volume = volume_from * (1.0f - i / float(length)) + volume_to * (i / float(length));
+	if(length <= 0)
+		return;
 
-		for(int c = 0; c < m_specs.channels; c++)
-			out[(i + start) * m_specs.channels + c] += buffer[i * m_specs.channels + c] * volume;
+	if(volume_to == volume_from)
+	{
+		m_mix(out + start * m_specs.channels, buffer, length * m_specs.channels, volume_to);
+		return;
 	}
+
+	// the kernels only support up to the maximum device channel count
+	if(m_specs.channels > CHANNELS_SURROUND71)
+		mix_ramp_scalar(out + start * m_specs.channels, buffer, length, m_specs.channels, volume_from, (volume_to - volume_from) / length);
+	else
+		m_mix_ramp(out + start * m_specs.channels, buffer, length, m_specs.channels, volume_from, (volume_to - volume_from) / length);
 }
 
 void Mixer::read(data_t* buffer, float volume)
 {
 	sample_t* out = m_buffer.getBuffer();
 
-	for(int i = 0; i < m_length * m_specs.channels; i++)
-		out[i] *= volume;
+	if(volume != 1.0f)
+		m_scale(out, m_length * m_specs.channels, volume);
 
 	m_convert(buffer, (data_t*) out, m_length * m_specs.channels);
 }
@@ -0,0 +1,233 @@
+/*******************************************************************************
+ * Copyright 2009-2016 Jörg Müller
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************/
+
+#include "respec/PolyphaseResampleReader.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+#define MAX_PHASES 1024
+#define MAX_TABLE_SIZE (4 << 20)
+#define TAP_ALIGNMENT 8
+
+AUD_NAMESPACE_BEGIN
+
+struct PolyphaseResampleReader::PhaseTable
+{
+	/// The number of phases.
+	int L;
+
+	/// The input frames per L output frames.
+	int M;
+
+	/// The number of taps up to and including the current input frame.
+	int left;
+
+	/// The number of taps per phase, a multiple of TAP_ALIGNMENT.
+	int taps;
+
+	/// The taps of all phases, the gain for downsampling included.
+	Buffer coefficients;
+};
+
+PolyphaseResampleReader::PolyphaseResampleReader(std::shared_ptr<IReader> reader, SampleRate rate, ResampleQuality quality) :
+	JOSResampleReader(reader, rate, quality),
+	m_source_rate(0)
+{
+}
+
+std::shared_ptr<const PolyphaseResampleReader::PhaseTable> PolyphaseResampleReader::getTable(int L, int M)
+{
+	typedef std::tuple<const float*, int, int> Key;
+
+	// the cutoff follows the lower of both rates
+	double scale = std::min(1.0, double(L) / double(M));
+	int wing = int(std::ceil(m_len / (m_L * scale))) + 1;
+	int taps = (2 * wing + TAP_ALIGNMENT - 1) / TAP_ALIGNMENT * TAP_ALIGNMENT;
+
+	if(double(L) * taps * sizeof(float) > MAX_TABLE_SIZE)
+		return nullptr;
+
+	static std::mutex mutex;
+	static std::map<Key, std::weak_ptr<const PhaseTable>> tables;
+
+	Key key(m_coeff, L, M);
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	std::shared_ptr<const PhaseTable> shared = tables[key].lock();
+
+	if(shared)
+		return shared;
+
+	// forget the tables that aren't used anymore
+	for(auto it = tables.begin(); it != tables.end();)
+	{
+		if(it->second.expired() && it->first != key)
+			it = tables.erase(it);
+		else
+			it++;
+	}
+
+	std::shared_ptr<PhaseTable> table = std::make_shared<PhaseTable>();
+	table->L = L;
+	table->M = M;
+	table->left = wing;
+	table->taps = taps;
+	table->coefficients.assureSize(L * taps * sizeof(float));
+
+	float* coefficients = reinterpret_cast<float*>(table->coefficients.getBuffer());
+
+	for(int p = 0; p < L; p++)
+	{
+		// the output sample lies p / L frames after the current input frame
+		double offset = double(p) / double(L);
+
+		for(int k = 0; k < taps; k++)
+		{
+			int frame = k - wing + 1;
+			double distance = frame <= 0 ? offset - frame : frame - offset;
+			double position = distance * scale * m_L;
+			float tap = 0;
+
+			if(position < m_len)
+			{
+				int l = int(position);
+				double eta = position - l;
+				tap = scale * (m_coeff[l] + eta * (m_coeff[l + 1] - m_coeff[l]));
+			}
+
+			coefficients[p * taps + k] = tap;
+		}
+	}
+
+	tables[key] = table;
+
+	return table;
+}
+
+void PolyphaseResampleReader::updateTable()
+{
+	SampleRate source = m_source_rate;
+
+	m_table = nullptr;
+
+	// only integer rates have a small rational ratio
+	if(source < 1 || m_rate < 1 || source > INT_MAX || m_rate > INT_MAX || std::floor(source) != source || std::floor(m_rate) != m_rate)
+		return;
+
+	int L = int(m_rate);
+	int M = int(source);
+	int a = L;
+	int b = M;
+
+	while(b)
+	{
+		int r = a % b;
+		a = b;
+		b = r;
+	}
+
+	L /= a;
+	M /= a;
+
+	if(L <= MAX_PHASES)
+		m_table = getTable(L, M);
+}
+
+void PolyphaseResampleReader::setSourceRate(SampleRate rate)
+{
+	if(rate == m_source_rate)
+		return;
+
+	m_source_rate = rate;
+	updateTable();
+}
+
+SampleRate PolyphaseResampleReader::getSourceRate() const
+{
+	return m_source_rate;
+}
+
+void PolyphaseResampleReader::setRate(SampleRate rate)
+{
+	if(rate == m_rate)
+		return;
+
+	JOSResampleReader::setRate(rate);
+
+	if(m_source_rate > 0)
+		updateTable();
+}
+
+void PolyphaseResampleReader::resampleBlock(double target_factor, int length, sample_t* buffer)
+{
+	// the filter bank only fits the nominal rates, a pitch or a changing ratio needs the variable ratio algorithm
+	if(!m_table || m_last_factor != target_factor || m_reader->getSpecs().rate != m_source_rate)
+	{
+		JOSResampleReader::resampleBlock(target_factor, length, buffer);
+		return;
+	}
+
+	const PhaseTable& table = *m_table;
+	const float* coefficients = reinterpret_cast<const float*>(table.coefficients.getBuffer());
+	const sample_t* buf = m_buffer.getBuffer();
+
+	m_sums.assureSize(m_channels * sizeof(float));
+	float* sums = reinterpret_cast<float*>(m_sums.getBuffer());
+
+	int L = table.L;
+	int n_increment = table.M / L;
+	int p_increment = table.M % L;
+
+	// continue at the nearest phase, which only moves the position after a ratio change
+	int n = m_n;
+	int p = int(std::lround(m_P * L));
+
+	if(p == L)
+	{
+		p = 0;
+		n++;
+	}
+
+	for(int t = 0; t < length; t++)
+	{
+		int first = n - table.left + 1;
+
+		// the taps are only cut off at the start of the stream and at the end of the cache
+		int skip = std::max(-first, 0);
+		int frames = std::max(std::min(table.taps, m_cache_valid - first) - skip, 0);
+
+		m_accumulate(coefficients + p * table.taps + skip, buf + (first + skip) * m_channels, frames, m_channels, sums);
+
+		for(int channel = 0; channel < m_channels; channel++)
+			*buffer++ = sums[channel];
+
+		p += p_increment;
+		int wrap = p >= L;
+		p -= wrap * L;
+		n += n_increment + wrap;
+	}
+
+	m_n = n;
+	m_P = double(p) / double(L);
+}
+
+AUD_NAMESPACE_END
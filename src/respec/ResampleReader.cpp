@@ -33,4 +33,8 @@ SampleRate ResampleReader::getRate()
 	return m_rate;
 }
 
+void ResampleReader::reset()
+{
+}
+
 AUD_NAMESPACE_END
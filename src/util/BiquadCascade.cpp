@@ -0,0 +1,666 @@
+/*******************************************************************************
+ * Copyright 2009-2016 Jörg Müller
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************/
+
+#include "util/BiquadCascade.h"
+#include "util/SIMD.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstring>
+
+#if defined(AUD_SIMD_X86)
+#include <immintrin.h>
+#elif defined(AUD_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+#define MAX_ORDER 32
+#define MAX_ITERATIONS 1000
+#define SECTION_SIZE 5
+#define STATE_SIZE 8
+#define TOLERANCE 1e-5
+#define ROUNDING_LIMIT 1e-14
+#define DENORMAL_LIMIT 1e-30f
+
+AUD_NAMESPACE_BEGIN
+
+/*
+ * The filter functions run the sections of one group of channels over a
+ * block, keeping the state in registers, and filter two sections per pass
+ * over the buffer. The state of each section consists of four z1 values
+ * followed by four z2 values, one per lane. Unused lanes filter zeros.
+ */
+
+template <int L, int N>
+static inline void biquad_pass_scalar(const float* c, float* state, sample_t* buffer, int length, int channels)
+{
+	float z1[N][L];
+	float z2[N][L];
+
+	for(int n = 0; n < N; n++)
+	{
+		for(int l = 0; l < L; l++)
+		{
+			z1[n][l] = state[n * STATE_SIZE + l];
+			z2[n][l] = state[n * STATE_SIZE + 4 + l];
+		}
+	}
+
+	for(int i = 0; i < length; i++)
+	{
+		sample_t* frame = buffer + i * channels;
+
+		for(int l = 0; l < L; l++)
+		{
+			float x = frame[l];
+
+			for(int n = 0; n < N; n++)
+			{
+				const float* s = c + n * SECTION_SIZE;
+				float y = s[0] * x + z1[n][l];
+				z1[n][l] = s[1] * x + s[3] * y + z2[n][l];
+				z2[n][l] = s[2] * x + s[4] * y;
+				x = y;
+			}
+
+			frame[l] = x;
+		}
+	}
+
+	for(int n = 0; n < N; n++)
+	{
+		for(int l = 0; l < L; l++)
+		{
+			state[n * STATE_SIZE + l] = z1[n][l];
+			state[n * STATE_SIZE + 4 + l] = z2[n][l];
+		}
+	}
+}
+
+template <int L>
+static void biquad_scalar(const float* coefficients, int sections, float* state, sample_t* buffer, int length, int channels)
+{
+	int s = 0;
+
+	for(; s + 2 <= sections; s += 2)
+		biquad_pass_scalar<L, 2>(coefficients + s * SECTION_SIZE, state + s * STATE_SIZE, buffer, length, channels);
+
+	if(s < sections)
+		biquad_pass_scalar<L, 1>(coefficients + s * SECTION_SIZE, state + s * STATE_SIZE, buffer, length, channels);
+}
+
+#if defined(AUD_SIMD_X86)
+template <int L>
+AUD_TARGET_SSE2 static inline __m128 load_sse2(const sample_t* p)
+{
+	if(L == 4)
+		return _mm_loadu_ps(p);
+	if(L == 2)
+		return _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(p)));
+	return _mm_load_ss(p);
+}
+
+template <int L>
+AUD_TARGET_SSE2 static inline void store_sse2(sample_t* p, __m128 v)
+{
+	if(L == 4)
+		_mm_storeu_ps(p, v);
+	else if(L == 2)
+		_mm_store_sd(reinterpret_cast<double*>(p), _mm_castps_pd(v));
+	else
+		_mm_store_ss(p, v);
+}
+
+template <int L, int N>
+AUD_TARGET_SSE2 static inline void biquad_pass_sse2(const float* c, float* state, sample_t* buffer, int length, int channels)
+{
+	__m128 b0[N], b1[N], b2[N], a1[N], a2[N], z1[N], z2[N];
+
+	for(int n = 0; n < N; n++)
+	{
+		b0[n] = _mm_set1_ps(c[n * SECTION_SIZE]);
+		b1[n] = _mm_set1_ps(c[n * SECTION_SIZE + 1]);
+		b2[n] = _mm_set1_ps(c[n * SECTION_SIZE + 2]);
+		a1[n] = _mm_set1_ps(c[n * SECTION_SIZE + 3]);
+		a2[n] = _mm_set1_ps(c[n * SECTION_SIZE + 4]);
+		z1[n] = _mm_load_ps(state + n * STATE_SIZE);
+		z2[n] = _mm_load_ps(state + n * STATE_SIZE + 4);
+	}
+
+	for(int i = 0; i < length; i++)
+	{
+		__m128 x = load_sse2<L>(buffer + i * channels);
+
+		for(int n = 0; n < N; n++)
+		{
+			__m128 y = _mm_add_ps(_mm_mul_ps(b0[n], x), z1[n]);
+			z1[n] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(b1[n], x), _mm_mul_ps(a1[n], y)), z2[n]);
+			z2[n] = _mm_add_ps(_mm_mul_ps(b2[n], x), _mm_mul_ps(a2[n], y));
+			x = y;
+		}
+
+		store_sse2<L>(buffer + i * channels, x);
+	}
+
+	for(int n = 0; n < N; n++)
+	{
+		_mm_store_ps(state + n * STATE_SIZE, z1[n]);
+		_mm_store_ps(state + n * STATE_SIZE + 4, z2[n]);
+	}
+}
+
+template <int L>
+AUD_TARGET_SSE2 static void biquad_sse2(const float* coefficients, int sections, float* state, sample_t* buffer, int length, int channels)
+{
+	int s = 0;
+
+	for(; s + 2 <= sections; s += 2)
+		biquad_pass_sse2<L, 2>(coefficients + s * SECTION_SIZE, state + s * STATE_SIZE, buffer, length, channels);
+
+	if(s < sections)
+		biquad_pass_sse2<L, 1>(coefficients + s * SECTION_SIZE, state + s * STATE_SIZE, buffer, length, channels);
+}
+#elif defined(AUD_SIMD_NEON)
+template <int L>
+static inline float32x4_t load_neon(const sample_t* p)
+{
+	if(L == 4)
+		return vld1q_f32(p);
+	if(L == 2)
+		return vcombine_f32(vld1_f32(p), vdup_n_f32(0));
+	return vsetq_lane_f32(*p, vdupq_n_f32(0), 0);
+}
+
+template <int L>
+static inline void store_neon(sample_t* p, float32x4_t v)
+{
+	if(L == 4)
+		vst1q_f32(p, v);
+	else if(L == 2)
+		vst1_f32(p, vget_low_f32(v));
+	else
+		vst1q_lane_f32(p, v, 0);
+}
+
+template <int L, int N>
+static inline void biquad_pass_neon(const float* c, float* state, sample_t* buffer, int length, int channels)
+{
+	float32x4_t b0[N], b1[N], b2[N], a1[N], a2[N], z1[N], z2[N];
+
+	for(int n = 0; n < N; n++)
+	{
+		b0[n] = vdupq_n_f32(c[n * SECTION_SIZE]);
+		b1[n] = vdupq_n_f32(c[n * SECTION_SIZE + 1]);
+		b2[n] = vdupq_n_f32(c[n * SECTION_SIZE + 2]);
+		a1[n] = vdupq_n_f32(c[n * SECTION_SIZE + 3]);
+		a2[n] = vdupq_n_f32(c[n * SECTION_SIZE + 4]);
+		z1[n] = vld1q_f32(state + n * STATE_SIZE);
+		z2[n] = vld1q_f32(state + n * STATE_SIZE + 4);
+	}
+
+	for(int i = 0; i < length; i++)
+	{
+		float32x4_t x = load_neon<L>(buffer + i * channels);
+
+		for(int n = 0; n < N; n++)
+		{
+			float32x4_t y = vaddq_f32(vmulq_f32(b0[n], x), z1[n]);
+			z1[n] = vaddq_f32(vaddq_f32(vmulq_f32(b1[n], x), vmulq_f32(a1[n], y)), z2[n]);
+			z2[n] = vaddq_f32(vmulq_f32(b2[n], x), vmulq_f32(a2[n], y));
+			x = y;
+		}
+
+		store_neon<L>(buffer + i * channels, x);
+	}
+
+	for(int n = 0; n < N; n++)
+	{
+		vst1q_f32(state + n * STATE_SIZE, z1[n]);
+		vst1q_f32(state + n * STATE_SIZE + 4, z2[n]);
+	}
+}
+
+template <int L>
+static void biquad_neon(const float* coefficients, int sections, float* state, sample_t* buffer, int length, int channels)
+{
+	int s = 0;
+
+	for(; s + 2 <= sections; s += 2)
+		biquad_pass_neon<L, 2>(coefficients + s * SECTION_SIZE, state + s * STATE_SIZE, buffer, length, channels);
+
+	if(s < sections)
+		biquad_pass_neon<L, 1>(coefficients + s * SECTION_SIZE, state + s * STATE_SIZE, buffer, length, channels);
+}
+#endif
+
+/// A factor 1 + c1 z^-1 + c2 z^-2 of a polynomial.
+struct Quadratic
+{
+	double c1;
+	double c2;
+
+	/// One of the roots, the one with the nonnegative imaginary part.
+	std::complex<double> root;
+};
+
+/**
+ * Finds the roots of 1 + p[1] z^-1 + ... + p[n] z^-n with the Durand-Kerner
+ * method, that is the roots of z^n + p[1] z^(n-1) + ... + p[n].
+ */
+static bool findRoots(const std::vector<double>& p, std::vector<std::complex<double>>& roots)
+{
+	int n = p.size() - 1;
+
+	roots.resize(n);
+
+	std::complex<double> start(0.4, 0.9);
+	std::complex<double> power = 1;
+
+	for(int k = 0; k < n; k++)
+	{
+		power *= start;
+		roots[k] = power;
+	}
+
+	for(int iteration = 0; iteration < MAX_ITERATIONS; iteration++)
+	{
+		bool converged = true;
+
+		for(int k = 0; k < n; k++)
+		{
+			std::complex<double> value = 1;
+			double bound = 1;
+			double radius = std::abs(roots[k]);
+
+			for(int i = 1; i <= n; i++)
+			{
+				value = value * roots[k] + p[i];
+				bound = bound * radius + std::abs(p[i]);
+			}
+
+			// multiple roots converge slowly, so the iteration stops once the rounding error dominates
+			if(std::abs(value) <= ROUNDING_LIMIT * bound)
+				continue;
+
+			converged = false;
+
+			std::complex<double> divisor = 1;
+
+			for(int j = 0; j < n; j++)
+				if(j != k)
+					divisor *= roots[k] - roots[j];
+
+			if(divisor == 0.0)
+				divisor = 1e-30;
+
+			roots[k] -= value / divisor;
+		}
+
+		if(converged)
+			break;
+	}
+
+	for(auto& root : roots)
+		if(!std::isfinite(root.real()) || !std::isfinite(root.imag()))
+			return false;
+
+	return true;
+}
+
+/**
+ * Groups the roots of a polynomial into conjugate pairs and pairs of real
+ * roots and returns their quadratic factors.
+ */
+static void pairRoots(std::vector<std::complex<double>> roots, std::vector<Quadratic>& quadratics)
+{
+	std::vector<double> reals;
+
+	while(!roots.empty())
+	{
+		auto it = std::max_element(roots.begin(), roots.end(), [](const std::complex<double>& a, const std::complex<double>& b) { return std::abs(a.imag()) < std::abs(b.imag()); });
+
+		if(it->imag() == 0)
+		{
+			for(auto& root : roots)
+				reals.push_back(root.real());
+			break;
+		}
+
+		std::complex<double> root = *it;
+		roots.erase(it);
+
+		// multiple roots are only approximated, so the nearest conjugate is taken
+		auto partner = std::min_element(roots.begin(), roots.end(), [&root](const std::complex<double>& a, const std::complex<double>& b) { return std::abs(a - std::conj(root)) < std::abs(b - std::conj(root)); });
+
+		if(partner == roots.end())
+		{
+			reals.push_back(root.real());
+			break;
+		}
+
+		std::complex<double> other = *partner;
+		roots.erase(partner);
+
+		Quadratic quadratic;
+		quadratic.c1 = -(root + other).real();
+		quadratic.c2 = (root * other).real();
+		quadratic.root = root.imag() < 0 ? std::conj(root) : root;
+		quadratics.push_back(quadratic);
+	}
+
+	std::sort(reals.begin(), reals.end());
+
+	for(size_t i = 0; i < reals.size(); i += 2)
+	{
+		Quadratic quadratic;
+
+		if(i + 1 < reals.size())
+		{
+			quadratic.c1 = -(reals[i] + reals[i + 1]);
+			quadratic.c2 = reals[i] * reals[i + 1];
+			quadratic.root = std::abs(reals[i]) > std::abs(reals[i + 1]) ? reals[i] : reals[i + 1];
+		}
+		else
+		{
+			quadratic.c1 = -reals[i];
+			quadratic.c2 = 0;
+			quadratic.root = reals[i];
+		}
+
+		quadratics.push_back(quadratic);
+	}
+}
+
+/**
+ * Normalizes a polynomial by a[0] and removes its trailing zeros.
+ */
+static std::vector<double> normalize(const std::vector<float>& p, double a0)
+{
+	std::vector<double> result(p.begin(), p.end());
+
+	for(auto& value : result)
+		value /= a0;
+
+	while(result.size() > 1 && result.back() == 0)
+		result.pop_back();
+
+	return result;
+}
+
+/**
+ * Checks whether the product of the factors matches a polynomial.
+ */
+static bool matches(const std::vector<double>& polynomial, const std::vector<double>& product)
+{
+	double norm = 0;
+	double error = 0;
+
+	for(auto value : polynomial)
+		norm += std::abs(value);
+
+	for(size_t i = 0; i < std::max(polynomial.size(), product.size()); i++)
+	{
+		double expected = i < polynomial.size() ? polynomial[i] : 0;
+		double actual = i < product.size() ? product[i] : 0;
+		error = std::max(error, std::abs(expected - actual));
+	}
+
+	return error <= TOLERANCE * norm;
+}
+
+/**
+ * Factors b(z) / a(z) into second order sections.
+ */
+static bool factor(const std::vector<float>& b, const std::vector<float>& a, std::vector<float>& result)
+{
+	std::vector<double> numerator = normalize(b, a[0]);
+	std::vector<double> denominator = normalize(a, a[0]);
+
+	double gain = numerator[0];
+
+	// a leading zero is a delay, which has no root
+	if(gain == 0 && numerator.size() > 1)
+		return false;
+
+	std::vector<double> zeros(1, 1);
+
+	if(gain != 0)
+	{
+		zeros = numerator;
+		for(auto& value : zeros)
+			value /= gain;
+	}
+
+	std::vector<std::complex<double>> roots;
+	std::vector<Quadratic> zero_factors;
+	std::vector<Quadratic> pole_factors;
+
+	if(!findRoots(zeros, roots))
+		return false;
+	pairRoots(roots, zero_factors);
+
+	if(!findRoots(denominator, roots))
+		return false;
+	pairRoots(roots, pole_factors);
+
+	size_t count = std::max(std::max(zero_factors.size(), pole_factors.size()), size_t(1));
+
+	Quadratic identity = { 0, 0, 0 };
+	zero_factors.resize(count, identity);
+	pole_factors.resize(count, identity);
+
+	// the poles closest to the unit circle come last and get the nearest zeros
+	std::sort(pole_factors.begin(), pole_factors.end(), [](const Quadratic& a, const Quadratic& b) { return std::abs(a.root) < std::abs(b.root); });
+
+	std::vector<Quadratic> paired_zeros(count);
+
+	for(size_t i = count; i-- > 0;)
+	{
+		auto nearest = std::min_element(zero_factors.begin(), zero_factors.end(), [&](const Quadratic& a, const Quadratic& b) { return std::abs(a.root - pole_factors[i].root) < std::abs(b.root - pole_factors[i].root); });
+		paired_zeros[i] = *nearest;
+		zero_factors.erase(nearest);
+	}
+
+	std::vector<float> coefficients(count * SECTION_SIZE);
+	std::vector<double> numerator_product(1, 1);
+	std::vector<double> denominator_product(1, 1);
+
+	for(size_t i = 0; i < count; i++)
+	{
+		double section_gain = i ? 1 : gain;
+		float* section = &coefficients[i * SECTION_SIZE];
+
+		section[0] = float(section_gain);
+		section[1] = float(section_gain * paired_zeros[i].c1);
+		section[2] = float(section_gain * paired_zeros[i].c2);
+		section[3] = float(-pole_factors[i].c1);
+		section[4] = float(-pole_factors[i].c2);
+
+		// multiply the rounded sections back for the check
+		std::vector<double> next_numerator(numerator_product.size() + 2, 0);
+		std::vector<double> next_denominator(denominator_product.size() + 2, 0);
+
+		for(size_t j = 0; j < numerator_product.size(); j++)
+			for(int k = 0; k < 3; k++)
+				next_numerator[j + k] += numerator_product[j] * section[k];
+
+		for(size_t j = 0; j < denominator_product.size(); j++)
+		{
+			next_denominator[j] += denominator_product[j];
+			next_denominator[j + 1] -= denominator_product[j] * section[3];
+			next_denominator[j + 2] -= denominator_product[j] * section[4];
+		}
+
+		numerator_product.swap(next_numerator);
+		denominator_product.swap(next_denominator);
+	}
+
+	if(!matches(numerator, numerator_product) || !matches(denominator, denominator_product))
+		return false;
+
+	result.swap(coefficients);
+
+	return true;
+}
+
+BiquadCascade::BiquadCascade() :
+	m_channels(CHANNELS_INVALID)
+{
+	m_biquad[0] = m_biquad[1] = m_biquad[2] = nullptr;
+}
+
+int BiquadCascade::getGroupCount(Channels channels)
+{
+	return channels / 4 + channels % 4 / 2 + channels % 2;
+}
+
+bool BiquadCascade::setCoefficients(const std::vector<float>& b, const std::vector<float>& a)
+{
+	int sections = getSectionCount();
+
+	bool valid = !a.empty() && !b.empty() && a[0] != 0 && a.size() <= MAX_ORDER + 1 && b.size() <= MAX_ORDER + 1;
+
+	for(size_t i = 0; valid && i < a.size(); i++)
+		valid = std::isfinite(a[i]);
+	for(size_t i = 0; valid && i < b.size(); i++)
+		valid = std::isfinite(b[i]);
+
+	if(valid && a.size() <= 3 && b.size() <= 3)
+	{
+		// a single section is used as it is
+		m_coefficients.assign(SECTION_SIZE, 0);
+
+		for(size_t i = 0; i < b.size(); i++)
+			m_coefficients[i] = b[i] / a[0];
+		for(size_t i = 1; i < a.size(); i++)
+			m_coefficients[2 + i] = -a[i] / a[0];
+	}
+	else if(!valid || !factor(b, a, m_coefficients))
+	{
+		m_coefficients.clear();
+		return false;
+	}
+
+	if(getSectionCount() != sections)
+		reset();
+
+	return true;
+}
+
+void BiquadCascade::setSections(const std::vector<float>& sections)
+{
+	int count = getSectionCount();
+
+	m_coefficients.resize(sections.size() / SECTION_SIZE * SECTION_SIZE);
+
+	for(size_t i = 0; i < m_coefficients.size(); i += SECTION_SIZE)
+	{
+		m_coefficients[i] = sections[i];
+		m_coefficients[i + 1] = sections[i + 1];
+		m_coefficients[i + 2] = sections[i + 2];
+		m_coefficients[i + 3] = -sections[i + 3];
+		m_coefficients[i + 4] = -sections[i + 4];
+	}
+
+	if(getSectionCount() != count)
+		reset();
+}
+
+int BiquadCascade::getSectionCount() const
+{
+	return m_coefficients.size() / SECTION_SIZE;
+}
+
+void BiquadCascade::interpolate(const BiquadCascade& target, float factor)
+{
+	if(target.m_coefficients.size() != m_coefficients.size())
+	{
+		m_coefficients = target.m_coefficients;
+		reset();
+		return;
+	}
+
+	for(size_t i = 0; i < m_coefficients.size(); i++)
+		m_coefficients[i] += (target.m_coefficients[i] - m_coefficients[i]) * factor;
+}
+
+void BiquadCascade::reset()
+{
+	int size = getGroupCount(m_channels) * getSectionCount() * STATE_SIZE * sizeof(float);
+
+	m_state.assureSize(size);
+	std::memset(m_state.getBuffer(), 0, size);
+}
+
+void BiquadCascade::process(sample_t* buffer, int length, Channels channels)
+{
+	if(m_coefficients.empty())
+		return;
+
+	if(channels != m_channels)
+	{
+		m_channels = channels;
+
+		switch(SIMD::getLevel())
+		{
+#if defined(AUD_SIMD_X86)
+		case SIMD_AVX2:
+		case SIMD_SSE2:
+			m_biquad[0] = biquad_sse2<1>;
+			m_biquad[1] = biquad_sse2<2>;
+			m_biquad[2] = biquad_sse2<4>;
+			break;
+#elif defined(AUD_SIMD_NEON)
+		case SIMD_NEON:
+			m_biquad[0] = biquad_neon<1>;
+			m_biquad[1] = biquad_neon<2>;
+			m_biquad[2] = biquad_neon<4>;
+			break;
+#endif
+		default:
+			m_biquad[0] = biquad_scalar<1>;
+			m_biquad[1] = biquad_scalar<2>;
+			m_biquad[2] = biquad_scalar<4>;
+			break;
+		}
+
+		reset();
+	}
+
+	int sections = getSectionCount();
+	float* state = reinterpret_cast<float*>(m_state.getBuffer());
+
+	for(int channel = 0; channel < channels;)
+	{
+		int remaining = channels - channel;
+		int lanes = remaining >= 4 ? 4 : remaining >= 2 ? 2 : 1;
+
+		m_biquad[lanes >> 1](m_coefficients.data(), sections, state, buffer + channel, length, channels);
+
+		state += sections * STATE_SIZE;
+		channel += lanes;
+	}
+
+	// decaying states are flushed before they become slow denormals
+	state = reinterpret_cast<float*>(m_state.getBuffer());
+
+	for(int i = 0; i < getGroupCount(channels) * sections * STATE_SIZE; i++)
+		if(std::abs(state[i]) < DENORMAL_LIMIT)
+			state[i] = 0;
+}
+
+AUD_NAMESPACE_END
@@ -15,29 +15,145 @@
  ******************************************************************************/
 
 #include "util/Buffer.h"
+#include "Exception.h"
 
 #include <algorithm>
 #include <cstring>
 #include <cstdlib>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #define ALIGNMENT 32
 #define ALIGN(a) (a + ALIGNMENT - ((long long)a & (ALIGNMENT-1)))
 
 AUD_NAMESPACE_BEGIN
 
+static void unmap(data_t* buffer, long long size)
+{
+#ifdef _WIN32
+	UnmapViewOfFile(buffer);
+#else
+	munmap(buffer, size);
+#endif
+}
+
 Buffer::Buffer(long long size)
 {
 	m_size = size;
 	m_buffer = (data_t*) std::malloc(size + ALIGNMENT);
+	m_mapped = false;
 }
 
 Buffer::~Buffer()
 {
-	std::free(m_buffer);
+	if(m_parent)
+		return;
+
+	if(m_mapped)
+		unmap(m_buffer, m_size);
+	else
+		std::free(m_buffer);
+}
+
+std::shared_ptr<Buffer> Buffer::map(const std::string& filename)
+{
+	long long size;
+	void* mapping;
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if(file == INVALID_HANDLE_VALUE)
+		AUD_THROW(FileException, "The file couldn't be opened for mapping.");
+
+	LARGE_INTEGER file_size;
+
+	if(!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		AUD_THROW(FileException, "The file is empty or its size couldn't be read.");
+	}
+
+	size = file_size.QuadPart;
+
+	HANDLE file_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+
+	if(!file_mapping)
+		AUD_THROW(FileException, "The file couldn't be mapped.");
+
+	// the view keeps the mapping alive
+	mapping = MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(file_mapping);
+
+	if(!mapping)
+		AUD_THROW(FileException, "The file couldn't be mapped.");
+#else
+	int file = open(filename.c_str(), O_RDONLY);
+
+	if(file < 0)
+		AUD_THROW(FileException, "The file couldn't be opened for mapping.");
+
+	struct stat status;
+
+	if(fstat(file, &status) < 0 || status.st_size == 0)
+	{
+		close(file);
+		AUD_THROW(FileException, "The file is empty or its size couldn't be read.");
+	}
+
+	size = status.st_size;
+
+	// the mapping stays valid after closing the file
+	mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, file, 0);
+	close(file);
+
+	if(mapping == MAP_FAILED)
+		AUD_THROW(FileException, "The file couldn't be mapped.");
+#endif
+
+	std::shared_ptr<Buffer> buffer = std::make_shared<Buffer>(0);
+	std::free(buffer->m_buffer);
+	buffer->m_buffer = (data_t*) mapping;
+	buffer->m_size = size;
+	buffer->m_mapped = true;
+
+	return buffer;
+}
+
+std::shared_ptr<Buffer> Buffer::slice(std::shared_ptr<Buffer> buffer, long long offset, long long size)
+{
+	if(offset < 0 || size < 0 || offset + size > buffer->getSize())
+		AUD_THROW(StateException, "The slice exceeds the buffer.");
+
+	std::shared_ptr<Buffer> result = std::make_shared<Buffer>(0);
+	std::free(result->m_buffer);
+	result->m_buffer = reinterpret_cast<data_t*>(buffer->getBuffer()) + offset;
+	result->m_size = size;
+	result->m_mapped = buffer->isMapped();
+	result->m_parent = buffer;
+
+	return result;
+}
+
+bool Buffer::isMapped() const
+{
+	return m_mapped;
 }
 
 sample_t* Buffer::getBuffer() const
 {
+	// mappings are page aligned and slices keep their offset
+	if(m_mapped || m_parent)
+		return (sample_t*) m_buffer;
+
 	return (sample_t*) ALIGN(m_buffer);
 }
 
@@ -48,7 +164,22 @@ long long Buffer::getSize() const
 
 void Buffer::resize(long long size, bool keep)
 {
-	if(keep)
+	if(m_mapped || m_parent)
+	{
+		data_t* buffer = (data_t*) std::malloc(size + ALIGNMENT);
+
+		if(keep)
+			std::memcpy(ALIGN(buffer), m_buffer, std::min(size, m_size));
+
+		if(m_parent)
+			m_parent = nullptr;
+		else
+			unmap(m_buffer, m_size);
+
+		m_buffer = buffer;
+		m_mapped = false;
+	}
+	else if(keep)
 	{
 		data_t* buffer = (data_t*) std::malloc(size + ALIGNMENT);
 
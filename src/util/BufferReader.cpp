@@ -16,6 +16,7 @@
 
 #include "util/BufferReader.h"
 #include "util/Buffer.h"
+#include "Exception.h"
 
 #include <cstring>
 
@@ -23,10 +24,42 @@ AUD_NAMESPACE_BEGIN
 
 BufferReader::BufferReader(std::shared_ptr<Buffer> buffer,
 								   Specs specs) :
-	m_position(0), m_buffer(buffer), m_specs(specs)
+	m_position(0), m_buffer(buffer), m_specs(specs), m_format(FORMAT_FLOAT32), m_convert(convert_copy<float>)
 {
 }
 
+BufferReader::BufferReader(std::shared_ptr<Buffer> buffer, DeviceSpecs specs) :
+	m_position(0), m_buffer(buffer), m_specs(specs.specs), m_format(specs.format)
+{
+	switch(m_format)
+	{
+	case FORMAT_U8:
+		m_convert = convert_u8_float;
+		break;
+	case FORMAT_S16:
+		m_convert = convert_s16_float;
+		break;
+	case FORMAT_S24:
+#ifdef __BIG_ENDIAN__
+		m_convert = convert_s24_float_be;
+#else
+		m_convert = convert_s24_float_le;
+#endif
+		break;
+	case FORMAT_S32:
+		m_convert = convert_s32_float;
+		break;
+	case FORMAT_FLOAT32:
+		m_convert = convert_copy<float>;
+		break;
+	case FORMAT_FLOAT64:
+		m_convert = convert_double_float;
+		break;
+	default:
+		AUD_THROW(StateException, "The sample format of the buffer is invalid.");
+	}
+}
+
 bool BufferReader::isSeekable() const
 {
 	return true;
@@ -39,7 +72,7 @@ void BufferReader::seek(int position)
 
 int BufferReader::getLength() const
 {
-	return m_buffer->getSize() / AUD_SAMPLE_SIZE(m_specs);
+	return m_buffer->getSize() / (m_specs.channels * AUD_FORMAT_SIZE(m_format));
 }
 
 int BufferReader::getPosition() const
@@ -56,9 +89,9 @@ void BufferReader::read(int& length, bool& eos, sample_t* buffer)
 {
 	eos = false;
 
-	int sample_size = AUD_SAMPLE_SIZE(m_specs);
+	int sample_size = m_specs.channels * AUD_FORMAT_SIZE(m_format);
 
-	sample_t* buf = m_buffer->getBuffer() + m_position * m_specs.channels;
+	data_t* buf = reinterpret_cast<data_t*>(m_buffer->getBuffer()) + m_position * sample_size;
 
 	// in case the end of the buffer is reached
 	if(m_buffer->getSize() < (m_position + length) * sample_size)
@@ -74,7 +107,7 @@ void BufferReader::read(int& length, bool& eos, sample_t* buffer)
 	}
 
 	m_position += length;
-	std::memcpy(buffer, buf, length * sample_size);
+	m_convert(reinterpret_cast<data_t*>(buffer), buf, length * m_specs.channels);
 }
 
 AUD_NAMESPACE_END
@@ -16,28 +16,104 @@
 
 #include "util/FFTPlan.h"
 
+#include <map>
+#include <mutex>
+#include <tuple>
+
 AUD_NAMESPACE_BEGIN
+
+// the FFTW planner isn't thread safe, only executing plans is
+static std::mutex planner_mutex;
+static std::string wisdom_file;
+
 FFTPlan::FFTPlan(double measureTime) :
 	FFTPlan(DEFAULT_N, measureTime)
 {
 }
 
 FFTPlan::FFTPlan(int n, double measureTime) :
+	FFTPlan(n, measureTime, FFTW_EXHAUSTIVE)
+{
+}
+
+FFTPlan::FFTPlan(int n, double measureTime, unsigned int flags) :
 	m_N(n), m_bufferSize(((n/2)+1)*2*sizeof(fftwf_complex))
 {
+	std::lock_guard<std::mutex> lock(planner_mutex);
+
 	fftwf_set_timelimit(measureTime);
 	void* buf = fftwf_malloc(m_bufferSize);
-	m_fftPlanR2C = fftwf_plan_dft_r2c_1d(m_N, (float*)buf, (fftwf_complex*)buf, FFTW_EXHAUSTIVE);
-	m_fftPlanC2R = fftwf_plan_dft_c2r_1d(m_N, (fftwf_complex*)buf, (float*)buf, FFTW_EXHAUSTIVE);
+	m_fftPlanR2C = fftwf_plan_dft_r2c_1d(m_N, (float*)buf, (fftwf_complex*)buf, flags);
+	m_fftPlanC2R = fftwf_plan_dft_c2r_1d(m_N, (fftwf_complex*)buf, (float*)buf, flags);
 	fftwf_free(buf);
 }
 
 FFTPlan::~FFTPlan()
 {
+	std::lock_guard<std::mutex> lock(planner_mutex);
+
 	fftwf_destroy_plan(m_fftPlanC2R);
 	fftwf_destroy_plan(m_fftPlanR2C);
 }
 
+std::shared_ptr<FFTPlan> FFTPlan::getShared(int n, double measureTime, unsigned int flags)
+{
+	typedef std::tuple<int, unsigned int, double> Key;
+
+	static std::mutex mutex;
+	static std::map<Key, std::shared_ptr<FFTPlan>> plans;
+
+	Key key(n, flags, measureTime);
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto it = plans.find(key);
+
+	if(it != plans.end())
+		return it->second;
+
+	std::shared_ptr<FFTPlan> plan = std::make_shared<FFTPlan>(n, measureTime, flags);
+	plans[key] = plan;
+
+	std::string filename = getWisdomFile();
+
+	if(!filename.empty())
+		exportWisdom(filename);
+
+	return plan;
+}
+
+bool FFTPlan::setWisdomFile(const std::string& filename)
+{
+	{
+		std::lock_guard<std::mutex> lock(planner_mutex);
+		wisdom_file = filename;
+	}
+
+	if(filename.empty())
+		return false;
+
+	return importWisdom(filename);
+}
+
+std::string FFTPlan::getWisdomFile()
+{
+	std::lock_guard<std::mutex> lock(planner_mutex);
+	return wisdom_file;
+}
+
+bool FFTPlan::importWisdom(const std::string& filename)
+{
+	std::lock_guard<std::mutex> lock(planner_mutex);
+	return fftwf_import_wisdom_from_filename(filename.c_str()) != 0;
+}
+
+bool FFTPlan::exportWisdom(const std::string& filename)
+{
+	std::lock_guard<std::mutex> lock(planner_mutex);
+	return fftwf_export_wisdom_to_filename(filename.c_str()) != 0;
+}
+
 int FFTPlan::getSize()
 {
 	return m_N;
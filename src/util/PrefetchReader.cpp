@@ -0,0 +1,238 @@
+/*******************************************************************************
+ * Copyright 2009-2016 Jörg Müller
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************/
+
+
+#include "util/PrefetchReader.h"
+#include "util/Buffer.h"
+#include "util/PrefetchThread.h"
+#include "util/RingBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+AUD_NAMESPACE_BEGIN
+
+class PrefetchReader::State : public PrefetchThread::Task
+{
+public:
+	/// The reader decoded ahead, only used by the prefetch thread after construction.
+	std::shared_ptr<IReader> m_reader;
+
+	/// The size of a sample in bytes.
+	int m_sampleSize;
+
+	/// The number of samples decoded at once.
+	int m_chunk;
+
+	/// The samples decoded ahead.
+	RingBuffer m_ring;
+
+	/// The buffer the reader is decoded into before writing to the ring.
+	Buffer m_buffer;
+
+	/// Whether the reader reached its end, all its samples are in the ring then.
+	std::atomic<bool> m_eos;
+
+	/// Whether the prefetch reader is destroyed and the state has to be released.
+	std::atomic<bool> m_stop;
+
+	/// Protects the seek state and writing to the ring, it is never held while decoding.
+	std::mutex m_mutex;
+
+	/// The position the source reader has to be seeked to, protected by the mutex.
+	int m_seekPosition;
+
+	/// Incremented by every seek to drop chunks decoded before it, protected by the mutex.
+	unsigned int m_generation;
+
+	/// The generation the source reader is positioned for, only used by the prefetch thread.
+	unsigned int m_readerGeneration;
+
+	State(std::shared_ptr<IReader> reader, int chunk) :
+		m_reader(reader), m_sampleSize(AUD_SAMPLE_SIZE(reader->getSpecs())), m_chunk(chunk),
+		m_eos(false), m_stop(false), m_seekPosition(reader->getPosition()), m_generation(0), m_readerGeneration(0)
+	{
+		// the ring keeps one byte free to tell full from empty
+		m_ring.resize(m_chunk * 4 * m_sampleSize + 1);
+		m_buffer.resize(m_chunk * m_sampleSize);
+	}
+
+	/**
+	 * Decodes chunks into the ring until it is full or the reader ends.
+	 * Seeks the source reader first if the reader has been seeked.
+	 */
+	void decode()
+	{
+		while(!m_stop)
+		{
+			unsigned int generation;
+			int position;
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				if(m_eos || int(m_ring.getWriteSize()) < m_chunk * m_sampleSize)
+					break;
+
+				generation = m_generation;
+				position = m_seekPosition;
+			}
+
+			// only the prefetch thread uses the source reader, so it is seeked and read without the lock
+			if(generation != m_readerGeneration)
+			{
+				m_reader->seek(position);
+				m_readerGeneration = generation;
+			}
+
+			int length = m_chunk;
+			bool eos;
+
+			m_reader->read(length, eos, m_buffer.getBuffer());
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			// a seek during reading makes the chunk obsolete
+			if(generation != m_generation)
+				continue;
+
+			m_ring.write(reinterpret_cast<data_t*>(m_buffer.getBuffer()), length * m_sampleSize);
+
+			// set after writing, so that the samples are in the ring when the end is seen
+			if(eos)
+				m_eos = true;
+		}
+	}
+
+	virtual bool run()
+	{
+		if(!m_stop)
+			decode();
+
+		return !m_stop;
+	}
+};
+
+PrefetchReader::PrefetchReader(std::shared_ptr<IReader> reader, std::shared_ptr<PrefetchThread> thread, int size, std::shared_ptr<std::atomic<long long>> underruns) :
+	m_state(std::make_shared<State>(reader, std::max(size / 4, 1))), m_thread(thread), m_specs(reader->getSpecs()), m_length(reader->getLength()),
+	m_seekable(reader->isSeekable()), m_position(reader->getPosition()), m_underruns(0), m_underrunLength(0), m_sharedUnderruns(underruns)
+{
+	// the prefetch thread doesn't know the state yet, so the first chunk can be decoded without locking
+	int length = m_state->m_chunk;
+	bool eos;
+
+	reader->read(length, eos, m_state->m_buffer.getBuffer());
+	m_state->m_ring.write(reinterpret_cast<data_t*>(m_state->m_buffer.getBuffer()), length * m_state->m_sampleSize);
+	m_state->m_eos = eos;
+
+	m_thread->add(m_state);
+}
+
+PrefetchReader::~PrefetchReader()
+{
+	// the prefetch thread releases the state the next time it runs, decoding may still be going on
+	m_state->m_stop = true;
+	m_thread->wake();
+}
+
+long long PrefetchReader::getUnderrunCount() const
+{
+	return m_underruns;
+}
+
+long long PrefetchReader::getUnderrunLength() const
+{
+	return m_underrunLength;
+}
+
+bool PrefetchReader::isSeekable() const
+{
+	return m_seekable;
+}
+
+void PrefetchReader::seek(int position)
+{
+	{
+		// the prefetch thread holds the lock at most for writing a chunk, it never decodes with it
+		std::lock_guard<std::mutex> lock(m_state->m_mutex);
+
+		m_state->m_ring.reset();
+		m_state->m_eos = false;
+		m_state->m_seekPosition = position;
+		m_state->m_generation++;
+	}
+
+	m_position = position;
+
+	// the reader is seeked and refilled by the prefetch thread, reading returns silence until then
+	m_thread->wake();
+}
+
+int PrefetchReader::getLength() const
+{
+	return m_length;
+}
+
+int PrefetchReader::getPosition() const
+{
+	return m_position;
+}
+
+Specs PrefetchReader::getSpecs() const
+{
+	return m_specs;
+}
+
+void PrefetchReader::read(int& length, bool& eos, sample_t* buffer)
+{
+	int sample_size = m_state->m_sampleSize;
+	RingBuffer& ring = m_state->m_ring;
+
+	// check the end before the ring, the last samples are written before it is set
+	bool ended = m_state->m_eos;
+	int count = std::min(length, int(ring.getReadSize()) / sample_size);
+
+	ring.read(reinterpret_cast<data_t*>(buffer), count * sample_size);
+	m_position += count;
+
+	eos = false;
+
+	if(count < length)
+	{
+		if(ended)
+		{
+			length = count;
+			eos = true;
+			return;
+		}
+
+		// the decoding didn't keep up, fill with silence instead of waiting
+		std::memset(buffer + count * m_specs.channels, 0, (length - count) * sample_size);
+
+		m_underruns++;
+		m_underrunLength += length - count;
+
+		if(m_sharedUnderruns)
+			(*m_sharedUnderruns)++;
+	}
+
+	// waking doesn't allocate, so it is fine on the mixing thread
+	if(!ended && int(ring.getWriteSize()) >= m_state->m_chunk * sample_size)
+		m_thread->wake();
+}
+
+AUD_NAMESPACE_END
@@ -0,0 +1,98 @@
+/*******************************************************************************
+ * Copyright 2009-2016 Jörg Müller
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************/
+
+#include "util/PrefetchThread.h"
+
+AUD_NAMESPACE_BEGIN
+
+PrefetchThread::PrefetchThread() :
+	m_wake(false), m_stop(false)
+{
+	m_thread = std::thread(&PrefetchThread::work, this);
+}
+
+PrefetchThread::~PrefetchThread()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+
+	m_condition.notify_one();
+	m_thread.join();
+}
+
+void PrefetchThread::add(std::shared_ptr<Task> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_tasks.push_back(task);
+		m_wake = true;
+	}
+
+	m_condition.notify_one();
+}
+
+void PrefetchThread::wake()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_wake = true;
+	}
+
+	m_condition.notify_one();
+}
+
+void PrefetchThread::work()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	for(;;)
+	{
+		m_condition.wait(lock, [this]() { return m_wake || m_stop; });
+
+		if(m_stop)
+			return;
+
+		// waking while the tasks run makes them run again
+		m_wake = false;
+
+		// only this thread removes tasks, others only append, so the indices stay valid
+		for(std::size_t i = 0; i < m_tasks.size() && !m_stop;)
+		{
+			std::shared_ptr<Task> task = m_tasks[i];
+
+			lock.unlock();
+			bool keep = task->run();
+			lock.lock();
+
+			if(keep)
+			{
+				i++;
+				continue;
+			}
+
+			m_tasks.erase(m_tasks.begin() + i);
+
+			// release the task without the lock, this may close its source
+			lock.unlock();
+			task.reset();
+			lock.lock();
+		}
+	}
+}
+
+AUD_NAMESPACE_END
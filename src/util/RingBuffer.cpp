@@ -44,8 +44,8 @@ int RingBuffer::getSize() const
 
 size_t RingBuffer::getReadSize() const
 {
-	size_t read = m_read;
-	size_t write = m_write;
+	size_t read = m_read.load(std::memory_order_acquire);
+	size_t write = m_write.load(std::memory_order_acquire);
 
 	if(read > write)
 		return write + getSize() - read;
@@ -55,8 +55,8 @@ size_t RingBuffer::getReadSize() const
 
 size_t RingBuffer::getWriteSize() const
 {
-	size_t read = m_read;
-	size_t write = m_write;
+	size_t read = m_read.load(std::memory_order_acquire);
+	size_t write = m_write.load(std::memory_order_acquire);
 
 	if(read > write)
 		return read - write - 1;
@@ -69,24 +69,28 @@ size_t RingBuffer::read(data_t* target, size_t size)
 	size = std::min(size, getReadSize());
 
 	data_t* buffer = reinterpret_cast<data_t*>(m_buffer.getBuffer());
+	size_t read = m_read.load(std::memory_order_relaxed);
 
-	if(m_read + size > m_buffer.getSize())
+	if(read + size > m_buffer.getSize())
 	{
-		size_t read_first = m_buffer.getSize() - m_read;
+		size_t read_first = m_buffer.getSize() - read;
 		size_t read_second = size - read_first;
 
-		std::memcpy(target, buffer + m_read, read_first);
+		std::memcpy(target, buffer + read, read_first);
 		std::memcpy(target + read_first, buffer, read_second);
 
-		m_read = read_second;
+		read = read_second;
 	}
 	else
 	{
-		std::memcpy(target, buffer + m_read, size);
+		std::memcpy(target, buffer + read, size);
 
-		m_read += size;
+		read += size;
 	}
 
+	// the space is only given back to the writer after the data is copied
+	m_read.store(read, std::memory_order_release);
+
 	return size;
 }
 
@@ -95,30 +99,34 @@ size_t RingBuffer::write(data_t* source, size_t size)
 	size = std::min(size, getWriteSize());
 
 	data_t* buffer = reinterpret_cast<data_t*>(m_buffer.getBuffer());
+	size_t write = m_write.load(std::memory_order_relaxed);
 
-	if(m_write + size > m_buffer.getSize())
+	if(write + size > m_buffer.getSize())
 	{
-		size_t write_first = m_buffer.getSize() - m_write;
+		size_t write_first = m_buffer.getSize() - write;
 		size_t write_second = size - write_first;
 
-		std::memcpy(buffer + m_write, source, write_first);
+		std::memcpy(buffer + write, source, write_first);
 		std::memcpy(buffer, source + write_first, write_second);
 
-		m_write = write_second;
+		write = write_second;
 	}
 	else
 	{
-		std::memcpy(buffer + m_write, source, size);
+		std::memcpy(buffer + write, source, size);
 
-		m_write += size;
+		write += size;
 	}
 
+	// the data is only published to the reader after it is copied
+	m_write.store(write, std::memory_order_release);
+
 	return size;
 }
 
 void RingBuffer::clear()
 {
-	m_read = m_write;
+	m_read.store(m_write.load(std::memory_order_acquire), std::memory_order_release);
 }
 
 void RingBuffer::reset()
@@ -0,0 +1,112 @@
+/*******************************************************************************
+ * Copyright 2009-2016 Jörg Müller
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************/
+
+#include "util/SIMD.h"
+
+#include <atomic>
+
+#if defined(AUD_SIMD_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+AUD_NAMESPACE_BEGIN
+
+static SIMDLevel detectLevel()
+{
+#if defined(AUD_SIMD_X86)
+#if defined(_MSC_VER)
+	int info[4];
+
+	__cpuid(info, 0);
+	int ids = info[0];
+
+	__cpuid(info, 1);
+	bool sse2 = (info[3] & (1 << 26)) != 0;
+	bool fma = (info[2] & (1 << 12)) != 0;
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	bool avx2 = false;
+
+	if(ids >= 7)
+	{
+		__cpuidex(info, 7, 0);
+		avx2 = (info[1] & (1 << 5)) != 0;
+	}
+
+	// the operating system has to save the ymm registers
+	if(osxsave && avx && avx2 && fma && (_xgetbv(0) & 0x06) == 0x06)
+		return SIMD_AVX2;
+
+	if(sse2)
+		return SIMD_SSE2;
+#else
+	__builtin_cpu_init();
+
+	if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		return SIMD_AVX2;
+
+	if(__builtin_cpu_supports("sse2"))
+		return SIMD_SSE2;
+#endif
+	return SIMD_NONE;
+#elif defined(AUD_SIMD_NEON)
+	return SIMD_NEON;
+#else
+	return SIMD_NONE;
+#endif
+}
+
+static std::atomic<int>& activeLevel()
+{
+	static std::atomic<int> level(SIMD::getSupportedLevel());
+	return level;
+}
+
+SIMDLevel SIMD::getSupportedLevel()
+{
+	static SIMDLevel level = detectLevel();
+	return level;
+}
+
+SIMDLevel SIMD::getLevel()
+{
+	return SIMDLevel(activeLevel().load());
+}
+
+void SIMD::setLevel(SIMDLevel level)
+{
+	SIMDLevel supported = getSupportedLevel();
+
+	bool available;
+
+	switch(level)
+	{
+	case SIMD_SSE2:
+	case SIMD_AVX2:
+		available = supported != SIMD_NEON && level <= supported;
+		break;
+	case SIMD_NEON:
+		available = supported == SIMD_NEON;
+		break;
+	default:
+		available = false;
+		break;
+	}
+
+	activeLevel() = available ? level : SIMD_NONE;
+}
+
+AUD_NAMESPACE_END
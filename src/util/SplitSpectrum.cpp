@@ -0,0 +1,273 @@
+/*******************************************************************************
+ * Copyright 2009-2016 Jörg Müller
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************/
+
+#include "util/SplitSpectrum.h"
+#include "util/SIMD.h"
+
+#include <cstring>
+
+#if defined(AUD_SIMD_X86)
+#include <immintrin.h>
+#elif defined(AUD_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+#define STRIDE_ALIGNMENT 8
+
+AUD_NAMESPACE_BEGIN
+
+/*
+ * The kernels keep the accumulated bins in registers while they run through
+ * all pairs, so the accumulator is only read and written once. The real
+ * and imaginary products are summed separately to have more independent
+ * additions in flight. The spectra don't need to be aligned.
+ */
+
+static void multiply_add_scalar(const sample_t* const* a, const sample_t* const* b, int count, sample_t* accumulator, int stride)
+{
+	for(int p = 0; p < count; p++)
+	{
+		const sample_t* ar = a[p];
+		const sample_t* ai = a[p] + stride;
+		const sample_t* br = b[p];
+		const sample_t* bi = b[p] + stride;
+
+		for(int i = 0; i < stride; i++)
+		{
+			accumulator[i] += ar[i] * br[i] - ai[i] * bi[i];
+			accumulator[stride + i] += ar[i] * bi[i] + ai[i] * br[i];
+		}
+	}
+}
+
+#if defined(AUD_SIMD_X86)
+AUD_TARGET_SSE2 static void multiply_add_sse2(const sample_t* const* a, const sample_t* const* b, int count, sample_t* accumulator, int stride)
+{
+	for(int i = 0; i < stride; i += 8)
+	{
+		__m128 rr0 = _mm_loadu_ps(accumulator + i);
+		__m128 rr1 = _mm_loadu_ps(accumulator + i + 4);
+		__m128 ri0 = _mm_loadu_ps(accumulator + stride + i);
+		__m128 ri1 = _mm_loadu_ps(accumulator + stride + i + 4);
+		__m128 ii0 = _mm_setzero_ps();
+		__m128 ii1 = _mm_setzero_ps();
+		__m128 ir0 = _mm_setzero_ps();
+		__m128 ir1 = _mm_setzero_ps();
+
+		for(int p = 0; p < count; p++)
+		{
+			const sample_t* x = a[p] + i;
+			const sample_t* y = b[p] + i;
+
+			__m128 xr0 = _mm_loadu_ps(x);
+			__m128 xr1 = _mm_loadu_ps(x + 4);
+			__m128 xi0 = _mm_loadu_ps(x + stride);
+			__m128 xi1 = _mm_loadu_ps(x + stride + 4);
+			__m128 yr0 = _mm_loadu_ps(y);
+			__m128 yr1 = _mm_loadu_ps(y + 4);
+			__m128 yi0 = _mm_loadu_ps(y + stride);
+			__m128 yi1 = _mm_loadu_ps(y + stride + 4);
+
+			rr0 = _mm_add_ps(rr0, _mm_mul_ps(xr0, yr0));
+			rr1 = _mm_add_ps(rr1, _mm_mul_ps(xr1, yr1));
+			ii0 = _mm_add_ps(ii0, _mm_mul_ps(xi0, yi0));
+			ii1 = _mm_add_ps(ii1, _mm_mul_ps(xi1, yi1));
+			ri0 = _mm_add_ps(ri0, _mm_mul_ps(xr0, yi0));
+			ri1 = _mm_add_ps(ri1, _mm_mul_ps(xr1, yi1));
+			ir0 = _mm_add_ps(ir0, _mm_mul_ps(xi0, yr0));
+			ir1 = _mm_add_ps(ir1, _mm_mul_ps(xi1, yr1));
+		}
+
+		_mm_storeu_ps(accumulator + i, _mm_sub_ps(rr0, ii0));
+		_mm_storeu_ps(accumulator + i + 4, _mm_sub_ps(rr1, ii1));
+		_mm_storeu_ps(accumulator + stride + i, _mm_add_ps(ri0, ir0));
+		_mm_storeu_ps(accumulator + stride + i + 4, _mm_add_ps(ri1, ir1));
+	}
+}
+
+AUD_TARGET_AVX2 static void multiply_add_avx2(const sample_t* const* a, const sample_t* const* b, int count, sample_t* accumulator, int stride)
+{
+	int i = 0;
+
+	for(; i + 16 <= stride; i += 16)
+	{
+		__m256 rr0 = _mm256_loadu_ps(accumulator + i);
+		__m256 rr1 = _mm256_loadu_ps(accumulator + i + 8);
+		__m256 ri0 = _mm256_loadu_ps(accumulator + stride + i);
+		__m256 ri1 = _mm256_loadu_ps(accumulator + stride + i + 8);
+		__m256 ii0 = _mm256_setzero_ps();
+		__m256 ii1 = _mm256_setzero_ps();
+		__m256 ir0 = _mm256_setzero_ps();
+		__m256 ir1 = _mm256_setzero_ps();
+
+		for(int p = 0; p < count; p++)
+		{
+			const sample_t* x = a[p] + i;
+			const sample_t* y = b[p] + i;
+
+			__m256 xr0 = _mm256_loadu_ps(x);
+			__m256 xr1 = _mm256_loadu_ps(x + 8);
+			__m256 xi0 = _mm256_loadu_ps(x + stride);
+			__m256 xi1 = _mm256_loadu_ps(x + stride + 8);
+			__m256 yr0 = _mm256_loadu_ps(y);
+			__m256 yr1 = _mm256_loadu_ps(y + 8);
+			__m256 yi0 = _mm256_loadu_ps(y + stride);
+			__m256 yi1 = _mm256_loadu_ps(y + stride + 8);
+
+			rr0 = _mm256_fmadd_ps(xr0, yr0, rr0);
+			rr1 = _mm256_fmadd_ps(xr1, yr1, rr1);
+			ii0 = _mm256_fmadd_ps(xi0, yi0, ii0);
+			ii1 = _mm256_fmadd_ps(xi1, yi1, ii1);
+			ri0 = _mm256_fmadd_ps(xr0, yi0, ri0);
+			ri1 = _mm256_fmadd_ps(xr1, yi1, ri1);
+			ir0 = _mm256_fmadd_ps(xi0, yr0, ir0);
+			ir1 = _mm256_fmadd_ps(xi1, yr1, ir1);
+		}
+
+		_mm256_storeu_ps(accumulator + i, _mm256_sub_ps(rr0, ii0));
+		_mm256_storeu_ps(accumulator + i + 8, _mm256_sub_ps(rr1, ii1));
+		_mm256_storeu_ps(accumulator + stride + i, _mm256_add_ps(ri0, ir0));
+		_mm256_storeu_ps(accumulator + stride + i + 8, _mm256_add_ps(ri1, ir1));
+	}
+
+	// the last eight bins
+	for(; i < stride; i += 8)
+	{
+		__m256 rr = _mm256_loadu_ps(accumulator + i);
+		__m256 ri = _mm256_loadu_ps(accumulator + stride + i);
+		__m256 ii = _mm256_setzero_ps();
+		__m256 ir = _mm256_setzero_ps();
+
+		for(int p = 0; p < count; p++)
+		{
+			const sample_t* x = a[p] + i;
+			const sample_t* y = b[p] + i;
+
+			__m256 xr = _mm256_loadu_ps(x);
+			__m256 xi = _mm256_loadu_ps(x + stride);
+			__m256 yr = _mm256_loadu_ps(y);
+			__m256 yi = _mm256_loadu_ps(y + stride);
+
+			rr = _mm256_fmadd_ps(xr, yr, rr);
+			ii = _mm256_fmadd_ps(xi, yi, ii);
+			ri = _mm256_fmadd_ps(xr, yi, ri);
+			ir = _mm256_fmadd_ps(xi, yr, ir);
+		}
+
+		_mm256_storeu_ps(accumulator + i, _mm256_sub_ps(rr, ii));
+		_mm256_storeu_ps(accumulator + stride + i, _mm256_add_ps(ri, ir));
+	}
+}
+#elif defined(AUD_SIMD_NEON)
+static void multiply_add_neon(const sample_t* const* a, const sample_t* const* b, int count, sample_t* accumulator, int stride)
+{
+	for(int i = 0; i < stride; i += 8)
+	{
+		float32x4_t rr0 = vld1q_f32(accumulator + i);
+		float32x4_t rr1 = vld1q_f32(accumulator + i + 4);
+		float32x4_t ri0 = vld1q_f32(accumulator + stride + i);
+		float32x4_t ri1 = vld1q_f32(accumulator + stride + i + 4);
+		float32x4_t ii0 = vdupq_n_f32(0);
+		float32x4_t ii1 = vdupq_n_f32(0);
+		float32x4_t ir0 = vdupq_n_f32(0);
+		float32x4_t ir1 = vdupq_n_f32(0);
+
+		for(int p = 0; p < count; p++)
+		{
+			const sample_t* x = a[p] + i;
+			const sample_t* y = b[p] + i;
+
+			float32x4_t xr0 = vld1q_f32(x);
+			float32x4_t xr1 = vld1q_f32(x + 4);
+			float32x4_t xi0 = vld1q_f32(x + stride);
+			float32x4_t xi1 = vld1q_f32(x + stride + 4);
+			float32x4_t yr0 = vld1q_f32(y);
+			float32x4_t yr1 = vld1q_f32(y + 4);
+			float32x4_t yi0 = vld1q_f32(y + stride);
+			float32x4_t yi1 = vld1q_f32(y + stride + 4);
+
+			rr0 = vfmaq_f32(rr0, xr0, yr0);
+			rr1 = vfmaq_f32(rr1, xr1, yr1);
+			ii0 = vfmaq_f32(ii0, xi0, yi0);
+			ii1 = vfmaq_f32(ii1, xi1, yi1);
+			ri0 = vfmaq_f32(ri0, xr0, yi0);
+			ri1 = vfmaq_f32(ri1, xr1, yi1);
+			ir0 = vfmaq_f32(ir0, xi0, yr0);
+			ir1 = vfmaq_f32(ir1, xi1, yr1);
+		}
+
+		vst1q_f32(accumulator + i, vsubq_f32(rr0, ii0));
+		vst1q_f32(accumulator + i + 4, vsubq_f32(rr1, ii1));
+		vst1q_f32(accumulator + stride + i, vaddq_f32(ri0, ir0));
+		vst1q_f32(accumulator + stride + i + 4, vaddq_f32(ri1, ir1));
+	}
+}
+#endif
+
+int SplitSpectrum::getStride(int bins)
+{
+	return (bins + STRIDE_ALIGNMENT - 1) / STRIDE_ALIGNMENT * STRIDE_ALIGNMENT;
+}
+
+int SplitSpectrum::getSize(int bins)
+{
+	return 2 * getStride(bins);
+}
+
+void SplitSpectrum::split(const sample_t* spectrum, sample_t* split, int bins)
+{
+	int stride = getStride(bins);
+
+	for(int i = 0; i < bins; i++)
+	{
+		split[i] = spectrum[2 * i];
+		split[stride + i] = spectrum[2 * i + 1];
+	}
+
+	std::memset(split + bins, 0, (stride - bins) * sizeof(sample_t));
+	std::memset(split + stride + bins, 0, (stride - bins) * sizeof(sample_t));
+}
+
+void SplitSpectrum::merge(const sample_t* split, sample_t* spectrum, int bins)
+{
+	int stride = getStride(bins);
+
+	for(int i = 0; i < bins; i++)
+	{
+		spectrum[2 * i] = split[i];
+		spectrum[2 * i + 1] = split[stride + i];
+	}
+}
+
+SplitSpectrum::multiply_add_f SplitSpectrum::getMultiplyAdd()
+{
+	switch(SIMD::getLevel())
+	{
+#if defined(AUD_SIMD_X86)
+	case SIMD_AVX2:
+		return multiply_add_avx2;
+	case SIMD_SSE2:
+		return multiply_add_sse2;
+#elif defined(AUD_SIMD_NEON)
+	case SIMD_NEON:
+		return multiply_add_neon;
+#endif
+	default:
+		return multiply_add_scalar;
+	}
+}
+
+AUD_NAMESPACE_END
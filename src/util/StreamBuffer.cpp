@@ -28,7 +28,7 @@
 AUD_NAMESPACE_BEGIN
 
 StreamBuffer::StreamBuffer(std::shared_ptr<ISound> sound) :
-	m_buffer(new Buffer())
+	m_buffer(new Buffer()), m_format(FORMAT_FLOAT32)
 {
 	std::shared_ptr<IReader> reader = sound->createReader();
 
@@ -69,7 +69,12 @@ StreamBuffer::StreamBuffer(std::shared_ptr<ISound> sound) :
 }
 
 StreamBuffer::StreamBuffer(std::shared_ptr<Buffer> buffer, Specs specs) :
-	m_buffer(buffer), m_specs(specs)
+	m_buffer(buffer), m_specs(specs), m_format(FORMAT_FLOAT32)
+{
+}
+
+StreamBuffer::StreamBuffer(std::shared_ptr<Buffer> buffer, DeviceSpecs specs) :
+	m_buffer(buffer), m_specs(specs.specs), m_format(specs.format)
 {
 }
 
@@ -85,7 +90,11 @@ Specs StreamBuffer::getSpecs()
 
 std::shared_ptr<IReader> StreamBuffer::createReader()
 {
-	return std::shared_ptr<IReader>(new BufferReader(m_buffer, m_specs));
+	DeviceSpecs specs;
+	specs.specs = m_specs;
+	specs.format = m_format;
+
+	return std::shared_ptr<IReader>(new BufferReader(m_buffer, specs));
 }
 
 AUD_NAMESPACE_END